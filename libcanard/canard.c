@@ -16,12 +16,52 @@
 #endif
 
 /// This macro is needed only for testing and for library development. Do not redefine this in production.
+/// Defining CANARD_CONFIG_INLINE_PRIVATE as true turns the private functions into "static inline", which is useful
+/// mostly for the amalgamated build where the application and the library are compiled as one translation unit.
 #if defined(CANARD_CONFIG_EXPOSE_PRIVATE) && CANARD_CONFIG_EXPOSE_PRIVATE
 #    define CANARD_PRIVATE
-#else  // Consider defining an extra compilation option that turns this into "static inline"?
+#elif defined(CANARD_CONFIG_INLINE_PRIVATE) && CANARD_CONFIG_INLINE_PRIVATE
+#    define CANARD_PRIVATE static inline
+#else
 #    define CANARD_PRIVATE static
 #endif
 
+/// The initial value of CanardInstance.tx_fd_bitrate_ratio assigned by canardInit().
+/// The default assumes no bit rate switching.
+#ifndef CANARD_CONFIG_TX_FD_BITRATE_RATIO
+#    define CANARD_CONFIG_TX_FD_BITRATE_RATIO 1U
+#endif
+
+/// Opt-in compact layout of the RX session state: the transfer timestamp is stored as the lower 32 bits of the
+/// microsecond timestamp and the payload sizes are 16-bit, which shrinks the session from 40 to 24 bytes on 64-bit
+/// platforms (below the 32-byte allocation granule of common heaps), so that more sessions fit in the data cache.
+/// The costs: the extent of a subscription shall not exceed UINT16_MAX - 2 bytes, so that the saturated total size
+/// still accounts for the CRC, and the transfer-ID timeout shall not exceed 2**31 - 1 microseconds (about 35 minutes);
+/// both are enforced by canardRxSubscribe(). The elapsed time is only known modulo 2**32 microseconds (about 71
+/// minutes): the timeout is missed if the session has been idle for a multiple of 2**32 microseconds plus less than
+/// the transfer-ID timeout or minus less than one second; any other idle time above 2**31 microseconds is a timeout.
+#ifndef CANARD_CONFIG_COMPACT_RX_SESSION
+#    define CANARD_CONFIG_COMPACT_RX_SESSION 0
+#endif
+
+/// USDT (statically defined tracing) probes for bpftrace/perf/SystemTap under the provider name "libcanard";
+/// see tools/bpftrace/ for the list of probes and their arguments. The probes are enabled by default if <sys/sdt.h>
+/// is available; define CANARD_CONFIG_TRACE as false to remove them. When no tracer is attached, a probe costs
+/// a single NOP instruction plus the evaluation of its arguments, which are chosen to be readily available.
+#ifndef CANARD_CONFIG_TRACE
+#    if defined(__has_include)
+#        if __has_include(<sys/sdt.h>)
+#            define CANARD_CONFIG_TRACE 1
+#        endif
+#    endif
+#endif
+#if defined(CANARD_CONFIG_TRACE) && CANARD_CONFIG_TRACE
+#    include <sys/sdt.h>
+#    define CANARD_TRACE(name, ...) STAP_PROBEV(libcanard, name, __VA_ARGS__)
+#else
+#    define CANARD_TRACE(name, ...) (void) 0
+#endif
+
 #if !defined(__STDC_VERSION__) || (__STDC_VERSION__ < 199901L)
 #    error "Unsupported language: ISO C99 or a newer version is required."
 #endif
@@ -54,6 +94,14 @@
 
 #define INITIAL_TOGGLE_STATE true
 
+// CAN FD frame bits exclusive of the data field, stuff bits not included. Ref. ISO 11898-1:2015.
+// Nominal bit rate: the arbitration phase (SOF, ID, SRR, IDE, RRS, FDF, res, BRS) and the trailer (CRC delimiter,
+// ACK, EOF, IFS). Data bit rate: ESI, DLC, the stuff count, the CRC, and the fixed stuff bits of the CRC field.
+#define FD_FRAME_NOMINAL_OVERHEAD_BITS (36U + 13U)
+#define FD_FRAME_DATA_OVERHEAD_BITS_CRC17 (5U + 4U + 17U + 6U)
+#define FD_FRAME_DATA_OVERHEAD_BITS_CRC21 (5U + 4U + 21U + 7U)
+#define FD_FRAME_CRC17_MAX_PAYLOAD 16U
+
 // --------------------------------------------- TRANSFER CRC ---------------------------------------------
 
 typedef uint16_t TransferCRC;
@@ -106,6 +154,7 @@ typedef struct CanardInternalTxQueueItem
 {
     CanardFrame                       frame;
     struct CanardInternalTxQueueItem* next;
+    struct CanardInternalTxCursor*    lazy;  ///< Produces the remaining frames of a lazy transfer, NULL otherwise.
 
     // Intentional violation of MISRA: this flex array is the lesser of three evils. The other two are:
     //  - Make the payload pointer point to the remainder of the allocated memory following this structure.
@@ -114,6 +163,20 @@ typedef struct CanardInternalTxQueueItem
     uint8_t payload_buffer[];  // NOSONAR
 } CanardInternalTxQueueItem;
 
+/// The serialization state of a multi-frame transfer: the position of its next frame. The transfer CRC is computed
+/// incrementally as the frames are written, so the payload is traversed only once.
+typedef struct CanardInternalTxCursor
+{
+    const uint8_t*   payload;
+    size_t           payload_size;
+    size_t           offset;  ///< The amount of the payload and the CRC written so far.
+    size_t           mtu;     ///< The presentation layer MTU of the frames.
+    TransferCRC      crc;
+    CanardTransferID transfer_id;
+    bool             start_of_transfer;
+    bool             toggle;
+} CanardInternalTxCursor;
+
 CANARD_PRIVATE uint32_t txMakeMessageSessionSpecifier(const CanardPortID subject_id, const CanardNodeID src_node_id);
 CANARD_PRIVATE uint32_t txMakeMessageSessionSpecifier(const CanardPortID subject_id, const CanardNodeID src_node_id)
 {
@@ -141,22 +204,27 @@ CANARD_PRIVATE uint32_t txMakeServiceSessionSpecifier(const CanardPortID service
 }
 
 /// This is the transport MTU rounded up to next full DLC minus the tail byte.
-CANARD_PRIVATE size_t txGetPresentationLayerMTU(const CanardInstance* const ins);
-CANARD_PRIVATE size_t txGetPresentationLayerMTU(const CanardInstance* const ins)
+/// Above the CAN FD MTU, CAN XL is used, where every length is valid.
+CANARD_PRIVATE size_t txGetPresentationLayerMTU(const size_t mtu_bytes);
+CANARD_PRIVATE size_t txGetPresentationLayerMTU(const size_t mtu_bytes)
 {
     const size_t max_index = (sizeof(CanardCANLengthToDLC) / sizeof(CanardCANLengthToDLC[0])) - 1U;
     size_t       mtu       = 0U;
-    if (ins->mtu_bytes < CANARD_MTU_CAN_CLASSIC)
+    if (mtu_bytes < CANARD_MTU_CAN_CLASSIC)
     {
         mtu = CANARD_MTU_CAN_CLASSIC;
     }
-    else if (ins->mtu_bytes <= max_index)
+    else if (mtu_bytes <= max_index)
     {
-        mtu = CanardCANDLCToLength[CanardCANLengthToDLC[ins->mtu_bytes]];  // Round up to nearest valid length.
+        mtu = CanardCANDLCToLength[CanardCANLengthToDLC[mtu_bytes]];  // Round up to nearest valid length.
+    }
+    else if (mtu_bytes <= CANARD_MTU_CAN_XL)
+    {
+        mtu = mtu_bytes;
     }
     else
     {
-        mtu = CanardCANDLCToLength[CanardCANLengthToDLC[max_index]];
+        mtu = CANARD_MTU_CAN_XL;
     }
     return mtu - 1U;
 }
@@ -245,14 +313,68 @@ CANARD_PRIVATE uint8_t txMakeTailByte(const bool             start_of_transfer,
 }
 
 /// Takes a frame payload size, returns a new size that is >=x and is rounded up to the nearest valid DLC.
+/// The sizes beyond the CAN FD MTU are CAN XL frames, which need no rounding.
 CANARD_PRIVATE size_t txRoundFramePayloadSizeUp(const size_t x);
 CANARD_PRIVATE size_t txRoundFramePayloadSizeUp(const size_t x)
 {
-    CANARD_ASSERT(x < (sizeof(CanardCANLengthToDLC) / sizeof(CanardCANLengthToDLC[0])));
-    // Suppressing a false-positive out-of-bounds access error from Sonar. Its control flow analyser is misbehaving.
-    const size_t y = CanardCANLengthToDLC[x];  // NOSONAR
-    CANARD_ASSERT(y < (sizeof(CanardCANDLCToLength) / sizeof(CanardCANDLCToLength[0])));
-    return CanardCANDLCToLength[y];
+    size_t out = x;
+    if (x < (sizeof(CanardCANLengthToDLC) / sizeof(CanardCANLengthToDLC[0])))
+    {
+        // Suppressing a false-positive out-of-bounds access error from Sonar. Its control flow analyser is misbehaving.
+        const size_t y = CanardCANLengthToDLC[x];  // NOSONAR
+        CANARD_ASSERT(y < (sizeof(CanardCANDLCToLength) / sizeof(CanardCANDLCToLength[0])));
+        out = CanardCANDLCToLength[y];
+    }
+    CANARD_ASSERT(out <= CANARD_MTU_CAN_XL);
+    return out;
+}
+
+/// Estimated bus time of a CAN FD frame with the specified payload size (tail byte included, valid DLC), expressed in
+/// data phase bit periods. Stuff bits are not counted because their number is roughly proportional to the frame size.
+CANARD_PRIVATE uint32_t txEstimateFrameBusTime(const size_t frame_payload_size, const uint32_t bitrate_ratio);
+CANARD_PRIVATE uint32_t txEstimateFrameBusTime(const size_t frame_payload_size, const uint32_t bitrate_ratio)
+{
+    const uint32_t data_overhead = (frame_payload_size <= FD_FRAME_CRC17_MAX_PAYLOAD)
+                                       ? FD_FRAME_DATA_OVERHEAD_BITS_CRC17
+                                       : FD_FRAME_DATA_OVERHEAD_BITS_CRC21;
+    return (FD_FRAME_NOMINAL_OVERHEAD_BITS * bitrate_ratio) + data_overhead +
+           (uint32_t)(frame_payload_size * BITS_PER_BYTE);
+}
+
+/// Chooses the presentation-layer MTU for a multi-frame transfer that minimizes its estimated bus time.
+/// The candidates are all valid DLC lengths not less than the Classic CAN MTU, up to the instance MTU inclusive.
+/// The resulting MTU never exceeds the argument; with Classic CAN, the result is always equal to the argument.
+/// The time complexity is constant (at most 8 candidates are evaluated).
+CANARD_PRIVATE size_t txChooseMultiFramePresentationLayerMTU(const size_t   presentation_layer_mtu,
+                                                             const size_t   payload_size,
+                                                             const uint32_t bitrate_ratio);
+CANARD_PRIVATE size_t txChooseMultiFramePresentationLayerMTU(const size_t   presentation_layer_mtu,
+                                                             const size_t   payload_size,
+                                                             const uint32_t bitrate_ratio)
+{
+    CANARD_ASSERT(presentation_layer_mtu >= (CANARD_MTU_CAN_CLASSIC - 1U));
+    CANARD_ASSERT(payload_size > presentation_layer_mtu);
+    const size_t payload_size_with_crc = payload_size + CRC_SIZE_BYTES;
+    size_t       best_mtu              = presentation_layer_mtu;
+    uint32_t     best_cost             = UINT32_MAX;
+    // Iterate from the largest frame size downward so that ties are resolved in favor of fewer frames.
+    size_t dlc = CanardCANLengthToDLC[presentation_layer_mtu + 1U];
+    while (CanardCANDLCToLength[dlc] >= CANARD_MTU_CAN_CLASSIC)
+    {
+        const size_t mtu        = CanardCANDLCToLength[dlc] - 1U;
+        const size_t num_frames = (payload_size_with_crc + mtu - 1U) / mtu;
+        const size_t last_size  = payload_size_with_crc - ((num_frames - 1U) * mtu);
+        const uint32_t cost     = ((uint32_t)(num_frames - 1U) * txEstimateFrameBusTime(mtu + 1U, bitrate_ratio)) +
+                              txEstimateFrameBusTime(txRoundFramePayloadSizeUp(last_size + 1U), bitrate_ratio);
+        if (cost < best_cost)
+        {
+            best_cost = cost;
+            best_mtu  = mtu;
+        }
+        --dlc;
+    }
+    CANARD_ASSERT(best_mtu <= presentation_layer_mtu);
+    return best_mtu;
 }
 
 CANARD_PRIVATE CanardInternalTxQueueItem* txAllocateQueueItem(CanardInstance* const   ins,
@@ -271,6 +393,7 @@ CANARD_PRIVATE CanardInternalTxQueueItem* txAllocateQueueItem(CanardInstance* co
     if (out != NULL)
     {
         out->next                  = NULL;
+        out->lazy                  = NULL;
         out->frame.timestamp_usec  = deadline_usec;
         out->frame.payload_size    = payload_size;
         out->frame.payload         = out->payload_buffer;
@@ -303,6 +426,32 @@ CANARD_PRIVATE CanardInternalTxQueueItem* txFindQueueSupremum(const CanardInstan
     return out;
 }
 
+/// Inserts the linked list of frames of one transfer into the queue after the frames of the same or higher priority.
+CANARD_PRIVATE void txEnqueue(CanardInstance* const            ins,
+                              CanardInternalTxQueueItem* const head,
+                              CanardInternalTxQueueItem* const tail,
+                              const size_t                     frame_count);
+CANARD_PRIVATE void txEnqueue(CanardInstance* const            ins,
+                              CanardInternalTxQueueItem* const head,
+                              CanardInternalTxQueueItem* const tail,
+                              const size_t                     frame_count)
+{
+    CANARD_ASSERT((head != NULL) && (tail != NULL));
+    CANARD_ASSERT(tail->next == NULL);  // The list shall be properly terminated.
+    CanardInternalTxQueueItem* const sup = txFindQueueSupremum(ins, head->frame.extended_can_id);
+    if (NULL == sup)  // Once the insertion point is located, we insert the entire frame sequence in constant time.
+    {
+        tail->next     = ins->_tx_queue;
+        ins->_tx_queue = head;
+    }
+    else
+    {
+        tail->next = sup->next;
+        sup->next  = head;
+    }
+    ins->_tx_queue_size += frame_count;
+}
+
 /// Returns the number of frames enqueued or error (i.e., =1 or <0).
 CANARD_PRIVATE int32_t txPushSingleFrame(CanardInstance* const   ins,
                                          const CanardMicrosecond deadline_usec,
@@ -342,17 +491,7 @@ CANARD_PRIVATE int32_t txPushSingleFrame(CanardInstance* const   ins,
         (void) memset(&tqi->payload_buffer[payload_size], PADDING_BYTE_VALUE, padding_size);  // NOLINT
 
         tqi->payload_buffer[frame_payload_size - 1U] = txMakeTailByte(true, true, true, transfer_id);
-        CanardInternalTxQueueItem* const sup         = txFindQueueSupremum(ins, can_id);
-        if (sup != NULL)
-        {
-            tqi->next = sup->next;
-            sup->next = tqi;
-        }
-        else
-        {
-            tqi->next      = ins->_tx_queue;
-            ins->_tx_queue = tqi;
-        }
+        txEnqueue(ins, tqi, tqi, 1U);
         out = 1;  // One frame enqueued.
     }
     else
@@ -363,6 +502,111 @@ CANARD_PRIVATE int32_t txPushSingleFrame(CanardInstance* const   ins,
     return out;
 }
 
+CANARD_PRIVATE CanardInternalTxCursor txMakeCursor(const size_t           presentation_layer_mtu,
+                                                  const CanardTransferID transfer_id,
+                                                  const size_t           payload_size,
+                                                  const void* const      payload);
+CANARD_PRIVATE CanardInternalTxCursor txMakeCursor(const size_t           presentation_layer_mtu,
+                                                  const CanardTransferID transfer_id,
+                                                  const size_t           payload_size,
+                                                  const void* const      payload)
+{
+    CANARD_ASSERT(presentation_layer_mtu > 0U);
+    CANARD_ASSERT(payload_size > presentation_layer_mtu);  // Otherwise, a single-frame transfer should be used.
+    CANARD_ASSERT(payload != NULL);
+    const CanardInternalTxCursor out = {
+        .payload           = (const uint8_t*) payload,
+        .payload_size      = payload_size,
+        .offset            = 0U,
+        .mtu               = presentation_layer_mtu,
+        .crc               = CRC_INITIAL,
+        .transfer_id       = transfer_id,
+        .start_of_transfer = true,
+        .toggle            = INITIAL_TOGGLE_STATE,
+    };
+    return out;
+}
+
+/// Returns the number of frames the transfer consists of.
+CANARD_PRIVATE size_t txCursorGetFrameCount(const CanardInternalTxCursor* const cur);
+CANARD_PRIVATE size_t txCursorGetFrameCount(const CanardInternalTxCursor* const cur)
+{
+    CANARD_ASSERT(cur != NULL);
+    return ((cur->payload_size + CRC_SIZE_BYTES) + (cur->mtu - 1U)) / cur->mtu;
+}
+
+/// Returns the payload size of the next frame including the tail byte.
+CANARD_PRIVATE size_t txCursorGetFrameSize(const CanardInternalTxCursor* const cur);
+CANARD_PRIVATE size_t txCursorGetFrameSize(const CanardInternalTxCursor* const cur)
+{
+    CANARD_ASSERT(cur != NULL);
+    const size_t remaining = (cur->payload_size + CRC_SIZE_BYTES) - cur->offset;
+    CANARD_ASSERT(remaining > 0U);
+    return (remaining < cur->mtu) ? txRoundFramePayloadSizeUp(remaining + 1U)  // Padding in the last frame only.
+                                  : (cur->mtu + 1U);
+}
+
+/// Writes the next frame of the transfer into the buffer, whose size shall be as returned by txCursorGetFrameSize(),
+/// and advances the cursor. Returns true if that was the last frame of the transfer.
+CANARD_PRIVATE bool txCursorWriteFrame(CanardInternalTxCursor* const cur, uint8_t* const buffer);
+CANARD_PRIVATE bool txCursorWriteFrame(CanardInternalTxCursor* const cur, uint8_t* const buffer)
+{
+    CANARD_ASSERT((cur != NULL) && (buffer != NULL));
+    const size_t payload_size_with_crc = cur->payload_size + CRC_SIZE_BYTES;
+    const size_t frame_payload_size    = txCursorGetFrameSize(cur) - 1U;
+    size_t       frame_offset          = 0U;
+
+    // Copy the payload into the frame.
+    if (cur->offset < cur->payload_size)
+    {
+        size_t move_size = cur->payload_size - cur->offset;
+        if (move_size > frame_payload_size)
+        {
+            move_size = frame_payload_size;
+        }
+        // Clang-Tidy raises an error recommending the use of memcpy_s() instead.
+        // We ignore it because the safe functions are poorly supported; reliance on them may limit the portability.
+        (void) memcpy(&buffer[0], &cur->payload[cur->offset], move_size);  // NOLINT
+        cur->crc     = crcAdd(cur->crc, move_size, &buffer[0]);
+        frame_offset = frame_offset + move_size;
+        cur->offset += move_size;
+    }
+
+    // Handle the last frame of the transfer: it is special because it also contains padding and CRC.
+    if (cur->offset >= cur->payload_size)
+    {
+        // Insert padding -- only in the last frame. Don't forget to include padding into the CRC.
+        while ((frame_offset + CRC_SIZE_BYTES) < frame_payload_size)
+        {
+            buffer[frame_offset] = PADDING_BYTE_VALUE;
+            ++frame_offset;
+            cur->crc = crcAddByte(cur->crc, PADDING_BYTE_VALUE);
+        }
+
+        // Insert the CRC.
+        if ((frame_offset < frame_payload_size) && (cur->offset == cur->payload_size))
+        {
+            buffer[frame_offset] = (uint8_t)(cur->crc >> BITS_PER_BYTE);
+            ++frame_offset;
+            ++cur->offset;
+        }
+        if ((frame_offset < frame_payload_size) && (cur->offset > cur->payload_size))
+        {
+            buffer[frame_offset] = (uint8_t)(cur->crc & BYTE_MAX);
+            ++frame_offset;
+            ++cur->offset;
+        }
+    }
+
+    // Finalize the frame.
+    CANARD_ASSERT(frame_offset == frame_payload_size);
+    const bool end_of_transfer = cur->offset >= payload_size_with_crc;
+    buffer[frame_offset]   = txMakeTailByte(cur->start_of_transfer, end_of_transfer, cur->toggle, cur->transfer_id);
+    cur->start_of_transfer = false;
+    cur->toggle            = !cur->toggle;
+    return end_of_transfer;
+}
+
 /// Returns the number of frames enqueued or error.
 CANARD_PRIVATE int32_t txPushMultiFrame(CanardInstance* const   ins,
                                         const size_t            presentation_layer_mtu,
@@ -380,31 +624,19 @@ CANARD_PRIVATE int32_t txPushMultiFrame(CanardInstance* const   ins,
                                         const void* const       payload)
 {
     CANARD_ASSERT(ins != NULL);
-    CANARD_ASSERT(presentation_layer_mtu > 0U);
-    CANARD_ASSERT(payload_size > presentation_layer_mtu);  // Otherwise, a single-frame transfer should be used.
-    CANARD_ASSERT(payload != NULL);
 
     int32_t out = 0;  // The number of frames enqueued or negated error.
 
     CanardInternalTxQueueItem* head = NULL;  // Head and tail of the linked list of frames of this transfer.
     CanardInternalTxQueueItem* tail = NULL;
 
-    const size_t   payload_size_with_crc = payload_size + CRC_SIZE_BYTES;
-    size_t         offset                = 0U;
-    TransferCRC    crc                   = crcAdd(CRC_INITIAL, payload_size, payload);
-    bool           start_of_transfer     = true;
-    bool           toggle                = INITIAL_TOGGLE_STATE;
-    const uint8_t* payload_ptr           = (const uint8_t*) payload;
-
-    while (offset < payload_size_with_crc)
+    CanardInternalTxCursor cursor = txMakeCursor(presentation_layer_mtu, transfer_id, payload_size, payload);
+    bool                   done   = false;
+    while (!done)
     {
         ++out;
-        const size_t frame_payload_size_with_tail =
-            ((payload_size_with_crc - offset) < presentation_layer_mtu)
-                ? txRoundFramePayloadSizeUp((payload_size_with_crc - offset) + 1U)  // Padding in the last frame only.
-                : (presentation_layer_mtu + 1U);
         CanardInternalTxQueueItem* const tqi =
-            txAllocateQueueItem(ins, can_id, deadline_usec, frame_payload_size_with_tail);
+            txAllocateQueueItem(ins, can_id, deadline_usec, txCursorGetFrameSize(&cursor));
         if (NULL == head)
         {
             head = tqi;
@@ -418,74 +650,13 @@ CANARD_PRIVATE int32_t txPushMultiFrame(CanardInstance* const   ins,
         {
             break;
         }
-
-        // Copy the payload into the frame.
-        const size_t frame_payload_size = frame_payload_size_with_tail - 1U;
-        size_t       frame_offset       = 0U;
-        if (offset < payload_size)
-        {
-            size_t move_size = payload_size - offset;
-            if (move_size > frame_payload_size)
-            {
-                move_size = frame_payload_size;
-            }
-            // Clang-Tidy raises an error recommending the use of memcpy_s() instead.
-            // We ignore it because the safe functions are poorly supported; reliance on them may limit the portability.
-            (void) memcpy(&tail->payload_buffer[0], payload_ptr, move_size);  // NOLINT
-            frame_offset = frame_offset + move_size;
-            offset += move_size;
-            payload_ptr += move_size;
-        }
-
-        // Handle the last frame of the transfer: it is special because it also contains padding and CRC.
-        if (offset >= payload_size)
-        {
-            // Insert padding -- only in the last frame. Don't forget to include padding into the CRC.
-            while ((frame_offset + CRC_SIZE_BYTES) < frame_payload_size)
-            {
-                tail->payload_buffer[frame_offset] = PADDING_BYTE_VALUE;
-                ++frame_offset;
-                crc = crcAddByte(crc, PADDING_BYTE_VALUE);
-            }
-
-            // Insert the CRC.
-            if ((frame_offset < frame_payload_size) && (offset == payload_size))
-            {
-                tail->payload_buffer[frame_offset] = (uint8_t)(crc >> BITS_PER_BYTE);
-                ++frame_offset;
-                ++offset;
-            }
-            if ((frame_offset < frame_payload_size) && (offset > payload_size))
-            {
-                tail->payload_buffer[frame_offset] = (uint8_t)(crc & BYTE_MAX);
-                ++frame_offset;
-                ++offset;
-            }
-        }
-
-        // Finalize the frame.
-        CANARD_ASSERT((frame_offset + 1U) == tail->frame.payload_size);
-        tail->payload_buffer[frame_offset] =
-            txMakeTailByte(start_of_transfer, offset >= payload_size_with_crc, toggle, transfer_id);
-        start_of_transfer = false;
-        toggle            = !toggle;
+        done = txCursorWriteFrame(&cursor, &tail->payload_buffer[0]);
     }
 
     if (tail != NULL)
     {
         CANARD_ASSERT(head->next != NULL);  // This is not a single-frame transfer so at least two frames shall exist.
-        CANARD_ASSERT(tail->next == NULL);  // The list shall be properly terminated.
-        CanardInternalTxQueueItem* const sup = txFindQueueSupremum(ins, can_id);
-        if (NULL == sup)  // Once the insertion point is located, we insert the entire frame sequence in constant time.
-        {
-            tail->next     = ins->_tx_queue;
-            ins->_tx_queue = head;
-        }
-        else
-        {
-            tail->next = sup->next;
-            sup->next  = head;
-        }
+        txEnqueue(ins, head, tail, (size_t) out);
     }
     else  // Failed to allocate at least one frame in the queue! Remove all frames and abort.
     {
@@ -502,6 +673,149 @@ CANARD_PRIVATE int32_t txPushMultiFrame(CanardInstance* const   ins,
     return out;
 }
 
+/// Like txPushMultiFrame() but only the first frame is enqueued; the cursor that produces the following ones
+/// is attached to it and references the payload of the application. Returns the number of frames of the transfer.
+CANARD_PRIVATE int32_t txPushMultiFrameLazy(CanardInstance* const   ins,
+                                            const size_t            presentation_layer_mtu,
+                                            const CanardMicrosecond deadline_usec,
+                                            const uint32_t          can_id,
+                                            const CanardTransferID  transfer_id,
+                                            const size_t            payload_size,
+                                            const void* const       payload);
+CANARD_PRIVATE int32_t txPushMultiFrameLazy(CanardInstance* const   ins,
+                                            const size_t            presentation_layer_mtu,
+                                            const CanardMicrosecond deadline_usec,
+                                            const uint32_t          can_id,
+                                            const CanardTransferID  transfer_id,
+                                            const size_t            payload_size,
+                                            const void* const       payload)
+{
+    CANARD_ASSERT(ins != NULL);
+    int32_t                       out = -CANARD_ERROR_OUT_OF_MEMORY;
+    CanardInternalTxCursor* const cur = (CanardInternalTxCursor*) ins->memory_allocate(ins, sizeof(*cur));
+    CanardInternalTxQueueItem*    tqi = NULL;
+    if (cur != NULL)
+    {
+        *cur = txMakeCursor(presentation_layer_mtu, transfer_id, payload_size, payload);
+        tqi  = txAllocateQueueItem(ins, can_id, deadline_usec, txCursorGetFrameSize(cur));
+    }
+    if (tqi != NULL)
+    {
+        const size_t frame_count = txCursorGetFrameCount(cur);
+        const bool   done        = txCursorWriteFrame(cur, &tqi->payload_buffer[0]);
+        CANARD_ASSERT(!done);  // This is not a single-frame transfer so at least two frames shall exist.
+        (void) done;
+        tqi->lazy = cur;
+        txEnqueue(ins, tqi, tqi, 1U);
+        out = (int32_t) frame_count;
+    }
+    else if (cur != NULL)
+    {
+        ins->memory_free(ins, cur);
+    }
+    CANARD_ASSERT((out < 0) || (out >= 2));
+    return out;
+}
+
+/// Called when the frame of a lazy transfer is popped: produces the next frame of the transfer and puts it at the top
+/// of the queue, which is where the popped frame was. The cursor is freed after the last frame is produced.
+/// If the next frame cannot be allocated, the rest of the transfer is dropped; the receivers will discard it
+/// as an incomplete transfer.
+CANARD_PRIVATE void txContinueLazy(CanardInstance* const ins, CanardInternalTxQueueItem* const popped);
+CANARD_PRIVATE void txContinueLazy(CanardInstance* const ins, CanardInternalTxQueueItem* const popped)
+{
+    CANARD_ASSERT((ins != NULL) && (popped != NULL) && (popped->lazy != NULL));
+    CanardInternalTxCursor* const cur = popped->lazy;
+    popped->lazy                      = NULL;  // The popped frame is owned by the application now.
+
+    const size_t                     frame_size = txCursorGetFrameSize(cur);
+    CanardInternalTxQueueItem* const tqi =
+        txAllocateQueueItem(ins, popped->frame.extended_can_id, popped->frame.timestamp_usec, frame_size);
+    if (tqi != NULL)
+    {
+        // The frames of the same CAN ID enqueued later shall follow; those of a higher priority are already ahead.
+        tqi->lazy      = txCursorWriteFrame(cur, &tqi->payload_buffer[0]) ? NULL : cur;
+        tqi->next      = ins->_tx_queue;
+        ins->_tx_queue = tqi;
+        ins->_tx_queue_size++;
+    }
+    else
+    {
+        CANARD_TRACE(tx_oom, popped->frame.extended_can_id, frame_size);
+    }
+    if ((NULL == tqi) || (NULL == tqi->lazy))
+    {
+        ins->memory_free(ins, cur);
+    }
+}
+
+/// The common part of the push functions except canardTxPushFrame(). Single-frame transfers are never lazy.
+/// The MTU of the instance is not consulted; the caller passes the one to use.
+CANARD_PRIVATE int32_t txPush(CanardInstance* const       ins,
+                              const CanardTransfer* const transfer,
+                              const size_t                mtu_bytes,
+                              const bool                  lazy);
+CANARD_PRIVATE int32_t txPush(CanardInstance* const       ins,
+                              const CanardTransfer* const transfer,
+                              const size_t                mtu_bytes,
+                              const bool                  lazy)
+{
+    int32_t out = -CANARD_ERROR_INVALID_ARGUMENT;
+    if ((ins != NULL) && (transfer != NULL) && ((transfer->payload != NULL) || (0U == transfer->payload_size)))
+    {
+        const size_t  pl_mtu       = txGetPresentationLayerMTU(mtu_bytes);
+        const int32_t maybe_can_id = txMakeCANID(transfer, ins->node_id, pl_mtu);
+        if (maybe_can_id >= 0)
+        {
+            if (transfer->payload_size <= pl_mtu)
+            {
+                out = txPushSingleFrame(ins,
+                                        transfer->timestamp_usec,
+                                        (uint32_t) maybe_can_id,
+                                        transfer->transfer_id,
+                                        transfer->payload_size,
+                                        transfer->payload);
+            }
+            else
+            {
+                // The bus time model only covers CAN FD; a CAN XL transfer uses the largest frames possible.
+                const size_t mft_mtu = ((CanardTxSegmentationMinimizeBusTime == ins->tx_segmentation) &&
+                                        (pl_mtu < CANARD_MTU_CAN_FD))
+                                           ? txChooseMultiFramePresentationLayerMTU(pl_mtu,
+                                                                                    transfer->payload_size,
+                                                                                    ins->tx_fd_bitrate_ratio)
+                                           : pl_mtu;
+                out = lazy ? txPushMultiFrameLazy(ins,
+                                                  mft_mtu,
+                                                  transfer->timestamp_usec,
+                                                  (uint32_t) maybe_can_id,
+                                                  transfer->transfer_id,
+                                                  transfer->payload_size,
+                                                  transfer->payload)
+                           : txPushMultiFrame(ins,
+                                              mft_mtu,
+                                              transfer->timestamp_usec,
+                                              (uint32_t) maybe_can_id,
+                                              transfer->transfer_id,
+                                              transfer->payload_size,
+                                              transfer->payload);
+            }
+        }
+        else
+        {
+            out = maybe_can_id;
+        }
+        CANARD_TRACE(tx_push,
+                     transfer->port_id,
+                     transfer->remote_node_id,
+                     transfer->transfer_id,
+                     transfer->payload_size,
+                     transfer->timestamp_usec,
+                     out);
+    }
+    return out;
+}
+
 // --------------------------------------------- RECEPTION ---------------------------------------------
 
 #define RX_SESSIONS_PER_SUBSCRIPTION (CANARD_NODE_ID_MAX + 1U)
@@ -511,16 +825,33 @@ CANARD_PRIVATE int32_t txPushMultiFrame(CanardInstance* const   ins,
 /// A user that needs a detailed analysis of the worst-case memory consumption may compute the size of this structure
 /// for the particular platform at hand manually or by evaluating its sizeof().
 /// The fields are ordered to minimize the amount of padding on all conventional platforms.
+#if CANARD_CONFIG_COMPACT_RX_SESSION
+typedef uint32_t RxSessionTimestamp;  ///< The lower 32 bits of the microsecond timestamp.
+typedef uint16_t RxSessionSize;
+#    define RX_SESSION_SIZE_MAX UINT16_MAX
+#    define RX_SESSION_EXTENT_MAX (UINT16_MAX - CRC_SIZE_BYTES)
+#    define RX_SESSION_TIMEOUT_MAX_USEC ((CanardMicrosecond) INT32_MAX)
+/// A difference of the 32-bit timestamps this close below 2**32 is taken as the time going backwards.
+#    define RX_SESSION_BACKWARD_TOLERANCE_USEC 1000000U
+#else
+typedef CanardMicrosecond RxSessionTimestamp;
+typedef size_t            RxSessionSize;
+#    define RX_SESSION_SIZE_MAX SIZE_MAX
+#    define RX_SESSION_EXTENT_MAX SIZE_MAX
+#    define RX_SESSION_TIMEOUT_MAX_USEC UINT64_MAX
+#endif
+
 typedef struct CanardInternalRxSession
 {
-    CanardMicrosecond transfer_timestamp_usec;  ///< Timestamp of the last received start-of-transfer.
-    size_t            total_payload_size;       ///< The payload size before the implicit truncation, including the CRC.
-    size_t            payload_size;             ///< How many bytes received so far.
-    uint8_t*          payload;                  ///< Dynamically allocated and handed off to the application when done.
-    TransferCRC       calculated_crc;           ///< Updated with the received payload in real time.
-    CanardTransferID  transfer_id;
-    uint8_t           redundant_transport_index;  ///< Arbitrary value in [0, 255].
-    bool              toggle;
+    RxSessionTimestamp transfer_timestamp_usec;  ///< Timestamp of the last received start-of-transfer.
+    RxSessionSize      total_payload_size;  ///< The payload size before the implicit truncation, including the CRC.
+    RxSessionSize      payload_size;        ///< How many bytes received so far.
+    uint8_t*           payload;             ///< Dynamically allocated and handed off to the application when done.
+    TransferCRC        calculated_crc;      ///< Updated with the received payload in real time.
+    CanardTransferID   transfer_id;
+    uint8_t            redundant_transport_index;  ///< Arbitrary value in [0, 255].
+    bool               toggle;
+    uint8_t            stream_holdback[CRC_SIZE_BYTES];  ///< The last bytes received, streaming subscriptions only.
 } CanardInternalRxSession;
 
 /// High-level transport frame model.
@@ -636,6 +967,38 @@ CANARD_PRIVATE uint8_t rxComputeTransferIDDifference(const uint8_t a, const uint
     return (uint8_t) diff;
 }
 
+/// The time elapsed since the start of the current transfer of the session; zero if the time went backwards.
+CANARD_PRIVATE CanardMicrosecond rxSessionGetElapsed(const CanardInternalRxSession* const rxs,
+                                                     const CanardMicrosecond              now_usec);
+CANARD_PRIVATE CanardMicrosecond rxSessionGetElapsed(const CanardInternalRxSession* const rxs,
+                                                     const CanardMicrosecond              now_usec)
+{
+#if CANARD_CONFIG_COMPACT_RX_SESSION
+    // The difference is computed modulo 2**32. A value in the upper half of the range exceeds any valid transfer-ID
+    // timeout, so an idle time of 2**31 to 2**32 microseconds is a timeout, except just below 2**32, which is taken as
+    // the time going backwards (e.g., a frame timestamped slightly earlier by another interface).
+    const uint32_t elapsed = (uint32_t) ((uint32_t) now_usec - rxs->transfer_timestamp_usec);
+    return (elapsed <= (UINT32_MAX - RX_SESSION_BACKWARD_TOLERANCE_USEC)) ? elapsed : 0U;
+#else
+    return (now_usec > rxs->transfer_timestamp_usec) ? (now_usec - rxs->transfer_timestamp_usec) : 0U;
+#endif
+}
+
+/// The full timestamp of the current transfer of the session. The argument is the timestamp of the last frame,
+/// which is used to restore the upper bits of the timestamp if the compact layout is used.
+CANARD_PRIVATE CanardMicrosecond rxSessionGetTransferTimestamp(const CanardInternalRxSession* const rxs,
+                                                               const CanardMicrosecond              now_usec);
+CANARD_PRIVATE CanardMicrosecond rxSessionGetTransferTimestamp(const CanardInternalRxSession* const rxs,
+                                                               const CanardMicrosecond              now_usec)
+{
+#if CANARD_CONFIG_COMPACT_RX_SESSION
+    return now_usec - (uint32_t) ((uint32_t) now_usec - rxs->transfer_timestamp_usec);
+#else
+    (void) now_usec;
+    return rxs->transfer_timestamp_usec;
+#endif
+}
+
 CANARD_PRIVATE int8_t rxSessionWritePayload(CanardInstance* const          ins,
                                             CanardInternalRxSession* const rxs,
                                             const size_t                   extent,
@@ -653,7 +1016,10 @@ CANARD_PRIVATE int8_t rxSessionWritePayload(CanardInstance* const          ins,
     CANARD_ASSERT(rxs->payload_size <= extent);  // This invariant is enforced by the subscription logic.
     CANARD_ASSERT(rxs->payload_size <= rxs->total_payload_size);
 
-    rxs->total_payload_size += payload_size;
+    // The total size is only used to determine how much of the CRC has been truncated away, so it can saturate.
+    rxs->total_payload_size = (((size_t) RX_SESSION_SIZE_MAX - rxs->total_payload_size) > payload_size)
+                                  ? (RxSessionSize) (rxs->total_payload_size + payload_size)
+                                  : RX_SESSION_SIZE_MAX;
 
     // Allocate the payload lazily, as late as possible.
     if ((NULL == rxs->payload) && (extent > 0U))
@@ -681,7 +1047,7 @@ CANARD_PRIVATE int8_t rxSessionWritePayload(CanardInstance* const          ins,
         // Clang-Tidy raises an error recommending the use of memcpy_s() instead.
         // We ignore it because the safe functions are poorly supported; reliance on them may limit the portability.
         (void) memcpy(&rxs->payload[rxs->payload_size], payload, bytes_to_copy);  // NOLINT NOSONAR
-        rxs->payload_size += bytes_to_copy;
+        rxs->payload_size = (RxSessionSize) (rxs->payload_size + bytes_to_copy);
         CANARD_ASSERT(rxs->payload_size <= extent);
     }
     else
@@ -728,7 +1094,7 @@ CANARD_PRIVATE int8_t rxSessionAcceptFrame(CanardInstance* const          ins,
 
     if (frame->start_of_transfer)  // The transfer timestamp is the timestamp of its first frame.
     {
-        rxs->transfer_timestamp_usec = frame->timestamp_usec;
+        rxs->transfer_timestamp_usec = (RxSessionTimestamp) frame->timestamp_usec;
     }
 
     const bool single_frame = frame->start_of_transfer && frame->end_of_transfer;
@@ -743,6 +1109,7 @@ CANARD_PRIVATE int8_t rxSessionAcceptFrame(CanardInstance* const          ins,
     if (out < 0)
     {
         CANARD_ASSERT(-CANARD_ERROR_OUT_OF_MEMORY == out);
+        CANARD_TRACE(rx_oom, frame->port_id, frame->source_node_id, frame->transfer_id, extent);
         rxSessionRestart(ins, rxs);  // Out-of-memory.
     }
     else if (frame->end_of_transfer)
@@ -750,9 +1117,16 @@ CANARD_PRIVATE int8_t rxSessionAcceptFrame(CanardInstance* const          ins,
         CANARD_ASSERT(0 == out);
         if (single_frame || (CRC_RESIDUE == rxs->calculated_crc))
         {
+            CANARD_TRACE(rx_transfer,
+                         frame->port_id,
+                         frame->source_node_id,
+                         frame->transfer_id,
+                         rxs->payload_size,
+                         rxSessionGetTransferTimestamp(rxs, frame->timestamp_usec),
+                         frame->timestamp_usec);
             out = 1;  // One transfer received, notify the application.
             rxInitTransferFromFrame(frame, out_transfer);
-            out_transfer->timestamp_usec = rxs->transfer_timestamp_usec;
+            out_transfer->timestamp_usec = rxSessionGetTransferTimestamp(rxs, frame->timestamp_usec);
             out_transfer->payload_size   = rxs->payload_size;
             out_transfer->payload        = rxs->payload;
 
@@ -767,6 +1141,14 @@ CANARD_PRIVATE int8_t rxSessionAcceptFrame(CanardInstance* const          ins,
 
             rxs->payload = NULL;  // Ownership passed over to the application, nullify to prevent freeing.
         }
+        else
+        {
+            CANARD_TRACE(rx_crc_error,
+                         frame->port_id,
+                         frame->source_node_id,
+                         frame->transfer_id,
+                         rxs->total_payload_size);
+        }
         rxSessionRestart(ins, rxs);  // Successful completion.
     }
     else
@@ -776,6 +1158,151 @@ CANARD_PRIVATE int8_t rxSessionAcceptFrame(CanardInstance* const          ins,
     return out;
 }
 
+/// Passes the part of the chunk that lies within the extent to the handler of the streaming subscription.
+CANARD_PRIVATE void rxStreamDeliver(CanardInstance* const       ins,
+                                    CanardRxSubscription* const subscription,
+                                    CanardTransfer* const       transfer,
+                                    const size_t                offset,
+                                    const size_t                size,
+                                    const uint8_t* const        data);
+CANARD_PRIVATE void rxStreamDeliver(CanardInstance* const       ins,
+                                    CanardRxSubscription* const subscription,
+                                    CanardTransfer* const       transfer,
+                                    const size_t                offset,
+                                    const size_t                size,
+                                    const uint8_t* const        data)
+{
+    CANARD_ASSERT(subscription->_stream_handler != NULL);
+    const size_t extent = subscription->_extent;
+    if ((size > 0U) && (offset < extent))
+    {
+        transfer->payload_size = ((extent - offset) < size) ? (extent - offset) : size;
+        transfer->payload      = data;
+        subscription->_stream_handler(ins, subscription, CanardRxStreamEventData, transfer, offset);
+    }
+}
+
+/// Concludes the transfer in progress of a streaming session with the specified event (commit or abort).
+CANARD_PRIVATE void rxStreamConclude(CanardInstance* const                ins,
+                                     CanardRxSubscription* const          subscription,
+                                     const CanardInternalRxSession* const rxs,
+                                     const RxFrameModel* const            frame,
+                                     const CanardRxStreamEvent            event);
+CANARD_PRIVATE void rxStreamConclude(CanardInstance* const                ins,
+                                     CanardRxSubscription* const          subscription,
+                                     const CanardInternalRxSession* const rxs,
+                                     const RxFrameModel* const            frame,
+                                     const CanardRxStreamEvent            event)
+{
+    CANARD_ASSERT(subscription->_stream_handler != NULL);
+    CanardTransfer transfer;
+    rxInitTransferFromFrame(frame, &transfer);
+    transfer.timestamp_usec = rxSessionGetTransferTimestamp(rxs, frame->timestamp_usec);
+    transfer.transfer_id    = rxs->transfer_id;  // The frame may belong to the next transfer if this is an abort.
+    transfer.payload_size   = 0U;
+    transfer.payload        = NULL;
+    subscription->_stream_handler(ins, subscription, event, &transfer, rxs->payload_size);
+}
+
+/// The streaming counterpart of rxSessionAcceptFrame(): instead of accumulating the payload in a buffer, the data is
+/// passed to the handler as it arrives. The payload of a multi-frame transfer is viewed as a stream; the last
+/// CRC_SIZE_BYTES bytes of the stream are held back in the session because they may turn out to be the CRC, and are
+/// delivered together with the next frame. payload_size counts the bytes delivered and total_payload_size the bytes
+/// received, both excluding the truncation by the extent.
+CANARD_PRIVATE void rxSessionAcceptStreamFrame(CanardInstance* const          ins,
+                                               CanardRxSubscription* const    subscription,
+                                               CanardInternalRxSession* const rxs,
+                                               const RxFrameModel* const      frame);
+CANARD_PRIVATE void rxSessionAcceptStreamFrame(CanardInstance* const          ins,
+                                               CanardRxSubscription* const    subscription,
+                                               CanardInternalRxSession* const rxs,
+                                               const RxFrameModel* const      frame)
+{
+    CANARD_ASSERT(ins != NULL);
+    CANARD_ASSERT(rxs != NULL);
+    CANARD_ASSERT(frame != NULL);
+    CANARD_ASSERT(frame->payload != NULL);
+
+    if (frame->start_of_transfer)  // The transfer timestamp is the timestamp of its first frame.
+    {
+        rxs->transfer_timestamp_usec = (RxSessionTimestamp) frame->timestamp_usec;
+    }
+    const bool single_frame = frame->start_of_transfer && frame->end_of_transfer;
+    if (!single_frame)
+    {
+        rxs->calculated_crc = crcAdd(rxs->calculated_crc, frame->payload_size, frame->payload);
+    }
+
+    CanardTransfer chunk;
+    rxInitTransferFromFrame(frame, &chunk);
+    chunk.timestamp_usec = rxSessionGetTransferTimestamp(rxs, frame->timestamp_usec);
+
+    // The stream positions: [from, received) are held back, [received, total) is the frame, [to, total) is kept.
+    // Once the position saturates, it is beyond the extent, so there is nothing to deliver; only the CRC matters.
+    const size_t received = rxs->total_payload_size;
+    if (received < RX_SESSION_SIZE_MAX)
+    {
+        const size_t   total   = ((RX_SESSION_SIZE_MAX - received) > frame->payload_size)
+                                     ? (received + frame->payload_size)
+                                     : RX_SESSION_SIZE_MAX;
+        const size_t   from    = rxs->payload_size;
+        const size_t   keep    = single_frame ? 0U : ((total < CRC_SIZE_BYTES) ? total : CRC_SIZE_BYTES);
+        const size_t   to      = total - keep;
+        const uint8_t* payload = (const uint8_t*) frame->payload;
+        CANARD_ASSERT((from <= received) && ((received - from) <= CRC_SIZE_BYTES) && (to >= from));
+
+        const size_t held = ((to < received) ? to : received) - from;
+        rxStreamDeliver(ins, subscription, &chunk, from, held, &rxs->stream_holdback[0]);
+        if (to > received)
+        {
+            rxStreamDeliver(ins, subscription, &chunk, received, to - received, payload);
+        }
+        // The new holdback is the tail of the stream, which may include the old holdback if the frame is short.
+        uint8_t holdback[CRC_SIZE_BYTES] = {0};
+        for (size_t i = 0U; i < keep; i++)
+        {
+            const size_t pos = to + i;
+            holdback[i]      = (pos < received) ? rxs->stream_holdback[pos - from] : payload[pos - received];
+        }
+        (void) memcpy(&rxs->stream_holdback[0], &holdback[0], sizeof(holdback));  // NOLINT
+        rxs->payload_size       = (RxSessionSize) to;
+        rxs->total_payload_size = (RxSessionSize) total;
+    }
+
+    if (frame->end_of_transfer)
+    {
+        const bool valid = single_frame || (CRC_RESIDUE == rxs->calculated_crc);
+        if (valid)
+        {
+            CANARD_TRACE(rx_transfer,
+                         frame->port_id,
+                         frame->source_node_id,
+                         frame->transfer_id,
+                         rxs->payload_size,
+                         chunk.timestamp_usec,
+                         frame->timestamp_usec);
+        }
+        else
+        {
+            CANARD_TRACE(rx_crc_error,
+                         frame->port_id,
+                         frame->source_node_id,
+                         frame->transfer_id,
+                         rxs->total_payload_size);
+        }
+        if (rxs->payload_size > subscription->_extent)
+        {
+            rxs->payload_size = (RxSessionSize) subscription->_extent;  // Report the amount actually delivered.
+        }
+        rxStreamConclude(ins, subscription, rxs, frame, valid ? CanardRxStreamEventCommit : CanardRxStreamEventAbort);
+        rxSessionRestart(ins, rxs);
+    }
+    else
+    {
+        rxs->toggle = !rxs->toggle;
+    }
+}
+
 /// RX session state machine update is the most intricate part of any UAVCAN transport implementation.
 /// The state model used here is derived from the reference pseudocode given in the original UAVCAN v0 specification.
 /// The UAVCAN/CAN v1 specification, which this library is an implementation of, does not provide any reference
@@ -784,29 +1311,28 @@ CANARD_PRIVATE int8_t rxSessionAcceptFrame(CanardInstance* const          ins,
 /// advantageous because it allows implementers to choose whatever solution works best for the specific application at
 /// hand, while the wire compatibility is still guaranteed by the high-level requirements given in the specification.
 CANARD_PRIVATE int8_t rxSessionUpdate(CanardInstance* const          ins,
+                                      CanardRxSubscription* const    subscription,
                                       CanardInternalRxSession* const rxs,
                                       const RxFrameModel* const      frame,
                                       const uint8_t                  redundant_transport_index,
-                                      const CanardMicrosecond        transfer_id_timeout_usec,
-                                      const size_t                   extent,
                                       CanardTransfer* const          out_transfer);
 CANARD_PRIVATE int8_t rxSessionUpdate(CanardInstance* const          ins,
+                                      CanardRxSubscription* const    subscription,
                                       CanardInternalRxSession* const rxs,
                                       const RxFrameModel* const      frame,
                                       const uint8_t                  redundant_transport_index,
-                                      const CanardMicrosecond        transfer_id_timeout_usec,
-                                      const size_t                   extent,
                                       CanardTransfer* const          out_transfer)
 {
     CANARD_ASSERT(ins != NULL);
+    CANARD_ASSERT(subscription != NULL);
     CANARD_ASSERT(rxs != NULL);
     CANARD_ASSERT(frame != NULL);
     CANARD_ASSERT(out_transfer != NULL);
     CANARD_ASSERT(rxs->transfer_id <= CANARD_TRANSFER_ID_MAX);
     CANARD_ASSERT(frame->transfer_id <= CANARD_TRANSFER_ID_MAX);
 
-    const bool tid_timed_out = (frame->timestamp_usec > rxs->transfer_timestamp_usec) &&
-                               ((frame->timestamp_usec - rxs->transfer_timestamp_usec) > transfer_id_timeout_usec);
+    const bool tid_timed_out =
+        rxSessionGetElapsed(rxs, frame->timestamp_usec) > subscription->_transfer_id_timeout_usec;
 
     const bool not_previous_tid = rxComputeTransferIDDifference(rxs->transfer_id, frame->transfer_id) > 1;
 
@@ -815,6 +1341,16 @@ CANARD_PRIVATE int8_t rxSessionUpdate(CanardInstance* const          ins,
 
     if (need_restart)
     {
+        CANARD_TRACE(rx_session_restart,
+                     frame->port_id,
+                     frame->source_node_id,
+                     rxs->transfer_id,
+                     frame->transfer_id,
+                     tid_timed_out);
+        if ((subscription->_stream_handler != NULL) && (rxs->total_payload_size > 0U))
+        {
+            rxStreamConclude(ins, subscription, rxs, frame, CanardRxStreamEventAbort);
+        }
         rxs->total_payload_size        = 0U;
         rxs->payload_size              = 0U;
         rxs->calculated_crc            = CRC_INITIAL;
@@ -833,9 +1369,13 @@ CANARD_PRIVATE int8_t rxSessionUpdate(CanardInstance* const          ins,
         const bool correct_transport = (rxs->redundant_transport_index == redundant_transport_index);
         const bool correct_toggle    = (frame->toggle == rxs->toggle);
         const bool correct_tid       = (frame->transfer_id == rxs->transfer_id);
-        if (correct_transport && correct_toggle && correct_tid)
+        if (correct_transport && correct_toggle && correct_tid && (subscription->_stream_handler != NULL))
+        {
+            rxSessionAcceptStreamFrame(ins, subscription, rxs, frame);
+        }
+        else if (correct_transport && correct_toggle && correct_tid)
         {
-            out = rxSessionAcceptFrame(ins, rxs, frame, extent, out_transfer);
+            out = rxSessionAcceptFrame(ins, rxs, frame, subscription->_extent, out_transfer);
         }
     }
     return out;
@@ -873,7 +1413,7 @@ CANARD_PRIVATE int8_t rxAcceptFrame(CanardInstance* const       ins,
             subscription->_sessions[frame->source_node_id] = rxs;
             if (rxs != NULL)
             {
-                rxs->transfer_timestamp_usec   = frame->timestamp_usec;
+                rxs->transfer_timestamp_usec   = (RxSessionTimestamp) frame->timestamp_usec;
                 rxs->total_payload_size        = 0U;
                 rxs->payload_size              = 0U;
                 rxs->payload                   = NULL;
@@ -884,6 +1424,11 @@ CANARD_PRIVATE int8_t rxAcceptFrame(CanardInstance* const       ins,
             }
             else
             {
+                CANARD_TRACE(rx_oom,
+                             frame->port_id,
+                             frame->source_node_id,
+                             frame->transfer_id,
+                             sizeof(CanardInternalRxSession));
                 out = -CANARD_ERROR_OUT_OF_MEMORY;
             }
         }
@@ -892,11 +1437,10 @@ CANARD_PRIVATE int8_t rxAcceptFrame(CanardInstance* const       ins,
         {
             CANARD_ASSERT(out == 0);
             out = rxSessionUpdate(ins,
+                                  subscription,
                                   subscription->_sessions[frame->source_node_id],
                                   frame,
                                   redundant_transport_index,
-                                  subscription->_transfer_id_timeout_usec,
-                                  subscription->_extent,
                                   out_transfer);
         }
     }
@@ -908,20 +1452,34 @@ CANARD_PRIVATE int8_t rxAcceptFrame(CanardInstance* const       ins,
         // independent of the input data and the memory shall be free-able.
         const size_t payload_size =
             (subscription->_extent < frame->payload_size) ? subscription->_extent : frame->payload_size;
-        void* const payload = ins->memory_allocate(ins, payload_size);
-        if (payload != NULL)
+        if (subscription->_stream_handler != NULL)
         {
-            rxInitTransferFromFrame(frame, out_transfer);
-            out_transfer->payload_size = payload_size;
-            out_transfer->payload      = payload;
-            // Clang-Tidy raises an error recommending the use of memcpy_s() instead.
-            // We ignore it because the safe functions are poorly supported; reliance on them may limit the portability.
-            (void) memcpy(payload, frame->payload, payload_size);  // NOLINT
-            out = 1;
+            // A streaming subscription needs no storage: the single frame is the whole transfer.
+            CanardTransfer transfer;
+            rxInitTransferFromFrame(frame, &transfer);
+            rxStreamDeliver(ins, subscription, &transfer, 0U, payload_size, (const uint8_t*) frame->payload);
+            transfer.payload_size = 0U;
+            transfer.payload      = NULL;
+            subscription->_stream_handler(ins, subscription, CanardRxStreamEventCommit, &transfer, payload_size);
         }
         else
         {
-            out = -CANARD_ERROR_OUT_OF_MEMORY;
+            void* const payload = ins->memory_allocate(ins, payload_size);
+            if (payload != NULL)
+            {
+                rxInitTransferFromFrame(frame, out_transfer);
+                out_transfer->payload_size = payload_size;
+                out_transfer->payload      = payload;
+                // Clang-Tidy raises an error recommending the use of memcpy_s() instead.
+                // We ignore it because the safe functions are poorly supported; reliance on them may limit the
+                // portability.
+                (void) memcpy(payload, frame->payload, payload_size);  // NOLINT
+                out = 1;
+            }
+            else
+            {
+                out = -CANARD_ERROR_OUT_OF_MEMORY;
+            }
         }
     }
     return out;
@@ -946,54 +1504,96 @@ CanardInstance canardInit(const CanardMemoryAllocate memory_allocate, const Cana
     CANARD_ASSERT(memory_allocate != NULL);
     CANARD_ASSERT(memory_free != NULL);
     const CanardInstance out = {
-        .user_reference    = NULL,
-        .mtu_bytes         = CANARD_MTU_CAN_FD,
-        .node_id           = CANARD_NODE_ID_UNSET,
-        .memory_allocate   = memory_allocate,
-        .memory_free       = memory_free,
-        ._rx_subscriptions = {NULL, NULL, NULL},
-        ._tx_queue         = NULL,
+        .user_reference      = NULL,
+        .mtu_bytes           = CANARD_MTU_CAN_FD,
+        .tx_segmentation     = CanardTxSegmentationMaximizeFrameSize,
+        .tx_fd_bitrate_ratio = CANARD_CONFIG_TX_FD_BITRATE_RATIO,
+        .node_id             = CANARD_NODE_ID_UNSET,
+        .memory_allocate     = memory_allocate,
+        .memory_free         = memory_free,
+        ._rx_subscriptions   = {NULL, NULL, NULL},
+        ._tx_queue           = NULL,
+        ._tx_queue_size      = 0U,
     };
     return out;
 }
 
 int32_t canardTxPush(CanardInstance* const ins, const CanardTransfer* const transfer)
+{
+    return txPush(ins, transfer, (ins != NULL) ? ins->mtu_bytes : 0U, false);
+}
+
+int32_t canardTxPushLazy(CanardInstance* const ins, const CanardTransfer* const transfer)
+{
+    return txPush(ins, transfer, (ins != NULL) ? ins->mtu_bytes : 0U, true);
+}
+
+int32_t canardTxPushMTU(CanardInstance* const ins, const CanardTransfer* const transfer, const size_t mtu_bytes)
+{
+    return txPush(ins, transfer, mtu_bytes, false);
+}
+
+int32_t canardTxPushLazyMTU(CanardInstance* const ins, const CanardTransfer* const transfer, const size_t mtu_bytes)
+{
+    return txPush(ins, transfer, mtu_bytes, true);
+}
+
+/// True if the frame is a valid single-frame transfer, which canardTxPushFrame() accepts.
+CANARD_PRIVATE bool txIsValidSingleFrame(const CanardFrame* const frame);
+CANARD_PRIVATE bool txIsValidSingleFrame(const CanardFrame* const frame)
+{
+    RxFrameModel model = {0};
+    return (frame->extended_can_id <= CAN_EXT_ID_MASK) && (frame->payload_size <= CANARD_MTU_CAN_XL) &&
+           rxTryParseFrame(frame, &model) && model.start_of_transfer && model.end_of_transfer;
+}
+
+/// The common part of canardTxPushFrame() and canardTxPushFrameUnchecked(); the frame is valid. The trace arguments
+/// are taken from the CAN ID and the tail byte directly, so that the frame is not parsed again.
+CANARD_PRIVATE int32_t txPushFrame(CanardInstance* const ins, const CanardFrame* const frame);
+CANARD_PRIVATE int32_t txPushFrame(CanardInstance* const ins, const CanardFrame* const frame)
+{
+    int32_t                          out = -CANARD_ERROR_OUT_OF_MEMORY;
+    CanardInternalTxQueueItem* const tqi =
+        txAllocateQueueItem(ins, frame->extended_can_id, frame->timestamp_usec, frame->payload_size);
+    if (tqi != NULL)
+    {
+        // Clang-Tidy raises an error recommending the use of memcpy_s() instead.
+        // We ignore it because the safe functions are poorly supported; reliance on them may limit the portability.
+        (void) memcpy(&tqi->payload_buffer[0], frame->payload, frame->payload_size);  // NOLINT
+        txEnqueue(ins, tqi, tqi, 1U);
+        out = 1;
+    }
+    CANARD_TRACE(tx_push,
+                 ((frame->extended_can_id & FLAG_SERVICE_NOT_MESSAGE) != 0)
+                     ? ((frame->extended_can_id >> OFFSET_SERVICE_ID) & CANARD_SERVICE_ID_MAX)
+                     : ((frame->extended_can_id >> OFFSET_SUBJECT_ID) & CANARD_SUBJECT_ID_MAX),
+                 ((frame->extended_can_id & FLAG_SERVICE_NOT_MESSAGE) != 0)
+                     ? ((frame->extended_can_id >> OFFSET_DST_NODE_ID) & CANARD_NODE_ID_MAX)
+                     : CANARD_NODE_ID_UNSET,
+                 ((const uint8_t*) frame->payload)[frame->payload_size - 1U] & CANARD_TRANSFER_ID_MAX,
+                 frame->payload_size - 1U,
+                 frame->timestamp_usec,
+                 out);
+    return out;
+}
+
+int32_t canardTxPushFrame(CanardInstance* const ins, const CanardFrame* const frame)
 {
     int32_t out = -CANARD_ERROR_INVALID_ARGUMENT;
-    if ((ins != NULL) && (transfer != NULL) && ((transfer->payload != NULL) || (0U == transfer->payload_size)))
+    if ((ins != NULL) && (frame != NULL) && txIsValidSingleFrame(frame))
     {
-        const size_t  pl_mtu       = txGetPresentationLayerMTU(ins);
-        const int32_t maybe_can_id = txMakeCANID(transfer, ins->node_id, pl_mtu);
-        if (maybe_can_id >= 0)
-        {
-            if (transfer->payload_size <= pl_mtu)
-            {
-                out = txPushSingleFrame(ins,
-                                        transfer->timestamp_usec,
-                                        (uint32_t) maybe_can_id,
-                                        transfer->transfer_id,
-                                        transfer->payload_size,
-                                        transfer->payload);
-            }
-            else
-            {
-                out = txPushMultiFrame(ins,
-                                       pl_mtu,
-                                       transfer->timestamp_usec,
-                                       (uint32_t) maybe_can_id,
-                                       transfer->transfer_id,
-                                       transfer->payload_size,
-                                       transfer->payload);
-            }
-        }
-        else
-        {
-            out = maybe_can_id;
-        }
+        out = txPushFrame(ins, frame);
     }
     return out;
 }
 
+int32_t canardTxPushFrameUnchecked(CanardInstance* const ins, const CanardFrame* const frame)
+{
+    CANARD_ASSERT((ins != NULL) && (frame != NULL));
+    CANARD_ASSERT(txIsValidSingleFrame(frame));
+    return txPushFrame(ins, frame);
+}
+
 const CanardFrame* canardTxPeek(const CanardInstance* const ins)
 {
     const CanardFrame* out = NULL;
@@ -1011,12 +1611,30 @@ const CanardFrame* canardTxPeek(const CanardInstance* const ins)
     return out;
 }
 
+size_t canardTxGetQueueSize(const CanardInstance* const ins)
+{
+    return (ins != NULL) ? ins->_tx_queue_size : 0U;
+}
+
 void canardTxPop(CanardInstance* const ins)
 {
     if ((ins != NULL) && (ins->_tx_queue != NULL))
     {
-        // The memory is NOT deallocated. The application is responsible for that.
-        ins->_tx_queue = ins->_tx_queue->next;
+        // The memory is NOT deallocated. The application is responsible for that. If the frame belongs to a lazy
+        // transfer, the next frame of the transfer is allocated and takes its place at the top of the queue.
+        CANARD_TRACE(tx_pop,
+                     ins->_tx_queue->frame.extended_can_id,
+                     ins->_tx_queue->frame.payload_size,
+                     ins->_tx_queue->payload_buffer[ins->_tx_queue->frame.payload_size - 1U],  // The tail byte.
+                     ins->_tx_queue->frame.timestamp_usec);
+        CanardInternalTxQueueItem* const top = ins->_tx_queue;
+        ins->_tx_queue                       = top->next;
+        CANARD_ASSERT(ins->_tx_queue_size > 0U);
+        ins->_tx_queue_size--;
+        if (top->lazy != NULL)
+        {
+            txContinueLazy(ins, top);
+        }
     }
 }
 
@@ -1077,7 +1695,8 @@ int8_t canardRxSubscribe(CanardInstance* const       ins,
 {
     int8_t       out = -CANARD_ERROR_INVALID_ARGUMENT;
     const size_t tk  = (size_t) transfer_kind;
-    if ((ins != NULL) && (out_subscription != NULL) && (tk < CANARD_NUM_TRANSFER_KINDS))
+    if ((ins != NULL) && (out_subscription != NULL) && (tk < CANARD_NUM_TRANSFER_KINDS) &&
+        (extent <= RX_SESSION_EXTENT_MAX) && (transfer_id_timeout_usec <= RX_SESSION_TIMEOUT_MAX_USEC))
     {
         // Reset to the initial state. This is absolutely critical because the new payload size limit may be larger
         // than the old value; if there are any payload buffers allocated, we may overrun them because they are shorter
@@ -1095,6 +1714,8 @@ int8_t canardRxSubscribe(CanardInstance* const       ins,
             out_subscription->_transfer_id_timeout_usec = transfer_id_timeout_usec;
             out_subscription->_extent                   = extent;
             out_subscription->_port_id                  = port_id;
+            out_subscription->_stream_handler           = NULL;
+            out_subscription->user_reference            = NULL;
             out_subscription->_next                     = ins->_rx_subscriptions[tk];
             ins->_rx_subscriptions[tk]                  = out_subscription;
             out                                         = (out > 0) ? 0 : 1;
@@ -1103,6 +1724,26 @@ int8_t canardRxSubscribe(CanardInstance* const       ins,
     return out;
 }
 
+int8_t canardRxSubscribeStream(CanardInstance* const       ins,
+                               const CanardTransferKind    transfer_kind,
+                               const CanardPortID          port_id,
+                               const size_t                extent,
+                               const CanardMicrosecond     transfer_id_timeout_usec,
+                               const CanardRxStreamHandler handler,
+                               CanardRxSubscription* const out_subscription)
+{
+    int8_t out = -CANARD_ERROR_INVALID_ARGUMENT;
+    if (handler != NULL)
+    {
+        out = canardRxSubscribe(ins, transfer_kind, port_id, extent, transfer_id_timeout_usec, out_subscription);
+        if (out >= 0)
+        {
+            out_subscription->_stream_handler = handler;
+        }
+    }
+    return out;
+}
+
 int8_t canardRxUnsubscribe(CanardInstance* const    ins,
                            const CanardTransferKind transfer_kind,
                            const CanardPortID       port_id)
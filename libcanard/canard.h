@@ -129,6 +129,13 @@ extern "C" {
 #define CANARD_MTU_CAN_CLASSIC 8U
 #define CANARD_MTU_CAN_FD 64U
 
+/// CAN XL frames carry 1 to 2048 bytes with a byte granularity (there is no DLC quantization); it is not covered by
+/// the UAVCAN/CAN Specification. The frames that fit into the CAN FD MTU are emitted as CAN FD frames as usual, so
+/// only the transfers that are larger than that are affected. Every CAN XL frame still carries the tail byte, and the
+/// multi-frame transfers the transfer CRC, so the transport layer is unchanged; how the 29-bit CAN ID is carried by
+/// a CAN XL frame is up to the media layer (see socketcanPush()).
+#define CANARD_MTU_CAN_XL 2048U
+
 /// Parameter ranges are inclusive; the lower bound is zero for all. See UAVCAN/CAN Specification for background.
 #define CANARD_SUBJECT_ID_MAX 8191U
 #define CANARD_SERVICE_ID_MAX 511U
@@ -146,11 +153,12 @@ extern "C" {
 #define CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC 2000000UL
 
 // Forward declarations.
-typedef struct CanardInstance CanardInstance;
-typedef uint64_t              CanardMicrosecond;
-typedef uint16_t              CanardPortID;
-typedef uint8_t               CanardNodeID;
-typedef uint8_t               CanardTransferID;
+typedef struct CanardInstance       CanardInstance;
+typedef struct CanardRxSubscription CanardRxSubscription;
+typedef uint64_t                    CanardMicrosecond;
+typedef uint16_t                    CanardPortID;
+typedef uint8_t                     CanardNodeID;
+typedef uint8_t                     CanardTransferID;
 
 /// Transfer priority level mnemonics per the recommendations given in the UAVCAN Specification.
 typedef enum
@@ -258,6 +266,31 @@ typedef struct
     const void* payload;
 } CanardTransfer;
 
+/// The events delivered to the handler of a streaming subscription, see canardRxSubscribeStream().
+typedef enum
+{
+    /// A chunk of the transfer payload. The chunks of a transfer are delivered in order without gaps; the transfer
+    /// is not validated yet, so the application shall not act upon the data until the transfer is committed.
+    CanardRxStreamEventData = 0,
+
+    /// The transfer is complete and its CRC is valid. No data is delivered with this event.
+    CanardRxStreamEventCommit = 1,
+
+    /// The transfer is abandoned: its CRC is invalid, or a frame was lost and the session was restarted.
+    /// The data delivered for it so far shall be discarded. No data is delivered with this event.
+    CanardRxStreamEventAbort = 2,
+} CanardRxStreamEvent;
+
+/// The handler of a streaming subscription. The transfer argument describes the transfer the event belongs to;
+/// for CanardRxStreamEventData, its payload points to the chunk and offset is the position of the chunk within
+/// the transfer payload; for the other events, the payload is NULL and offset equals the amount of data delivered.
+/// The payload pointer is only valid until the handler returns. The handler shall not modify the subscriptions.
+typedef void (*CanardRxStreamHandler)(CanardInstance*       ins,
+                                      CanardRxSubscription* subscription,
+                                      CanardRxStreamEvent   event,
+                                      const CanardTransfer* transfer,
+                                      size_t                offset);
+
 /// Transfer subscription state. The application can register its interest in a particular kind of data exchanged
 /// over the bus by creating such subscription objects. Frames that carry data for which there is no active
 /// subscription will be silently dropped by the library.
@@ -269,7 +302,7 @@ typedef struct
 ///
 /// The memory footprint of a subscription is large. On a 32-bit platform it slightly exceeds half a KiB.
 /// This is an intentional time-memory trade-off: use a large look-up table to ensure predictable temporal properties.
-typedef struct CanardRxSubscription
+struct CanardRxSubscription
 {
     struct CanardRxSubscription* _next;  ///< Internal use only.
 
@@ -288,10 +321,15 @@ typedef struct CanardRxSubscription
     /// but more memory-efficient approach.
     struct CanardInternalRxSession* _sessions[CANARD_NODE_ID_MAX + 1U];
 
-    CanardMicrosecond _transfer_id_timeout_usec;  ///< Internal use only.
-    size_t            _extent;                    ///< Internal use only.
-    CanardPortID      _port_id;                   ///< Internal use only.
-} CanardRxSubscription;
+    CanardMicrosecond     _transfer_id_timeout_usec;  ///< Internal use only.
+    size_t                _extent;                    ///< Internal use only.
+    CanardPortID          _port_id;                   ///< Internal use only.
+    CanardRxStreamHandler _stream_handler;            ///< Internal use only. NULL unless streaming.
+
+    /// User pointer that can link this subscription with other objects, e.g., for the streaming handler.
+    /// It is set to NULL when the subscription is created; the application may change it afterwards at any time.
+    void* user_reference;
+};
 
 /// A pointer to the memory allocation function. The semantics are similar to malloc():
 ///     - The returned pointer shall point to an uninitialized block of memory that is at least "amount" bytes large.
@@ -310,6 +348,22 @@ typedef void* (*CanardMemoryAllocate)(CanardInstance* ins, size_t amount);
 ///     - The execution time should be constant (O(1)).
 typedef void (*CanardMemoryFree)(CanardInstance* ins, void* pointer);
 
+/// Segmentation policies for multi-frame transfers. See canardTxPush().
+typedef enum
+{
+    /// Every frame except the last one carries as many bytes as the MTU allows; the last frame is padded up to the
+    /// nearest valid DLC. This is the default policy; it minimizes the number of frames.
+    CanardTxSegmentationMaximizeFrameSize = 0,
+
+    /// The MTU of each multi-frame transfer is chosen among the valid DLC lengths not exceeding the instance MTU so
+    /// that the estimated bus time of the transfer is minimized. The non-last frames still utilize the chosen MTU
+    /// fully as required by the specification, so the only degree of freedom is the frame size; a smaller one may
+    /// trade the padding of the last frame (up to 15 bytes with CAN FD) for an extra frame. This is only beneficial
+    /// if the data phase is not much faster than the arbitration phase; see CanardInstance.tx_fd_bitrate_ratio.
+    /// With Classic CAN and CAN XL, this policy is equivalent to the default one.
+    CanardTxSegmentationMinimizeBusTime = 1,
+} CanardTxSegmentation;
+
 /// This is the core structure that keeps all of the states and allocated resources of the library instance.
 /// The application may directly alter the fields whose names do not begin with an underscore.
 struct CanardInstance
@@ -326,10 +380,23 @@ struct CanardInstance
     /// Only the standard values should be used as recommended by the specification;
     /// otherwise, networking interoperability issues may arise. See recommended values CANARD_MTU_*.
     ///
-    /// Valid values are any valid CAN frame data length value not smaller than 8.
-    /// Invalid values are treated as the nearest valid value. The default is the maximum valid value.
+    /// Valid values are any valid CAN frame data length value not smaller than 8; above CANARD_MTU_CAN_FD, any value
+    /// up to CANARD_MTU_CAN_XL selects CAN XL. Invalid values are treated as the nearest valid value.
+    /// The default is CANARD_MTU_CAN_FD.
     size_t mtu_bytes;
 
+    /// The segmentation policy for multi-frame transfers. The value can be changed arbitrarily at any time.
+    /// The default is CanardTxSegmentationMaximizeFrameSize.
+    CanardTxSegmentation tx_segmentation;
+
+    /// The ratio of the CAN FD data phase bit rate to the nominal bit rate of the bus, rounded down, as assumed by the
+    /// bus time estimation of CanardTxSegmentationMinimizeBusTime. Higher ratios make the per-frame overhead relatively
+    /// more expensive, so that the padding of the last frame is less likely to be worth an extra frame; a ratio lower
+    /// than that of the bus makes the policy add frames that cost more than the padding they save. One means no bit
+    /// rate switching. The value can be changed arbitrarily at any time.
+    /// The default is CANARD_CONFIG_TX_FD_BITRATE_RATIO, which is 1 unless overridden at build time.
+    uint32_t tx_fd_bitrate_ratio;
+
     /// The node-ID of the local node.
     /// Per the UAVCAN Specification, the node-ID should not be assigned more than once.
     /// Invalid values are treated as CANARD_NODE_ID_UNSET. The default value is CANARD_NODE_ID_UNSET.
@@ -340,8 +407,10 @@ struct CanardInstance
     /// The time complexity models given in the API documentation are made on the assumption that the memory management
     /// functions have constant complexity O(1).
     ///
-    /// The following API functions may allocate memory:   canardRxAccept(), canardTxPush().
-    /// The following API functions may deallocate memory: canardRxAccept(), canardRxSubscribe(), canardRxUnsubscribe().
+    /// The following API functions may allocate memory:   canardRxAccept(), canardTxPush(), canardTxPushLazy(),
+    ///                                                     canardTxPushFrame(), canardTxPop() (lazy transfers only).
+    /// The following API functions may deallocate memory: canardRxAccept(), canardRxSubscribe(), canardRxUnsubscribe(),
+    ///                                                     canardTxPushLazy(), canardTxPop() (lazy transfers only).
     /// The exact memory requirement and usage model is specified for each function in its documentation.
     CanardMemoryAllocate memory_allocate;
     CanardMemoryFree     memory_free;
@@ -349,6 +418,7 @@ struct CanardInstance
     /// These fields are for internal use only. Do not access from the application.
     CanardRxSubscription*             _rx_subscriptions[CANARD_NUM_TRANSFER_KINDS];
     struct CanardInternalTxQueueItem* _tx_queue;
+    size_t                            _tx_queue_size;
 };
 
 /// Construct a new library instance.
@@ -373,7 +443,8 @@ CanardInstance canardInit(const CanardMemoryAllocate memory_allocate, const Cana
 ///
 /// The MTU of the generated frames is dependent on the value of the MTU setting at the time when this function
 /// is invoked. The MTU setting can be changed arbitrarily between invocations. No other functions rely on that
-/// parameter.
+/// parameter. The same holds for the segmentation policy, which defines how the frame size of multi-frame transfers
+/// is chosen within the MTU.
 ///
 /// The timestamp value of the transfer will be used to populate the timestamp values of the resulting transport
 /// frames (so all frames will have the same timestamp value). This feature is intended to facilitate transmission
@@ -407,9 +478,62 @@ CanardInstance canardInit(const CanardMemoryAllocate memory_allocate, const Cana
 ///
 /// The memory allocation requirement is one allocation per transport frame. A single-frame transfer takes one
 /// allocation; a multi-frame transfer of N frames takes N allocations. The maximum size of each allocation is
-/// (sizeof(CanardFrame) + sizeof(void*) + MTU).
+/// (sizeof(CanardFrame) + 2 * sizeof(void*) + MTU).
 int32_t canardTxPush(CanardInstance* const ins, const CanardTransfer* const transfer);
 
+/// This function is like canardTxPush() except that the frames of a multi-frame transfer are produced on demand
+/// rather than all at once. Only the first frame is enqueued; each time a frame of the transfer is removed from the
+/// queue by canardTxPop(), the next one is serialized from the payload and takes its place at the top of the queue.
+/// The transfer CRC is computed as the frames are produced. This is intended for large transfers, such as file
+/// transfers: the queue holds one frame per transfer instead of all of them, and the time complexity of this function
+/// is O(e) instead of O(p+e) (see canardTxPush()). The order of the frames in the queue is the same as with
+/// canardTxPush(). Single-frame transfers are handled exactly as by canardTxPush().
+///
+/// The payload is NOT copied: the application shall keep the payload buffer valid and unchanged until the last frame
+/// of the transfer is removed from the queue. The return value is the number of frames of the transfer, which is the
+/// number of times canardTxPop() shall be invoked to remove them all, as with canardTxPush().
+///
+/// The memory allocation requirement is two allocations per multi-frame transfer at the time of this call: the first
+/// frame, as with canardTxPush(), and the serialization state, whose size is below 64 bytes on conventional platforms;
+/// the latter is freed automatically once the last frame is produced. canardTxPop() allocates each following frame.
+int32_t canardTxPushLazy(CanardInstance* const ins, const CanardTransfer* const transfer);
+
+/// These functions are like canardTxPush() and canardTxPushLazy() except that the MTU of the transfer is given by the
+/// argument instead of CanardInstance.mtu_bytes, which is not accessed; the same values are valid. This allows
+/// transfers of different MTU (e.g., Classic CAN messages for legacy listeners and large CAN FD transfers) to share
+/// one instance without changing its state before every push.
+int32_t canardTxPushMTU(CanardInstance* const ins, const CanardTransfer* const transfer, const size_t mtu_bytes);
+int32_t canardTxPushLazyMTU(CanardInstance* const ins, const CanardTransfer* const transfer, const size_t mtu_bytes);
+
+/// This function inserts a copy of a ready-made frame into the prioritized transmission queue, bypassing the
+/// serialization performed by canardTxPush(). It is intended for periodic single-frame transfers: the application
+/// builds the frame once (e.g., takes it from canardTxPeek() after a canardTxPush()), then only patches the payload
+/// bytes, the transfer-ID in the tail byte, and the timestamp (deadline) before each publication. Since a single-frame
+/// transfer carries no CRC, the patched frame remains valid. The payload of an anonymous message cannot be patched
+/// because the pseudo node-ID in its CAN ID is derived from it.
+///
+/// The frame shall be a single-frame transfer (start and end of transfer set in the tail byte) with a valid CAN ID;
+/// otherwise, the invalid argument error is returned. The frame is copied, so the application may modify it at once.
+/// The position of the frame in the queue is the same as if it was pushed by canardTxPush().
+///
+/// Returns 1 (one frame enqueued) on success; otherwise, a negated error code: invalid argument or out-of-memory.
+///
+/// The frame is validated by the parser of the received frames, and its position in the queue is found by the same
+/// linear search as in canardTxPush(); only the serialization is saved. The time complexity is O(e), where e is the
+/// number of frames already enqueued whose CAN ID is not greater than that of the frame.
+/// The memory allocation requirement is one allocation of (sizeof(CanardFrame) + 2 * sizeof(void*) + payload size).
+int32_t canardTxPushFrame(CanardInstance* const ins, const CanardFrame* const frame);
+
+/// This function is like canardTxPushFrame() except that the frame is not validated, which leaves only the memory
+/// allocation, the copy of the payload, and the insertion into the queue. It is intended for the frames that are
+/// known to be valid, e.g., a frame taken from canardTxPeek() and patched as described above, which the application
+/// has validated once when building it. The validity is only checked by CANARD_ASSERT(), i.e., in debug builds; an
+/// invalid frame is undefined behavior otherwise.
+///
+/// Returns 1 (one frame enqueued) on success; otherwise, the negated out-of-memory error code.
+/// The time complexity of the insertion is O(e), the same as in canardTxPushFrame().
+int32_t canardTxPushFrameUnchecked(CanardInstance* const ins, const CanardFrame* const frame);
+
 /// This function accesses the top element of the prioritized transmission queue. The queue itself is not modified
 /// (i.e., the accessed element is not removed). The application should invoke this function to collect the transport
 /// frames of serialized transfers pushed into the prioritized transmission queue by canardTxPush().
@@ -437,6 +561,13 @@ int32_t canardTxPush(CanardInstance* const ins, const CanardTransfer* const tran
 /// The time complexity is constant. This function does not invoke the dynamic memory manager.
 const CanardFrame* canardTxPeek(const CanardInstance* const ins);
 
+/// Returns the number of frames in the transmission queue, or zero if the argument is NULL. A transfer pushed with
+/// canardTxPushLazy() counts as one frame, since its next frame is only produced when the previous one is popped.
+/// This lets the application keep its bulk transfers from flooding the queue.
+///
+/// The time complexity is constant. This function does not invoke the dynamic memory manager.
+size_t canardTxGetQueueSize(const CanardInstance* const ins);
+
 /// This function transfers the ownership of the top element of the prioritized transmission queue to the application.
 /// The application should invoke this function to remove the top element from the prioritized transmission queue.
 /// The element is removed but it is not invalidated; it is the responsibility of the application to deallocate
@@ -449,7 +580,12 @@ const CanardFrame* canardTxPeek(const CanardInstance* const ins);
 ///
 /// If the input argument is NULL or if the transmission queue is empty, the function has no effect.
 ///
-/// The time complexity is constant. This function does not invoke the dynamic memory manager.
+/// If the removed frame belongs to a transfer pushed with canardTxPushLazy() and is not its last frame, the next frame
+/// of the transfer is serialized into a new allocation and placed at the top of the queue; if the memory is exhausted,
+/// the rest of the transfer is dropped (the receivers discard the incomplete transfer).
+///
+/// The time complexity is constant except for the serialization of the next frame of a lazy transfer, which is O(MTU).
+/// This function does not invoke the dynamic memory manager except for lazy transfers.
 void canardTxPop(CanardInstance* const ins);
 
 /// This function implements the transfer reassembly logic. It accepts a transport frame, locates the appropriate
@@ -561,6 +697,9 @@ int8_t canardRxAccept(CanardInstance* const    ins,
 /// Transfers that carry payloads that exceed the specified extent will be accepted anyway but the excess payload
 /// will be truncated away, as mandated by the Specification. The transfer CRC is always validated regardless of
 /// whether its payload is truncated.
+/// If the library is built with CANARD_CONFIG_COMPACT_RX_SESSION, the extent shall not exceed UINT16_MAX - 2 (so that
+/// the CRC of the longest transfers is still detected) and the transfer-ID timeout shall not exceed INT32_MAX
+/// microseconds.
 ///
 /// The default transfer-ID timeout value is defined as CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC; use it if not sure.
 /// The redundant transport fail-over timeout (if redundant transports are used) is the same as the transfer-ID timeout.
@@ -589,6 +728,31 @@ int8_t canardRxSubscribe(CanardInstance* const       ins,
                          const CanardMicrosecond     transfer_id_timeout_usec,
                          CanardRxSubscription* const out_subscription);
 
+/// This function is like canardRxSubscribe() except that the transfers are not reassembled in a payload buffer.
+/// Instead, the payload of every in-order frame is passed to the handler as soon as it is accepted, and the transfer
+/// is concluded with a commit or an abort event once its last frame is received (see CanardRxStreamEvent).
+/// This is intended for large transfers, such as file transfers, that the application processes sequentially:
+/// the memory per session is the session state only (no extent-sized buffer is ever allocated), and the application
+/// may begin processing the data before the transfer is complete.
+///
+/// The transfer CRC is computed incrementally as usual. Because the end of a multi-frame transfer is not known until
+/// its last frame is received, the last two bytes received are held back in the session state until more data
+/// arrives, so that the CRC is never delivered as data. Consequently, a chunk may be as short as one byte.
+/// The extent limits the amount of data delivered per transfer (the rest is truncated away as usual); it does not
+/// affect the memory consumption. A transfer in progress when its session is restarted is aborted; no event is
+/// delivered for the transfers in progress when the subscription is terminated.
+///
+/// canardRxAccept() returns zero for the frames that match a streaming subscription; it never allocates memory for
+/// them except for the session state, so it returns an out-of-memory error only if that cannot be allocated.
+/// The handler is invoked from canardRxAccept(). The return values are the same as those of canardRxSubscribe().
+int8_t canardRxSubscribeStream(CanardInstance* const       ins,
+                               const CanardTransferKind    transfer_kind,
+                               const CanardPortID          port_id,
+                               const size_t                extent,
+                               const CanardMicrosecond     transfer_id_timeout_usec,
+                               const CanardRxStreamHandler handler,
+                               CanardRxSubscription* const out_subscription);
+
 /// This function reverses the effect of canardRxSubscribe().
 /// If the subscription is found, all its memory is de-allocated (session states and payload buffers); to determine
 /// the amount of memory freed, please refer to the memory allocation requirement model of canardRxAccept().
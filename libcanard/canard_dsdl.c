@@ -25,9 +25,13 @@
 #endif
 
 /// This macro is needed only for testing and for library development. Do not redefine this in production.
+/// Defining CANARD_CONFIG_INLINE_PRIVATE as true turns the private functions into "static inline", which is useful
+/// mostly for the amalgamated build where the application and the library are compiled as one translation unit.
 #if defined(CANARD_CONFIG_EXPOSE_PRIVATE) && CANARD_CONFIG_EXPOSE_PRIVATE
 #    define CANARD_PRIVATE
-#else  // Consider defining an extra compilation option that turns this into "static inline"?
+#elif defined(CANARD_CONFIG_INLINE_PRIVATE) && CANARD_CONFIG_INLINE_PRIVATE
+#    define CANARD_PRIVATE static inline
+#else
 #    define CANARD_PRIVATE static
 #endif
 
@@ -445,3 +449,66 @@ void canardDSDLSetF64(uint8_t* const buf, const size_t off_bit, const CanardDSDL
 }
 
 #endif  // CANARD_DSDL_PLATFORM_IEEE754_DOUBLE
+
+// --------------------------------------------- PUBLIC API - COMPOSITE ---------------------------------------------
+
+size_t canardDSDLBeginDelimited(const size_t off_bit)
+{
+    CANARD_ASSERT((off_bit % BYTE_WIDTH) == 0U);  // Composites are byte-aligned.
+    return off_bit + CANARD_DSDL_DELIMITER_HEADER_SIZE_BIT;
+}
+
+size_t canardDSDLEndDelimited(uint8_t* const buf, const size_t off_bit, const size_t end_off_bit)
+{
+    CANARD_ASSERT(buf != NULL);
+    CANARD_ASSERT((off_bit % BYTE_WIDTH) == 0U);
+    CANARD_ASSERT(end_off_bit >= (off_bit + CANARD_DSDL_DELIMITER_HEADER_SIZE_BIT));
+    const size_t body_size = ((end_off_bit - off_bit - CANARD_DSDL_DELIMITER_HEADER_SIZE_BIT) + BYTE_WIDTH - 1U) /
+                             BYTE_WIDTH;
+    CANARD_ASSERT(body_size <= UINT32_MAX);
+    canardDSDLSetUxx(buf, off_bit, (uint64_t) body_size, (uint8_t) CANARD_DSDL_DELIMITER_HEADER_SIZE_BIT);
+    return off_bit + CANARD_DSDL_DELIMITER_HEADER_SIZE_BIT + (body_size * BYTE_WIDTH);
+}
+
+int64_t canardDSDLGetDelimited(const uint8_t* const  buf,
+                               const size_t          buf_size,
+                               const size_t          off_bit,
+                               CanardDSDLView* const out_body)
+{
+    int64_t out = -CANARD_DSDL_ERROR_INVALID_ARGUMENT;
+    if ((buf != NULL) && (out_body != NULL) && ((off_bit % BYTE_WIDTH) == 0U))
+    {
+        // The only bounds check of the composite: the fields of the body are read from the view.
+        const size_t body_size =
+            canardDSDLGetU32(buf, buf_size, off_bit, (uint8_t) CANARD_DSDL_DELIMITER_HEADER_SIZE_BIT);
+        const size_t body_off  = chooseMin((off_bit + CANARD_DSDL_DELIMITER_HEADER_SIZE_BIT) / BYTE_WIDTH, buf_size);
+        if (body_size <= (buf_size - body_off))
+        {
+            out_body->data = &buf[body_off];
+            out_body->size = body_size;
+            out            = (int64_t) (off_bit + CANARD_DSDL_DELIMITER_HEADER_SIZE_BIT + (body_size * BYTE_WIDTH));
+        }
+        else
+        {
+            out = -CANARD_DSDL_ERROR_BAD_DELIMITER_HEADER;
+        }
+    }
+    return out;
+}
+
+const uint8_t* canardDSDLViewFix(const CanardDSDLView* const view, const size_t fixed_size, uint8_t* const scratch)
+{
+    CANARD_ASSERT(view != NULL);
+    const uint8_t* out = view->data;
+    if (view->size < fixed_size)
+    {
+        CANARD_ASSERT(scratch != NULL);
+        if (view->size > 0U)
+        {
+            (void) memcpy(scratch, view->data, view->size);
+        }
+        (void) memset(&scratch[view->size], 0, fixed_size - view->size);
+        out = scratch;
+    }
+    return out;
+}
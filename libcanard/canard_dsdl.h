@@ -38,9 +38,24 @@
 extern "C" {
 #endif
 
+/// The composite helpers return these error codes negated.
+#define CANARD_DSDL_ERROR_INVALID_ARGUMENT 2
+#define CANARD_DSDL_ERROR_BAD_DELIMITER_HEADER 3
+
+/// The delimiter header of a delimited composite is a uint32 holding the size of the body in bytes.
+#define CANARD_DSDL_DELIMITER_HEADER_SIZE_BIT 32U
+
 typedef float  CanardDSDLFloat32;
 typedef double CanardDSDLFloat64;
 
+/// A byte-aligned region of a serialized buffer, such as the body of a nested composite. It points into the buffer
+/// it was obtained from; nothing is copied.
+typedef struct CanardDSDLView
+{
+    const uint8_t* data;
+    size_t         size;  ///< In bytes.
+} CanardDSDLView;
+
 /// Copy the specified number of bits from the source buffer into the destination buffer in accordance with the
 /// DSDL bit-level serialization specification. The offsets may be arbitrary (may exceed 8 bits).
 /// If both offsets and the length are byte-aligned, the algorithm degenerates to memcpy().
@@ -106,6 +121,81 @@ CanardDSDLFloat32 canardDSDLGetF16(const uint8_t* const buf, const size_t buf_si
 CanardDSDLFloat32 canardDSDLGetF32(const uint8_t* const buf, const size_t buf_size, const size_t off_bit);
 CanardDSDLFloat64 canardDSDLGetF64(const uint8_t* const buf, const size_t buf_size, const size_t off_bit);
 
+/// Define a read-only accessor of a field of a serialized composite: a static inline function with the given name that
+/// takes a CanardDSDLView of the composite and decodes the field from it on every invocation. Nothing is decoded until
+/// the accessor is invoked, so a consumer that needs one field of a large message pays for that field only; since the
+/// offset and the length are constants, the compiler reduces the accessor to a single bounds check and load.
+/// The fields beyond the end of the view read as zeros per the IZER, so the accessors also work on the truncated or
+/// older versions of an extensible type. Example:
+///
+///     CANARD_DSDL_VIEW_INTEGER(rangeGetTimestamp, uint64_t, canardDSDLGetU64, 0U, 56U)
+///     CANARD_DSDL_VIEW_FLOAT(rangeGetMeters, CanardDSDLFloat32, canardDSDLGetF32, 56U)
+///     ...
+///     const CanardDSDLView view = {(const uint8_t*) transfer.payload, transfer.payload_size};
+///     const CanardDSDLFloat32 meters = rangeGetMeters(view);
+#define CANARD_DSDL_VIEW_BIT(name, off_bit)                      \
+    static inline bool name(const CanardDSDLView view)           \
+    {                                                            \
+        return canardDSDLGetBit(view.data, view.size, (off_bit)); \
+    }
+#define CANARD_DSDL_VIEW_INTEGER(name, type, getter, off_bit, len_bit)       \
+    static inline type name(const CanardDSDLView view)                       \
+    {                                                                        \
+        return getter(view.data, view.size, (off_bit), (uint8_t) (len_bit)); \
+    }
+#define CANARD_DSDL_VIEW_FLOAT(name, type, getter, off_bit) \
+    static inline type name(const CanardDSDLView view)      \
+    {                                                       \
+        return getter(view.data, view.size, (off_bit));     \
+    }
+/// The view of a nested sealed composite of the given size located at the given byte-aligned offset; the part of it
+/// that lies beyond the end of the outer view is cut off. The accessors of the nested type apply to the returned view.
+/// The nested delimited composites are opened with canardDSDLGetDelimited() instead, because their size is dynamic.
+#define CANARD_DSDL_VIEW_COMPOSITE(name, off_bit, size_bytes)                                   \
+    static inline CanardDSDLView name(const CanardDSDLView view)                               \
+    {                                                                                          \
+        const size_t   off  = (view.size < ((off_bit) / 8U)) ? view.size : ((off_bit) / 8U);   \
+        const size_t   left = view.size - off;                                                 \
+        CanardDSDLView out  = {&view.data[off], (left < (size_bytes)) ? left : (size_bytes)}; \
+        return out;                                                                            \
+    }
+
+/// Serialize a delimited (extensible) composite. The delimiter header is placed at the specified offset, which shall
+/// be byte-aligned, and the body follows it. First, obtain the offset of the body; then serialize the fields of the
+/// body using the functions above; finally, pass the offset of the end of the body to write the delimiter header.
+/// The body is padded to a whole number of bytes; the padding bits are not modified, so the buffer should be zeroed.
+/// Returns the offset, in bits, of the field that follows the composite.
+///
+///     const size_t body_off = canardDSDLBeginDelimited(off);
+///     canardDSDLSetF32(buf, body_off, distance);
+///     off = canardDSDLEndDelimited(buf, off, body_off + 32U);
+size_t canardDSDLBeginDelimited(const size_t off_bit);
+size_t canardDSDLEndDelimited(uint8_t* const buf, const size_t off_bit, const size_t end_off_bit);
+
+/// Deserialize the delimiter header of a delimited composite located at the specified byte-aligned offset and
+/// provide a view of its body. The fields of the body are then read from the view with the functions above, which
+/// apply the IZER within the body: the fields that a sender of an older version of the type did not serialize are
+/// read as zeros. The fields that a sender of a newer version added are skipped in constant time, because the
+/// returned offset of the next field is computed from the delimiter header. The composites nested in the body are
+/// opened by invoking this function on the view; no data is copied.
+///
+/// The delimiter header is subject to the IZER like any other field. If the body would extend beyond the end of the
+/// buffer (which includes the case where the transfer was truncated to the extent of the subscription in the middle
+/// of the composite), the object is malformed and CANARD_DSDL_ERROR_BAD_DELIMITER_HEADER is returned.
+/// CANARD_DSDL_ERROR_INVALID_ARGUMENT is returned if the offset is not byte-aligned or either pointer is NULL.
+/// Returns the offset, in bits, of the field that follows the composite, or a negated error code.
+int64_t canardDSDLGetDelimited(const uint8_t* const  buf,
+                               const size_t          buf_size,
+                               const size_t          off_bit,
+                               CanardDSDLView* const out_body);
+
+/// Returns a pointer to the first fixed_size bytes of the view, so that the fields located within that size can be
+/// read with buf_size = fixed_size, which allows the compiler to resolve the bounds checks of the getters statically
+/// when they are inlined (see CANARD_CONFIG_INLINE_PRIVATE) -- one bounds check per composite instead of one per field.
+/// If the view is large enough, the pointer refers to the view itself (no copy); otherwise, the view is copied into
+/// the scratch buffer, which shall be at least fixed_size bytes large, and zero-extended to fixed_size per the IZER.
+const uint8_t* canardDSDLViewFix(const CanardDSDLView* const view, const size_t fixed_size, uint8_t* const scratch);
+
 #ifdef __cplusplus
 }
 #endif
@@ -12,6 +12,8 @@
 #ifdef __linux__
 #    include <linux/can.h>
 #    include <linux/can/raw.h>
+#    include <linux/errqueue.h>
+#    include <linux/net_tstamp.h>
 #    include <net/if.h>
 #    include <sys/ioctl.h>
 #else
@@ -26,9 +28,49 @@
 #include <string.h>
 #include <time.h>
 
+// USDT probes under the provider name "socketcan", see tools/bpftrace/; compiled out if <sys/sdt.h> is unavailable
+// or SOCKETCAN_CONFIG_TRACE is defined as false.
+#ifndef SOCKETCAN_CONFIG_TRACE
+#    if defined(__has_include)
+#        if __has_include(<sys/sdt.h>)
+#            define SOCKETCAN_CONFIG_TRACE 1
+#        endif
+#    endif
+#endif
+#if defined(SOCKETCAN_CONFIG_TRACE) && SOCKETCAN_CONFIG_TRACE
+#    include <sys/sdt.h>
+#    define SOCKETCAN_TRACE(name, ...) STAP_PROBEV(socketcan, name, __VA_ARGS__)
+#else
+#    define SOCKETCAN_TRACE(name, ...) (void) 0
+#endif
+
 #define KILO 1000L
 #define MEGA (KILO * KILO)
 
+// CAN XL is available since Linux 6.2; with older kernel headers, CAN XL sockets are reported as unsupported.
+#ifdef CANXL_XLF
+#    define SOCKETCAN_XL_SUPPORTED 1
+#    define SOCKETCAN_PAYLOAD_MAX CANXL_MAX_DLEN
+#else
+#    define SOCKETCAN_XL_SUPPORTED 0
+#    define SOCKETCAN_PAYLOAD_MAX CANFD_MAX_DLEN
+#endif
+
+/// The fields of the UAVCAN/CAN ID that make up the priority field of a CAN XL frame, see socketcanGetXLPriority().
+#define XL_TRANSFER_PRIORITY_OFFSET 26U
+#define XL_TRANSFER_PRIORITY_MASK 7U
+#define XL_SERVICE_NOT_MESSAGE_OFFSET 25U
+#define XL_NODE_ID_MASK 0x7FU
+
+/// The frame buffer large enough for any frame the socket may deliver.
+typedef union
+{
+    struct canfd_frame fd;
+#if SOCKETCAN_XL_SUPPORTED
+    struct canxl_frame xl;
+#endif
+} FrameBuffer;
+
 static int16_t getNegatedErrno()
 {
     const int out = -abs(errno);
@@ -46,6 +88,75 @@ static int16_t getNegatedErrno()
     return INT16_MIN;
 }
 
+static CanardMicrosecond timespecToMicroseconds(const struct timespec* const ts)
+{
+    return (CanardMicrosecond)((ts->tv_sec * MEGA) + (ts->tv_nsec / KILO));
+}
+
+/// The kernel timestamps are expressed in CLOCK_REALTIME, whereas this library uses CLOCK_TAI. The offset between
+/// the two is an integer number of seconds, so it can be recovered reliably by rounding the difference of the clocks.
+static CanardMicrosecond convertRealtimeToTAI(const struct timespec* const realtime)
+{
+    struct timespec tai;
+    struct timespec now;
+    (void) clock_gettime(CLOCK_TAI, &tai);
+    (void) clock_gettime(CLOCK_REALTIME, &now);
+    const int64_t diff_usec = (int64_t) timespecToMicroseconds(&tai) - (int64_t) timespecToMicroseconds(&now);
+    const int64_t offset_s  = (diff_usec + (MEGA / 2)) / MEGA;
+    return (CanardMicrosecond)((int64_t) timespecToMicroseconds(realtime) + (offset_s * MEGA));
+}
+
+/// Returns a pointer to the software timestamp carried by the message, or NULL if there is none.
+static const struct timespec* findSoftwareTimestamp(struct msghdr* const msg)
+{
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(msg); cmsg != NULL; cmsg = CMSG_NXTHDR(msg, cmsg))
+    {
+        if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SO_TIMESTAMPING))
+        {
+            const struct scm_timestamping* const tss = (const struct scm_timestamping*) CMSG_DATA(cmsg);
+            if ((tss->ts[0].tv_sec != 0) || (tss->ts[0].tv_nsec != 0))
+            {
+                return &tss->ts[0];
+            }
+        }
+    }
+    return NULL;
+}
+
+/// Returns true if the frame read from the socket is a CAN XL frame. The CAN XL flag occupies the same position as the
+/// length of the Classic CAN and CAN FD frames, which is too small to have that bit set.
+static bool isXLFrame(const FrameBuffer* const buf, const ssize_t read_size)
+{
+#if SOCKETCAN_XL_SUPPORTED
+    return (read_size >= (ssize_t) (CANXL_HDR_SIZE + CANXL_MIN_DLEN)) && ((buf->xl.flags & CANXL_XLF) != 0) &&
+           (read_size == (ssize_t) (CANXL_HDR_SIZE + buf->xl.len));
+#else
+    (void) buf;
+    (void) read_size;
+    return false;
+#endif
+}
+
+static ssize_t writeXLFrame(const SocketCANFD fd, const CanardFrame* const frame)
+{
+#if SOCKETCAN_XL_SUPPORTED
+    // Only the header is cleared; the 2 KiB of data are not worth zeroing as only the used part is written.
+    struct canxl_frame cxl;
+    (void) memset(&cxl, 0, CANXL_HDR_SIZE);
+    cxl.prio  = socketcanGetXLPriority(frame->extended_can_id) & CANXL_PRIO_MASK;
+    cxl.flags = CANXL_XLF;
+    cxl.len   = (uint16_t) frame->payload_size;
+    cxl.af    = frame->extended_can_id & CAN_EFF_MASK;
+    (void) memcpy(cxl.data, frame->payload, frame->payload_size);
+    return write(fd, &cxl, CANXL_HDR_SIZE + frame->payload_size);
+#else
+    (void) fd;
+    (void) frame;
+    errno = EOPNOTSUPP;
+    return -1;
+#endif
+}
+
 static int16_t doPoll(const SocketCANFD fd, const int16_t mask, const CanardMicrosecond timeout_usec)
 {
     struct pollfd fds;
@@ -74,7 +185,7 @@ static int16_t doPoll(const SocketCANFD fd, const int16_t mask, const CanardMicr
     return 1;
 }
 
-SocketCANFD socketcanOpen(const char* const iface_name, const bool can_fd)
+static SocketCANFD openSocket(const char* const iface_name, const bool can_fd, const bool can_xl)
 {
     const size_t iface_name_size = strlen(iface_name) + 1;
     if (iface_name_size > IFNAMSIZ)
@@ -101,30 +212,88 @@ SocketCANFD socketcanOpen(const char* const iface_name, const bool can_fd)
         }
     }
 
+    if (ok && can_fd)
+    {
+        // The socket option is accepted regardless of the interface, so check the MTU of the interface explicitly
+        // to let the caller fall back to Classic CAN instead of failing on the first large frame.
+        struct ifreq ifr;
+        (void) memset(&ifr, 0, sizeof(ifr));
+        (void) memcpy(ifr.ifr_name, iface_name, iface_name_size);
+        // A CAN XL interface carries CAN FD frames as well.
+        ok = 0 == ioctl(fd, SIOCGIFMTU, &ifr);
+        if (ok && (ifr.ifr_mtu < (int) CANFD_MTU))
+        {
+            errno = EOPNOTSUPP;
+            ok    = false;
+        }
+#if SOCKETCAN_XL_SUPPORTED
+        if (ok && can_xl && (ifr.ifr_mtu < (int) CANXL_MIN_MTU))
+        {
+            errno = EOPNOTSUPP;
+            ok    = false;
+        }
+#endif
+    }
+
     if (ok && can_fd)
     {
         const int en = 1;
         ok           = 0 == setsockopt(fd, SOL_CAN_RAW, CAN_RAW_FD_FRAMES, &en, sizeof(en));
     }
 
+    if (ok && can_xl)
+    {
+#if SOCKETCAN_XL_SUPPORTED
+        const int en = 1;
+        ok           = 0 == setsockopt(fd, SOL_CAN_RAW, CAN_RAW_XL_FRAMES, &en, sizeof(en));
+#else
+        errno = EOPNOTSUPP;
+        ok    = false;
+#endif
+    }
+
     if (ok)
     {
         return fd;
     }
 
-    (void) close(fd);
-    return getNegatedErrno();
+    // The errno is captured first: closing an invalid descriptor would overwrite it.
+    const int16_t out = getNegatedErrno();
+    if (fd >= 0)
+    {
+        (void) close(fd);
+    }
+    return out;
+}
+
+SocketCANFD socketcanOpen(const char* const iface_name, const bool can_fd)
+{
+    return openSocket(iface_name, can_fd, false);
+}
+
+SocketCANFD socketcanOpenXL(const char* const iface_name)
+{
+    return openSocket(iface_name, true, true);
 }
 
 int16_t socketcanPush(const SocketCANFD fd, const CanardFrame* const frame, const CanardMicrosecond timeout_usec)
 {
-    if ((frame == NULL) || (frame->payload == NULL) || (frame->payload_size > UINT8_MAX))
+    if ((frame == NULL) || (frame->payload == NULL) || (frame->payload_size > SOCKETCAN_PAYLOAD_MAX))
     {
         return -EINVAL;
     }
 
     const int16_t poll_result = doPoll(fd, POLLOUT, timeout_usec);
-    if (poll_result > 0)
+    if ((poll_result > 0) && (frame->payload_size > CANFD_MAX_DLEN))
+    {
+        const ssize_t result = writeXLFrame(fd, frame);
+        SOCKETCAN_TRACE(frame_write, frame->extended_can_id, frame->payload_size, frame->timestamp_usec, result);
+        if (result < 0)
+        {
+            return getNegatedErrno();
+        }
+    }
+    else if (poll_result > 0)
     {
         // We use the CAN FD struct regardless of whether the CAN FD socket option is set.
         // Per the user manual, this is acceptable because they are binary compatible.
@@ -139,8 +308,10 @@ int16_t socketcanPush(const SocketCANFD fd, const CanardFrame* const frame, cons
         // If the payload is small, use the smaller MTU for compatibility with non-FD sockets.
         // This way, if the user attempts to transmit a CAN FD frame without having the CAN FD socket option enabled,
         // an error will be triggered here.  This is convenient -- we can handle both FD and Classic CAN uniformly.
-        const size_t mtu = (frame->payload_size > CAN_MAX_DLEN) ? CANFD_MTU : CAN_MTU;
-        if (write(fd, &cfd, mtu) < 0)
+        const size_t  mtu    = (frame->payload_size > CAN_MAX_DLEN) ? CANFD_MTU : CAN_MTU;
+        const ssize_t result = write(fd, &cfd, mtu);
+        SOCKETCAN_TRACE(frame_write, frame->extended_can_id, frame->payload_size, frame->timestamp_usec, result);
+        if (result < 0)
         {
             return getNegatedErrno();
         }
@@ -148,11 +319,19 @@ int16_t socketcanPush(const SocketCANFD fd, const CanardFrame* const frame, cons
     return poll_result;
 }
 
-int16_t socketcanPop(const SocketCANFD       fd,
-                     CanardFrame* const      out_frame,
-                     const size_t            payload_buffer_size,
-                     void* const             payload_buffer,
-                     const CanardMicrosecond timeout_usec)
+uint16_t socketcanGetXLPriority(const uint32_t extended_can_id)
+{
+    const uint32_t priority = (extended_can_id >> XL_TRANSFER_PRIORITY_OFFSET) & XL_TRANSFER_PRIORITY_MASK;
+    const uint32_t service  = (extended_can_id >> XL_SERVICE_NOT_MESSAGE_OFFSET) & 1U;
+    return (uint16_t) ((priority << 8U) | (service << 7U) | (extended_can_id & XL_NODE_ID_MASK));
+}
+
+int16_t socketcanPop(const SocketCANFD         fd,
+                     CanardFrame* const        out_frame,
+                     SocketCANFrameInfo* const out_info,
+                     const size_t              payload_buffer_size,
+                     void* const               payload_buffer,
+                     const CanardMicrosecond   timeout_usec)
 {
     if ((out_frame == NULL) || (payload_buffer == NULL))
     {
@@ -170,39 +349,132 @@ int16_t socketcanPop(const SocketCANFD       fd,
 
         // We use the CAN FD struct regardless of whether the CAN FD socket option is set.
         // Per the user manual, this is acceptable because they are binary compatible.
-        struct canfd_frame cfd;
-        const ssize_t      read_size = read(fd, &cfd, sizeof(cfd));
+        // The message flags are needed to tell looped back frames apart from those emitted by other nodes.
+        FrameBuffer               buf;
+        struct canfd_frame* const cfd = &buf.fd;
+        struct iovec              iov = {.iov_base = &buf, .iov_len = sizeof(buf)};
+        uint8_t                   control[CMSG_SPACE(sizeof(struct scm_timestamping))];
+        struct msghdr             msg;
+        (void) memset(&msg, 0, sizeof(msg));
+        msg.msg_iov             = &iov;
+        msg.msg_iovlen          = 1;
+        msg.msg_control         = control;
+        msg.msg_controllen      = sizeof(control);
+        const ssize_t read_size = recvmsg(fd, &msg, 0);
         if (read_size < 0)
         {
             return getNegatedErrno();
         }
-        if ((read_size != CAN_MTU) && (read_size != CANFD_MTU))
+        const bool xl = isXLFrame(&buf, read_size);
+        if (!xl && (read_size != CAN_MTU) && (read_size != CANFD_MTU))
         {
             return -EIO;
         }
-        if (cfd.len > payload_buffer_size)
+#if SOCKETCAN_XL_SUPPORTED
+        const size_t   len    = xl ? buf.xl.len : cfd->len;
+        const uint8_t* data   = xl ? &buf.xl.data[0] : &cfd->data[0];
+        const canid_t  can_id = xl ? ((buf.xl.af & CAN_EFF_MASK) | CAN_EFF_FLAG) : cfd->can_id;
+#else
+        const size_t   len    = cfd->len;
+        const uint8_t* data   = &cfd->data[0];
+        const canid_t  can_id = cfd->can_id;
+#endif
+        if (len > payload_buffer_size)
         {
             return -EFBIG;
         }
 
-        const bool valid = ((cfd.can_id & CAN_EFF_FLAG) != 0) &&  // Extended frame
-                           ((cfd.can_id & CAN_RTR_FLAG) == 0) &&  // Not RTR frame
-                           ((cfd.can_id & CAN_ERR_FLAG) == 0);    // Not error frame
+        const bool valid = ((can_id & CAN_EFF_FLAG) != 0) &&  // Extended frame
+                           ((can_id & CAN_RTR_FLAG) == 0) &&  // Not RTR frame
+                           ((can_id & CAN_ERR_FLAG) == 0);    // Not error frame
         if (!valid)
         {
             return 0;  // Not an extended data frame -- drop silently and return early.
         }
 
+        const struct timespec* const kernel_ts = findSoftwareTimestamp(&msg);
+
         (void) memset(out_frame, 0, sizeof(CanardFrame));
-        out_frame->timestamp_usec  = (CanardMicrosecond)((ts.tv_sec * MEGA) + (ts.tv_nsec / KILO));
-        out_frame->extended_can_id = cfd.can_id & CAN_EFF_MASK;
-        out_frame->payload_size    = cfd.len;
+        out_frame->timestamp_usec =
+            (kernel_ts != NULL) ? convertRealtimeToTAI(kernel_ts) : timespecToMicroseconds(&ts);
+        out_frame->extended_can_id = can_id & CAN_EFF_MASK;
+        out_frame->payload_size    = len;
         out_frame->payload         = payload_buffer;
-        (void) memcpy(payload_buffer, &cfd.data[0], cfd.len);
+        (void) memcpy(payload_buffer, data, len);
+        SOCKETCAN_TRACE(frame_read,
+                        out_frame->extended_can_id,
+                        out_frame->payload_size,
+                        out_frame->timestamp_usec,
+                        (((uint32_t) msg.msg_flags) & (uint32_t) MSG_CONFIRM) != 0);
+
+        if (out_info != NULL)
+        {
+            out_info->loopback = (((uint32_t) msg.msg_flags) & (uint32_t) MSG_CONFIRM) != 0;
+            out_info->fd       = !xl && (read_size == CANFD_MTU);
+            out_info->brs      = out_info->fd && ((cfd->flags & CANFD_BRS) != 0);
+            out_info->xl       = xl;
+        }
     }
     return poll_result;
 }
 
+int16_t socketcanEnableLoopback(const SocketCANFD fd)
+{
+    // Local loopback is enabled by default, but the frames are not delivered to the originating socket without this.
+    const int en = 1;
+    return (setsockopt(fd, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &en, sizeof(en)) < 0) ? getNegatedErrno() : 0;
+}
+
+int16_t socketcanEnableTxTimestamping(const SocketCANFD fd)
+{
+    // The ID option makes the kernel number the frames so that the reports can be matched with the written frames.
+    // The TSONLY option prevents the kernel from returning a copy of the frame with each report.
+    const int flags = SOF_TIMESTAMPING_TX_SCHED | SOF_TIMESTAMPING_TX_SOFTWARE | SOF_TIMESTAMPING_RX_SOFTWARE |
+                      SOF_TIMESTAMPING_SOFTWARE | SOF_TIMESTAMPING_OPT_ID | SOF_TIMESTAMPING_OPT_TSONLY;
+    return (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) < 0) ? getNegatedErrno() : 0;
+}
+
+int16_t socketcanPopTxTimestamp(const SocketCANFD fd, SocketCANTxTimestamp* const out_timestamp)
+{
+    if (out_timestamp == NULL)
+    {
+        return -EINVAL;
+    }
+
+    uint8_t       control[CMSG_SPACE(sizeof(struct scm_timestamping)) + CMSG_SPACE(sizeof(struct sock_extended_err))];
+    struct msghdr msg;
+    (void) memset(&msg, 0, sizeof(msg));
+    msg.msg_control    = control;
+    msg.msg_controllen = sizeof(control);
+    if (recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+    {
+        return ((errno == EAGAIN) || (errno == EWOULDBLOCK)) ? 0 : getNegatedErrno();
+    }
+
+    const struct timespec*          ts  = NULL;
+    const struct sock_extended_err* err = NULL;
+    for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+        if ((cmsg->cmsg_level == SOL_SOCKET) && (cmsg->cmsg_type == SO_TIMESTAMPING))
+        {
+            ts = &((const struct scm_timestamping*) CMSG_DATA(cmsg))->ts[0];
+        }
+        else if ((cmsg->cmsg_level == SOL_CAN_RAW) && (cmsg->cmsg_type == SCM_CAN_RAW_ERRQUEUE))
+        {
+            err = (const struct sock_extended_err*) CMSG_DATA(cmsg);
+        }
+    }
+    if ((ts == NULL) || (err == NULL) || (err->ee_origin != SO_EE_ORIGIN_TIMESTAMPING))
+    {
+        return -EIO;
+    }
+
+    out_timestamp->id             = err->ee_data;
+    out_timestamp->scheduled      = err->ee_info == SCM_TSTAMP_SCHED;
+    out_timestamp->timestamp_usec = convertRealtimeToTAI(ts);
+    return 1;
+}
+
 int16_t socketcanFilter(const SocketCANFD fd, const size_t num_configs, const SocketCANFilterConfig* const configs)
 {
     if (configs == NULL)
@@ -35,28 +35,93 @@ typedef int SocketCANFD;
 /// Initialize a new non-blocking (sic!) SocketCAN socket and return its handle on success.
 /// On failure, a negated errno is returned.
 /// To discard the socket just call close() on it; no additional de-initialization activities are required.
-/// The argument can_fd enables support for CAN FD frames.
+/// The argument can_fd enables support for CAN FD frames; -EOPNOTSUPP is returned if the interface is not CAN FD capable.
+/// A CAN FD socket emits the frames that fit into 8 bytes as Classic CAN frames, see socketcanPush().
 SocketCANFD socketcanOpen(const char* const iface_name, const bool can_fd);
 
+/// Like socketcanOpen() with CAN FD enabled, but also enables CAN XL frames (Linux 6.2 or newer is required).
+/// -EOPNOTSUPP is returned if the interface is not CAN XL capable; a virtual interface becomes CAN XL capable once its
+/// MTU is raised (e.g., "ip link set vcan0 mtu 2060"). A CAN XL socket emits the frames that fit into 64 bytes as
+/// Classic CAN or CAN FD frames, see socketcanPush(). Note that the acceptance filters (see socketcanFilter()) do not
+/// match CAN XL frames, so any filter configuration blocks them; leave the default accept-all configuration.
+SocketCANFD socketcanOpenXL(const char* const iface_name);
+
 /// Enqueue a new extended CAN data frame for transmission.
 /// Block until the frame is enqueued or until the timeout is expired.
 /// Zero timeout makes the operation non-blocking.
 /// Returns 1 on success, 0 on timeout, negated errno on error.
+/// Frames of up to 8 bytes are written as Classic CAN frames and larger ones as CAN FD frames, so transfers emitted
+/// with different MTU settings can share the same socket. Frames larger than 64 bytes (up to CANARD_MTU_CAN_XL) are
+/// written as CAN XL frames, which requires a CAN XL socket; the extended CAN ID is carried in the acceptance field,
+/// and the priority field is derived from it by socketcanGetXLPriority().
 int16_t socketcanPush(const SocketCANFD fd, const CanardFrame* const frame, const CanardMicrosecond timeout_usec);
 
+/// The 11-bit priority field of a CAN XL frame with the given UAVCAN/CAN extended CAN ID. The priority field is
+/// arbitrated on the bus like a base CAN ID, so it shall be unique per node and precede the frames of lower priority:
+///
+///     bits 10..8  The transfer priority (bits 28..26 of the CAN ID).
+///     bit  7      Set for the service transfers (bit 25), so that the messages win at the same transfer priority.
+///     bits 6..0   The source node-ID (bits 6..0).
+///
+/// The acceptance field carries the whole CAN ID, so the nodes that send the same subject still use distinct
+/// priority fields.
+uint16_t socketcanGetXLPriority(const uint32_t extended_can_id);
+
+/// Auxiliary information about a received frame that does not fit into CanardFrame.
+typedef struct SocketCANFrameInfo
+{
+    bool loopback;  ///< The frame was emitted by this socket and looped back; see socketcanEnableLoopback().
+    bool fd;        ///< The frame is a CAN FD frame rather than a Classic CAN frame.
+    bool brs;       ///< The CAN FD bit rate switch flag is set; always false for Classic CAN frames.
+    bool xl;        ///< The frame is a CAN XL frame; fd is false in this case.
+} SocketCANFrameInfo;
+
 /// Fetch a new extended CAN data frame from the RX queue.
 /// If the received frame is not an extended-ID data frame, it will be dropped and the function will return early.
 /// The payload pointer of the returned frame will point to the payload_buffer. It can be a stack-allocated array.
-/// The payload_buffer_size shall be large enough (64 bytes is enough for CAN FD), otherwise an error is returned.
-/// The timestamp of the received frame will be set to the CLOCK_TAI sampled near the moment of its arrival.
+/// The payload_buffer_size shall be large enough (64 bytes is enough for CAN FD, CANARD_MTU_CAN_XL for CAN XL),
+/// otherwise an error is returned.
+/// The timestamp of the received frame will be set to the CLOCK_TAI sampled near the moment of its arrival;
+/// if kernel timestamping is enabled (see socketcanEnableTxTimestamping()), the kernel timestamp is used instead.
+/// If out_info is not NULL, it will be populated with the frame format and the loopback flag.
 /// The function will block until a frame is received or until the timeout is expired. It may return early.
 /// Zero timeout makes the operation non-blocking.
 /// Returns 1 on success, 0 on timeout, negated errno on error.
-int16_t socketcanPop(const SocketCANFD       fd,
-                     CanardFrame* const      out_frame,
-                     const size_t            payload_buffer_size,
-                     void* const             payload_buffer,
-                     const CanardMicrosecond timeout_usec);
+int16_t socketcanPop(const SocketCANFD         fd,
+                     CanardFrame* const        out_frame,
+                     SocketCANFrameInfo* const out_info,
+                     const size_t              payload_buffer_size,
+                     void* const               payload_buffer,
+                     const CanardMicrosecond   timeout_usec);
+
+/// Deliver the frames transmitted via this socket back into its own RX queue once they are sent.
+/// Looped back frames are marked as such by socketcanPop(); this allows the application to observe its own
+/// traffic in the same way as the traffic emitted by other nodes, e.g., for bus load estimation.
+/// Returns 0 on success, negated errno on error.
+int16_t socketcanEnableLoopback(const SocketCANFD fd);
+
+/// A transmission timestamp harvested from the error queue of the socket.
+/// The id is the sequence number of the frame: the first frame written after socketcanEnableTxTimestamping()
+/// has id 0, the next one has id 1, and so on; the counter wraps around at 2**32.
+/// The timestamp is expressed in CLOCK_TAI, like the RX timestamps.
+typedef struct SocketCANTxTimestamp
+{
+    uint32_t          id;
+    bool              scheduled;  ///< True if the frame entered the packet scheduler, false if passed to the driver.
+    CanardMicrosecond timestamp_usec;
+} SocketCANTxTimestamp;
+
+/// Request the kernel to report when each transmitted frame enters the packet scheduler and when it is handed over
+/// to the driver (SOF_TIMESTAMPING_TX_SCHED and SOF_TIMESTAMPING_TX_SOFTWARE). The reports are collected with
+/// socketcanPopTxTimestamp(). This also enables kernel RX timestamps for socketcanPop().
+/// The driver-level timestamp is only reported by drivers that support it (the common CAN driver infrastructure
+/// does so since Linux 5.14); otherwise, only the scheduler timestamps will be available.
+/// Returns 0 on success, negated errno on error.
+int16_t socketcanEnableTxTimestamping(const SocketCANFD fd);
+
+/// Fetch one transmission timestamp from the error queue of the socket. This function never blocks.
+/// Returns 1 on success, 0 if there are no pending timestamps, negated errno on error.
+int16_t socketcanPopTxTimestamp(const SocketCANFD fd, SocketCANTxTimestamp* const out_timestamp);
 
 /// The configuration of a single extended 29-bit data frame acceptance filter.
 /// Bits above the 29-th shall be cleared.
@@ -0,0 +1,42 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Amalgamated build of the node: the application, libcanard, and the SocketCAN glue are compiled as a single
+/// translation unit, so the compiler can inline across the module boundaries (e.g., the DSDL serialization and
+/// canardTxPush() into the publishers, socketcanPush() into the transmission loop) without relying on LTO.
+/// Build with CANARD_CONFIG_INLINE_PRIVATE to turn the private functions of libcanard into "static inline".
+///
+/// The modules are included in the dependency order. The macros that are private to a module and would collide
+/// with the definitions in the modules included after it are undefined right after its inclusion.
+
+// Shall be defined before any system header is included; see socketcan.c.
+#ifndef _GNU_SOURCE
+#    define _GNU_SOURCE
+#endif
+
+#include "../libcanard/canard.c"
+#include "../libcanard/canard_dsdl.c"
+
+#include "../socketcan/socketcan.c"
+#undef KILO
+#undef MEGA
+
+#include "metrics.c"
+#include "busload.c"
+#include "txlatency.c"
+#include "flightrec.c"
+#include "sensor_pigpio.c"
+#if PIGPIOD_ENABLED
+#    include "sensor_pigpiod.c"
+#endif
+#include "sensor_replay.c"
+#include "periodic.c"
+#include "burst.c"
+#include "history.c"
+#include "demand.c"
+#include "timesync.c"
+#include "tdma.c"
+#include "ultrasound.c"
+
+#include "main.c"
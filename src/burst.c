@@ -0,0 +1,202 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "burst.h"
+#include <canard_dsdl.h>
+#include <assert.h>
+#include <string.h>
+
+#define STATE_GENERATION_OFFSET 16U
+#define STATE_COUNT_MASK 0xFFFFU
+
+static_assert(BURST_MAX_SAMPLES <= STATE_COUNT_MASK, "The count shall fit into the state");
+
+static inline uint32_t makeState(const uint16_t generation, const uint32_t count)
+{
+    return (((uint32_t) generation) << STATE_GENERATION_OFFSET) | count;
+}
+
+static inline uint32_t getCount(const uint32_t state)
+{
+    return state & STATE_COUNT_MASK;
+}
+
+void burstInit(BurstCapture* const     burst,
+               SensorBackend* const    sensor,
+               CanardInstance* const   canard,
+               const CanardPortID      subject_id,
+               const size_t            mtu_bytes,
+               const uint32_t          normal_period_usec,
+               const CanardMicrosecond tx_deadline_usec)
+{
+    (void) memset(burst, 0, sizeof(BurstCapture));
+    burst->sensor             = sensor;
+    burst->canard             = canard;
+    burst->subject_id         = subject_id;
+    burst->mtu_bytes          = mtu_bytes;
+    burst->normal_period_usec = normal_period_usec;
+    burst->tx_deadline_usec   = tx_deadline_usec;
+    atomic_init(&burst->active, false);
+    atomic_init(&burst->state, makeState(0U, 0U));
+}
+
+static BurstStatus burstStart(BurstCapture* const     burst,
+                              const uint32_t          period_usec,
+                              const uint32_t          max_samples,
+                              const CanardMicrosecond max_duration_usec,
+                              const CanardMicrosecond now_usec)
+{
+    if (atomic_load(&burst->active) || burst->sending)
+    {
+        return BurstStatusBusy;
+    }
+    burst->burst_id++;
+    burst->max_samples     = max_samples;
+    burst->period_usec     = period_usec;
+    burst->started_at_usec = now_usec;
+    burst->ends_at_usec    = now_usec + max_duration_usec;
+    burst->next_index      = 0U;
+    burst->final_count     = 0U;
+    burst->generation++;
+    atomic_store(&burst->state, makeState(burst->generation, 0U));
+    atomic_store(&burst->active, true);  // Publishes the above to the thread of the sensor backend.
+    if (burst->sensor->setTriggerPeriod(burst->sensor, period_usec) < 0)
+    {
+        atomic_store(&burst->active, false);
+        (void) burst->sensor->setTriggerPeriod(burst->sensor, burst->normal_period_usec);
+        return BurstStatusUnsupported;
+    }
+    burst->sending = true;
+    return BurstStatusStarted;
+}
+
+/// The samples collected so far are sent by burstPoll(); the last transfer is flagged.
+static void burstStop(BurstCapture* const burst)
+{
+    atomic_store(&burst->active, false);
+    burst->generation++;
+    burst->final_count = getCount(atomic_exchange(&burst->state, makeState(burst->generation, 0U)));
+    (void) burst->sensor->setTriggerPeriod(burst->sensor, burst->normal_period_usec);
+}
+
+void burstHandleRequest(BurstCapture* const     burst,
+                        const uint8_t* const    request,
+                        const size_t            request_size,
+                        const CanardMicrosecond now_usec,
+                        uint8_t* const          response)
+{
+    const uint32_t period_usec    = canardDSDLGetU32(request, request_size, 0U, 32U);
+    const uint32_t samples        = canardDSDLGetU16(request, request_size, 32U, 16U);
+    const uint64_t duration_usec  = canardDSDLGetU16(request, request_size, 48U, 16U) * 1000ULL;
+    const bool     samples_valid  = (samples > 0U) && (samples <= BURST_MAX_SAMPLES);
+    const bool     duration_valid = (duration_usec > 0U) && (duration_usec <= BURST_MAX_DURATION_USEC);
+    BurstStatus    status         = BurstStatusIdle;
+    if (period_usec > 0U)
+    {
+        status = burstStart(burst,
+                            period_usec,
+                            samples_valid ? samples : BURST_MAX_SAMPLES,
+                            duration_valid ? duration_usec : BURST_MAX_DURATION_USEC,
+                            now_usec);
+    }
+    else if (atomic_load(&burst->active))
+    {
+        burstStop(burst);
+        status = BurstStatusStopped;
+    }
+    canardDSDLSetUxx(response, 0U, (uint64_t) status, 8U);
+    canardDSDLSetUxx(response, 8U, burst->burst_id, 8U);
+    canardDSDLSetUxx(response, 16U, burst->max_samples, 16U);
+    canardDSDLSetUxx(response, 32U, (burst->ends_at_usec - burst->started_at_usec) / 1000U, 16U);
+}
+
+/// The main loop may stop the burst, and start the next one, while a sample is being stored here. Both advance the
+/// generation in the state, so the count of a sample that was taken before is not stored into the state of the next
+/// burst. Its stale write into the buffer is at or above the count, so it is overwritten before any transfer has it.
+bool burstAccept(BurstCapture* const burst, const CanardMicrosecond edge_usec, const uint32_t pulse_usec)
+{
+    bool pass = true;
+    if (atomic_load(&burst->active))
+    {
+        uint32_t       state = atomic_load_explicit(&burst->state, memory_order_relaxed);
+        const uint32_t index = getCount(state);
+        if ((index < burst->max_samples) && (edge_usec >= burst->started_at_usec))
+        {
+            burst->samples[index].offset_usec = (uint32_t)(edge_usec - burst->started_at_usec);
+            burst->samples[index].pulse_usec  = pulse_usec;
+            (void) atomic_compare_exchange_strong_explicit(&burst->state,
+                                                           &state,
+                                                           state + 1U,
+                                                           memory_order_release,
+                                                           memory_order_relaxed);
+        }
+        // The period of the burst is the tolerance, so that the distance follows the normal period closely.
+        pass = (edge_usec + burst->period_usec) >= (burst->passed_at_usec + burst->normal_period_usec);
+    }
+    if (pass)
+    {
+        burst->passed_at_usec = edge_usec;
+    }
+    return pass;
+}
+
+static void burstSend(BurstCapture* const     burst,
+                      const uint32_t          num_samples,
+                      const bool              last,
+                      const CanardMicrosecond now_usec)
+{
+    uint8_t payload[BURST_MESSAGE_MAX_SIZE] = {0};
+    canardDSDLSetUxx(payload, 0U, burst->burst_id, 8U);
+    canardDSDLSetUxx(payload, 8U, last ? BURST_FLAG_LAST : 0U, 8U);
+    canardDSDLSetUxx(payload, 16U, burst->next_index, 16U);
+    canardDSDLSetUxx(payload, 32U, burst->period_usec, 32U);
+    canardDSDLSetUxx(payload, 64U, burst->started_at_usec, 64U);
+    canardDSDLSetUxx(payload, 128U, num_samples, 8U);
+    for (uint32_t i = 0; i < num_samples; i++)
+    {
+        const BurstSample* const sample = &burst->samples[burst->next_index + i];
+        const size_t             offset = (BURST_MESSAGE_HEADER_SIZE + (i * BURST_MESSAGE_SAMPLE_SIZE)) * 8U;
+        const uint32_t           pulse  = (sample->pulse_usec > UINT16_MAX) ? UINT16_MAX : sample->pulse_usec;
+        canardDSDLSetUxx(payload, offset, sample->offset_usec, 32U);
+        canardDSDLSetUxx(payload, offset + 32U, pulse, 16U);
+    }
+    const CanardTransfer transfer = {
+        .timestamp_usec = now_usec + burst->tx_deadline_usec,
+        .priority       = CanardPriorityLow,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = burst->subject_id,
+        .remote_node_id = CANARD_NODE_ID_UNSET,
+        .transfer_id    = burst->transfer_id,
+        .payload_size   = BURST_MESSAGE_HEADER_SIZE + (num_samples * BURST_MESSAGE_SAMPLE_SIZE),
+        .payload        = &payload[0],
+    };
+    burst->transfer_id       = (CanardTransferID)((burst->transfer_id + 1U) & CANARD_TRANSFER_ID_MAX);
+    const int32_t result     = canardTxPushMTU(burst->canard, &transfer, burst->mtu_bytes);
+    burst->failed += (result < 0) ? 1U : 0U;
+    if ((result > 0) && (burst->txlatency != NULL))
+    {
+        txlatencyOnPush(burst->txlatency, transfer.transfer_kind, transfer.port_id, transfer.timestamp_usec, now_usec);
+    }
+}
+
+void burstPoll(BurstCapture* const burst, const CanardMicrosecond now_usec)
+{
+    if (atomic_load(&burst->active) &&
+        ((getCount(atomic_load(&burst->state)) >= burst->max_samples) || (now_usec >= burst->ends_at_usec)))
+    {
+        burstStop(burst);
+    }
+    const bool     active    = atomic_load(&burst->active);
+    const uint32_t available = active ? getCount(atomic_load(&burst->state)) : burst->final_count;
+    while (burst->sending && (!active || ((available - burst->next_index) >= BURST_SAMPLES_PER_TRANSFER)) &&
+           (canardTxGetQueueSize(burst->canard) < BURST_TX_QUEUE_LIMIT))
+    {
+        const uint32_t remaining   = available - burst->next_index;
+        const uint32_t num_samples = (remaining < BURST_SAMPLES_PER_TRANSFER) ? remaining : BURST_SAMPLES_PER_TRANSFER;
+        const bool     last        = !active && (num_samples == remaining);
+        burstSend(burst, num_samples, last, now_usec);
+        burst->next_index += num_samples;
+        burst->sending = !last;
+    }
+}
@@ -0,0 +1,143 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Burst capture of the raw echo pulse widths at a high trigger rate, e.g., 1 kHz for a few seconds during a
+/// calibration or an incident analysis. A request switches the sensor to the burst trigger period; the samples are
+/// collected into a preallocated buffer and streamed on the burst subject as they come, in multi-frame transfers that
+/// use the MTU of the large transfers (CAN FD if available). Once the requested number of samples is collected, the
+/// requested duration elapses, or a stop request arrives, the sensor reverts to the normal trigger period and the
+/// last transfer of the burst is flagged. The distance keeps being published at the normal rate during the burst.
+///
+/// The HC-SR04 measures one echo at a time: at 1 kHz, only the targets closer than about 17 cm are measured within
+/// the period, and the farther ones yield fewer samples or none.
+///
+/// The samples are collected in the thread of the sensor backend, everything else runs in the main loop.
+///
+/// Request (the extent is BURST_REQUEST_SIZE bytes):
+///     uint32 period_usec      # The trigger period of the burst; zero stops the running burst.
+///     uint16 max_samples      # Zero or more than BURST_MAX_SAMPLES: BURST_MAX_SAMPLES.
+///     uint16 max_duration_ms  # Zero or more than BURST_MAX_DURATION_USEC: BURST_MAX_DURATION_USEC.
+///
+/// Response:
+///     uint8  status           # See BurstStatus.
+///     uint8  burst_id         # Of the burst started or stopped.
+///     uint16 max_samples      # As granted.
+///     uint16 max_duration_ms  # As granted.
+///
+/// Message on the burst subject, one per BURST_SAMPLES_PER_TRANSFER samples:
+///     uint8  burst_id         # Incremented with every burst.
+///     uint8  flags            # Bit 0: the last transfer of the burst.
+///     uint16 first_index      # The index of the first sample of the transfer within the burst.
+///     uint32 period_usec      # The trigger period of the burst.
+///     uint64 started_at_usec  # The start of the burst in the time base of the transfers.
+///     Sample[<=BURST_SAMPLES_PER_TRANSFER] samples, preceded by the uint8 length as usual, each:
+///         uint32 offset_usec  # The falling edge of the echo relative to the start of the burst.
+///         uint16 pulse_usec   # The width of the echo pulse.
+
+#ifndef BURST_H_INCLUDED
+#define BURST_H_INCLUDED
+
+#include "sensor.h"
+#include "txlatency.h"
+#include <canard.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BURST_MAX_SAMPLES 8192U
+#define BURST_MAX_DURATION_USEC 10000000U
+#define BURST_SAMPLES_PER_TRANSFER 64U
+/// The next transfer is pushed only while the TX queue holds fewer frames, and the rest of the samples waits in the
+/// buffer. Otherwise a burst of 8192 samples would put about 7400 Classic CAN frames into the queue at once, which
+/// would expire before they are sent.
+#define BURST_TX_QUEUE_LIMIT 64U
+
+#define BURST_REQUEST_SIZE 8U
+#define BURST_RESPONSE_SIZE 6U
+#define BURST_MESSAGE_HEADER_SIZE 17U  ///< Including the length of the sample array.
+#define BURST_MESSAGE_SAMPLE_SIZE 6U
+#define BURST_MESSAGE_MAX_SIZE (BURST_MESSAGE_HEADER_SIZE + (BURST_SAMPLES_PER_TRANSFER * BURST_MESSAGE_SAMPLE_SIZE))
+
+#define BURST_FLAG_LAST 1U
+
+typedef enum
+{
+    BurstStatusStarted = 0,
+    BurstStatusStopped,      ///< The running burst was stopped by the request.
+    BurstStatusBusy,         ///< A burst is running or its samples are still being sent.
+    BurstStatusIdle,         ///< A stop was requested, but no burst was running.
+    BurstStatusUnsupported,  ///< The sensor backend cannot trigger at the requested period.
+} BurstStatus;
+
+typedef struct BurstSample
+{
+    uint32_t offset_usec;
+    uint32_t pulse_usec;
+} BurstSample;
+
+typedef struct BurstCapture
+{
+    SensorBackend*    sensor;
+    CanardInstance*   canard;
+    CanardPortID      subject_id;
+    size_t            mtu_bytes;  ///< The MTU of the burst transfers, passed with each push.
+    uint32_t          normal_period_usec;
+    CanardMicrosecond tx_deadline_usec;
+    TxLatencyTracker* txlatency;  ///< Notified of every push if not NULL, which is the initial state.
+
+    // Shared with the thread of the sensor backend.
+    atomic_bool       active;
+    _Atomic uint32_t  state;  ///< The generation in the upper 16 bits, the number of samples in the lower 16 bits.
+    uint32_t          max_samples;
+    uint32_t          period_usec;
+    CanardMicrosecond started_at_usec;
+    CanardMicrosecond passed_at_usec;  ///< When a sample was last passed on for publication, see burstAccept().
+
+    // The main loop only.
+    CanardMicrosecond ends_at_usec;
+    uint32_t          final_count;  ///< The number of samples of a stopped burst.
+    uint32_t          next_index;   ///< The first sample not sent yet.
+    bool              sending;      ///< The samples of the last burst are not sent completely yet.
+    uint8_t           burst_id;
+    uint16_t          generation;  ///< Advanced by every start and stop, see burstAccept().
+    CanardTransferID  transfer_id;
+    uint64_t          failed;  ///< The transfers that could not be pushed, for the lack of memory.
+
+    BurstSample samples[BURST_MAX_SAMPLES];
+} BurstCapture;
+
+void burstInit(BurstCapture* const     burst,
+               SensorBackend* const    sensor,
+               CanardInstance* const   canard,
+               const CanardPortID      subject_id,
+               const size_t            mtu_bytes,
+               const uint32_t          normal_period_usec,
+               const CanardMicrosecond tx_deadline_usec);
+
+/// Handles a request of the burst service from the main loop and writes the response, which is always
+/// BURST_RESPONSE_SIZE bytes long. A shorter request is zero-extended, as the implicit zero extension rule requires.
+void burstHandleRequest(BurstCapture* const     burst,
+                        const uint8_t* const    request,
+                        const size_t            request_size,
+                        const CanardMicrosecond now_usec,
+                        uint8_t* const          response);
+
+/// Shall be invoked for every echo pulse from the thread of the sensor backend; the timestamp is that of the falling
+/// edge. Returns false if the sample shall not be published on the distance subject, which keeps the rate of the
+/// distance publications at the normal trigger period during a burst.
+bool burstAccept(BurstCapture* const burst, const CanardMicrosecond edge_usec, const uint32_t pulse_usec);
+
+/// Shall be invoked from the main loop: sends the collected samples and ends the burst when it is complete.
+/// The samples are sent as fast as the TX queue drains, see BURST_TX_QUEUE_LIMIT.
+void burstPoll(BurstCapture* const burst, const CanardMicrosecond now_usec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,277 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "busload.h"
+#include "canid.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#define NANO_PER_SECOND 1000000000ULL
+#define NANO_PER_MICRO 1000ULL
+
+// Frame layout, in bits. Ref. ISO 11898-1:2015.
+// Classic extended data frame: SOF, base ID, SRR, IDE, extended ID, RTR, r1, r0, DLC -- then data and the CRC.
+#define CLASSIC_HEADER_BITS (1U + 11U + 1U + 1U + 18U + 1U + 2U + 4U)
+#define CLASSIC_CRC_BITS 15U
+// CAN FD extended data frame arbitration phase: SOF, base ID, SRR, IDE, extended ID, RRS, FDF, res, BRS.
+#define FD_ARBITRATION_BITS (1U + 11U + 1U + 1U + 18U + 1U + 1U + 1U + 1U)
+// CAN FD data phase before the data field: ESI and DLC.
+#define FD_CONTROL_BITS (1U + 4U)
+#define FD_STUFF_COUNT_BITS 4U
+#define FD_CRC17_BITS 17U
+#define FD_CRC21_BITS 21U
+#define FD_CRC17_MAX_PAYLOAD 16U
+// CRC delimiter, ACK slot, ACK delimiter, EOF, IFS. Never stuffed, always at the nominal bit rate.
+#define TRAILER_BITS (1U + 1U + 1U + 7U + 3U)
+
+#define STUFFING_WORST_CASE_PERIOD 4U
+#define STUFFING_EXPECTED_PERIOD 30U
+#define FIXED_STUFFING_PERIOD 4U
+
+#define PORT_PROBE_LIMIT 8U
+
+static_assert((BUSLOAD_MAX_TRACKED_PORTS & (BUSLOAD_MAX_TRACKED_PORTS - 1U)) == 0U, "Shall be a power of two");
+
+static uint32_t getStuffBits(const uint32_t stuffed_region_bits, const BusLoadStuffing stuffing)
+{
+    if (stuffing == BusLoadStuffingWorstCase)
+    {
+        return (stuffed_region_bits > 0U) ? ((stuffed_region_bits - 1U) / STUFFING_WORST_CASE_PERIOD) : 0U;
+    }
+    return (stuffed_region_bits + (STUFFING_EXPECTED_PERIOD / 2U)) / STUFFING_EXPECTED_PERIOD;
+}
+
+BusLoadFrameBits busloadComputeFrameBits(const size_t             payload_size,
+                                         const BusLoadFrameFormat format,
+                                         const BusLoadStuffing    stuffing)
+{
+    const size_t   clamped   = (payload_size < CANARD_MTU_CAN_FD) ? payload_size : CANARD_MTU_CAN_FD;
+    const uint32_t data_bits = 8U * CanardCANDLCToLength[CanardCANLengthToDLC[clamped]];
+
+    BusLoadFrameBits out = {0, 0};
+    if (format == BusLoadFrameFormatClassic)
+    {
+        const uint32_t stuffed = CLASSIC_HEADER_BITS + data_bits + CLASSIC_CRC_BITS;
+        out.nominal            = (uint16_t)(stuffed + getStuffBits(stuffed, stuffing) + TRAILER_BITS);
+    }
+    else
+    {
+        // The arbitration phase and the data phase are stuffed dynamically as one region; the split of the stuff
+        // bits between the two phases is proportional, the worst case being bounded by the whole region.
+        const uint32_t data_stuffed  = FD_CONTROL_BITS + data_bits;
+        const uint32_t all_stuff     = getStuffBits(FD_ARBITRATION_BITS + data_stuffed, stuffing);
+        const uint32_t arb_stuff     = getStuffBits(FD_ARBITRATION_BITS, stuffing);
+        const uint32_t data_stuff    = all_stuff - arb_stuff;
+        const uint32_t crc_bits      = (data_bits <= (8U * FD_CRC17_MAX_PAYLOAD)) ? FD_CRC17_BITS : FD_CRC21_BITS;
+        const uint32_t crc_field     = FD_STUFF_COUNT_BITS + crc_bits;
+        const uint32_t fixed_stuff   = (crc_field + FIXED_STUFFING_PERIOD - 1U) / FIXED_STUFFING_PERIOD;
+        const uint32_t nominal_phase = FD_ARBITRATION_BITS + arb_stuff + TRAILER_BITS;
+        const uint32_t data_phase    = data_stuffed + data_stuff + crc_field + fixed_stuff;
+        if (format == BusLoadFrameFormatFDBRS)
+        {
+            out.nominal = (uint16_t) nominal_phase;
+            out.data    = (uint16_t) data_phase;
+        }
+        else
+        {
+            out.nominal = (uint16_t)(nominal_phase + data_phase);
+        }
+    }
+    return out;
+}
+
+uint32_t busloadComputeFrameTimeNs(const BusLoadFrameBits bits,
+                                   const uint32_t         nominal_bitrate,
+                                   const uint32_t         data_bitrate)
+{
+    assert(nominal_bitrate > 0U);
+    const uint64_t data_rate = (data_bitrate > 0U) ? data_bitrate : nominal_bitrate;
+    const uint64_t ns        = ((bits.nominal * NANO_PER_SECOND) / nominal_bitrate) +  //
+                        ((bits.data * NANO_PER_SECOND) / data_rate);
+    return (uint32_t) ns;
+}
+
+static void windowAdvance(BusLoadWindow* const w, const uint64_t epoch)
+{
+    if (epoch > w->epoch)
+    {
+        if ((epoch - w->epoch) >= BUSLOAD_WINDOW_BINS)
+        {
+            (void) memset(w->bins_ns, 0, sizeof(w->bins_ns));
+            w->total_ns = 0U;
+        }
+        else
+        {
+            for (uint64_t e = w->epoch + 1U; e <= epoch; e++)
+            {
+                const size_t idx = (size_t)(e % BUSLOAD_WINDOW_BINS);
+                w->total_ns -= w->bins_ns[idx];
+                w->bins_ns[idx] = 0U;
+            }
+        }
+        w->epoch = epoch;
+    }
+}
+
+static void windowAdd(BusLoadWindow* const w, const uint64_t epoch, const uint32_t ns)
+{
+    windowAdvance(w, epoch);
+    w->bins_ns[w->epoch % BUSLOAD_WINDOW_BINS] += ns;
+    w->total_ns += ns;
+}
+
+static double windowGetUtilization(const BusLoadEstimator* const est, BusLoadWindow* const w, const uint64_t epoch)
+{
+    windowAdvance(w, epoch);
+    return ((double) w->total_ns) / ((double) (est->bin_usec * NANO_PER_MICRO * BUSLOAD_WINDOW_BINS));
+}
+
+static BusLoadWindow* findPortWindow(BusLoadEstimator* const est, const uint16_t key)
+{
+    size_t idx = (size_t)((key * UINT32_C(2654435761)) >> 16U) & (BUSLOAD_MAX_TRACKED_PORTS - 1U);
+    for (size_t i = 0; i < PORT_PROBE_LIMIT; i++)
+    {
+        BusLoadPortEntry* const entry = &est->per_port[idx];
+        if (entry->key == BUSLOAD_PORT_KEY_NONE)
+        {
+            entry->key = key;
+        }
+        if (entry->key == key)
+        {
+            return &entry->window;
+        }
+        idx = (idx + 1U) & (BUSLOAD_MAX_TRACKED_PORTS - 1U);
+    }
+    return &est->other_ports;
+}
+
+void busloadInit(BusLoadEstimator* const est,
+                 const uint32_t          nominal_bitrate,
+                 const uint32_t          data_bitrate,
+                 const CanardMicrosecond bin_usec)
+{
+    assert((bin_usec > 0U) && ((bin_usec * NANO_PER_MICRO) <= UINT32_MAX));
+    (void) memset(est, 0, sizeof(BusLoadEstimator));
+    est->nominal_bitrate = nominal_bitrate;
+    est->data_bitrate    = data_bitrate;
+    est->bin_usec        = bin_usec;
+    for (size_t s = 0; s < BUSLOAD_NUM_STUFFING_MODELS; s++)
+    {
+        for (size_t f = 0; f < BUSLOAD_NUM_FRAME_FORMATS; f++)
+        {
+            for (size_t dlc = 0; dlc < 16U; dlc++)
+            {
+                const BusLoadFrameBits bits =
+                    busloadComputeFrameBits(CanardCANDLCToLength[dlc], (BusLoadFrameFormat) f, (BusLoadStuffing) s);
+                est->frame_ns[s][f][dlc] = busloadComputeFrameTimeNs(bits, nominal_bitrate, data_bitrate);
+            }
+        }
+    }
+    for (size_t i = 0; i < BUSLOAD_MAX_TRACKED_PORTS; i++)
+    {
+        est->per_port[i].key = BUSLOAD_PORT_KEY_NONE;
+    }
+}
+
+void busloadAccept(BusLoadEstimator* const est, const CanardFrame* const frame, const BusLoadFrameFormat format)
+{
+    const size_t   size  = (frame->payload_size < CANARD_MTU_CAN_FD) ? frame->payload_size : CANARD_MTU_CAN_FD;
+    const uint8_t  dlc   = CanardCANLengthToDLC[size];
+    const uint64_t epoch = frame->timestamp_usec / est->bin_usec;
+    const uint32_t ns    = est->frame_ns[BusLoadStuffingExpected][format][dlc];
+    est->frame_count++;
+    windowAdd(&est->total[BusLoadStuffingExpected], epoch, ns);
+    windowAdd(&est->total[BusLoadStuffingWorstCase], epoch, est->frame_ns[BusLoadStuffingWorstCase][format][dlc]);
+
+    const uint32_t     can_id = frame->extended_can_id;
+    const CanardNodeID node   = canidGetSourceNodeID(can_id);
+    windowAdd(&est->per_priority[canidGetPriority(can_id)], epoch, ns);
+    windowAdd(&est->per_node[(node <= CANARD_NODE_ID_MAX) ? node : (BUSLOAD_NODE_SLOTS - 1U)], epoch, ns);
+    windowAdd(findPortWindow(est, canidGetPortKey(can_id)), epoch, ns);
+}
+
+double busloadGetUtilization(BusLoadEstimator* const est,
+                             const BusLoadStuffing   stuffing,
+                             const CanardMicrosecond now_usec)
+{
+    return windowGetUtilization(est, &est->total[stuffing], now_usec / est->bin_usec);
+}
+
+CanardNodeID busloadGetBusiestNode(BusLoadEstimator* const est,
+                                   const CanardMicrosecond now_usec,
+                                   double* const           out_utilization)
+{
+    const uint64_t epoch    = now_usec / est->bin_usec;
+    size_t         best     = 0;
+    double         best_val = -1.0;
+    for (size_t i = 0; i < BUSLOAD_NODE_SLOTS; i++)
+    {
+        const double u = windowGetUtilization(est, &est->per_node[i], epoch);
+        if (u > best_val)
+        {
+            best     = i;
+            best_val = u;
+        }
+    }
+    if (out_utilization != NULL)
+    {
+        *out_utilization = best_val;
+    }
+    return (best <= CANARD_NODE_ID_MAX) ? (CanardNodeID) best : CANARD_NODE_ID_UNSET;
+}
+
+void busloadWriteMetrics(BusLoadEstimator* const est, const CanardMicrosecond now_usec, MetricsSink* const sink)
+{
+    const uint64_t epoch = now_usec / est->bin_usec;
+    char           labels[64];
+    metricsGauge(sink, "busload_frames_total", NULL, (double) est->frame_count);
+    metricsGauge(sink,
+                 "busload_utilization",
+                 "stuffing=\"expected\"",
+                 windowGetUtilization(est, &est->total[BusLoadStuffingExpected], epoch));
+    metricsGauge(sink,
+                 "busload_utilization",
+                 "stuffing=\"worst\"",
+                 windowGetUtilization(est, &est->total[BusLoadStuffingWorstCase], epoch));
+    for (size_t i = 0; i <= CANARD_PRIORITY_MAX; i++)
+    {
+        (void) snprintf(labels, sizeof(labels), "priority=\"%u\"", (unsigned) i);
+        metricsGauge(sink, "busload_priority_utilization", labels, windowGetUtilization(est, &est->per_priority[i], epoch));
+    }
+    for (size_t i = 0; i < BUSLOAD_NODE_SLOTS; i++)
+    {
+        const double u = windowGetUtilization(est, &est->per_node[i], epoch);
+        if (u > 0.0)
+        {
+            if (i <= CANARD_NODE_ID_MAX)
+            {
+                (void) snprintf(labels, sizeof(labels), "node=\"%u\"", (unsigned) i);
+            }
+            else
+            {
+                (void) snprintf(labels, sizeof(labels), "node=\"anonymous\"");
+            }
+            metricsGauge(sink, "busload_node_utilization", labels, u);
+        }
+    }
+    for (size_t i = 0; i < BUSLOAD_MAX_TRACKED_PORTS; i++)
+    {
+        BusLoadPortEntry* const entry = &est->per_port[i];
+        if (entry->key != BUSLOAD_PORT_KEY_NONE)
+        {
+            const double u = windowGetUtilization(est, &entry->window, epoch);
+            if (u > 0.0)
+            {
+                (void) snprintf(labels,
+                                sizeof(labels),
+                                "kind=\"%s\",port=\"%u\"",
+                                canidGetPortKeyKindName(entry->key),
+                                (unsigned) (entry->key & CANID_PORT_KEY_PORT_MASK));
+                metricsGauge(sink, "busload_port_utilization", labels, u);
+            }
+        }
+    }
+    metricsGauge(sink, "busload_port_utilization", "kind=\"other\"", windowGetUtilization(est, &est->other_ports, epoch));
+}
@@ -0,0 +1,136 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Passive CAN bus load estimator. Every frame observed on the bus (received from other nodes, or emitted locally
+/// and looped back by the socket) is converted into its on-wire duration, which is then accumulated into sliding
+/// windows: the whole bus, per priority level, per source node, and per port (subject-ID or service-ID).
+///
+/// The on-wire duration is computed from the frame format: the arbitration field, the control field with the DLC,
+/// the data field, the CRC field, the fixed-length delimiters and the inter-frame space. Bit stuffing depends on the
+/// actual bit pattern, so it is modeled twice: the worst case (one stuff bit per four bits of the stuffed region)
+/// and the expected case (one stuff bit per 30 bits, which is the mean distance between stuff bits for uniformly
+/// random data). For CAN FD frames with the bit rate switch set, the data phase is timed at the data bit rate.
+/// The durations are tabulated per DLC at initialization, so accepting a frame is a table look-up.
+///
+/// Each sliding window is a ring of bins that is advanced lazily when it is updated or read, so the cost of
+/// accepting a frame is constant regardless of the number of tracked nodes and ports. The utilization reported for a
+/// window is the fraction of the window duration occupied by the frames; the bin currently being filled is included,
+/// so the reported value may lag the true value by at most one bin.
+
+#ifndef BUSLOAD_H_INCLUDED
+#define BUSLOAD_H_INCLUDED
+
+#include "canard.h"
+#include "metrics.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BUSLOAD_WINDOW_BINS 10U
+
+/// The number of ports tracked individually. Ports seen after the table is full are accounted as "other".
+/// Shall be a power of two.
+#define BUSLOAD_MAX_TRACKED_PORTS 64U
+
+/// The anonymous source is tracked in a separate slot after the regular node-IDs.
+#define BUSLOAD_NODE_SLOTS (CANARD_NODE_ID_MAX + 2U)
+
+typedef enum
+{
+    BusLoadStuffingExpected = 0,
+    BusLoadStuffingWorstCase,
+} BusLoadStuffing;
+#define BUSLOAD_NUM_STUFFING_MODELS 2U
+
+typedef enum
+{
+    BusLoadFrameFormatClassic = 0,
+    BusLoadFrameFormatFD,     ///< CAN FD without the bit rate switch.
+    BusLoadFrameFormatFDBRS,  ///< CAN FD with the data phase transmitted at the data bit rate.
+} BusLoadFrameFormat;
+#define BUSLOAD_NUM_FRAME_FORMATS 3U
+
+/// The number of bits of a frame transmitted at the nominal and at the data bit rates.
+typedef struct BusLoadFrameBits
+{
+    uint16_t nominal;
+    uint16_t data;
+} BusLoadFrameBits;
+
+typedef struct BusLoadWindow
+{
+    uint64_t epoch;  ///< The index of the bin being filled, counted from the origin of the time axis.
+    uint64_t total_ns;
+    uint32_t bins_ns[BUSLOAD_WINDOW_BINS];
+} BusLoadWindow;
+
+typedef struct BusLoadPortEntry
+{
+    uint16_t      key;  ///< Transfer kind and port-ID; BUSLOAD_PORT_KEY_NONE if the entry is vacant.
+    BusLoadWindow window;
+} BusLoadPortEntry;
+#define BUSLOAD_PORT_KEY_NONE 0xFFFFU
+
+typedef struct BusLoadEstimator
+{
+    uint32_t          nominal_bitrate;
+    uint32_t          data_bitrate;
+    CanardMicrosecond bin_usec;
+    uint32_t          frame_ns[BUSLOAD_NUM_STUFFING_MODELS][BUSLOAD_NUM_FRAME_FORMATS][16];
+
+    uint64_t         frame_count;
+    BusLoadWindow    total[BUSLOAD_NUM_STUFFING_MODELS];
+    BusLoadWindow    per_priority[CANARD_PRIORITY_MAX + 1U];
+    BusLoadWindow    per_node[BUSLOAD_NODE_SLOTS];
+    BusLoadPortEntry per_port[BUSLOAD_MAX_TRACKED_PORTS];
+    BusLoadWindow    other_ports;
+} BusLoadEstimator;
+
+/// Compute the number of bits of an extended-ID data frame carrying the specified number of bytes.
+/// The payload size is rounded up to the nearest valid DLC; values above 64 are treated as 64.
+BusLoadFrameBits busloadComputeFrameBits(const size_t             payload_size,
+                                         const BusLoadFrameFormat format,
+                                         const BusLoadStuffing    stuffing);
+
+/// Convert the frame bits into the on-wire duration in nanoseconds at the specified bit rates.
+/// If the data bit rate is zero, the nominal bit rate is used for the data phase.
+uint32_t busloadComputeFrameTimeNs(const BusLoadFrameBits bits,
+                                   const uint32_t         nominal_bitrate,
+                                   const uint32_t         data_bitrate);
+
+/// The window duration is BUSLOAD_WINDOW_BINS * bin_usec. The bin duration shall not exceed 4 seconds.
+/// The data bit rate is only relevant for CAN FD frames with the bit rate switch set; zero means no switching.
+void busloadInit(BusLoadEstimator* const est,
+                 const uint32_t          nominal_bitrate,
+                 const uint32_t          data_bitrate,
+                 const CanardMicrosecond bin_usec);
+
+/// Account one frame observed on the bus. The frame timestamp defines its position on the time axis;
+/// the timestamps are expected to be non-decreasing (late frames are accounted into the current bin).
+/// The time complexity is constant.
+void busloadAccept(BusLoadEstimator* const est, const CanardFrame* const frame, const BusLoadFrameFormat format);
+
+/// The utilization of the bus over the sliding window ending at the specified time, in [0, 1].
+/// Values above 1 indicate that the configured bit rates do not match the bus.
+double busloadGetUtilization(BusLoadEstimator* const est,
+                             const BusLoadStuffing   stuffing,
+                             const CanardMicrosecond now_usec);
+
+/// Returns the node-ID with the largest share of the bus over the sliding window and its utilization.
+/// The anonymous source is reported as CANARD_NODE_ID_UNSET. The time complexity is linear of the number of nodes.
+CanardNodeID busloadGetBusiestNode(BusLoadEstimator* const est,
+                                   const CanardMicrosecond now_usec,
+                                   double* const           out_utilization);
+
+/// Export the utilization values via the metrics surface. Zero-valued nodes and ports are omitted.
+void busloadWriteMetrics(BusLoadEstimator* const est, const CanardMicrosecond now_usec, MetricsSink* const sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Accessors for the fields of a UAVCAN/CAN extended CAN ID, for the modules that observe or patch raw frames
+/// without going through the libcanard RX pipeline. The layout is defined by the UAVCAN/CAN specification;
+/// the same constants are used privately in canard.c.
+
+#ifndef CANID_H_INCLUDED
+#define CANID_H_INCLUDED
+
+#include "canard.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CANID_OFFSET_PRIORITY 26U
+#define CANID_OFFSET_SUBJECT_ID 8U
+#define CANID_OFFSET_SERVICE_ID 14U
+#define CANID_OFFSET_DST_NODE_ID 7U
+#define CANID_FLAG_SERVICE_NOT_MESSAGE (UINT32_C(1) << 25U)
+#define CANID_FLAG_ANONYMOUS_MESSAGE (UINT32_C(1) << 24U)
+#define CANID_FLAG_REQUEST_NOT_RESPONSE (UINT32_C(1) << 24U)
+
+/// A port key combines the transfer kind with the port-ID into a 15-bit value that identifies a port uniquely.
+#define CANID_PORT_KEY_KIND_OFFSET 13U
+#define CANID_PORT_KEY_PORT_MASK ((1U << CANID_PORT_KEY_KIND_OFFSET) - 1U)
+
+static inline CanardPriority canidGetPriority(const uint32_t can_id)
+{
+    return (CanardPriority)((can_id >> CANID_OFFSET_PRIORITY) & CANARD_PRIORITY_MAX);
+}
+
+static inline uint32_t canidSetPriority(const uint32_t can_id, const CanardPriority priority)
+{
+    const uint32_t mask = ((uint32_t) CANARD_PRIORITY_MAX) << CANID_OFFSET_PRIORITY;
+    return (can_id & ~mask) | ((((uint32_t) priority) << CANID_OFFSET_PRIORITY) & mask);
+}
+
+static inline CanardTransferKind canidGetTransferKind(const uint32_t can_id)
+{
+    if (0U == (can_id & CANID_FLAG_SERVICE_NOT_MESSAGE))
+    {
+        return CanardTransferKindMessage;
+    }
+    return ((can_id & CANID_FLAG_REQUEST_NOT_RESPONSE) != 0U) ? CanardTransferKindRequest
+                                                              : CanardTransferKindResponse;
+}
+
+static inline CanardPortID canidGetPortID(const uint32_t can_id)
+{
+    if (0U == (can_id & CANID_FLAG_SERVICE_NOT_MESSAGE))
+    {
+        return (CanardPortID)((can_id >> CANID_OFFSET_SUBJECT_ID) & CANARD_SUBJECT_ID_MAX);
+    }
+    return (CanardPortID)((can_id >> CANID_OFFSET_SERVICE_ID) & CANARD_SERVICE_ID_MAX);
+}
+
+/// Returns CANARD_NODE_ID_UNSET for anonymous messages.
+static inline CanardNodeID canidGetSourceNodeID(const uint32_t can_id)
+{
+    if ((0U == (can_id & CANID_FLAG_SERVICE_NOT_MESSAGE)) && ((can_id & CANID_FLAG_ANONYMOUS_MESSAGE) != 0U))
+    {
+        return CANARD_NODE_ID_UNSET;
+    }
+    return (CanardNodeID)(can_id & CANARD_NODE_ID_MAX);
+}
+
+/// Returns the CAN ID of the frames of a response transfer sent by the source node; the node-IDs shall be valid.
+static inline uint32_t canidMakeResponse(const CanardPriority priority,
+                                         const CanardPortID   service_id,
+                                         const CanardNodeID   destination_node_id,
+                                         const CanardNodeID   source_node_id)
+{
+    return (((uint32_t) priority) << CANID_OFFSET_PRIORITY) | CANID_FLAG_SERVICE_NOT_MESSAGE |
+           (((uint32_t) service_id) << CANID_OFFSET_SERVICE_ID) |
+           (((uint32_t) destination_node_id) << CANID_OFFSET_DST_NODE_ID) | ((uint32_t) source_node_id);
+}
+
+static inline uint16_t canidGetPortKey(const uint32_t can_id)
+{
+    return (uint16_t)((((uint16_t) canidGetTransferKind(can_id)) << CANID_PORT_KEY_KIND_OFFSET) |
+                      canidGetPortID(can_id));
+}
+
+/// Returns a static string naming the transfer kind encoded in the port key.
+static inline const char* canidGetPortKeyKindName(const uint16_t key)
+{
+    static const char* const Names[CANARD_NUM_TRANSFER_KINDS] = {"message", "response", "request"};
+    const unsigned           kind                              = (unsigned) key >> CANID_PORT_KEY_KIND_OFFSET;
+    return (kind < CANARD_NUM_TRANSFER_KINDS) ? Names[kind] : "invalid";
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,131 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "demand.h"
+#include <canard_dsdl.h>
+#include <string.h>
+
+#define DEMAND_SUBJECT_LIST_MASK 0U
+#define DEMAND_SUBJECT_LIST_SPARSE 1U
+#define DEMAND_SUBJECT_LIST_TOTAL 2U
+
+void demandInit(DemandTracker* const    tracker,
+                SensorBackend* const    sensor,
+                BurstCapture* const     burst,
+                const CanardPortID      subject_id,
+                const uint32_t          active_period_usec,
+                const uint32_t          idle_period_usec,
+                const CanardMicrosecond timeout_usec,
+                const CanardMicrosecond now_usec)
+{
+    (void) memset(tracker, 0, sizeof(DemandTracker));
+    tracker->sensor             = sensor;
+    tracker->burst              = burst;
+    tracker->subject_id         = subject_id;
+    tracker->active_period_usec = active_period_usec;
+    tracker->idle_period_usec   = idle_period_usec;
+    tracker->timeout_usec       = timeout_usec;
+    tracker->startup_until_usec = now_usec + timeout_usec;
+    tracker->period_usec        = active_period_usec;
+}
+
+/// Switches the sensor to the period that the demand calls for, unless a burst capture owns the trigger period.
+/// The burst capture reverts to the period set here when it is over.
+static void demandApply(DemandTracker* const tracker, const CanardMicrosecond now_usec)
+{
+    const uint32_t active   = tracker->active_period_usec;
+    const uint32_t idle     = ((tracker->idle_period_usec + active - 1U) / active) * active;
+    const bool     wanted   = (tracker->idle_period_usec == 0U) || (tracker->num_subscribers > 0U) ||
+                        (now_usec < tracker->startup_until_usec);
+    const uint32_t period   = wanted ? active : idle;
+    const bool     bursting = (tracker->burst != NULL) && atomic_load(&tracker->burst->active);
+    if ((period != tracker->period_usec) && !bursting &&
+        (tracker->sensor->setTriggerPeriod(tracker->sensor, period) >= 0))
+    {
+        tracker->period_usec = period;
+        tracker->transitions++;
+        if (tracker->burst != NULL)
+        {
+            tracker->burst->normal_period_usec = period;
+        }
+    }
+}
+
+void demandSetActivePeriod(DemandTracker* const tracker, const uint32_t period_usec, const CanardMicrosecond now_usec)
+{
+    tracker->active_period_usec = period_usec;
+    demandApply(tracker, now_usec);
+}
+
+static bool demandIsListed(const CanardDSDLView subjects, const CanardPortID subject_id)
+{
+    bool         listed = false;
+    const size_t tag    = canardDSDLGetU8(subjects.data, subjects.size, 0U, 8U);
+    if (tag == DEMAND_SUBJECT_LIST_MASK)
+    {
+        listed = canardDSDLGetBit(subjects.data, subjects.size, 8U + subject_id);
+    }
+    else if (tag == DEMAND_SUBJECT_LIST_SPARSE)
+    {
+        const size_t count = canardDSDLGetU8(subjects.data, subjects.size, 8U, 8U);
+        for (size_t i = 0; (i < count) && !listed; i++)
+        {
+            listed = canardDSDLGetU16(subjects.data, subjects.size, 16U + (i * 16U), 13U) == subject_id;
+        }
+    }
+    else
+    {
+        listed = (tag == DEMAND_SUBJECT_LIST_TOTAL);
+    }
+    return listed;
+}
+
+void demandOnPortList(DemandTracker* const tracker, const CanardTransfer* const transfer)
+{
+    const uint8_t* const payload     = (const uint8_t*) transfer->payload;
+    CanardDSDLView       publishers  = {NULL, 0U};
+    CanardDSDLView       subscribers = {NULL, 0U};
+    const int64_t        off         = canardDSDLGetDelimited(payload, transfer->payload_size, 0U, &publishers);
+    if ((off < 0) || (canardDSDLGetDelimited(payload, transfer->payload_size, (size_t) off, &subscribers) < 0))
+    {
+        tracker->malformed++;  // E.g., a newer version of the list that does not fit into the extent.
+    }
+    else if (transfer->remote_node_id <= CANARD_NODE_ID_MAX)  // The anonymous nodes cannot be told apart.
+    {
+        const bool               listed = demandIsListed(subscribers, tracker->subject_id);
+        CanardMicrosecond* const seen   = &tracker->seen_at_usec[transfer->remote_node_id];
+        if (listed && (*seen == 0U))
+        {
+            tracker->num_subscribers++;
+        }
+        else if (!listed && (*seen != 0U))
+        {
+            tracker->num_subscribers--;
+        }
+        *seen = listed ? transfer->timestamp_usec : 0U;
+        demandApply(tracker, transfer->timestamp_usec);
+    }
+}
+
+void demandPoll(DemandTracker* const tracker, const CanardMicrosecond now_usec)
+{
+    for (size_t i = 0; i <= CANARD_NODE_ID_MAX; i++)
+    {
+        CanardMicrosecond* const seen = &tracker->seen_at_usec[i];
+        if ((*seen != 0U) && (now_usec > *seen) && ((now_usec - *seen) > tracker->timeout_usec))
+        {
+            *seen = 0U;
+            tracker->num_subscribers--;
+        }
+    }
+    demandApply(tracker, now_usec);
+}
+
+void demandWriteMetrics(const DemandTracker* const tracker, MetricsSink* const sink)
+{
+    metricsGauge(sink, "demand_subscribers", NULL, (double) tracker->num_subscribers);
+    metricsGauge(sink, "demand_trigger_period_seconds", NULL, (double) tracker->period_usec * 1e-6);
+    metricsGauge(sink, "demand_transitions_total", NULL, (double) tracker->transitions);
+    metricsGauge(sink, "demand_malformed_lists_total", NULL, (double) tracker->malformed);
+}
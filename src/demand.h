@@ -0,0 +1,91 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Demand-driven sampling: the sensor is triggered at the full rate only while some node on the bus subscribes to the
+/// distance subject, and at a keep-alive rate otherwise, which saves the CPU, the bus bandwidth, and the sensor.
+///
+/// The subscribers are learned from uavcan.node.port.List, which every node publishes at least every 10 seconds and
+/// whenever its set of ports changes. A node that lists the subject (in the mask, in the sparse list, or as a
+/// subscriber of all subjects) is a subscriber until it publishes a list without the subject or goes silent for the
+/// timeout. A new subscriber restores the full rate as soon as its list is received; the rate drops to the keep-alive
+/// rate once the last subscriber is gone. After the start, the full rate is kept for one timeout, so that the nodes
+/// already on the bus have the time to publish their lists.
+///
+/// The tracker owns the trigger period of the normal operation, which the other users change through it (see tdma.h).
+/// The keep-alive period is rounded up to a whole number of active periods, so that an aligned trigger stays in its
+/// slot. A burst capture owns the trigger period while it runs; a change is applied when the burst is over.
+///
+/// Only the publishers and the subscribers are read from the list, the ports of the services are not needed:
+///     SubjectIDList.0.1 publishers   # Delimited; the union tag is followed by the selected field:
+///     SubjectIDList.0.1 subscribers  #     0: bool[8192] mask, 1: SubjectID.1.0[<=255] sparse_list, 2: Empty total
+///     ServiceIDList.0.1 clients
+///     ServiceIDList.0.1 servers
+
+#ifndef DEMAND_H_INCLUDED
+#define DEMAND_H_INCLUDED
+
+#include "burst.h"
+#include "metrics.h"
+#include "sensor.h"
+#include <canard.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DEMAND_PORT_LIST_SUBJECT_ID 7510U
+/// The publishers and the subscribers of the largest form, the masks; the service lists are cut off by libcanard.
+#define DEMAND_PORT_LIST_EXTENT (2U * (4U + 1U + 1024U))
+/// Three times the maximal publication period of the port list, so that a lost list does not drop the subscriber.
+#define DEMAND_DEFAULT_TIMEOUT_USEC 30000000U
+
+typedef struct DemandTracker
+{
+    SensorBackend*    sensor;
+    BurstCapture*     burst;  ///< NULL if the burst capture is not used.
+    CanardPortID      subject_id;
+    uint32_t          active_period_usec;
+    uint32_t          idle_period_usec;
+    CanardMicrosecond timeout_usec;
+    CanardMicrosecond startup_until_usec;
+
+    CanardMicrosecond seen_at_usec[CANARD_NODE_ID_MAX + 1U];  ///< The last list with the subject; zero if none.
+    uint32_t          num_subscribers;
+    uint32_t          period_usec;  ///< The trigger period in effect.
+    uint64_t          transitions;
+    uint64_t          malformed;  ///< The lists that could not be parsed.
+} DemandTracker;
+
+/// The sensor shall be triggered at the active period already, as it is during the startup. A zero idle period
+/// disables the demand-driven sampling: the sensor is always triggered at the active period.
+void demandInit(DemandTracker* const    tracker,
+                SensorBackend* const    sensor,
+                BurstCapture* const     burst,
+                const CanardPortID      subject_id,
+                const uint32_t          active_period_usec,
+                const uint32_t          idle_period_usec,
+                const CanardMicrosecond timeout_usec,
+                const CanardMicrosecond now_usec);
+
+/// Shall be invoked for every received uavcan.node.port.List transfer; the anonymous ones are ignored.
+/// The trigger period is updated at once if the demand changes.
+void demandOnPortList(DemandTracker* const tracker, const CanardTransfer* const transfer);
+
+/// Changes the period of the triggers while the distance is in demand; applied at once unless a burst is running.
+void demandSetActivePeriod(DemandTracker* const tracker, const uint32_t period_usec, const CanardMicrosecond now_usec);
+
+/// Shall be invoked from the main loop periodically, e.g., once a second: forgets the subscribers that went silent,
+/// ends the startup, and applies a change of the demand that was deferred by a burst capture.
+/// The time complexity is linear in the number of node-IDs.
+void demandPoll(DemandTracker* const tracker, const CanardMicrosecond now_usec);
+
+void demandWriteMetrics(const DemandTracker* const tracker, MetricsSink* const sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
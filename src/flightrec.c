@@ -0,0 +1,274 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+// This is needed to enable the necessary declarations in sys/ (MAP_POPULATE).
+#ifndef _GNU_SOURCE
+#    define _GNU_SOURCE
+#endif
+
+#include "flightrec.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+_Static_assert(sizeof(FlightRecRecord) == FLIGHTREC_RECORD_SIZE, "Unexpected record layout");
+_Static_assert(sizeof(FlightRecHeader) <= FLIGHTREC_HEADER_SIZE, "Unexpected header layout");
+_Static_assert(sizeof(FlightRecPublish) <= FLIGHTREC_RECORD_PAYLOAD_SIZE, "Unexpected payload size");
+_Static_assert(sizeof(FlightRecBusEvent) <= FLIGHTREC_RECORD_PAYLOAD_SIZE, "Unexpected payload size");
+
+#define VARINT_SIZE_MAX 10U
+
+static bool flightrecHeaderIsValid(const FlightRecHeader* const header, const uint32_t capacity)
+{
+    return (0 == memcmp(header->magic, FLIGHTREC_MAGIC, sizeof(FLIGHTREC_MAGIC))) &&
+           (header->version == FLIGHTREC_VERSION) && (header->record_size == FLIGHTREC_RECORD_SIZE) &&
+           (header->capacity == capacity);
+}
+
+int16_t flightrecOpen(FlightRecorder* const recorder, const char* const path, const uint32_t capacity)
+{
+    (void) memset(recorder, 0, sizeof(FlightRecorder));
+    if ((capacity == 0U) || ((capacity & (capacity - 1U)) != 0U))
+    {
+        return -EINVAL;
+    }
+    const size_t map_size = FLIGHTREC_HEADER_SIZE + ((size_t) capacity * FLIGHTREC_RECORD_SIZE);
+
+    const int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        return (int16_t) -errno;
+    }
+    struct stat st;
+    int         result = (fstat(fd, &st) == 0) ? 0 : errno;
+    if ((result == 0) && (st.st_size != (off_t) map_size))
+    {
+        // A file of a different capacity is not worth converting; start over.
+        result = (ftruncate(fd, 0) == 0) ? 0 : errno;
+    }
+    if (result == 0)
+    {
+        // Allocate the blocks now: a write fault on a sparse file with the disk full would kill the process.
+        result = posix_fallocate(fd, 0, (off_t) map_size);
+    }
+    void* map = MAP_FAILED;
+    if (result == 0)
+    {
+        map    = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+        result = (map != MAP_FAILED) ? 0 : errno;
+    }
+    (void) close(fd);  // The mapping keeps the file open.
+    if (result != 0)
+    {
+        return (int16_t) -result;
+    }
+
+    FlightRecHeader* const header = (FlightRecHeader*) map;
+    if (!flightrecHeaderIsValid(header, capacity))
+    {
+        (void) memset(map, 0, map_size);
+        (void) memcpy(header->magic, FLIGHTREC_MAGIC, sizeof(FLIGHTREC_MAGIC));
+        header->version     = FLIGHTREC_VERSION;
+        header->record_size = FLIGHTREC_RECORD_SIZE;
+        header->capacity    = capacity;
+        atomic_init(&header->head, 0U);
+    }
+    recorder->header     = header;
+    recorder->records    = (FlightRecRecord*) (void*) ((uint8_t*) map + FLIGHTREC_HEADER_SIZE);
+    recorder->index_mask = capacity - 1U;
+    recorder->map_size   = map_size;
+    return 0;
+}
+
+void flightrecClose(FlightRecorder* const recorder)
+{
+    if (recorder->header != NULL)
+    {
+        (void) munmap(recorder->header, recorder->map_size);
+    }
+    (void) memset(recorder, 0, sizeof(FlightRecorder));
+}
+
+/// Invalidates the oldest slot and returns it for writing; the caller publishes it by storing the sequence number.
+static FlightRecRecord* flightrecReserve(FlightRecorder* const recorder, uint64_t* const out_seq)
+{
+    const uint64_t index  = atomic_fetch_add_explicit(&recorder->header->head, 1U, memory_order_relaxed);
+    FlightRecRecord* const rec = &recorder->records[index & recorder->index_mask];
+    atomic_store_explicit(&rec->seq, 0U, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);  // The invalidation is visible before any of the new contents.
+    *out_seq = index + 1U;
+    return rec;
+}
+
+void flightrecWrite(FlightRecorder* const     recorder,
+                    const FlightRecRecordType type,
+                    const CanardMicrosecond   timestamp_usec,
+                    const void* const         payload,
+                    const size_t              payload_size)
+{
+    if ((recorder->header != NULL) && (payload_size <= FLIGHTREC_RECORD_PAYLOAD_SIZE))
+    {
+        uint64_t               seq = 0;
+        FlightRecRecord* const rec = flightrecReserve(recorder, &seq);
+        rec->type                  = (uint8_t) type;
+        rec->stream                = 0U;
+        rec->timestamp_usec        = timestamp_usec;
+        (void) memcpy(rec->payload, payload, payload_size);
+        atomic_store_explicit(&rec->usage, (uint32_t) payload_size, memory_order_relaxed);
+        atomic_store_explicit(&rec->seq, seq, memory_order_release);
+    }
+}
+
+void flightrecSampleWriterInit(FlightRecSampleWriter* const writer,
+                               FlightRecorder* const        recorder,
+                               const uint8_t                stream)
+{
+    (void) memset(writer, 0, sizeof(FlightRecSampleWriter));
+    writer->recorder = recorder;
+    writer->stream   = stream;
+}
+
+static size_t flightrecEncodeVarint(uint8_t* const out, uint64_t value)
+{
+    size_t size = 0;
+    while (value >= 0x80U)
+    {
+        out[size++] = (uint8_t)((value & 0x7FU) | 0x80U);
+        value >>= 7U;
+    }
+    out[size++] = (uint8_t) value;
+    return size;
+}
+
+static size_t flightrecDecodeVarint(const uint8_t* const in, const size_t size, uint64_t* const out_value)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; (i < size) && (i < VARINT_SIZE_MAX); i++)
+    {
+        value |= (uint64_t)(in[i] & 0x7FU) << (7U * i);
+        if ((in[i] & 0x80U) == 0U)
+        {
+            *out_value = value;
+            return i + 1U;
+        }
+    }
+    return 0;  // Truncated.
+}
+
+static size_t flightrecEncodeSample(const FlightRecSampleWriter* const writer,
+                                    uint8_t* const                     out,
+                                    const CanardMicrosecond            timestamp_usec,
+                                    const int32_t                      value)
+{
+    const int64_t  value_delta = (int64_t) value - (int64_t) writer->last_value;
+    const uint64_t zigzag      = ((uint64_t) value_delta << 1U) ^ (uint64_t)(value_delta >> 63U);
+    const size_t   size        = flightrecEncodeVarint(out, timestamp_usec - writer->last_timestamp_usec);
+    return size + flightrecEncodeVarint(&out[size], zigzag);
+}
+
+void flightrecSample(FlightRecSampleWriter* const writer, const CanardMicrosecond timestamp_usec, const int32_t value)
+{
+    FlightRecorder* const recorder = writer->recorder;
+    if (recorder->header == NULL)
+    {
+        return;
+    }
+    uint8_t encoded[VARINT_SIZE_MAX * 2U];
+    size_t  size = flightrecEncodeSample(writer, encoded, timestamp_usec, value);
+    // Start a new block if the current one is full or has been recycled by the other writers meanwhile.
+    if ((writer->block == NULL) || ((writer->used + size) > FLIGHTREC_RECORD_PAYLOAD_SIZE) ||
+        (atomic_load_explicit(&writer->block->seq, memory_order_relaxed) != writer->block_seq))
+    {
+        FlightRecRecord* const rec  = flightrecReserve(recorder, &writer->block_seq);
+        rec->type                   = (uint8_t) FlightRecRecordSamples;
+        rec->stream                 = writer->stream;
+        rec->timestamp_usec         = timestamp_usec;
+        atomic_store_explicit(&rec->usage, 0U, memory_order_relaxed);
+        atomic_store_explicit(&rec->seq, writer->block_seq, memory_order_release);
+        writer->block               = rec;
+        writer->count               = 0U;
+        writer->used                = 0U;
+        writer->last_timestamp_usec = timestamp_usec;
+        writer->last_value          = 0;
+        size                        = flightrecEncodeSample(writer, encoded, timestamp_usec, value);
+    }
+    (void) memcpy(&writer->block->payload[writer->used], encoded, size);
+    writer->used = (uint16_t)(writer->used + size);
+    writer->count++;
+    writer->last_timestamp_usec = timestamp_usec;
+    writer->last_value          = value;
+    // The sample becomes visible to the readers, and survives a crash, once the usage is updated.
+    atomic_store_explicit(&writer->block->usage,
+                          ((uint32_t) writer->count << 16U) | writer->used,
+                          memory_order_release);
+}
+
+bool flightrecRead(const FlightRecHeader* const header,
+                   const FlightRecRecord* const records,
+                   const uint64_t               seq,
+                   FlightRecRecordCopy* const   out)
+{
+    const uint64_t head = atomic_load_explicit(&header->head, memory_order_acquire);
+    if ((seq == 0U) || (seq > head) || ((head - seq) >= header->capacity))
+    {
+        return false;  // Not written yet or already overwritten.
+    }
+    const FlightRecRecord* const rec = &records[(seq - 1U) & (header->capacity - 1U)];
+    if (atomic_load_explicit(&rec->seq, memory_order_acquire) != seq)
+    {
+        return false;  // Being written, or torn by a crash.
+    }
+    const uint32_t usage = atomic_load_explicit(&rec->usage, memory_order_acquire);
+    out->seq             = seq;
+    out->type            = rec->type;
+    out->stream          = rec->stream;
+    out->timestamp_usec  = rec->timestamp_usec;
+    (void) memcpy(out->payload, rec->payload, sizeof(out->payload));
+    if (out->type == (uint8_t) FlightRecRecordSamples)
+    {
+        out->count = (uint16_t)(usage >> 16U);
+        out->size  = (uint16_t)(usage & 0xFFFFU);
+    }
+    else
+    {
+        out->count = 0U;
+        out->size  = (uint16_t) usage;
+    }
+    atomic_thread_fence(memory_order_acquire);
+    return (atomic_load_explicit(&rec->seq, memory_order_relaxed) == seq) &&
+           (out->size <= FLIGHTREC_RECORD_PAYLOAD_SIZE);
+}
+
+size_t flightrecDecodeSamples(const FlightRecRecordCopy* const copy,
+                              const size_t                     capacity,
+                              CanardMicrosecond* const         out_timestamps_usec,
+                              int32_t* const                   out_values)
+{
+    CanardMicrosecond timestamp_usec = copy->timestamp_usec;
+    int64_t           value          = 0;
+    size_t            offset         = 0;
+    size_t            count          = 0;
+    while ((count < copy->count) && (count < capacity))
+    {
+        uint64_t     timestamp_delta = 0;
+        uint64_t     zigzag          = 0;
+        const size_t a = flightrecDecodeVarint(&copy->payload[offset], copy->size - offset, &timestamp_delta);
+        const size_t b = (a > 0U) ? flightrecDecodeVarint(&copy->payload[offset + a], copy->size - offset - a, &zigzag)
+                                  : 0U;
+        if (b == 0U)
+        {
+            break;  // Corrupted.
+        }
+        offset += a + b;
+        timestamp_usec += timestamp_delta;
+        value += (int64_t)(zigzag >> 1U) ^ -(int64_t)(zigzag & 1U);
+        out_timestamps_usec[count] = timestamp_usec;
+        out_values[count]          = (int32_t) value;
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,164 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Black-box flight recorder. The recent history of the node (raw sensor samples, publication decisions, bus events)
+/// is kept in a ring of fixed-size records in a memory-mapped file. The data lives in the page cache, so it survives
+/// a crash of the process (but not a power loss unless flushed) and can be extracted post mortem with the reader tool
+/// (tools/flightrec_dump.c). The file is reused after a restart: the recording continues after the last record.
+///
+/// The records are written lock-free from any thread: a writer reserves a slot by incrementing the shared head
+/// counter atomically, then fills the slot and publishes it by storing its sequence number (the slot index plus one)
+/// with release semantics. A slot being overwritten has the sequence number zeroed first, so a reader that observes
+/// the same expected sequence number before and after copying a record is guaranteed to have a consistent copy;
+/// torn records (e.g., the one being written when the process crashed) are skipped.
+///
+/// Sensor samples are packed into sample block records. A block is written in place: every sample is appended to the
+/// reserved slot and published by updating the sample count, so that at most the sample being written is lost in a
+/// crash. The samples are encoded as zigzag varint deltas of the timestamp and the value relative to the previous
+/// sample, which typically takes 3-4 bytes per sample at 1 kHz.
+
+#ifndef FLIGHTREC_H_INCLUDED
+#define FLIGHTREC_H_INCLUDED
+
+#include "canard.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define FLIGHTREC_MAGIC "FLTREC1"
+#define FLIGHTREC_VERSION 1U
+#define FLIGHTREC_HEADER_SIZE 4096U  ///< The records start at the next page.
+#define FLIGHTREC_RECORD_SIZE 64U
+#define FLIGHTREC_RECORD_PAYLOAD_SIZE 40U
+
+typedef enum
+{
+    FlightRecRecordSamples = 1,  ///< Payload: varint-encoded sample deltas, see the file header.
+    FlightRecRecordPublish = 2,  ///< Payload: FlightRecPublish.
+    FlightRecRecordBus     = 3,  ///< Payload: FlightRecBusEvent.
+} FlightRecRecordType;
+
+typedef struct FlightRecHeader
+{
+    char             magic[8];
+    uint32_t         version;
+    uint32_t         record_size;
+    uint64_t         capacity;  ///< The number of record slots.
+    _Atomic uint64_t head;      ///< The number of slots reserved since the file was created.
+} FlightRecHeader;
+
+typedef struct FlightRecRecord
+{
+    _Atomic uint64_t  seq;     ///< The slot index plus one; zero while the slot is being (re)written.
+    _Atomic uint32_t  usage;   ///< Sample blocks: (sample count << 16) | payload bytes used; otherwise, payload size.
+    uint8_t           type;    ///< FlightRecRecordType.
+    uint8_t           stream;  ///< Sample blocks: the identifier of the sample stream (e.g., the sensor index).
+    uint16_t          reserved;
+    CanardMicrosecond timestamp_usec;  ///< Sample blocks: the timestamp of the first sample.
+    uint8_t           payload[FLIGHTREC_RECORD_PAYLOAD_SIZE];
+} FlightRecRecord;
+
+typedef struct FlightRecPublish
+{
+    CanardPortID     port_id;
+    CanardTransferID transfer_id;
+    uint8_t          priority;
+    int32_t          result;  ///< The result of canardTxPush() or canardTxPushFrameUnchecked().
+    float            value;   ///< The published value, if the message carries a single one (e.g., the distance).
+} FlightRecPublish;
+
+typedef enum
+{
+    FlightRecBusTxDropped   = 0,  ///< A frame was dropped; error holds socketcanPush() result or -ETIMEDOUT.
+    FlightRecBusUtilization = 1,  ///< Periodic bus load snapshot; value holds the utilization.
+} FlightRecBusEventKind;
+
+typedef struct FlightRecBusEvent
+{
+    uint8_t  kind;  ///< FlightRecBusEventKind.
+    uint32_t can_id;
+    int32_t  error;
+    float    value;
+} FlightRecBusEvent;
+
+typedef struct FlightRecorder
+{
+    FlightRecHeader* header;  ///< NULL if the recorder is not open; all writes are then ignored.
+    FlightRecRecord* records;
+    uint64_t         index_mask;  ///< The capacity minus one.
+    size_t           map_size;
+} FlightRecorder;
+
+/// A writer of one sample stream. Each stream shall be written from one thread at a time.
+typedef struct FlightRecSampleWriter
+{
+    FlightRecorder*   recorder;
+    uint8_t           stream;
+    FlightRecRecord*  block;  ///< The open sample block; NULL if none.
+    uint64_t          block_seq;
+    uint16_t          count;
+    uint16_t          used;
+    CanardMicrosecond last_timestamp_usec;
+    int32_t           last_value;
+} FlightRecSampleWriter;
+
+/// Opens the ring file, creating it if it does not exist or if it was created with a different capacity or layout.
+/// The capacity is the number of records; it shall be a power of two. The file is preallocated and the mapping is
+/// prefaulted, so that the writers never block on the file system.
+/// Returns zero on success, negated errno on failure.
+int16_t flightrecOpen(FlightRecorder* const recorder, const char* const path, const uint32_t capacity);
+
+/// Unmaps the file; the contents are left in the page cache and written back by the kernel eventually.
+void flightrecClose(FlightRecorder* const recorder);
+
+/// Writes one record of the specified type with a payload of up to FLIGHTREC_RECORD_PAYLOAD_SIZE bytes.
+/// Safe to invoke from any thread concurrently. The time complexity is constant.
+void flightrecWrite(FlightRecorder* const     recorder,
+                    const FlightRecRecordType type,
+                    const CanardMicrosecond   timestamp_usec,
+                    const void* const         payload,
+                    const size_t              payload_size);
+
+void flightrecSampleWriterInit(FlightRecSampleWriter* const writer,
+                               FlightRecorder* const        recorder,
+                               const uint8_t                stream);
+
+/// Appends one sample to the stream; a new block is started when the current one is full.
+/// The timestamps are expected to be non-decreasing. The time complexity is constant.
+void flightrecSample(FlightRecSampleWriter* const writer, const CanardMicrosecond timestamp_usec, const int32_t value);
+
+/// A consistent copy of a record made by flightrecRead().
+typedef struct FlightRecRecordCopy
+{
+    uint64_t          seq;
+    uint8_t           type;
+    uint8_t           stream;
+    uint16_t          count;
+    uint16_t          size;
+    CanardMicrosecond timestamp_usec;
+    uint8_t           payload[FLIGHTREC_RECORD_PAYLOAD_SIZE];
+} FlightRecRecordCopy;
+
+/// Copies the record with the specified sequence number if it is still in the ring and not being written.
+/// Safe to invoke concurrently with the writers, also from another process mapping the same file.
+bool flightrecRead(const FlightRecHeader* const header,
+                   const FlightRecRecord* const records,
+                   const uint64_t               seq,
+                   FlightRecRecordCopy* const   out);
+
+/// Decodes the samples of a sample block copy. Returns the number of samples stored into the output arrays.
+size_t flightrecDecodeSamples(const FlightRecRecordCopy* const copy,
+                              const size_t                     capacity,
+                              CanardMicrosecond* const         out_timestamps_usec,
+                              int32_t* const                   out_values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
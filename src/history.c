@@ -0,0 +1,90 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "history.h"
+#include <assert.h>
+#include <canard_dsdl.h>
+#include <string.h>
+
+static_assert((HISTORY_CAPACITY & (HISTORY_CAPACITY - 1U)) == 0U, "Shall be a power of two");
+
+void historyInit(HistoryRing* const ring)
+{
+    (void) memset(ring, 0, sizeof(HistoryRing));
+    atomic_init(&ring->head, 0U);
+}
+
+void historyAppend(HistoryRing* const ring, const CanardMicrosecond timestamp_usec, const float distance_cm)
+{
+    const uint64_t       head   = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    HistorySample* const sample = &ring->samples[head % HISTORY_CAPACITY];
+    sample->timestamp_usec      = timestamp_usec;
+    sample->distance_cm         = distance_cm;
+    atomic_store_explicit(&ring->head, head + 1U, memory_order_release);
+}
+
+static CanardMicrosecond historyGetTimestamp(const HistoryRing* const ring, const uint64_t index)
+{
+    return ring->samples[index % HISTORY_CAPACITY].timestamp_usec;
+}
+
+size_t historyHandleRequest(HistoryRing* const   ring,
+                            const uint8_t* const request,
+                            const size_t         request_size,
+                            uint8_t* const       response)
+{
+    const CanardMicrosecond since_usec = canardDSDLGetU64(request, request_size, 0U, 64U);
+    const CanardMicrosecond until_usec = canardDSDLGetU64(request, request_size, 64U, 64U);
+    const uint64_t          limit      = canardDSDLGetU16(request, request_size, 128U, 16U);
+    const uint64_t          max_samples =
+        ((limit == 0U) || (limit > HISTORY_MAX_RESPONSE_SAMPLES)) ? HISTORY_MAX_RESPONSE_SAMPLES : limit;
+
+    // The window [first, last) is searched from the newest sample back, within the samples that are safe to read.
+    const uint64_t head   = atomic_load_explicit(&ring->head, memory_order_acquire);
+    const uint64_t oldest = (head > HISTORY_MAX_RESPONSE_SAMPLES) ? (head - HISTORY_MAX_RESPONSE_SAMPLES) : 0U;
+    uint64_t       last   = head;
+    while ((until_usec != 0U) && (last > oldest) && (historyGetTimestamp(ring, last - 1U) > until_usec))
+    {
+        last--;
+    }
+    uint64_t first = last;
+    while ((first > oldest) && ((last - first) < max_samples) && (historyGetTimestamp(ring, first - 1U) >= since_usec))
+    {
+        first--;
+    }
+    // The window may reach past the oldest sample kept, unless it was cut short by the limit of the request.
+    const bool    limited = (limit > 0U) && ((last - first) == limit);
+    HistoryStatus status  = HistoryStatusComplete;
+    if ((since_usec != 0U) && (first == oldest) && (oldest > 0U) && !limited)
+    {
+        status = HistoryStatusPartial;
+    }
+
+    size_t count = (size_t)(last - first);
+    for (size_t i = 0; i < count; i++)
+    {
+        const HistorySample* const sample = &ring->samples[(first + i) % HISTORY_CAPACITY];
+        const size_t               offset = (HISTORY_RESPONSE_HEADER_SIZE + (i * HISTORY_RESPONSE_SAMPLE_SIZE)) * 8U;
+        canardDSDLSetUxx(response, offset, sample->timestamp_usec, 64U);
+        canardDSDLSetF32(response, offset + 64U, sample->distance_cm);
+    }
+    // The writer may have been filling the slot of the oldest sample read: head_after - capacity at most.
+    atomic_thread_fence(memory_order_acquire);
+    const uint64_t head_after = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    if ((count > 0U) && ((head_after + 1U) > (first + HISTORY_CAPACITY)))
+    {
+        status = HistoryStatusOverwritten;
+        count  = 0U;
+    }
+    canardDSDLSetUxx(response, 0U, (uint64_t) status, 8U);
+    canardDSDLSetUxx(response, 8U, count, 16U);
+    return HISTORY_RESPONSE_HEADER_SIZE + (count * HISTORY_RESPONSE_SAMPLE_SIZE);
+}
+
+size_t historyHandleBusy(uint8_t* const response)
+{
+    canardDSDLSetUxx(response, 0U, (uint64_t) HistoryStatusBusy, 8U);
+    canardDSDLSetUxx(response, 8U, 0U, 16U);
+    return HISTORY_RESPONSE_HEADER_SIZE;
+}
@@ -0,0 +1,90 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// History of the last samples of a sensor, so that a consumer that starts up can warm its filters from a snapshot
+/// instead of waiting for fresh publications. The samples are appended to a ring in O(1) from the thread of the sensor
+/// backend; a request served from the main loop returns a time window of the ring in one multi-frame response, which
+/// is serialized straight from the ring into the payload of the response.
+///
+/// There is a single writer and no lock. The reader takes the head of the ring before and after serializing the
+/// window, and never reads the oldest HISTORY_READ_MARGIN slots of the ring: they are the next ones the writer
+/// overwrites, possibly while the window is read. If the writer laps the reader regardless, the response says so
+/// instead of returning torn samples.
+///
+/// Request (the extent is HISTORY_REQUEST_SIZE bytes):
+///     uint64 since_usec   # The oldest timestamp of interest; zero: from the oldest sample kept.
+///     uint64 until_usec   # The newest timestamp of interest; zero: up to the newest sample.
+///     uint16 max_samples  # If the window holds more samples, the newest ones are returned; zero: no limit.
+///
+/// Response:
+///     uint8  status       # See HistoryStatus.
+///     Sample[<=HISTORY_MAX_RESPONSE_SAMPLES] samples, preceded by the uint16 length, oldest first, each:
+///         uint64  timestamp_usec  # The falling edge of the echo, in the time base of the transfers.
+///         float32 distance_cm
+
+#ifndef HISTORY_H_INCLUDED
+#define HISTORY_H_INCLUDED
+
+#include <canard.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Shall be a power of two. 1024 samples hold about 50 seconds at 20 Hz.
+#define HISTORY_CAPACITY 1024U
+#define HISTORY_READ_MARGIN 16U
+#define HISTORY_MAX_RESPONSE_SAMPLES (HISTORY_CAPACITY - HISTORY_READ_MARGIN)
+
+#define HISTORY_REQUEST_SIZE 18U
+#define HISTORY_RESPONSE_HEADER_SIZE 3U
+#define HISTORY_RESPONSE_SAMPLE_SIZE 12U
+#define HISTORY_RESPONSE_MAX_SIZE \
+    (HISTORY_RESPONSE_HEADER_SIZE + (HISTORY_MAX_RESPONSE_SAMPLES * HISTORY_RESPONSE_SAMPLE_SIZE))
+
+typedef enum
+{
+    HistoryStatusComplete = 0,
+    HistoryStatusPartial,      ///< The window starts before the oldest sample kept; the older samples are lost.
+    HistoryStatusOverwritten,  ///< The writer overwrote the window while it was read; no samples, try again.
+    HistoryStatusBusy,         ///< The previous response is still being transmitted; no samples, try again.
+} HistoryStatus;
+
+typedef struct HistorySample
+{
+    CanardMicrosecond timestamp_usec;
+    float             distance_cm;
+} HistorySample;
+
+typedef struct HistoryRing
+{
+    HistorySample    samples[HISTORY_CAPACITY];
+    _Atomic uint64_t head;  ///< The number of samples appended so far; the next one goes to head % capacity.
+} HistoryRing;
+
+void historyInit(HistoryRing* const ring);
+
+/// Shall be invoked from one thread only. The timestamps are expected to be nondecreasing.
+void historyAppend(HistoryRing* const ring, const CanardMicrosecond timestamp_usec, const float distance_cm);
+
+/// Serializes the response to the request into the buffer, which shall hold HISTORY_RESPONSE_MAX_SIZE bytes, and
+/// returns its size. A shorter request is zero-extended, as the implicit zero extension rule requires.
+/// The time complexity is linear in the number of samples in the window.
+size_t historyHandleRequest(HistoryRing* const   ring,
+                            const uint8_t* const request,
+                            const size_t         request_size,
+                            uint8_t* const       response);
+
+/// Serializes the response with the busy status and no samples into the buffer and returns its size, which is
+/// HISTORY_RESPONSE_HEADER_SIZE. For the node that can only keep one response in flight.
+size_t historyHandleBusy(uint8_t* const response);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -5,19 +5,49 @@
 ///     Pavel Kirienko <pavel.kirienko@zubax.com>
 ///     joan2937 <joan@abyz.me.uk>
 
+#include "burst.h"
+#include "busload.h"
+#include "canid.h"
+#include "demand.h"
+#include "flightrec.h"
+#include "history.h"
+#include "metrics.h"
+#include "periodic.h"
+#include "sensor_pigpio.h"
+#include "sensor_pigpiod.h"
+#include "sensor_replay.h"
+#include "tdma.h"
+#include "timesync.h"
+#include "txlatency.h"
+#include "ultrasound.h"
 #include <canard.h>
 #include <canard_dsdl.h>
-#include <pigpio.h>
+#include <errno.h>
+#include <signal.h>
 #include <socketcan.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include <time.h>
 
-/* Ultrasound GPIO pins */
-
+/* Ultrasound sensor
+ *
+ * The sensor is driven through pigpio on these GPIO pins and measures at 20 Hz. Alternatively, a recorded trace can be
+ * replayed instead (see sensor_replay.h), optionally faster than the original speed.
+ * With PIGPIOD_ENABLED, the node attaches to a running pigpio daemon (sudo pigpiod) instead of initializing pigpio in
+ * the process (see sensor_pigpiod.h): the node starts in milliseconds and does not need root. NULL address and port:
+ * $PIGPIO_ADDR and $PIGPIO_PORT, or the daemon on localhost. It is set by the ENABLE_PIGPIOD option of CMake, which
+ * also links pigpiod_if2; the default is the in-process backend.
+ */
 #define TRIGGER_PIN 18
 #define ECHO_PIN 24
+#define TRIGGER_PERIOD_MS 50U
+#ifndef PIGPIOD_ENABLED
+#define PIGPIOD_ENABLED 0
+#endif
+#define PIGPIOD_ADDRESS NULL
+#define PIGPIOD_PORT NULL
 
 /* Message Subject ID's
  *
@@ -27,11 +57,143 @@
  * Where ID = [7168, 8191] for Standard fixed regulated identifiers.
  * and message uavcan.node.Heartbeat = 7509
  *
+ * Service ID's: [0, 255] for Unregulated identifiers.
+ *
  * ref. Specification v1.0-beta,Revision 2020-10-16;
  *      sec. 5.1.1, 5.3.2 and sec. 6.4.4.1
  */
 static const uint16_t HeartbeatSubjectID = 7509;
 static const uint16_t UltrasoundMessageSubjectID = 1610;
+static const uint16_t BusLoadDiagnosticsSubjectID = 1620;
+static const uint16_t BurstSamplesSubjectID = 1630;
+static const uint16_t BurstCaptureServiceID = 210;
+static const uint16_t HistorySnapshotServiceID = 211;
+static const uint16_t TdmaScheduleServiceID = 212;
+static const uint16_t PortListSubjectID = DEMAND_PORT_LIST_SUBJECT_ID;
+static const uint16_t TimeSyncSubjectID = TIMESYNC_SUBJECT_ID;
+
+/* Bus load estimation
+ *
+ * The bit rates shall match the configuration of the interface, e.g.:
+ *     ip link set can0 type can bitrate 500000
+ * The data bit rate is only used for CAN FD frames with the bit rate switch; zero if not used. The ratio of the bit
+ * rates also determines the segmentation of the large CAN FD transfers.
+ * The diagnostics subject is optional; the metrics file is always written.
+ */
+#define CAN_NOMINAL_BITRATE 500000U
+#define CAN_DATA_BITRATE 0U
+#define BUSLOAD_BIN_USEC 100000U
+#define BUSLOAD_DIAGNOSTICS_ENABLED 0
+#define METRICS_FILE "/tmp/ultrasound-can-node.prom"
+
+/* TX deadline
+ *
+ * The transmission deadline of the transfers relative to the moment they are pushed into the TX queue.
+ */
+#define TX_DEADLINE_USEC 100000U
+
+/* Per-publisher MTU
+ *
+ * The periodic messages are small and shall remain readable by Classic CAN listeners, so they are always published
+ * with the Classic CAN MTU by the periodic publication engine. Large transfers use CAN FD if it is enabled and
+ * supported by the interface, otherwise they fall back to Classic CAN. The TX queue holds frames of any size, so the
+ * large transfers are pushed with their MTU given per transfer (canardTxPushMTU()); the MTU setting of the instance
+ * is left alone.
+ */
+#define CAN_FD_ENABLED 1
+
+/* CAN XL
+ *
+ * If enabled and supported by the interface, large transfers use CAN XL frames of up to 2048 bytes instead, which
+ * makes most of them single-frame. The bus load estimator does not model CAN XL; it counts such frames as CAN FD.
+ */
+#define CAN_XL_ENABLED 0
+static size_t LargeTransferMTU = CANARD_MTU_CAN_CLASSIC; // Updated in main() once the interface is opened.
+
+/* Periodic publications
+ *
+ * The frames of the periodic subjects are built once and patched in place when due, see periodic.h. The heartbeat
+ * and the bus load diagnostics are timed; the distance is published whenever a measurement completes.
+ */
+#define HEARTBEAT_PERIOD_USEC 1000000U
+#define BUSLOAD_DIAGNOSTICS_PERIOD_USEC 1000000U
+
+/* Urgency-based priority of the distance
+ *
+ * Close-range readings are published with a higher priority so that they win the arbitration on a loaded bus;
+ * the first matching level applies, and the other readings keep the nominal priority. The closing speed is the
+ * decrease of the distance between two consecutive readings. See the tx_latency_priority metrics for the effect.
+ */
+static const UltrasoundUrgencyLevel UrgencyLevels[] = {
+    {.max_distance_cm = 20.0F, .min_closing_speed_cm_per_s = 50.0F, .priority = CanardPriorityImmediate},
+    {.max_distance_cm = 50.0F, .min_closing_speed_cm_per_s = 0.0F, .priority = CanardPriorityHigh},
+};
+
+/* Burst capture
+ *
+ * On request, the sensor is triggered at a high rate (e.g., 1 kHz) for up to BURST_MAX_SAMPLES samples or
+ * BURST_MAX_DURATION_USEC; the raw samples are streamed on the burst subject using the MTU of the large transfers,
+ * and the normal trigger period is restored automatically afterwards. See burst.h for the service definition.
+ */
+#define BURST_CAPTURE_ENABLED 1
+
+/* Sample history
+ *
+ * The last published distances are kept with their timestamps, so that a consumer that starts up can request a
+ * snapshot of any time window from service 211 and warm its filters at once. See history.h for the service definition.
+ * The largest response is about 1700 Classic CAN frames, so its deadline lets it go out on a bus of 250 kbit/s.
+ */
+#define HISTORY_SNAPSHOT_ENABLED 1
+#define HISTORY_TX_DEADLINE_USEC 1000000U
+
+/* Demand-driven sampling
+ *
+ * The sensor is triggered at TRIGGER_PERIOD_MS only while a node on the bus lists the distance subject among its
+ * subscriptions in uavcan.node.port.List, and at the keep-alive period otherwise; see demand.h. The keep-alive
+ * period shall be supported by the timer of the sensor backend, i.e., a whole number of milliseconds.
+ */
+#define DEMAND_DRIVEN_SAMPLING_ENABLED 1
+#define DEMAND_IDLE_TRIGGER_PERIOD_MS 1000U
+
+/* Trigger schedule
+ *
+ * The nodes mounted near each other take turns: each triggers in its own slot of a frame of the network time, which
+ * is followed from the uavcan.time.Synchronization master. The slots are assigned through service 212; until then,
+ * the node triggers at TRIGGER_PERIOD_MS on its own. See tdma.h for the service definition.
+ */
+#define TDMA_SCHEDULE_ENABLED 1
+
+/* Flight recorder
+ *
+ * The raw echo pulse widths, the publication decisions and the bus events are recorded into a ring file that
+ * survives a crash of the node; read it with tools/flightrec_dump.c. 65536 records take 4 MiB and hold about a minute
+ * at 1 kHz sampling (one sample block per ~13 samples plus one record per publication), about 45 minutes at 20 Hz.
+ * The node runs without the recorder if the file cannot be opened.
+ */
+#define FLIGHTREC_FILE "/var/tmp/ultrasound-can-node.flightrec"
+#define FLIGHTREC_CAPACITY 65536U
+static FlightRecorder Recorder;
+
+#define MEGA 1000000ULL
+
+/* Set by SIGINT and SIGTERM: the main loop ends and the node shuts down in order, so that the process exits normally
+ * (which is also when a PGO build writes its profile).
+ */
+static volatile sig_atomic_t Terminated = 0;
+
+static void onTerminationSignal(const int signal_number)
+{
+    (void)signal_number;
+    Terminated = 1;
+}
+
+/* The same time base as the RX frame timestamps, see socketcanPop(). */
+static CanardMicrosecond getTAIMicroseconds(void)
+{
+    struct timespec ts;
+    (void)clock_gettime(CLOCK_TAI, &ts);
+    return (CanardMicrosecond)ts.tv_sec * MEGA + (CanardMicrosecond)ts.tv_nsec / 1000U;
+}
 
 // Memory management.
 static void *canardAllocate(CanardInstance *const ins, const size_t amount)
@@ -48,109 +210,301 @@ static void canardFree(CanardInstance *const ins, void *const pointer)
 
 /* Node heartbeat
  * ref. Specification v1.0-beta,Revision 2020-10-16; sec. 5.3.2
+ *     uint32 uptime
+ *     Health.1.0 health, Mode.1.0 mode, uint8 vendor_specific_status_code # all zero: nominal, operational
+ * Only the uptime changes; the context is the boot time.
  */
-static void publishHeartbeat(CanardInstance *const canard, const uint32_t uptime)
-{
-    static CanardTransferID transfer_id;
-    const uint8_t payload[7] = {
-        (uint8_t)(uptime >> 0U),
-        (uint8_t)(uptime >> 8U),
-        (uint8_t)(uptime >> 16U),
-        (uint8_t)(uptime >> 24U),
-        0,
-        0,
-        0,
-    };
-    const CanardTransfer transfer = {
-        .timestamp_usec = uptime,
-        .priority = CanardPriorityNominal,
-        .transfer_kind = CanardTransferKindMessage,
-        .port_id = HeartbeatSubjectID,
-        .remote_node_id = CANARD_NODE_ID_UNSET,
-        .transfer_id = transfer_id,
-        .payload_size = sizeof(payload),
-        .payload = &payload[0],
-    };
-    ++transfer_id;
-    (void)canardTxPush(canard, &transfer);
+static void updateHeartbeat(void *const context, uint8_t *const payload, const CanardMicrosecond now_usec)
+{
+    const CanardMicrosecond boot_usec = *(const CanardMicrosecond *)context;
+    canardDSDLSetUxx(payload, 0, (now_usec - boot_usec) / MEGA, 32);
 }
 
-/* Ultrasound node functions using the pigpio library
- * ref. http://abyz.me.uk/rpi/pigpio/index.html
- * ref. http://abyz.me.uk/rpi/pigpio/ex_sonar_ranger.html
+/* Converts a utilization into units of 1e-4 for a uint16 field, saturating: an overloaded bus (e.g., the estimate of
+ * a burst of retransmissions) would otherwise wrap around to a low value.
  */
-static void publishUltrasoundDistance(CanardInstance *const canard, const float distance)
+static uint64_t getUtilizationUnits(const double utilization)
 {
-    static CanardTransferID transfer_id;
-    uint8_t payload[4] = {0, 0, 0, 0};
-
-    //Serilize the distance
-    canardDSDLSetF32(payload, 0, distance);
+    const double units = utilization * 1e4;
+    return (units >= (double)UINT16_MAX) ? UINT16_MAX : (units > 0.0) ? (uint64_t)units : 0U;
+}
 
-    const CanardTransfer transfer = {
-        .priority = CanardPriorityNominal,
-        .transfer_kind = CanardTransferKindMessage,
-        .port_id = UltrasoundMessageSubjectID,
-        .remote_node_id = CANARD_NODE_ID_UNSET,
-        .transfer_id = transfer_id,
-        .payload_size = 4, // sizeof(payload),
-        .payload = &payload[0],
-    };
-    ++transfer_id;
-    (void)canardTxPush(canard, &transfer);
+/* Bus load diagnostics, published only if enabled.
+ *     uint16 utilization            # expected case, in units of 1e-4
+ *     uint16 utilization_worst_case # in units of 1e-4
+ *     uint8  busiest_node_id        # 255 if anonymous
+ *     uint16 busiest_node_utilization
+ * The context is the bus load estimator.
+ */
+static void updateBusLoadDiagnostics(void *const context, uint8_t *const payload, const CanardMicrosecond now_usec)
+{
+    BusLoadEstimator *const busload = (BusLoadEstimator *)context;
+    double node_utilization = 0.0;
+    const CanardNodeID node_id = busloadGetBusiestNode(busload, now_usec, &node_utilization);
+    const double utilization = busloadGetUtilization(busload, BusLoadStuffingExpected, now_usec);
+    const double utilization_worst = busloadGetUtilization(busload, BusLoadStuffingWorstCase, now_usec);
+    canardDSDLSetUxx(payload, 0, getUtilizationUnits(utilization), 16);
+    canardDSDLSetUxx(payload, 16, getUtilizationUnits(utilization_worst), 16);
+    canardDSDLSetUxx(payload, 32, node_id, 8);
+    canardDSDLSetUxx(payload, 40, getUtilizationUnits(node_utilization), 16);
 }
 
-void ultrasoundTrigger(void)
+/* The MTU is given per transfer, and the TX queue holds frames of any size, so transfers with different MTU can be
+ * interleaved freely without touching the MTU setting of the instance.
+ * A lazy transfer is not copied into the queue: its payload shall stay unchanged until its last frame is popped.
+ */
+static int32_t pushTransfer(CanardInstance *const canard,
+                            const CanardTransfer *const transfer,
+                            const size_t mtu,
+                            const bool lazy)
 {
-    gpioWrite(TRIGGER_PIN, PI_ON);
-    gpioDelay(10);
-    gpioWrite(TRIGGER_PIN, PI_OFF);
+    return lazy ? canardTxPushLazyMTU(canard, transfer, mtu) : canardTxPushMTU(canard, transfer, mtu);
 }
 
-void ultrasoundEcho(int gpio, int level, uint32_t tick, void *canard_ins)
+/* The history response in flight. It is pushed lazily: its frames are serialized from the payload as they are popped
+ * instead of being copied into the queue at once, so the payload is reserved until its last frame has been popped,
+ * whether it was sent, expired or dropped. Only one history response can be in flight; see processTransfer().
+ */
+typedef struct LazyResponse
 {
-    static uint32_t startTick, firstTick = 0;
+    uint8_t payload[HISTORY_RESPONSE_MAX_SIZE];
+    uint32_t can_id;
+    size_t frames_left;
+} LazyResponse;
 
-    int diffTick;
-    double distanceCm;
+static bool isLazyResponseFrame(const LazyResponse *const lazy, const CanardFrame *const frame)
+{
+    return (lazy->frames_left > 0U) && (frame != NULL) && (frame->extended_can_id == lazy->can_id);
+}
 
-    if (!firstTick)
-        firstTick = tick;
+/* The modules that handle the received transfers, and the tracker that learns when the responses are pushed. */
+typedef struct ReceiverContext
+{
+    BurstCapture *burst;
+    HistoryRing *history;
+    DemandTracker *demand;
+    TimeSync *timesync;
+    TdmaSchedule *tdma;
+    TxLatencyTracker *txlatency;
+    LazyResponse *history_response;
+} ReceiverContext;
 
-    if (level == PI_ON)
+/* Serve a received request or message; the response goes out with the same priority and transfer-ID.
+ * The responses may be large, so they use the MTU of the large transfers.
+ * The history response, up to 12 KB, is pushed lazily from its own buffer; while the previous one is in flight,
+ * a new history request is answered with the busy status instead.
+ */
+static void processTransfer(CanardInstance *const canard,
+                            const CanardTransfer *const transfer,
+                            const ReceiverContext *const receiver)
+{
+    uint8_t response[(BURST_RESPONSE_SIZE > TDMA_RESPONSE_SIZE) ? BURST_RESPONSE_SIZE : TDMA_RESPONSE_SIZE];
+    const uint8_t *response_payload = &response[0];
+    size_t response_size = 0U;
+    CanardMicrosecond deadline_usec = TX_DEADLINE_USEC;
+    bool lazy = false;
+    const bool request = (transfer->transfer_kind == CanardTransferKindRequest);
+    const bool message = (transfer->transfer_kind == CanardTransferKindMessage);
+    if (request && (transfer->port_id == BurstCaptureServiceID))
+    {
+        burstHandleRequest(
+            receiver->burst, transfer->payload, transfer->payload_size, getTAIMicroseconds(), &response[0]);
+        response_size = BURST_RESPONSE_SIZE;
+    }
+    else if (request && (transfer->port_id == HistorySnapshotServiceID))
+    {
+        LazyResponse *const history_response = receiver->history_response;
+        if (history_response->frames_left > 0U)
+        {
+            response_size = historyHandleBusy(&response[0]);
+        }
+        else
+        {
+            response_size = historyHandleRequest(
+                receiver->history, transfer->payload, transfer->payload_size, &history_response->payload[0]);
+            response_payload = &history_response->payload[0];
+            deadline_usec = HISTORY_TX_DEADLINE_USEC;
+            lazy = true;
+        }
+    }
+    else if (request && (transfer->port_id == TdmaScheduleServiceID))
     {
-        startTick = tick;
+        const CanardMicrosecond now_usec = getTAIMicroseconds();
+        const uint32_t frame_usec =
+            tdmaHandleRequest(receiver->tdma, transfer->payload, transfer->payload_size, now_usec, &response[0]);
+        demandSetActivePeriod(receiver->demand, (frame_usec > 0U) ? frame_usec : TRIGGER_PERIOD_MS * 1000U, now_usec);
+        response_size = TDMA_RESPONSE_SIZE;
     }
-    else if (level == PI_OFF)
+    else if (message && (transfer->port_id == PortListSubjectID))
     {
-        diffTick = tick - startTick;
-        distanceCm = (diffTick / 2) * 0.0343;
+        demandOnPortList(receiver->demand, transfer);
+    }
+    else if (message && (transfer->port_id == TimeSyncSubjectID))
+    {
+        timesyncOnMessage(receiver->timesync, transfer);
+    }
+    if (response_size > 0U)
+    {
+        const CanardMicrosecond now_usec = getTAIMicroseconds();
+        const CanardTransfer response_transfer = {
+            .timestamp_usec = now_usec + deadline_usec,
+            .priority = transfer->priority,
+            .transfer_kind = CanardTransferKindResponse,
+            .port_id = transfer->port_id,
+            .remote_node_id = transfer->remote_node_id,
+            .transfer_id = transfer->transfer_id,
+            .payload_size = response_size,
+            .payload = response_payload,
+        };
+        const int32_t frames = pushTransfer(canard, &response_transfer, LargeTransferMTU, lazy);
+        if (frames > 0)
+        {
+            txlatencyOnPush(receiver->txlatency,
+                            CanardTransferKindResponse,
+                            transfer->port_id,
+                            response_transfer.timestamp_usec,
+                            now_usec);
+        }
+        if (lazy && (frames > 0))
+        {
+            receiver->history_response->can_id = canidMakeResponse(
+                transfer->priority, transfer->port_id, transfer->remote_node_id, canard->node_id);
+            receiver->history_response->frames_left = (size_t)frames;
+        }
+    }
+}
 
-        publishUltrasoundDistance(canard_ins, distanceCm);
+/* Drain the RX queue of the socket.
+ * Our own frames are looped back by the socket, so the bus load estimator observes the complete traffic,
+ * and the TX latency tracker learns when each of our frames has actually left the controller.
+ * The other frames are passed to libcanard, which only accepts the subscribed ports.
+ */
+static void processReceivedFrames(const SocketCANFD sock,
+                                  CanardInstance *const canard,
+                                  BusLoadEstimator *const busload,
+                                  TxLatencyTracker *const txlatency,
+                                  const ReceiverContext *const receiver)
+{
+    uint8_t payload_buffer[CAN_XL_ENABLED ? CANARD_MTU_CAN_XL : CANARD_MTU_CAN_FD];
+    CanardFrame frame;
+    SocketCANFrameInfo info;
+    while (socketcanPop(sock, &frame, &info, sizeof(payload_buffer), payload_buffer, 0) > 0)
+    {
+        const BusLoadFrameFormat format =
+            info.brs ? BusLoadFrameFormatFDBRS : (info.fd ? BusLoadFrameFormatFD : BusLoadFrameFormatClassic);
+        busloadAccept(busload, &frame, format);
+        if (info.loopback)
+        {
+            txlatencyOnLoopback(txlatency, &frame);
+        }
+        else
+        {
+            CanardTransfer transfer;
+            if (canardRxAccept(canard, &frame, 0, &transfer) > 0)
+            {
+                processTransfer(canard, &transfer, receiver);
+                canard->memory_free(canard, (void *)transfer.payload);
+            }
+        }
+    }
+}
 
-        //Debugging
-        //printf("%u %u\ ", tick - firstTick, diffTick);
-        printf("%f \n", distanceCm);
+/* Remove the frame at the top of the TX queue and release the history response once its last frame is gone.
+ * The next frame of a lazy transfer takes the place of the popped one at the top of the queue; if it is not there,
+ * it could not be allocated and the rest of the transfer was dropped.
+ */
+static void popPendingFrame(CanardInstance *const canard, LazyResponse *const lazy)
+{
+    const CanardFrame *const txf = canardTxPeek(canard);
+    const bool own = isLazyResponseFrame(lazy, txf);
+    canardTxPop(canard);
+    free((void *)txf);
+    if (own)
+    {
+        lazy->frames_left--;
+        if (!isLazyResponseFrame(lazy, canardTxPeek(canard)))
+        {
+            lazy->frames_left = 0U;
+        }
     }
 }
 
-int initializaUltrasoundSensor(CanardInstance *const ins)
+static void recordDroppedFrame(const CanardFrame *const txf, const int16_t error)
 {
-    if (gpioInitialise() < 0)
-        return -1;
+    const FlightRecBusEvent event = {
+        .kind = FlightRecBusTxDropped,
+        .can_id = txf->extended_can_id,
+        .error = error,
+        .value = 0.0F,
+    };
+    flightrecWrite(&Recorder, FlightRecRecordBus, getTAIMicroseconds(), &event, sizeof(event));
+}
 
-    gpioSetMode(TRIGGER_PIN, PI_OUTPUT);
-    gpioWrite(TRIGGER_PIN, PI_OFF);
-    gpioSetMode(ECHO_PIN, PI_INPUT);
+/* Transmit pending frames and collect the transmission timestamps reported by the kernel.
+ * When the socket cannot take a frame right now, the frame stays at the top of the queue and the transmission is
+ * resumed on the next iteration of the main loop. Only the frames past their deadline and those the socket rejects
+ * for good are dropped, and each one is noted in the flight recorder.
+ */
+static void transmitPendingFrames(const SocketCANFD sock,
+                                  CanardInstance *const canard,
+                                  TxLatencyTracker *const txlatency,
+                                  LazyResponse *const lazy)
+{
+    const CanardFrame *txf = canardTxPeek(canard);
+    while (txf != NULL)
+    {
+        if (txf->timestamp_usec < getTAIMicroseconds())
+        {
+            recordDroppedFrame(txf, -ETIMEDOUT);
+        }
+        else
+        {
+            const int16_t push_result = socketcanPush(sock, txf, 0);
+            if (push_result > 0)
+            {
+                txlatencyOnWrite(txlatency, txf, getTAIMicroseconds());
+            }
+            else if (push_result < 0) // The write was attempted, which may have used up a timestamp sequence number.
+            {
+                txlatencyOnWriteFailed(txlatency, txf, getTAIMicroseconds());
+            }
+            if ((push_result == 0) || (push_result == -EAGAIN) || (push_result == -ENOBUFS))
+            {
+                break; // The socket is full; retry later.
+            }
+            if (push_result < 0)
+            {
+                recordDroppedFrame(txf, push_result);
+            }
+        }
+        popPendingFrame(canard, lazy);
+        txf = canardTxPeek(canard);
+    }
 
-    // update ultrasound at 20 Hz
-    // timer #0, every 50ms, interrupt function
-    gpioSetTimerFunc(0, 50, ultrasoundTrigger);
+    SocketCANTxTimestamp timestamp;
+    while (socketcanPopTxTimestamp(sock, &timestamp) > 0)
+    {
+        txlatencyOnTimestamp(txlatency, &timestamp);
+    }
+}
 
-    // monitor ultrasound echos
-    // pin, callback function, Canard instance
-    gpioSetAlertFuncEx(ECHO_PIN, ultrasoundEcho, ins);
-    return 0;
+static void writeMetrics(BusLoadEstimator *const busload,
+                         const TxLatencyTracker *const txlatency,
+                         const UltrasoundPipeline *const ultrasound,
+                         const ReceiverContext *const receiver,
+                         const CanardMicrosecond now_usec)
+{
+    MetricsSink sink;
+    if (metricsOpen(&sink, METRICS_FILE))
+    {
+        busloadWriteMetrics(busload, now_usec, &sink);
+        txlatencyWriteMetrics(txlatency, &sink);
+        ultrasoundWriteMetrics(ultrasound, &sink);
+        demandWriteMetrics(receiver->demand, &sink);
+        timesyncWriteMetrics(receiver->timesync, now_usec, &sink);
+        tdmaWriteMetrics(receiver->tdma, &sink);
+        metricsClose(&sink);
+    }
 }
 
 /*
@@ -158,52 +512,268 @@ int initializaUltrasoundSensor(CanardInstance *const ins)
  */
 int main(const int argc, const char *const argv[])
 {
-    if (argc != 3)
+    if ((argc < 3) || (argc > 5))
     {
-        fprintf(stderr, "Usage:   %s <iface-name> <node-id>\n", argv[0]);
+        fprintf(stderr, "Usage:   %s <iface-name> <node-id> [<replay-trace> [<speed>]]\n", argv[0]);
         fprintf(stderr, "Example: %s vcan0 42\n", argv[0]);
         return 1;
     }
 
     // Initialize the node with a static node-ID as specified in the command-line arguments.
     CanardInstance canard = canardInit(&canardAllocate, &canardFree);
-    canard.mtu_bytes = CANARD_MTU_CAN_CLASSIC; // Do not use CAN FD to enhance compatibility.
     canard.node_id = (CanardNodeID)atoi(argv[2]);
+    // The large CAN FD transfers are segmented for the shortest bus time at the bit rates of the bus.
+    canard.tx_segmentation = CanardTxSegmentationMinimizeBusTime;
+    canard.tx_fd_bitrate_ratio =
+        (CAN_DATA_BITRATE > CAN_NOMINAL_BITRATE) ? (CAN_DATA_BITRATE / CAN_NOMINAL_BITRATE) : 1U;
 
-    // Initialize a SocketCAN socket. Do not use CAN FD to enhance compatibility.
-    const SocketCANFD sock = socketcanOpen(argv[1], false);
+    // Initialize a SocketCAN socket. CAN XL and CAN FD are only used for large transfers; fall back to CAN FD and
+    // then to Classic CAN if unsupported.
+    SocketCANFD sock = -EOPNOTSUPP;
+    if (CAN_XL_ENABLED)
+    {
+        sock = socketcanOpenXL(argv[1]);
+        if (sock >= 0)
+        {
+            LargeTransferMTU = CANARD_MTU_CAN_XL;
+        }
+        else if (sock == -EOPNOTSUPP)
+        {
+            fprintf(stderr, "The interface does not support CAN XL, large transfers will use CAN FD\n");
+        }
+    }
+    if (sock == -EOPNOTSUPP)
+    {
+        sock = socketcanOpen(argv[1], CAN_FD_ENABLED);
+        if (sock >= 0)
+        {
+            LargeTransferMTU = CAN_FD_ENABLED ? CANARD_MTU_CAN_FD : CANARD_MTU_CAN_CLASSIC;
+        }
+    }
+    if (CAN_FD_ENABLED && (sock == -EOPNOTSUPP))
+    {
+        fprintf(stderr, "The interface does not support CAN FD, large transfers will use Classic CAN\n");
+        sock = socketcanOpen(argv[1], false);
+    }
     if (sock < 0)
     {
         fprintf(stderr, "Could not initialize the SocketCAN interface: errno %d %s\n", -sock, strerror(-sock));
         return 1;
     }
+    const int16_t loopback_result = socketcanEnableLoopback(sock);
+    if (loopback_result < 0)
+    {
+        fprintf(stderr, "Could not enable the loopback, own frames will not be accounted: errno %d\n", -loopback_result);
+    }
+
+    static BusLoadEstimator busload;
+    busloadInit(&busload, CAN_NOMINAL_BITRATE, CAN_DATA_BITRATE, BUSLOAD_BIN_USEC);
+
+    static TxLatencyTracker txlatency;
+    txlatencyInit(&txlatency);
+    const int16_t timestamping_result = socketcanEnableTxTimestamping(sock);
+    if (timestamping_result < 0)
+    {
+        fprintf(stderr, "Could not enable TX timestamping: errno %d\n", -timestamping_result);
+    }
 
-    // Initialize ultrasound
-    if (initializaUltrasoundSensor(&canard) < 0)
+    const int16_t flightrec_result = flightrecOpen(&Recorder, FLIGHTREC_FILE, FLIGHTREC_CAPACITY);
+    if (flightrec_result < 0)
     {
-        fprintf(stderr, "Could not initialize GPIO.");
+        fprintf(stderr, "Could not open the flight recorder %s: errno %d\n", FLIGHTREC_FILE, -flightrec_result);
+    }
+
+    // Initialize ultrasound, either the real sensor or a replayed trace.
+    static SensorPigpio sensor_pigpio;
+    static SensorReplay sensor_replay;
+    sensorPigpioInit(&sensor_pigpio, TRIGGER_PIN, ECHO_PIN);
+    SensorBackend *sensor = &sensor_pigpio.base;
+#if PIGPIOD_ENABLED
+    static SensorPigpiod sensor_pigpiod;
+    sensorPigpiodInit(&sensor_pigpiod, PIGPIOD_ADDRESS, PIGPIOD_PORT, TRIGGER_PIN, ECHO_PIN);
+    sensor = &sensor_pigpiod.base;
+#endif
+    if (argc > 3)
+    {
+        const int16_t load_result = sensorReplayLoad(&sensor_replay, argv[3], (argc > 4) ? atof(argv[4]) : 1.0);
+        if (load_result < 0)
+        {
+            fprintf(stderr, "Could not load the replay trace %s: errno %d\n", argv[3], -load_result);
+            return 1;
+        }
+        sensor = &sensor_replay.base;
+    }
+    // Set up the periodic publications: the templates are built for the node-ID assigned above.
+    static PeriodicEngine periodic;
+    periodicInit(&periodic, &canard);
+    periodic.txlatency = &txlatency;
+    static CanardMicrosecond boot_usec;
+    boot_usec = getTAIMicroseconds();
+    int periodic_result = periodicAdd(&periodic,
+                                      HeartbeatSubjectID,
+                                      CanardPriorityNominal,
+                                      7U,
+                                      HEARTBEAT_PERIOD_USEC,
+                                      TX_DEADLINE_USEC,
+                                      &updateHeartbeat,
+                                      &boot_usec,
+                                      boot_usec);
+    if ((periodic_result >= 0) && BUSLOAD_DIAGNOSTICS_ENABLED)
+    {
+        periodic_result = periodicAdd(&periodic,
+                                      BusLoadDiagnosticsSubjectID,
+                                      CanardPriorityOptional,
+                                      7U,
+                                      BUSLOAD_DIAGNOSTICS_PERIOD_USEC,
+                                      TX_DEADLINE_USEC,
+                                      &updateBusLoadDiagnostics,
+                                      &busload,
+                                      boot_usec);
+    }
+    static UltrasoundPipeline ultrasound;
+    if (periodic_result >= 0)
+    {
+        periodic_result = ultrasoundInit(&ultrasound,
+                                         &periodic,
+                                         sensor,
+                                         &getTAIMicroseconds,
+                                         &Recorder,
+                                         UltrasoundMessageSubjectID,
+                                         TX_DEADLINE_USEC);
+    }
+    if (periodic_result < 0)
+    {
+        fprintf(stderr, "Could not set up the periodic publications: errno %d\n", -periodic_result);
+        return 1;
+    }
+    ultrasound.print_distance = true;
+    ultrasoundSetUrgency(&ultrasound, UrgencyLevels, sizeof(UrgencyLevels) / sizeof(UrgencyLevels[0]));
+
+    // The burst capture takes over the sensor on request; the buffer is allocated statically.
+    static BurstCapture burst;
+    burstInit(&burst,
+              sensor,
+              &canard,
+              BurstSamplesSubjectID,
+              LargeTransferMTU,
+              TRIGGER_PERIOD_MS * 1000U,
+              TX_DEADLINE_USEC);
+    burst.txlatency = &txlatency;
+    static CanardRxSubscription burst_subscription;
+    if (BURST_CAPTURE_ENABLED)
+    {
+        (void)canardRxSubscribe(&canard,
+                                CanardTransferKindRequest,
+                                BurstCaptureServiceID,
+                                BURST_REQUEST_SIZE,
+                                CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                                &burst_subscription);
+        ultrasound.burst = &burst;
+    }
+    static HistoryRing history;
+    historyInit(&history);
+    static CanardRxSubscription history_subscription;
+    if (HISTORY_SNAPSHOT_ENABLED)
+    {
+        (void)canardRxSubscribe(&canard,
+                                CanardTransferKindRequest,
+                                HistorySnapshotServiceID,
+                                HISTORY_REQUEST_SIZE,
+                                CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                                &history_subscription);
+        ultrasound.history = &history;
+    }
+    // Without the demand tracking, the tracker never goes idle; it still owns the trigger period of the schedule.
+    static DemandTracker demand;
+    demandInit(&demand,
+               sensor,
+               &burst,
+               UltrasoundMessageSubjectID,
+               TRIGGER_PERIOD_MS * 1000U,
+               DEMAND_DRIVEN_SAMPLING_ENABLED ? (DEMAND_IDLE_TRIGGER_PERIOD_MS * 1000U) : 0U,
+               DEMAND_DEFAULT_TIMEOUT_USEC,
+               getTAIMicroseconds());
+    static CanardRxSubscription port_list_subscription;
+    if (DEMAND_DRIVEN_SAMPLING_ENABLED)
+    {
+        (void)canardRxSubscribe(&canard,
+                                CanardTransferKindMessage,
+                                PortListSubjectID,
+                                DEMAND_PORT_LIST_EXTENT,
+                                CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                                &port_list_subscription);
+    }
+    static TimeSync timesync;
+    timesyncInit(&timesync);
+    static TdmaSchedule tdma;
+    tdmaInit(&tdma, sensor, &timesync);
+    static CanardRxSubscription timesync_subscription;
+    static CanardRxSubscription tdma_subscription;
+    if (TDMA_SCHEDULE_ENABLED)
+    {
+        (void)canardRxSubscribe(&canard,
+                                CanardTransferKindMessage,
+                                TimeSyncSubjectID,
+                                TIMESYNC_MESSAGE_EXTENT,
+                                CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                                &timesync_subscription);
+        (void)canardRxSubscribe(&canard,
+                                CanardTransferKindRequest,
+                                TdmaScheduleServiceID,
+                                TDMA_REQUEST_SIZE,
+                                CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                                &tdma_subscription);
+    }
+    static LazyResponse history_response;
+    const ReceiverContext receiver = {
+        .burst = &burst,
+        .history = &history,
+        .demand = &demand,
+        .timesync = &timesync,
+        .tdma = &tdma,
+        .txlatency = &txlatency,
+        .history_response = &history_response,
+    };
+    const int16_t sensor_result = sensor->start(sensor, TRIGGER_PERIOD_MS, &ultrasoundOnEcho, &ultrasound);
+    if (sensor_result < 0)
+    {
+        fprintf(stderr, "Could not initialize the %s sensor: errno %d\n", sensor->name, -sensor_result);
+        if (sensor_result == -ECONNREFUSED)
+        {
+            fprintf(stderr, "Is the pigpio daemon running? Start it with: sudo pigpiod\n");
+        }
         return 1;
     };
 
     // The main loop: publish messages and process service requests.
-    const time_t boot_ts = time(NULL);
-    time_t next_1hz_at = boot_ts;
-    while (true)
+    (void)signal(SIGINT, &onTerminationSignal);
+    (void)signal(SIGTERM, &onTerminationSignal);
+    time_t next_1hz_at = time(NULL);
+    while (!Terminated)
     {
+        (void)ultrasoundPoll(&ultrasound);
+        (void)periodicPoll(&periodic, getTAIMicroseconds());
+        burstPoll(&burst, getTAIMicroseconds());
         if (next_1hz_at < time(NULL))
         {
             next_1hz_at++;
-            publishHeartbeat(&canard, time(NULL) - boot_ts);
+            const CanardMicrosecond now_usec = getTAIMicroseconds();
+            writeMetrics(&busload, &txlatency, &ultrasound, &receiver, now_usec);
+            demandPoll(&demand, now_usec);
+            tdmaPoll(&tdma, now_usec);
+            const FlightRecBusEvent event = {
+                .kind = FlightRecBusUtilization,
+                .can_id = 0U,
+                .error = 0,
+                .value = (float)busloadGetUtilization(&busload, BusLoadStuffingExpected, now_usec),
+            };
+            flightrecWrite(&Recorder, FlightRecRecordBus, now_usec, &event, sizeof(event));
         }
 
-        // Transmit pending frames.
-        const CanardFrame *txf = canardTxPeek(&canard);
-        while (txf != NULL)
-        {
-            (void)socketcanPush(sock, txf, 0); // Error handling not implemented
-            canardTxPop(&canard);
-            free((void *)txf);
-            txf = canardTxPeek(&canard);
-        }
+        processReceivedFrames(sock, &canard, &busload, &txlatency, &receiver);
+        transmitPendingFrames(sock, &canard, &txlatency, &history_response);
     }
+    sensor->stop(sensor);
+    flightrecClose(&Recorder);
+    return 0;
 }
@@ -0,0 +1,53 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "metrics.h"
+#include <stdio.h>
+#include <string.h>
+
+bool metricsOpen(MetricsSink* const sink, const char* const path)
+{
+    (void) memset(sink, 0, sizeof(MetricsSink));
+    const size_t path_size = strlen(path) + 1U;
+    if (path_size > METRICS_PATH_MAX)
+    {
+        return false;
+    }
+    (void) memcpy(sink->path, path, path_size);
+    (void) snprintf(sink->temp_path, sizeof(sink->temp_path), "%s.tmp", path);
+    sink->file = fopen(sink->temp_path, "w");
+    return sink->file != NULL;
+}
+
+void metricsGauge(MetricsSink* const sink, const char* const name, const char* const labels, const double value)
+{
+    if (sink->file != NULL)
+    {
+        if (labels != NULL)
+        {
+            (void) fprintf(sink->file, "%s{%s} %.9g\n", name, labels, value);
+        }
+        else
+        {
+            (void) fprintf(sink->file, "%s %.9g\n", name, value);
+        }
+    }
+}
+
+void metricsClose(MetricsSink* const sink)
+{
+    if (sink->file != NULL)
+    {
+        const bool ok = (0 == fclose(sink->file));
+        sink->file    = NULL;
+        if (ok)
+        {
+            (void) rename(sink->temp_path, sink->path);
+        }
+        else
+        {
+            (void) remove(sink->temp_path);
+        }
+    }
+}
@@ -0,0 +1,44 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The metrics surface of the node. Every module that keeps runtime statistics exports them through a sink that
+/// writes a snapshot in the Prometheus text exposition format. The snapshot is written into a temporary file
+/// which then atomically replaces the target, so the readers (a node_exporter textfile collector, a shell script,
+/// or a human with cat) never observe a partially written file.
+
+#ifndef METRICS_H_INCLUDED
+#define METRICS_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define METRICS_PATH_MAX 256U
+
+typedef struct MetricsSink
+{
+    FILE* file;
+    char  path[METRICS_PATH_MAX];
+    char  temp_path[METRICS_PATH_MAX + 4U];
+} MetricsSink;
+
+/// Begin a new snapshot that will replace the file at the specified path once metricsClose() is called.
+/// Returns false if the temporary file could not be created; in this case the other functions have no effect.
+bool metricsOpen(MetricsSink* const sink, const char* const path);
+
+/// Emit one sample. The labels are given in the exposition format without the braces, e.g., "priority=\"4\"";
+/// NULL means no labels.
+void metricsGauge(MetricsSink* const sink, const char* const name, const char* const labels, const double value);
+
+/// Finish the snapshot and atomically publish it.
+void metricsClose(MetricsSink* const sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,149 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "periodic.h"
+#include "canid.h"
+#include <errno.h>
+#include <string.h>
+
+/// The phases of the timed slots in eighths of their period, in the order the slots are added. Every prefix of the
+/// sequence spreads the slots evenly: 0, 1/2, 1/4, 3/4, and so on.
+static const uint8_t StaggerEighths[PERIODIC_MAX_SLOTS] = {0U, 4U, 2U, 6U, 1U, 5U, 3U, 7U};
+
+void periodicInit(PeriodicEngine* const engine, CanardInstance* const canard)
+{
+    (void) memset(engine, 0, sizeof(*engine));
+    engine->canard = canard;
+}
+
+/// Lets libcanard serialize the first transfer of the slot on a scratch instance and keeps the resulting frame.
+static int buildTemplate(PeriodicEngine* const engine,
+                         PeriodicSlot* const   slot,
+                         const CanardPortID    subject_id,
+                         const CanardPriority  priority)
+{
+    CanardInstance scratch = canardInit(engine->canard->memory_allocate, engine->canard->memory_free);
+    scratch.user_reference = engine->canard->user_reference;
+    scratch.node_id        = engine->canard->node_id;
+    scratch.mtu_bytes      = CANARD_MTU_CAN_CLASSIC;
+    const uint8_t        zeros[PERIODIC_MAX_PAYLOAD_SIZE] = {0};
+    const CanardTransfer transfer                         = {
+        .timestamp_usec = 0U,
+        .priority       = priority,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = subject_id,
+        .remote_node_id = CANARD_NODE_ID_UNSET,
+        .transfer_id    = 0U,
+        .payload_size   = slot->payload_size,
+        .payload        = &zeros[0],
+    };
+    const int32_t result = canardTxPush(&scratch, &transfer);
+    if (result != 1)
+    {
+        return (result == -CANARD_ERROR_OUT_OF_MEMORY) ? -ENOMEM : -EINVAL;
+    }
+    const CanardFrame* const txf = canardTxPeek(&scratch);
+    (void) memcpy(&slot->frame_payload[0], txf->payload, txf->payload_size);
+    slot->frame         = *txf;
+    slot->frame.payload = &slot->frame_payload[0];
+    canardTxPop(&scratch);
+    scratch.memory_free(&scratch, (void*) txf);
+    return 0;
+}
+
+int periodicAdd(PeriodicEngine* const       engine,
+                const CanardPortID          subject_id,
+                const CanardPriority        priority,
+                const size_t                payload_size,
+                const CanardMicrosecond     period_usec,
+                const CanardMicrosecond     tx_deadline_usec,
+                const PeriodicUpdateHandler update,
+                void* const                 context,
+                const CanardMicrosecond     now_usec)
+{
+    if ((payload_size > PERIODIC_MAX_PAYLOAD_SIZE) || (engine->canard->node_id > CANARD_NODE_ID_MAX) ||
+        ((period_usec > 0U) && (update == NULL)))
+    {
+        return -EINVAL;
+    }
+    if (engine->num_slots >= PERIODIC_MAX_SLOTS)
+    {
+        return -ENOSPC;
+    }
+    PeriodicSlot* const slot = &engine->slots[engine->num_slots];
+    (void) memset(slot, 0, sizeof(*slot));
+    slot->payload_size = payload_size;
+    const int result   = buildTemplate(engine, slot, subject_id, priority);
+    if (result < 0)
+    {
+        return result;
+    }
+    slot->period_usec      = period_usec;
+    slot->tx_deadline_usec = tx_deadline_usec;
+    slot->update           = update;
+    slot->context          = context;
+    if (period_usec > 0U)
+    {
+        slot->next_at_usec = now_usec + ((period_usec * StaggerEighths[engine->num_timed % PERIODIC_MAX_SLOTS]) / 8U);
+        engine->num_timed++;
+    }
+    return (int) engine->num_slots++;
+}
+
+uint8_t* periodicGetPayload(PeriodicEngine* const engine, const int slot)
+{
+    return &engine->slots[slot].frame_payload[0];
+}
+
+void periodicSetPriority(PeriodicEngine* const engine, const int slot, const CanardPriority priority)
+{
+    CanardFrame* const frame = &engine->slots[slot].frame;
+    frame->extended_can_id   = canidSetPriority(frame->extended_can_id, priority);
+}
+
+int32_t periodicPublish(PeriodicEngine* const engine, const int slot, const CanardMicrosecond now_usec)
+{
+    PeriodicSlot* const s    = &engine->slots[slot];
+    uint8_t* const      tail = &s->frame_payload[s->frame.payload_size - 1U];
+    *tail                    = (uint8_t)((*tail & ~CANARD_TRANSFER_ID_MAX) | s->transfer_id);
+    s->frame.timestamp_usec  = now_usec + s->tx_deadline_usec;
+    const int32_t result     = canardTxPushFrameUnchecked(engine->canard, &s->frame);
+    if ((result > 0) && (engine->txlatency != NULL))
+    {
+        txlatencyOnPush(engine->txlatency,
+                        CanardTransferKindMessage,
+                        canidGetPortID(s->frame.extended_can_id),
+                        s->frame.timestamp_usec,
+                        now_usec);
+    }
+    s->transfer_id           = (CanardTransferID)((s->transfer_id + 1U) & CANARD_TRANSFER_ID_MAX);
+    s->published += (result > 0) ? 1U : 0U;
+    s->failed += (result > 0) ? 0U : 1U;
+    return result;
+}
+
+CanardMicrosecond periodicPoll(PeriodicEngine* const engine, const CanardMicrosecond now_usec)
+{
+    CanardMicrosecond next = UINT64_MAX;
+    for (size_t i = 0; i < engine->num_slots; i++)
+    {
+        PeriodicSlot* const slot = &engine->slots[i];
+        if (slot->period_usec == 0U)
+        {
+            continue;
+        }
+        if (slot->next_at_usec <= now_usec)
+        {
+            slot->update(slot->context, &slot->frame_payload[0], now_usec);
+            (void) periodicPublish(engine, (int) i, now_usec);
+            slot->next_at_usec += slot->period_usec;
+            if (slot->next_at_usec <= now_usec)  // Fell behind: keep the phase, skip the missed publications.
+            {
+                slot->next_at_usec += ((now_usec - slot->next_at_usec) / slot->period_usec + 1U) * slot->period_usec;
+            }
+        }
+        next = (slot->next_at_usec < next) ? slot->next_at_usec : next;
+    }
+    return next;
+}
@@ -0,0 +1,100 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Periodic publication engine for single-frame message subjects. Each subject has a slot that holds its frame ready
+/// for transmission: the CAN ID, the payload with the padding, and the tail byte are produced by libcanard once, when
+/// the slot is added. A publication then only patches the bytes that change, the transfer-ID in the tail byte, and
+/// the deadline in place, and inserts a copy of the frame into the TX queue with canardTxPushFrameUnchecked(). The
+/// frame is valid by construction and none of the patches can invalidate it, so it is not validated again on every
+/// publication; debug builds still assert its validity.
+///
+/// A slot is either timed, then periodicPoll() publishes it every period after letting its update handler patch the
+/// payload, or published on demand with periodicPublish(), e.g., when a new measurement is available. The first
+/// publications of the timed slots are staggered over their period, so that slots of the same period never fall due
+/// at the same time and the TX queue does not receive them in a burst.
+///
+/// The frames are Classic CAN frames, so that every listener can read the periodic messages. The local node shall not
+/// be anonymous, because the pseudo node-ID of an anonymous message depends on its payload.
+
+#ifndef PERIODIC_H_INCLUDED
+#define PERIODIC_H_INCLUDED
+
+#include "txlatency.h"
+#include <canard.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PERIODIC_MAX_SLOTS 8U
+#define PERIODIC_MAX_PAYLOAD_SIZE (CANARD_MTU_CAN_CLASSIC - 1U)  ///< The tail byte takes the rest of the frame.
+
+/// Patches the changing bytes of the payload of a timed slot before it is published at the specified time.
+typedef void (*PeriodicUpdateHandler)(void* const context, uint8_t* const payload, const CanardMicrosecond now_usec);
+
+typedef struct PeriodicSlot
+{
+    CanardFrame           frame;  ///< The template; the payload points to frame_payload.
+    uint8_t               frame_payload[CANARD_MTU_CAN_CLASSIC];
+    size_t                payload_size;
+    CanardMicrosecond     period_usec;       ///< Zero if the slot is only published on demand.
+    CanardMicrosecond     next_at_usec;      ///< When the timed slot is due next.
+    CanardMicrosecond     tx_deadline_usec;  ///< Relative to the publication.
+    PeriodicUpdateHandler update;
+    void*                 context;
+
+    CanardTransferID transfer_id;  ///< Of the next publication.
+    uint64_t         published;
+    uint64_t         failed;  ///< The publications that could not be enqueued, for the lack of memory.
+} PeriodicSlot;
+
+typedef struct PeriodicEngine
+{
+    CanardInstance*   canard;
+    TxLatencyTracker* txlatency;  ///< Notified of every publication if not NULL, which is the initial state.
+    PeriodicSlot      slots[PERIODIC_MAX_SLOTS];
+    size_t            num_slots;
+    size_t            num_timed;  ///< The number of timed slots, which determines the phase of the next one.
+} PeriodicEngine;
+
+void periodicInit(PeriodicEngine* const engine, CanardInstance* const canard);
+
+/// Adds a slot for a message subject and returns its index, or negated errno: -EINVAL if the payload does not fit
+/// into a Classic CAN frame, the local node is anonymous, or libcanard rejects the transfer (e.g., the subject-ID is
+/// out of range); -ENOSPC if all slots are taken; -ENOMEM. The payload is initially zeroed.
+/// A timed slot (nonzero period) is first due within one period from now, depending on the number of timed slots
+/// added before it; the update handler is required for timed slots and ignored otherwise.
+int periodicAdd(PeriodicEngine* const       engine,
+                const CanardPortID          subject_id,
+                const CanardPriority        priority,
+                const size_t                payload_size,
+                const CanardMicrosecond     period_usec,
+                const CanardMicrosecond     tx_deadline_usec,
+                const PeriodicUpdateHandler update,
+                void* const                 context,
+                const CanardMicrosecond     now_usec);
+
+/// The payload of the slot, which can be patched in place between publications.
+uint8_t* periodicGetPayload(PeriodicEngine* const engine, const int slot);
+
+/// Changes the priority of the following publications of the slot by patching the CAN ID of the frame. The priority
+/// is not a part of the session specifier, so the transfer-ID sequence of the subject continues uninterrupted.
+void periodicSetPriority(PeriodicEngine* const engine, const int slot, const CanardPriority priority);
+
+/// Publishes the slot now as it is. Returns the result of canardTxPushFrameUnchecked(): 1 on success, negated
+/// out-of-memory error otherwise.
+int32_t periodicPublish(PeriodicEngine* const engine, const int slot, const CanardMicrosecond now_usec);
+
+/// Publishes the timed slots that are due, each at most once: if the engine falls behind by more than a period,
+/// the missed publications are skipped instead of being sent in a burst. Returns when the next slot is due,
+/// UINT64_MAX if there are no timed slots. The time complexity is linear in the number of slots.
+CanardMicrosecond periodicPoll(PeriodicEngine* const engine, const CanardMicrosecond now_usec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
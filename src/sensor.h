@@ -0,0 +1,66 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Hardware abstraction of the HC-SR04 sensor. A backend triggers the measurements and delivers the edges of the echo
+/// pulse to a handler, timestamped by a free-running microsecond tick that wraps around every 2^32 us (like the pigpio
+/// tick). The application only consumes edges, so the same processing is driven by the hardware (sensor_pigpio.h)
+/// or by a recorded trace (sensor_replay.h).
+
+#ifndef SENSOR_H_INCLUDED
+#define SENSOR_H_INCLUDED
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SENSOR_LEVEL_LOW 0
+#define SENSOR_LEVEL_HIGH 1
+
+/// Invoked for every edge of the echo pin from the thread of the backend; the edges of one backend are serialized.
+typedef void (*SensorEchoHandler)(void* const context, const int level, const uint32_t tick);
+
+typedef struct SensorBackend SensorBackend;
+struct SensorBackend
+{
+    const char* name;
+
+    /// Starts triggering a measurement every period and delivering the echo edges to the handler.
+    /// Returns zero on success, negated errno on failure.
+    int16_t (*start)(SensorBackend* const     self,
+                     const uint32_t           trigger_period_ms,
+                     const SensorEchoHandler  handler,
+                     void* const              context);
+
+    /// The current value of the tick that timestamps the edges.
+    uint32_t (*tick)(SensorBackend* const self);
+
+    /// Changes the trigger period of the running measurements, e.g., for a burst capture and back.
+    /// Returns zero on success, negated errno on failure (-EINVAL if the backend cannot trigger at this period).
+    int16_t (*setTriggerPeriod)(SensorBackend* const self, const uint32_t period_usec);
+
+    /// If aligned, the following triggers fall on the ticks phase_tick + k * period, so that the triggers of several
+    /// nodes can be interleaved (see tdma.h); the alignment is kept across the changes of the period. The phase may be
+    /// updated at any time to follow a drifting time base. Returns zero on success, negated errno on failure.
+    int16_t (*setTriggerPhase)(SensorBackend* const self, const bool aligned, const uint32_t phase_tick);
+
+    /// Stops the measurements; no edges are delivered after this function returns.
+    void (*stop)(SensorBackend* const self);
+};
+
+/// The time from now to the next tick phase + k * period, for the backends that generate the aligned triggers; the
+/// phase may lie in the past or, after an update, in the future.
+static inline uint32_t sensorGetTimeToPhase(const uint32_t now, const uint32_t phase, const uint32_t period)
+{
+    const uint32_t since = now - phase;
+    return ((int32_t) since < 0) ? ((0U - since) % period) : ((period - (since % period)) % period);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
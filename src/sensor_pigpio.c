@@ -0,0 +1,208 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "sensor_pigpio.h"
+#include "trace.h"
+#include <errno.h>
+#include <pigpio.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SENSOR_PIGPIO_TIMER 0U
+#define SENSOR_PIGPIO_TRIGGER_PULSE_USEC 10U
+#define SENSOR_PIGPIO_TIMER_MIN_PERIOD_MS 10U
+#define SENSOR_PIGPIO_TIMER_MAX_PERIOD_MS 60000U
+
+static void sensorPigpioTrigger(void* const user)
+{
+    const SensorPigpio* const sensor = (const SensorPigpio*) user;
+    TRACE(trigger, gpioTick());
+    (void) gpioWrite(sensor->trigger_pin, PI_ON);
+    (void) gpioDelay(SENSOR_PIGPIO_TRIGGER_PULSE_USEC);
+    (void) gpioWrite(sensor->trigger_pin, PI_OFF);
+}
+
+/// Triggers on the ticks phase + k * period; both may change at any time. A trigger is never closer than half a
+/// period to the previous one, so that a shift of the phase does not produce a double trigger.
+static void* sensorPigpioAlignedTriggerThread(void* const user)
+{
+    const SensorPigpio* const sensor = (const SensorPigpio*) user;
+    uint32_t                  last   = gpioTick();
+    while (true)
+    {
+        const uint32_t period = atomic_load(&sensor->period_usec);
+        const uint32_t now    = gpioTick();
+        uint32_t       target = now + sensorGetTimeToPhase(now, atomic_load(&sensor->phase_tick), period);
+        if ((int32_t)(target - last) < (int32_t)(period / 2U))
+        {
+            target += period;
+        }
+        int32_t remaining = (int32_t)(target - gpioTick());
+        if (remaining > (int32_t) SENSOR_PIGPIO_SPIN_USEC)
+        {
+            (void) gpioDelay((uint32_t) remaining - SENSOR_PIGPIO_SPIN_USEC);  // Sleeps.
+            remaining = (int32_t)(target - gpioTick());
+        }
+        if (remaining > 0)
+        {
+            (void) gpioDelay((uint32_t) remaining);  // Spins.
+        }
+        sensorPigpioTrigger(user);
+        last = target;
+    }
+    return NULL;
+}
+
+static void sensorPigpioOnAlert(const int gpio, const int level, const uint32_t tick, void* const user)
+{
+    (void) gpio;
+    const SensorPigpio* const sensor = (const SensorPigpio*) user;
+    // PI_TIMEOUT is not an edge and is not enabled anyway.
+    if ((level == PI_ON) || (level == PI_OFF))
+    {
+        sensor->handler(sensor->context, (level == PI_ON) ? SENSOR_LEVEL_HIGH : SENSOR_LEVEL_LOW, tick);
+    }
+}
+
+static int16_t sensorPigpioStart(SensorBackend* const    self,
+                                 const uint32_t          trigger_period_ms,
+                                 const SensorEchoHandler handler,
+                                 void* const             context)
+{
+    SensorPigpio* const sensor = (SensorPigpio*) self;
+    if (gpioInitialise() < 0)
+    {
+        return -EIO;
+    }
+    sensor->handler = handler;
+    sensor->context = context;
+    atomic_store(&sensor->period_usec, trigger_period_ms * 1000U);
+
+    (void) gpioSetMode(sensor->trigger_pin, PI_OUTPUT);
+    (void) gpioWrite(sensor->trigger_pin, PI_OFF);
+    (void) gpioSetMode(sensor->echo_pin, PI_INPUT);
+
+    // Monitor the echo first, so that the first measurement is not missed.
+    if ((gpioSetAlertFuncEx(sensor->echo_pin, sensorPigpioOnAlert, sensor) != 0) ||
+        (gpioSetTimerFuncEx(SENSOR_PIGPIO_TIMER, trigger_period_ms, sensorPigpioTrigger, sensor) != 0))
+    {
+        gpioTerminate();
+        return -EINVAL;
+    }
+    return 0;
+}
+
+/// Stops the waveform if it is running; the timer is left alone.
+static void sensorPigpioStopWave(SensorPigpio* const sensor)
+{
+    if (sensor->wave_id >= 0)
+    {
+        (void) gpioWaveTxStop();
+        (void) gpioWaveDelete((unsigned) sensor->wave_id);
+        sensor->wave_id = -1;
+        (void) gpioWrite(sensor->trigger_pin, PI_OFF);
+    }
+}
+
+static void sensorPigpioStopThread(SensorPigpio* const sensor)
+{
+    if (sensor->thread != NULL)
+    {
+        gpioStopThread(sensor->thread);
+        sensor->thread = NULL;
+        (void) gpioWrite(sensor->trigger_pin, PI_OFF);
+    }
+}
+
+static int16_t sensorPigpioSetTriggerPeriod(SensorBackend* const self, const uint32_t period_usec)
+{
+    SensorPigpio* const sensor = (SensorPigpio*) self;
+    const uint32_t      ms     = period_usec / 1000U;
+    const bool use_timer = ((period_usec % 1000U) == 0U) && (ms >= SENSOR_PIGPIO_TIMER_MIN_PERIOD_MS) &&
+                           (ms <= SENSOR_PIGPIO_TIMER_MAX_PERIOD_MS);
+    if (!use_timer && (period_usec < SENSOR_PIGPIO_MIN_TRIGGER_PERIOD_USEC))
+    {
+        return -EINVAL;
+    }
+    // Only one of the generators drives the trigger pin at a time; the aligned trigger thread follows the new period.
+    atomic_store(&sensor->period_usec, period_usec);
+    (void) gpioSetTimerFuncEx(SENSOR_PIGPIO_TIMER, 0U, NULL, NULL);
+    sensorPigpioStopWave(sensor);
+    if (sensor->aligned && (ms >= SENSOR_PIGPIO_TIMER_MIN_PERIOD_MS))
+    {
+        if (sensor->thread == NULL)
+        {
+            sensor->thread = gpioStartThread(&sensorPigpioAlignedTriggerThread, sensor);
+        }
+        return (sensor->thread != NULL) ? 0 : -EIO;
+    }
+    sensorPigpioStopThread(sensor);
+    if (use_timer)
+    {
+        return (gpioSetTimerFuncEx(SENSOR_PIGPIO_TIMER, ms, sensorPigpioTrigger, sensor) == 0) ? 0 : -EINVAL;
+    }
+    gpioPulse_t pulses[2] = {
+        {.gpioOn = 1U << sensor->trigger_pin, .gpioOff = 0U, .usDelay = SENSOR_PIGPIO_TRIGGER_PULSE_USEC},
+        {.gpioOn = 0U, .gpioOff = 1U << sensor->trigger_pin, .usDelay = period_usec - SENSOR_PIGPIO_TRIGGER_PULSE_USEC},
+    };
+    (void) gpioWaveClear();
+    const int wave_id = (gpioWaveAddGeneric(2U, &pulses[0]) >= 0) ? gpioWaveCreate() : -1;
+    if ((wave_id < 0) || (gpioWaveTxSend((unsigned) wave_id, PI_WAVE_MODE_REPEAT) < 0))
+    {
+        if (wave_id >= 0)
+        {
+            (void) gpioWaveDelete((unsigned) wave_id);
+        }
+        return -EIO;
+    }
+    sensor->wave_id = wave_id;
+    return 0;
+}
+
+static int16_t sensorPigpioSetTriggerPhase(SensorBackend* const self, const bool aligned, const uint32_t phase_tick)
+{
+    SensorPigpio* const sensor = (SensorPigpio*) self;
+    atomic_store(&sensor->phase_tick, phase_tick);
+    if (aligned == sensor->aligned)
+    {
+        return 0;
+    }
+    sensor->aligned = aligned;
+    return sensorPigpioSetTriggerPeriod(self, atomic_load(&sensor->period_usec));
+}
+
+static uint32_t sensorPigpioTick(SensorBackend* const self)
+{
+    (void) self;
+    return gpioTick();
+}
+
+static void sensorPigpioStop(SensorBackend* const self)
+{
+    SensorPigpio* const sensor = (SensorPigpio*) self;
+    (void) gpioSetTimerFuncEx(SENSOR_PIGPIO_TIMER, 0U, NULL, NULL);
+    sensorPigpioStopWave(sensor);
+    sensorPigpioStopThread(sensor);
+    (void) gpioSetAlertFuncEx(sensor->echo_pin, NULL, NULL);
+    gpioTerminate();
+}
+
+void sensorPigpioInit(SensorPigpio* const sensor, const unsigned trigger_pin, const unsigned echo_pin)
+{
+    sensor->base.name             = "pigpio";
+    sensor->base.start            = &sensorPigpioStart;
+    sensor->base.tick             = &sensorPigpioTick;
+    sensor->base.setTriggerPeriod = &sensorPigpioSetTriggerPeriod;
+    sensor->base.setTriggerPhase  = &sensorPigpioSetTriggerPhase;
+    sensor->base.stop             = &sensorPigpioStop;
+    sensor->trigger_pin           = trigger_pin;
+    sensor->echo_pin              = echo_pin;
+    sensor->handler               = NULL;
+    sensor->context               = NULL;
+    sensor->wave_id               = -1;
+    sensor->aligned               = false;
+    sensor->thread                = NULL;
+    atomic_init(&sensor->period_usec, 0U);
+    atomic_init(&sensor->phase_tick, 0U);
+}
@@ -0,0 +1,52 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Sensor backend using the pigpio library: the trigger pulse is generated from a pigpio timer and the echo edges are
+/// captured by a pigpio alert, both running in the threads of the library. The timers have a resolution of 1 ms and
+/// a minimum period of 10 ms; any other trigger period is generated by a repeated DMA waveform instead, which is
+/// timed by the hardware to the microsecond and runs without the CPU. Neither can be started at a chosen tick, so the
+/// aligned triggers (see SensorBackend.setTriggerPhase) of 10 ms or more are generated by a thread that sleeps until
+/// the next tick of the schedule instead; it spins for the last SENSOR_PIGPIO_SPIN_USEC to keep the jitter low.
+/// ref. http://abyz.me.uk/rpi/pigpio/index.html
+/// ref. http://abyz.me.uk/rpi/pigpio/ex_sonar_ranger.html
+
+#ifndef SENSOR_PIGPIO_H_INCLUDED
+#define SENSOR_PIGPIO_H_INCLUDED
+
+#include "sensor.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The shortest trigger period: the trigger pulse and the shortest echo shall fit into it.
+#define SENSOR_PIGPIO_MIN_TRIGGER_PERIOD_USEC 500U
+#define SENSOR_PIGPIO_SPIN_USEC 100U
+
+typedef struct SensorPigpio
+{
+    SensorBackend     base;
+    unsigned          trigger_pin;
+    unsigned          echo_pin;
+    SensorEchoHandler handler;
+    void*             context;
+    int               wave_id;  ///< The waveform generating the trigger; negative if the timer does.
+    bool              aligned;
+    pthread_t*        thread;  ///< The thread generating the aligned trigger; NULL if not running.
+
+    // Shared with the thread generating the aligned trigger.
+    _Atomic uint32_t period_usec;
+    _Atomic uint32_t phase_tick;
+} SensorPigpio;
+
+void sensorPigpioInit(SensorPigpio* const sensor, const unsigned trigger_pin, const unsigned echo_pin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
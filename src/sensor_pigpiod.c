@@ -0,0 +1,229 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "sensor_pigpiod.h"
+#include "trace.h"
+#include <errno.h>
+#include <pigpiod_if2.h>
+#include <stddef.h>
+#include <time.h>
+
+#define SENSOR_PIGPIOD_TRIGGER_PULSE_USEC 10U
+/// The thread wakes up at least this often to follow the changes of the schedule and to notice the stop.
+#define SENSOR_PIGPIOD_MAX_SLEEP_USEC 100000U
+
+static uint32_t sensorPigpiodGetLocalMicroseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)(((uint64_t) ts.tv_sec * 1000000ULL) + ((uint64_t) ts.tv_nsec / 1000U));
+}
+
+static void sensorPigpiodSleep(const uint32_t usec)
+{
+    const struct timespec duration = {
+        .tv_sec  = (time_t)(usec / 1000000U),
+        .tv_nsec = (long) (usec % 1000000U) * 1000L,
+    };
+    (void) nanosleep(&duration, NULL);  // An early wake-up by a signal is corrected by the caller.
+}
+
+/// Reads the tick of the daemon and updates its offset from the local clock, which is read around the round trip.
+static uint32_t sensorPigpiodSyncTick(SensorPigpiod* const sensor)
+{
+    const uint32_t before = sensorPigpiodGetLocalMicroseconds();
+    const uint32_t tick   = get_current_tick(sensor->pi);
+    const uint32_t after  = sensorPigpiodGetLocalMicroseconds();
+    atomic_store(&sensor->tick_offset, tick - (before + ((after - before) / 2U)));
+    return tick;
+}
+
+static uint32_t sensorPigpiodTick(SensorBackend* const self)
+{
+    const SensorPigpiod* const sensor = (const SensorPigpiod*) self;
+    return sensorPigpiodGetLocalMicroseconds() + atomic_load(&sensor->tick_offset);
+}
+
+/// Triggers every period from the last trigger or, if aligned, on the ticks phase + k * period; both may change at
+/// any time. The first trigger is sent right away. An aligned trigger is never closer than half a period to the
+/// previous one, so that a shift of the phase does not produce a double trigger.
+static void* sensorPigpiodTriggerThread(void* const user)
+{
+    SensorPigpiod* const sensor = (SensorPigpiod*) user;
+    uint32_t             last   = sensorPigpiodSyncTick(sensor) - atomic_load(&sensor->period_usec);
+    while (atomic_load(&sensor->running))
+    {
+        const uint32_t period = atomic_load(&sensor->period_usec);
+        const uint32_t now    = sensorPigpiodSyncTick(sensor);
+        uint32_t       target = last + period;
+        if (atomic_load(&sensor->aligned))
+        {
+            target = now + sensorGetTimeToPhase(now, atomic_load(&sensor->phase_tick), period);
+            if ((int32_t)(target - last) < (int32_t)(period / 2U))
+            {
+                target += period;
+            }
+        }
+        else if ((int32_t)(target - now) < 0)
+        {
+            target = now;  // Behind the schedule, e.g., after the period was shortened: the schedule restarts now.
+        }
+        const int32_t remaining = (int32_t)(target - now);
+        if (remaining > (int32_t) SENSOR_PIGPIOD_MAX_SLEEP_USEC)
+        {
+            sensorPigpiodSleep(SENSOR_PIGPIOD_MAX_SLEEP_USEC);
+            continue;
+        }
+        if (remaining > (int32_t) SENSOR_PIGPIOD_SPIN_USEC)
+        {
+            sensorPigpiodSleep((uint32_t) remaining - SENSOR_PIGPIOD_SPIN_USEC);
+        }
+        while ((int32_t)(target - sensorPigpiodTick(&sensor->base)) > 0)
+        {
+            // Spins on the local clock, which is cheap unlike the tick of the daemon.
+        }
+        if (atomic_load(&sensor->running))
+        {
+            TRACE(trigger, target);
+            (void) gpio_trigger(sensor->pi, sensor->trigger_pin, SENSOR_PIGPIOD_TRIGGER_PULSE_USEC, PI_ON);
+        }
+        last = target;
+    }
+    return NULL;
+}
+
+static void sensorPigpiodOnEdge(const int      pi,
+                                const unsigned gpio,
+                                const unsigned level,
+                                const uint32_t tick,
+                                void* const    user)
+{
+    (void) pi;
+    (void) gpio;
+    const SensorPigpiod* const sensor = (const SensorPigpiod*) user;
+    // PI_TIMEOUT is not an edge and is not enabled anyway.
+    if ((level == PI_ON) || (level == PI_OFF))
+    {
+        sensor->handler(sensor->context, (level == PI_ON) ? SENSOR_LEVEL_HIGH : SENSOR_LEVEL_LOW, tick);
+    }
+}
+
+/// Cancels the callback and closes the connection; the daemon keeps the modes of the pins.
+static void sensorPigpiodDisconnect(SensorPigpiod* const sensor)
+{
+    if (sensor->callback_id >= 0)
+    {
+        (void) callback_cancel((unsigned) sensor->callback_id);
+        sensor->callback_id = -1;
+    }
+    (void) gpio_write(sensor->pi, sensor->trigger_pin, PI_OFF);
+    pigpio_stop(sensor->pi);
+    sensor->pi = -1;
+}
+
+static int16_t sensorPigpiodStart(SensorBackend* const    self,
+                                  const uint32_t          trigger_period_ms,
+                                  const SensorEchoHandler handler,
+                                  void* const             context)
+{
+    SensorPigpiod* const sensor = (SensorPigpiod*) self;
+    if ((trigger_period_ms * 1000U) < SENSOR_PIGPIOD_MIN_TRIGGER_PERIOD_USEC)
+    {
+        return -EINVAL;
+    }
+    sensor->pi = pigpio_start(sensor->address, sensor->port);
+    if (sensor->pi < 0)
+    {
+        return -ECONNREFUSED;
+    }
+    sensor->handler = handler;
+    sensor->context = context;
+    atomic_store(&sensor->period_usec, trigger_period_ms * 1000U);
+
+    // The pins may be reserved by another client of the daemon.
+    if ((set_mode(sensor->pi, sensor->trigger_pin, PI_OUTPUT) != 0) ||
+        (gpio_write(sensor->pi, sensor->trigger_pin, PI_OFF) != 0) ||
+        (set_mode(sensor->pi, sensor->echo_pin, PI_INPUT) != 0))
+    {
+        sensorPigpiodDisconnect(sensor);
+        return -EIO;
+    }
+    // Monitor the echo first, so that the first measurement is not missed.
+    sensor->callback_id = callback_ex(sensor->pi, sensor->echo_pin, EITHER_EDGE, &sensorPigpiodOnEdge, sensor);
+    if (sensor->callback_id < 0)
+    {
+        sensorPigpiodDisconnect(sensor);
+        return -EINVAL;
+    }
+    (void) sensorPigpiodSyncTick(sensor);
+    atomic_store(&sensor->running, true);
+    const int result = pthread_create(&sensor->thread, NULL, &sensorPigpiodTriggerThread, sensor);
+    if (result != 0)
+    {
+        atomic_store(&sensor->running, false);
+        sensorPigpiodDisconnect(sensor);
+        return (int16_t) -result;
+    }
+    return 0;
+}
+
+/// The thread follows the new period from the next trigger.
+static int16_t sensorPigpiodSetTriggerPeriod(SensorBackend* const self, const uint32_t period_usec)
+{
+    SensorPigpiod* const sensor = (SensorPigpiod*) self;
+    if (period_usec < SENSOR_PIGPIOD_MIN_TRIGGER_PERIOD_USEC)
+    {
+        return -EINVAL;
+    }
+    atomic_store(&sensor->period_usec, period_usec);
+    return 0;
+}
+
+static int16_t sensorPigpiodSetTriggerPhase(SensorBackend* const self, const bool aligned, const uint32_t phase_tick)
+{
+    SensorPigpiod* const sensor = (SensorPigpiod*) self;
+    atomic_store(&sensor->phase_tick, phase_tick);
+    atomic_store(&sensor->aligned, aligned);
+    return 0;
+}
+
+static void sensorPigpiodStop(SensorBackend* const self)
+{
+    SensorPigpiod* const sensor = (SensorPigpiod*) self;
+    if (atomic_exchange(&sensor->running, false))
+    {
+        (void) pthread_join(sensor->thread, NULL);
+    }
+    if (sensor->pi >= 0)
+    {
+        sensorPigpiodDisconnect(sensor);
+    }
+}
+
+void sensorPigpiodInit(SensorPigpiod* const sensor,
+                       const char* const    address,
+                       const char* const    port,
+                       const unsigned       trigger_pin,
+                       const unsigned       echo_pin)
+{
+    sensor->base.name             = "pigpiod";
+    sensor->base.start            = &sensorPigpiodStart;
+    sensor->base.tick             = &sensorPigpiodTick;
+    sensor->base.setTriggerPeriod = &sensorPigpiodSetTriggerPeriod;
+    sensor->base.setTriggerPhase  = &sensorPigpiodSetTriggerPhase;
+    sensor->base.stop             = &sensorPigpiodStop;
+    sensor->address               = address;
+    sensor->port                  = port;
+    sensor->trigger_pin           = trigger_pin;
+    sensor->echo_pin              = echo_pin;
+    sensor->handler               = NULL;
+    sensor->context               = NULL;
+    sensor->pi                    = -1;
+    sensor->callback_id           = -1;
+    atomic_init(&sensor->running, false);
+    atomic_init(&sensor->aligned, false);
+    atomic_init(&sensor->period_usec, 0U);
+    atomic_init(&sensor->phase_tick, 0U);
+    atomic_init(&sensor->tick_offset, 0U);
+}
@@ -0,0 +1,69 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Sensor backend using a running pigpio daemon (pigpiod) through the pigpiod_if2 library, instead of initializing
+/// pigpio in the process like sensor_pigpio.h does. The daemon owns the hardware and keeps it set up between the runs
+/// of the node, so attaching to it takes a socket connection instead of the initialization of the DMA, the clocks and
+/// the sampling, the node does not need root, and several processes can drive their own sensors through one daemon.
+///
+/// The echo edges are captured by the daemon and delivered with their ticks by the callback thread of the library.
+/// The trigger pulses are sent by a thread of the backend that sleeps until the tick of the next trigger and spins for
+/// the last SENSOR_PIGPIOD_SPIN_USEC; a waveform is not used because the daemon transmits one waveform at a time for
+/// all of its clients. The pulse is generated by the daemon, but it is late by the time the command takes to get there:
+/// tens of microseconds, which is of no consequence for the measurement because the echo is timed by the daemon.
+///
+/// The tick is read from the daemon once per trigger, together with the local monotonic clock; in between, the tick is
+/// extrapolated from the local clock, so that SensorBackend.tick() and the spinning do not cost a round trip to the
+/// daemon.
+/// ref. http://abyz.me.uk/rpi/pigpio/pdif2.html
+
+#ifndef SENSOR_PIGPIOD_H_INCLUDED
+#define SENSOR_PIGPIOD_H_INCLUDED
+
+#include "sensor.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The shortest trigger period: a trigger costs a wake-up of the thread and a command to the daemon.
+#define SENSOR_PIGPIOD_MIN_TRIGGER_PERIOD_USEC 1000U
+#define SENSOR_PIGPIOD_SPIN_USEC 100U
+
+typedef struct SensorPigpiod
+{
+    SensorBackend     base;
+    const char*       address;  ///< Of the daemon; NULL: $PIGPIO_ADDR, or localhost if not set.
+    const char*       port;     ///< Of the daemon; NULL: $PIGPIO_PORT, or 8888 if not set.
+    unsigned          trigger_pin;
+    unsigned          echo_pin;
+    SensorEchoHandler handler;
+    void*             context;
+    int               pi;           ///< The handle of the connection to the daemon; negative if not connected.
+    int               callback_id;  ///< Of the echo pin; negative if not set.
+    pthread_t         thread;
+
+    // Shared with the thread generating the trigger.
+    atomic_bool      running;
+    atomic_bool      aligned;
+    _Atomic uint32_t period_usec;
+    _Atomic uint32_t phase_tick;
+    _Atomic uint32_t tick_offset;  ///< The tick of the daemon minus the local monotonic clock in microseconds.
+} SensorPigpiod;
+
+/// The address and the port are not copied and shall outlive the backend.
+void sensorPigpiodInit(SensorPigpiod* const sensor,
+                       const char* const    address,
+                       const char* const    port,
+                       const unsigned       trigger_pin,
+                       const unsigned       echo_pin);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
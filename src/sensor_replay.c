@@ -0,0 +1,225 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "sensor_replay.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/// The round-trip speed of sound: the echo pulse width in microseconds times this is the distance in centimeters.
+#define CM_PER_PULSE_USEC 0.01715
+
+#define LINE_SIZE_MAX 256U
+#define INITIAL_CAPACITY 1024U
+
+static uint64_t sensorReplayGetMonotonicNanoseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+static void* sensorReplayThread(void* const arg)
+{
+    SensorReplay* const replay     = (SensorReplay*) arg;
+    const uint32_t      first_tick = replay->edges[0].tick;
+    for (size_t i = 0; (i < replay->count) && atomic_load(&replay->running); i++)
+    {
+        const double          offset_ns = (double) (uint32_t)(replay->edges[i].tick - first_tick) * 1e3 / replay->speed;
+        const uint64_t        due_ns    = replay->started_at_ns + (uint64_t) offset_ns;
+        const struct timespec due       = {
+            .tv_sec  = (time_t)(due_ns / 1000000000ULL),
+            .tv_nsec = (long) (due_ns % 1000000000ULL),
+        };
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR)
+        {
+            // Interrupted by a signal; sleep again.
+        }
+        atomic_store_explicit(&replay->last_tick, replay->edges[i].tick, memory_order_relaxed);
+        replay->handler(replay->context, replay->edges[i].level, replay->edges[i].tick);
+    }
+    return NULL;
+}
+
+static int16_t sensorReplayStart(SensorBackend* const    self,
+                                 const uint32_t          trigger_period_ms,
+                                 const SensorEchoHandler handler,
+                                 void* const             context)
+{
+    (void) trigger_period_ms;  // The timing is given by the trace.
+    SensorReplay* const replay = (SensorReplay*) self;
+    if ((replay->count == 0U) || !(replay->speed > 0.0))
+    {
+        return -EINVAL;
+    }
+    replay->handler       = handler;
+    replay->context       = context;
+    replay->started_at_ns = sensorReplayGetMonotonicNanoseconds();
+    atomic_store(&replay->running, true);
+    const int result = pthread_create(&replay->thread, NULL, &sensorReplayThread, replay);
+    if (result != 0)
+    {
+        atomic_store(&replay->running, false);
+        return (int16_t) -result;
+    }
+    return 0;
+}
+
+static uint32_t sensorReplayTick(SensorBackend* const self)
+{
+    SensorReplay* const replay = (SensorReplay*) self;
+    if (!atomic_load(&replay->running))
+    {
+        return atomic_load(&replay->last_tick);
+    }
+    const uint64_t elapsed_ns = sensorReplayGetMonotonicNanoseconds() - replay->started_at_ns;
+    return replay->edges[0].tick + (uint32_t)((double) elapsed_ns * 1e-3 * replay->speed);
+}
+
+static int16_t sensorReplaySetTriggerPeriod(SensorBackend* const self, const uint32_t period_usec)
+{
+    (void) self;
+    (void) period_usec;
+    return 0;
+}
+
+/// The trace keeps the timing of the recorded triggers.
+static int16_t sensorReplaySetTriggerPhase(SensorBackend* const self, const bool aligned, const uint32_t phase_tick)
+{
+    (void) self;
+    (void) aligned;
+    (void) phase_tick;
+    return 0;
+}
+
+static void sensorReplayStop(SensorBackend* const self)
+{
+    SensorReplay* const replay = (SensorReplay*) self;
+    if (atomic_exchange(&replay->running, false))
+    {
+        (void) pthread_join(replay->thread, NULL);
+    }
+}
+
+void sensorReplayInit(SensorReplay* const           replay,
+                      const SensorReplayEdge* const edges,
+                      const size_t                  count,
+                      const double                  speed)
+{
+    (void) memset(replay, 0, sizeof(SensorReplay));
+    replay->base.name             = "replay";
+    replay->base.start            = &sensorReplayStart;
+    replay->base.tick             = &sensorReplayTick;
+    replay->base.setTriggerPeriod = &sensorReplaySetTriggerPeriod;
+    replay->base.setTriggerPhase  = &sensorReplaySetTriggerPhase;
+    replay->base.stop             = &sensorReplayStop;
+    replay->edges                 = edges;
+    replay->count                 = count;
+    replay->owned                 = false;
+    replay->speed                 = speed;
+    atomic_init(&replay->running, false);
+    atomic_init(&replay->last_tick, (count > 0U) ? edges[0].tick : 0U);
+}
+
+/// Appends an edge, growing the array as needed. Returns false if out of memory.
+static bool sensorReplayAppend(SensorReplayEdge** const edges,
+                               size_t* const            count,
+                               size_t* const            capacity,
+                               const uint32_t           tick,
+                               const uint8_t            level)
+{
+    if (*count >= *capacity)
+    {
+        const size_t            new_capacity = (*capacity > 0U) ? (*capacity * 2U) : INITIAL_CAPACITY;
+        SensorReplayEdge* const grown        = realloc(*edges, new_capacity * sizeof(SensorReplayEdge));
+        if (grown == NULL)
+        {
+            return false;
+        }
+        *edges    = grown;
+        *capacity = new_capacity;
+    }
+    (*edges)[*count].tick  = tick;
+    (*edges)[*count].level = level;
+    (*count)++;
+    return true;
+}
+
+int16_t sensorReplayLoad(SensorReplay* const replay, const char* const path, const double speed)
+{
+    FILE* const file = fopen(path, "r");
+    if (file == NULL)
+    {
+        return (int16_t) -errno;
+    }
+    SensorReplayEdge* edges    = NULL;
+    size_t            count    = 0;
+    size_t            capacity = 0;
+    bool              ok       = true;
+    char              line[LINE_SIZE_MAX];
+    while (ok && (fgets(line, sizeof(line), file) != NULL))
+    {
+        unsigned long long usec   = 0;
+        int                offset = 0;
+        if (sscanf(line, "%llu %n", &usec, &offset) != 1)
+        {
+            continue;  // Comment or garbage.
+        }
+        const char* const rest       = &line[offset];
+        const uint32_t    tick       = (uint32_t) usec;
+        double            distance   = 0.0;
+        unsigned          stream     = 0;
+        long              pulse_usec = -1;
+        unsigned          level      = 0;
+        if (sscanf(rest, "distance=%lf", &distance) == 1)
+        {
+            pulse_usec = (long) ((distance / CM_PER_PULSE_USEC) + 0.5);
+        }
+        else if (sscanf(rest, "sample stream=%u value=%ld", &stream, &pulse_usec) != 2)
+        {
+            pulse_usec = -1;
+            if ((sscanf(rest, "%u", &level) == 1) && (level <= 1U))
+            {
+                ok = sensorReplayAppend(&edges, &count, &capacity, tick, (uint8_t) level);
+            }
+        }
+        if (pulse_usec >= 0)
+        {
+            ok = sensorReplayAppend(&edges, &count, &capacity, tick - (uint32_t) pulse_usec, SENSOR_LEVEL_HIGH) &&
+                 sensorReplayAppend(&edges, &count, &capacity, tick, SENSOR_LEVEL_LOW);
+        }
+    }
+    (void) fclose(file);
+    if (!ok || (count == 0U))
+    {
+        free(edges);
+        return ok ? -EINVAL : -ENOMEM;
+    }
+    sensorReplayInit(replay, edges, count, speed);
+    replay->owned = true;
+    return 0;
+}
+
+void sensorReplayFree(SensorReplay* const replay)
+{
+    if (replay->owned)
+    {
+        free((void*) replay->edges);
+    }
+    replay->edges = NULL;
+    replay->count = 0;
+    replay->owned = false;
+}
+
+size_t sensorReplayRun(SensorReplay* const replay, const SensorEchoHandler handler, void* const context)
+{
+    for (size_t i = 0; i < replay->count; i++)
+    {
+        atomic_store_explicit(&replay->last_tick, replay->edges[i].tick, memory_order_relaxed);
+        handler(context, replay->edges[i].level, replay->edges[i].tick);
+    }
+    return replay->count;
+}
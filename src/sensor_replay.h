@@ -0,0 +1,73 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Sensor backend that replays a recorded trace of echo edges instead of measuring. The trace is a text file with one
+/// entry per line, the first field being a timestamp in microseconds; the following entries are understood:
+///
+///     <usec> <level>                              An edge of the echo pin, level 0 or 1.
+///     <usec> distance=<cm>                        A measured distance; the pulse ends at the timestamp.
+///     <usec> sample stream=<n> value=<pulse_usec>  An echo pulse width as printed by flightrec-dump.
+///
+/// Other lines (e.g., the other records printed by flightrec-dump, comments) are ignored. The trace is either paced
+/// by a thread of the backend at the original or scaled speed when started as a SensorBackend, which ignores the
+/// trigger period (also when changed) because the timing is given by the trace, or delivered synchronously as fast as
+/// possible by sensorReplayRun().
+
+#ifndef SENSOR_REPLAY_H_INCLUDED
+#define SENSOR_REPLAY_H_INCLUDED
+
+#include "sensor.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SensorReplayEdge
+{
+    uint32_t tick;
+    uint8_t  level;
+} SensorReplayEdge;
+
+typedef struct SensorReplay
+{
+    SensorBackend           base;
+    const SensorReplayEdge* edges;
+    size_t                  count;
+    bool                    owned;  ///< The edges were loaded from a file and are freed by sensorReplayFree().
+    double                  speed;  ///< 1 is the original speed, 2 is twice as fast, and so on.
+
+    SensorEchoHandler handler;
+    void*             context;
+    pthread_t         thread;
+    atomic_bool       running;
+    uint64_t          started_at_ns;  ///< Monotonic time of the first edge in the paced mode.
+    _Atomic uint32_t  last_tick;      ///< The tick of the last delivered edge in the batch mode.
+} SensorReplay;
+
+/// Replays the edges provided by the caller, which shall outlive the backend.
+void sensorReplayInit(SensorReplay* const            replay,
+                      const SensorReplayEdge* const edges,
+                      const size_t                   count,
+                      const double                   speed);
+
+/// Loads the trace from the file. Returns zero on success, negated errno on failure (-EINVAL if the file is not a
+/// trace or contains no edges).
+int16_t sensorReplayLoad(SensorReplay* const replay, const char* const path, const double speed);
+
+/// Frees the edges loaded by sensorReplayLoad(); the backend shall be stopped.
+void sensorReplayFree(SensorReplay* const replay);
+
+/// Delivers all edges to the handler synchronously from the caller's thread, as fast as possible.
+/// Returns the number of edges delivered.
+size_t sensorReplayRun(SensorReplay* const replay, const SensorEchoHandler handler, void* const context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
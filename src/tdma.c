@@ -0,0 +1,86 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "tdma.h"
+#include <canard_dsdl.h>
+#include <string.h>
+
+void tdmaInit(TdmaSchedule* const schedule, SensorBackend* const sensor, const TimeSync* const sync)
+{
+    (void) memset(schedule, 0, sizeof(TdmaSchedule));
+    schedule->sensor    = sensor;
+    schedule->sync      = sync;
+    schedule->slot_usec = TDMA_DEFAULT_SLOT_USEC;
+}
+
+static uint32_t tdmaGetFrame(const TdmaSchedule* const schedule)
+{
+    return (uint32_t) schedule->slot_count * schedule->slot_usec;
+}
+
+uint32_t tdmaHandleRequest(TdmaSchedule* const     schedule,
+                           const uint8_t* const    request,
+                           const size_t            request_size,
+                           const CanardMicrosecond now_usec,
+                           uint8_t* const          response)
+{
+    const uint8_t  slot_index = canardDSDLGetU8(request, request_size, 0U, 8U);
+    const uint8_t  slot_count = canardDSDLGetU8(request, request_size, 8U, 8U);
+    const uint16_t slot_usec  = canardDSDLGetU16(request, request_size, 16U, 16U);
+    const uint32_t length     = (slot_usec > 0U) ? slot_usec : TDMA_DEFAULT_SLOT_USEC;
+    TdmaStatus     status     = TdmaStatusApplied;
+    if (slot_count == 0U)
+    {
+        schedule->slot_count = 0U;
+        if (schedule->aligned)
+        {
+            (void) schedule->sensor->setTriggerPhase(schedule->sensor, false, 0U);
+            schedule->aligned = false;
+        }
+        status = TdmaStatusDisabled;
+    }
+    else if ((slot_index >= slot_count) || (((uint32_t) slot_count * length) < TDMA_MIN_FRAME_USEC))
+    {
+        status = TdmaStatusInvalid;  // The schedule in effect is kept.
+    }
+    else
+    {
+        schedule->slot_index = slot_index;
+        schedule->slot_count = slot_count;
+        schedule->slot_usec  = length;
+        tdmaPoll(schedule, now_usec);
+    }
+    const uint32_t frame_usec = tdmaGetFrame(schedule);
+    canardDSDLSetUxx(response, 0U, (uint64_t) status, 8U);
+    canardDSDLSetBit(response, 8U, schedule->aligned);
+    canardDSDLSetUxx(response, 16U, frame_usec, 32U);
+    return frame_usec;
+}
+
+void tdmaPoll(TdmaSchedule* const schedule, const CanardMicrosecond now_usec)
+{
+    CanardMicrosecond network_usec = 0U;
+    if ((schedule->slot_count > 0U) && timesyncGetNetworkTime(schedule->sync, now_usec, &network_usec))
+    {
+        // The slot of the current frame may not have started yet; then the phase refers to the previous frame.
+        const uint32_t tick       = schedule->sensor->tick(schedule->sensor);
+        const uint64_t frame_usec = tdmaGetFrame(schedule);
+        const uint64_t slot_start = (uint64_t) schedule->slot_index * schedule->slot_usec;
+        const uint64_t into_slot  = ((network_usec % frame_usec) + frame_usec - slot_start) % frame_usec;
+        if (schedule->sensor->setTriggerPhase(schedule->sensor, true, tick - (uint32_t) into_slot) >= 0)
+        {
+            schedule->aligned = true;
+            schedule->alignments++;
+        }
+    }
+}
+
+void tdmaWriteMetrics(const TdmaSchedule* const schedule, MetricsSink* const sink)
+{
+    metricsGauge(sink, "tdma_slot_count", NULL, (double) schedule->slot_count);
+    metricsGauge(sink, "tdma_slot_index", NULL, (double) schedule->slot_index);
+    metricsGauge(sink, "tdma_frame_seconds", NULL, (double) tdmaGetFrame(schedule) * 1e-6);
+    metricsGauge(sink, "tdma_aligned", NULL, schedule->aligned ? 1.0 : 0.0);
+    metricsGauge(sink, "tdma_alignments_total", NULL, (double) schedule->alignments);
+}
@@ -0,0 +1,91 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Time-division trigger schedule shared by the sensor nodes mounted near each other, so that no node hears the ping
+/// of another one as its own echo. The network time (see timesync.h) is divided into frames of slot_count slots of
+/// equal length; the frames start at the multiples of the frame length, so every node that is configured with the
+/// same slot count and length agrees on them without further coordination. A node triggers once per frame at the
+/// start of its slot, and the slot is long enough for the ping to die out before the next slot begins.
+///
+/// The aggregate sample rate of the network is slot_count / frame = 1 / slot_usec, so the slots shall be as short as
+/// the acoustic window allows: the round trip over the longest range of interest plus a guard for the error of the
+/// time synchronization and the jitter of the trigger. The nodes that cannot hear each other may share a slot.
+///
+/// The schedule is configured through a service; it is kept in RAM only. The node triggers at the frame period as
+/// soon as the schedule is configured, and aligns the trigger to its slot once it is synchronized. The alignment is
+/// refreshed by tdmaPoll() to follow the drift of the local clock; it is kept if the synchronization is lost.
+///
+/// Request (the extent is TDMA_REQUEST_SIZE bytes):
+///     uint8  slot_index    # Shall be less than slot_count.
+///     uint8  slot_count    # Zero disables the schedule: the node triggers at its own period again.
+///     uint16 slot_usec     # Zero: TDMA_DEFAULT_SLOT_USEC.
+///
+/// Response:
+///     uint8  status        # See TdmaStatus.
+///     bool   synchronized  # The trigger is aligned to the slot.
+///     uint32 frame_usec    # The trigger period of the schedule in effect; zero if disabled.
+
+#ifndef TDMA_H_INCLUDED
+#define TDMA_H_INCLUDED
+
+#include "metrics.h"
+#include "sensor.h"
+#include "timesync.h"
+#include <canard.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The round trip over the 4 m range of the HC-SR04 takes 23.3 ms at 343 m/s; the rest is the guard.
+#define TDMA_DEFAULT_SLOT_USEC 25000U
+/// Without a target in range, the HC-SR04 holds the echo pin high for about 38 ms and ignores the triggers meanwhile.
+#define TDMA_MIN_FRAME_USEC 40000U
+
+#define TDMA_REQUEST_SIZE 4U
+#define TDMA_RESPONSE_SIZE 6U
+
+typedef enum
+{
+    TdmaStatusApplied = 0,
+    TdmaStatusDisabled,  ///< The schedule was disabled by the request.
+    TdmaStatusInvalid,   ///< The slot index is out of range or the frame is shorter than TDMA_MIN_FRAME_USEC.
+} TdmaStatus;
+
+typedef struct TdmaSchedule
+{
+    SensorBackend*  sensor;
+    const TimeSync* sync;
+
+    uint8_t  slot_index;
+    uint8_t  slot_count;  ///< Zero if the schedule is disabled.
+    uint32_t slot_usec;
+    bool     aligned;  ///< The trigger is aligned to the slot.
+    uint64_t alignments;
+} TdmaSchedule;
+
+void tdmaInit(TdmaSchedule* const schedule, SensorBackend* const sensor, const TimeSync* const sync);
+
+/// Handles a request of the schedule service and writes the response, which is always TDMA_RESPONSE_SIZE bytes long.
+/// Returns the frame length to be used as the trigger period from now on, or zero if the schedule is disabled; the
+/// caller owns the trigger period (see demand.h). A shorter request is zero-extended per the implicit zero extension.
+uint32_t tdmaHandleRequest(TdmaSchedule* const     schedule,
+                           const uint8_t* const    request,
+                           const size_t            request_size,
+                           const CanardMicrosecond now_usec,
+                           uint8_t* const          response);
+
+/// Aligns the trigger to the slot using the current network time; shall be invoked from the main loop periodically,
+/// e.g., once a second, and after the configuration of the schedule.
+void tdmaPoll(TdmaSchedule* const schedule, const CanardMicrosecond now_usec);
+
+void tdmaWriteMetrics(const TdmaSchedule* const schedule, MetricsSink* const sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
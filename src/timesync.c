@@ -0,0 +1,71 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "timesync.h"
+#include <canard_dsdl.h>
+#include <string.h>
+
+void timesyncInit(TimeSync* const sync)
+{
+    (void) memset(sync, 0, sizeof(TimeSync));
+    sync->master_node_id = CANARD_NODE_ID_UNSET;
+}
+
+static bool timesyncIsMasterAlive(const TimeSync* const sync, const CanardMicrosecond local_usec)
+{
+    return (sync->master_node_id <= CANARD_NODE_ID_MAX) && (local_usec >= sync->last_rx_usec) &&
+           ((local_usec - sync->last_rx_usec) <= TIMESYNC_TIMEOUT_USEC);
+}
+
+void timesyncOnMessage(TimeSync* const sync, const CanardTransfer* const transfer)
+{
+    const CanardNodeID node_id = transfer->remote_node_id;
+    if ((node_id <= CANARD_NODE_ID_MAX) &&
+        ((node_id <= sync->master_node_id) || !timesyncIsMasterAlive(sync, transfer->timestamp_usec)))
+    {
+        const CanardMicrosecond previous_tx_usec =
+            canardDSDLGetU64((const uint8_t*) transfer->payload, transfer->payload_size, 0U, 56U);
+        const bool consecutive = (node_id == sync->master_node_id) &&
+                                 (transfer->transfer_id == ((sync->last_transfer_id + 1U) & CANARD_TRANSFER_ID_MAX)) &&
+                                 timesyncIsMasterAlive(sync, transfer->timestamp_usec);
+        if (consecutive && (previous_tx_usec > 0U))
+        {
+            const int64_t offset_usec = (int64_t)(previous_tx_usec - sync->last_rx_usec);
+            sync->last_correction_usec = sync->synchronized ? (offset_usec - sync->offset_usec) : 0;
+            sync->offset_usec          = offset_usec;
+            sync->synchronized         = true;
+            sync->measurements++;
+        }
+        else if (node_id != sync->master_node_id)
+        {
+            sync->synchronized = false;  // A different master, a different time base.
+        }
+        sync->master_node_id   = node_id;
+        sync->last_transfer_id = transfer->transfer_id;
+        sync->last_rx_usec     = transfer->timestamp_usec;
+    }
+}
+
+bool timesyncGetNetworkTime(const TimeSync* const    sync,
+                            const CanardMicrosecond  local_usec,
+                            CanardMicrosecond* const out_network_usec)
+{
+    const bool valid = sync->synchronized && timesyncIsMasterAlive(sync, local_usec);
+    if (valid)
+    {
+        *out_network_usec = (CanardMicrosecond)((int64_t) local_usec + sync->offset_usec);
+    }
+    return valid;
+}
+
+void timesyncWriteMetrics(const TimeSync* const sync, const CanardMicrosecond now_usec, MetricsSink* const sink)
+{
+    CanardMicrosecond network_usec = 0U;
+    const bool        synchronized = timesyncGetNetworkTime(sync, now_usec, &network_usec);
+    metricsGauge(sink, "timesync_synchronized", NULL, synchronized ? 1.0 : 0.0);
+    metricsGauge(sink, "timesync_master_node_id", NULL, (double) sync->master_node_id);
+    metricsGauge(sink, "timesync_offset_seconds", NULL, (double) sync->offset_usec * 1e-6);
+    metricsGauge(sink, "timesync_last_correction_seconds", NULL, (double) sync->last_correction_usec * 1e-6);
+    metricsGauge(sink, "timesync_measurements_total", NULL, (double) sync->measurements);
+}
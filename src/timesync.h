@@ -0,0 +1,59 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Time synchronization slave: follows the network time published by a master on uavcan.time.Synchronization.
+/// ref. Specification v1.0-beta, Revision 2020-10-16; sec. 5.3.6
+///     truncated uint56 previous_transmission_timestamp_microsecond  # Zero if unknown.
+///
+/// Each message carries the time, in the network time base, at which the master transmitted its previous message.
+/// The local reception timestamp of the previous message is paired with it if the transfer-IDs are consecutive; the
+/// difference is the offset of the network time from the local time. If several masters publish, the one with the
+/// lowest node-ID is followed; a different master is accepted once the current one has been silent for the timeout.
+
+#ifndef TIMESYNC_H_INCLUDED
+#define TIMESYNC_H_INCLUDED
+
+#include "metrics.h"
+#include <canard.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TIMESYNC_SUBJECT_ID 7168U
+#define TIMESYNC_MESSAGE_EXTENT 7U
+/// The maximal publication period of the master times the publisher timeout multiplier of the specification.
+#define TIMESYNC_TIMEOUT_USEC 3000000U
+
+typedef struct TimeSync
+{
+    CanardNodeID      master_node_id;  ///< CANARD_NODE_ID_UNSET if no master is followed.
+    CanardTransferID  last_transfer_id;
+    CanardMicrosecond last_rx_usec;  ///< The local reception timestamp of the last message of the master.
+    bool              synchronized;  ///< The offset has been measured with the current master.
+    int64_t           offset_usec;   ///< The network time minus the local time.
+    int64_t           last_correction_usec;  ///< The change of the offset at the last measurement.
+    uint64_t          measurements;
+} TimeSync;
+
+void timesyncInit(TimeSync* const sync);
+
+/// Shall be invoked for every received uavcan.time.Synchronization transfer; the anonymous ones are ignored.
+void timesyncOnMessage(TimeSync* const sync, const CanardTransfer* const transfer);
+
+/// Converts the local time into the network time. Returns false if the node is not synchronized: no offset has been
+/// measured yet, or the master has been silent for the timeout; the output is not modified then.
+bool timesyncGetNetworkTime(const TimeSync* const   sync,
+                            const CanardMicrosecond local_usec,
+                            CanardMicrosecond* const out_network_usec);
+
+void timesyncWriteMetrics(const TimeSync* const sync, const CanardMicrosecond now_usec, MetricsSink* const sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,28 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// USDT probes of the application under the provider name "ultrasound", see tools/bpftrace/. libcanard and socketcan
+/// have their own probes under the providers "libcanard" and "socketcan". The probes are compiled out if <sys/sdt.h>
+/// is unavailable or TRACE_ENABLED is defined as false. When no tracer is attached, a probe costs a single NOP
+/// instruction plus the evaluation of its arguments; the arguments shall be integers or pointers.
+
+#ifndef TRACE_H_INCLUDED
+#define TRACE_H_INCLUDED
+
+#ifndef TRACE_ENABLED
+#    if defined(__has_include)
+#        if __has_include(<sys/sdt.h>)
+#            define TRACE_ENABLED 1
+#        endif
+#    endif
+#endif
+
+#if defined(TRACE_ENABLED) && TRACE_ENABLED
+#    include <sys/sdt.h>
+#    define TRACE(name, ...) STAP_PROBEV(ultrasound, name, __VA_ARGS__)
+#else
+#    define TRACE(name, ...) (void) 0
+#endif
+
+#endif
@@ -0,0 +1,290 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "txlatency.h"
+#include "canid.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static_assert((TXLATENCY_MAX_IN_FLIGHT & (TXLATENCY_MAX_IN_FLIGHT - 1U)) == 0U, "Shall be a power of two");
+static_assert((TXLATENCY_MAX_QUEUED & (TXLATENCY_MAX_QUEUED - 1U)) == 0U, "Shall be a power of two");
+
+static const char* const PhaseNames[TXLATENCY_NUM_PHASES] = {"userspace", "kernel", "transmit", "total"};
+
+static void histogramAdd(TxLatencyHistogram* const hist, const CanardMicrosecond from, const CanardMicrosecond to)
+{
+    const uint64_t value = (to > from) ? (to - from) : 0U;
+    size_t         bin   = 0;
+    while ((bin < (TXLATENCY_HISTOGRAM_BINS - 1U)) && ((value >> bin) > 0U))
+    {
+        ++bin;
+    }
+    hist->bins[bin]++;
+    hist->count++;
+    hist->sum_usec += value;
+    hist->max_usec = (value > hist->max_usec) ? value : hist->max_usec;
+}
+
+/// Returns the upper bound of the bin where the specified quantile falls.
+static uint64_t histogramGetQuantile(const TxLatencyHistogram* const hist, const double quantile)
+{
+    const uint64_t threshold = (uint64_t)(quantile * (double) hist->count);
+    uint64_t       acc       = 0;
+    for (size_t i = 0; i < TXLATENCY_HISTOGRAM_BINS; i++)
+    {
+        acc += hist->bins[i];
+        if ((acc > threshold) || (acc == hist->count))
+        {
+            return (i > 0U) ? (UINT64_C(1) << i) : 0U;
+        }
+    }
+    return 0U;
+}
+
+static TxLatencyPort* findPort(TxLatencyTracker* const tracker, const uint16_t key)
+{
+    for (size_t i = 0; i < TXLATENCY_MAX_PORTS; i++)
+    {
+        TxLatencyPort* const port = &tracker->ports[i];
+        if (port->key == TXLATENCY_PORT_KEY_NONE)
+        {
+            port->key = key;
+        }
+        if (port->key == key)
+        {
+            return port;
+        }
+    }
+    return NULL;
+}
+
+static void complete(TxLatencyTracker* const   tracker,
+                     TxLatencyRecord* const    rec,
+                     const CanardMicrosecond   looped_back_usec)
+{
+    TxLatencyPort* const port = findPort(tracker, canidGetPortKey(rec->can_id));
+    if (port != NULL)
+    {
+        const CanardMicrosecond handed_over_usec =
+            (rec->sent_usec != 0U) ? rec->sent_usec
+                                   : ((rec->scheduled_usec != 0U) ? rec->scheduled_usec : rec->written_usec);
+        if (rec->enqueued_usec != 0U)
+        {
+            histogramAdd(&port->phases[TxLatencyPhaseUserspace], rec->enqueued_usec, rec->written_usec);
+            histogramAdd(&port->phases[TxLatencyPhaseTotal], rec->enqueued_usec, looped_back_usec);
+        }
+        histogramAdd(&port->phases[TxLatencyPhaseKernel], rec->written_usec, handed_over_usec);
+        histogramAdd(&port->phases[TxLatencyPhaseTransmit], handed_over_usec, looped_back_usec);
+    }
+    if (rec->enqueued_usec != 0U)
+    {
+        histogramAdd(&tracker->priorities[canidGetPriority(rec->can_id)], rec->enqueued_usec, looped_back_usec);
+    }
+    rec->pending = false;
+}
+
+void txlatencyInit(TxLatencyTracker* const tracker)
+{
+    (void) memset(tracker, 0, sizeof(TxLatencyTracker));
+    for (size_t i = 0; i < TXLATENCY_MAX_PORTS; i++)
+    {
+        tracker->ports[i].key = TXLATENCY_PORT_KEY_NONE;
+    }
+}
+
+void txlatencyOnPush(TxLatencyTracker* const  tracker,
+                     const CanardTransferKind kind,
+                     const CanardPortID       port_id,
+                     const CanardMicrosecond  deadline_usec,
+                     const CanardMicrosecond  enqueued_usec)
+{
+    TxLatencyPush* const push = &tracker->queued[tracker->next_push % TXLATENCY_MAX_QUEUED];
+    push->key                 = (uint16_t)((((uint16_t) kind) << CANID_PORT_KEY_KIND_OFFSET) | port_id);
+    push->deadline_usec       = deadline_usec;
+    push->enqueued_usec       = enqueued_usec;
+    tracker->next_push++;
+}
+
+/// The newest matching push is the one: an older push of the same port with the same deadline is long gone.
+static CanardMicrosecond findEnqueued(const TxLatencyTracker* const tracker, const CanardFrame* const frame)
+{
+    const uint16_t key = canidGetPortKey(frame->extended_can_id);
+    for (uint32_t i = 1U; i <= TXLATENCY_MAX_QUEUED; i++)
+    {
+        const TxLatencyPush* const push = &tracker->queued[(tracker->next_push - i) % TXLATENCY_MAX_QUEUED];
+        if ((push->deadline_usec == frame->timestamp_usec) && (push->key == key))
+        {
+            return push->enqueued_usec;
+        }
+    }
+    return 0U;
+}
+
+/// Takes the record of the next sequence number; the frame is in flight only if it was written.
+static TxLatencyRecord* addRecord(TxLatencyTracker* const  tracker,
+                                  const CanardFrame* const frame,
+                                  const CanardMicrosecond  written_usec,
+                                  const bool               pending)
+{
+    TxLatencyRecord* const rec = &tracker->in_flight[tracker->next_id % TXLATENCY_MAX_IN_FLIGHT];
+    if (rec->pending)
+    {
+        tracker->lost++;  // The loopback of this frame never arrived.
+    }
+    rec->pending        = pending;
+    rec->id             = tracker->next_id;
+    rec->can_id         = frame->extended_can_id;
+    rec->enqueued_usec  = 0U;
+    rec->written_usec   = written_usec;
+    rec->scheduled_usec = 0U;
+    rec->sent_usec      = 0U;
+    tracker->next_id++;
+    if ((tracker->next_id - tracker->oldest_id) > TXLATENCY_MAX_IN_FLIGHT)
+    {
+        tracker->oldest_id = tracker->next_id - TXLATENCY_MAX_IN_FLIGHT;
+    }
+    return rec;
+}
+
+void txlatencyOnWrite(TxLatencyTracker* const  tracker,
+                      const CanardFrame* const frame,
+                      const CanardMicrosecond  written_usec)
+{
+    const CanardMicrosecond enqueued_usec = findEnqueued(tracker, frame);
+    tracker->untracked += (enqueued_usec == 0U) ? 1U : 0U;
+    addRecord(tracker, frame, written_usec, true)->enqueued_usec = enqueued_usec;
+}
+
+void txlatencyOnWriteFailed(TxLatencyTracker* const  tracker,
+                            const CanardFrame* const frame,
+                            const CanardMicrosecond  failed_usec)
+{
+    (void) addRecord(tracker, frame, failed_usec, false);
+}
+
+/// Whether the scheduler report of the given time belongs to the record of the given sequence number.
+static bool isScheduledBy(const TxLatencyTracker* const tracker, const uint32_t id, const CanardMicrosecond at_usec)
+{
+    const TxLatencyRecord* const rec  = &tracker->in_flight[id % TXLATENCY_MAX_IN_FLIGHT];
+    const TxLatencyRecord* const prev = &tracker->in_flight[(id - 1U) % TXLATENCY_MAX_IN_FLIGHT];
+    return (rec->id == id) && (at_usec <= rec->written_usec) &&
+           ((prev->id != (id - 1U)) || (prev->written_usec <= at_usec));
+}
+
+/// Returns the sequence number of the first frame written after the given time, or next_id if there is none.
+static uint32_t findWrittenAfter(const TxLatencyTracker* const tracker, const CanardMicrosecond at_usec)
+{
+    for (uint32_t id = tracker->next_id - TXLATENCY_MAX_IN_FLIGHT; id != tracker->next_id; id++)
+    {
+        const TxLatencyRecord* const rec = &tracker->in_flight[id % TXLATENCY_MAX_IN_FLIGHT];
+        if ((rec->id == id) && (rec->written_usec >= at_usec))
+        {
+            return id;
+        }
+    }
+    return tracker->next_id;
+}
+
+void txlatencyOnTimestamp(TxLatencyTracker* const tracker, const SocketCANTxTimestamp* const timestamp)
+{
+    uint32_t id = timestamp->id + tracker->id_skew;
+    if (timestamp->scheduled && !isScheduledBy(tracker, id, timestamp->timestamp_usec))
+    {
+        id = findWrittenAfter(tracker, timestamp->timestamp_usec);
+        if (id != tracker->next_id)
+        {
+            tracker->id_skew = id - timestamp->id;
+            tracker->resynced++;
+        }
+    }
+    TxLatencyRecord* const rec = &tracker->in_flight[id % TXLATENCY_MAX_IN_FLIGHT];
+    if (rec->pending && (rec->id == id))
+    {
+        if (timestamp->scheduled)
+        {
+            rec->scheduled_usec = timestamp->timestamp_usec;
+        }
+        else
+        {
+            rec->sent_usec = timestamp->timestamp_usec;
+        }
+    }
+}
+
+void txlatencyOnLoopback(TxLatencyTracker* const tracker, const CanardFrame* const frame)
+{
+    // The frames are looped back in the order of transmission, so the oldest pending frame with the same CAN ID
+    // is the one. Frames with different CAN IDs may be skipped if the controller reordered them by priority.
+    for (uint32_t id = tracker->oldest_id; id != tracker->next_id; id++)
+    {
+        TxLatencyRecord* const rec = &tracker->in_flight[id % TXLATENCY_MAX_IN_FLIGHT];
+        if (rec->pending && (rec->can_id == frame->extended_can_id))
+        {
+            complete(tracker, rec, frame->timestamp_usec);
+            break;
+        }
+    }
+    while ((tracker->oldest_id != tracker->next_id) &&
+           !tracker->in_flight[tracker->oldest_id % TXLATENCY_MAX_IN_FLIGHT].pending)
+    {
+        tracker->oldest_id++;
+    }
+}
+
+/// The labels of the histogram are given; the quantile label is appended to them.
+static void writeHistogram(const TxLatencyHistogram* const hist,
+                           const char* const               prefix,
+                           char* const                     labels,
+                           const size_t                    labels_size,
+                           const int                       base,
+                           MetricsSink* const              sink)
+{
+    char name[64];
+    (void) snprintf(name, sizeof(name), "%s_frames_total", prefix);
+    metricsGauge(sink, name, labels, (double) hist->count);
+    if (hist->count > 0U)
+    {
+        (void) snprintf(name, sizeof(name), "%s_usec_mean", prefix);
+        metricsGauge(sink, name, labels, (double) hist->sum_usec / (double) hist->count);
+        (void) snprintf(name, sizeof(name), "%s_usec_max", prefix);
+        metricsGauge(sink, name, labels, (double) hist->max_usec);
+        (void) snprintf(name, sizeof(name), "%s_usec", prefix);
+        (void) snprintf(&labels[base], labels_size - (size_t) base, ",quantile=\"0.5\"");
+        metricsGauge(sink, name, labels, (double) histogramGetQuantile(hist, 0.5));
+        (void) snprintf(&labels[base], labels_size - (size_t) base, ",quantile=\"0.99\"");
+        metricsGauge(sink, name, labels, (double) histogramGetQuantile(hist, 0.99));
+    }
+}
+
+void txlatencyWriteMetrics(const TxLatencyTracker* const tracker, MetricsSink* const sink)
+{
+    char labels[96];
+    metricsGauge(sink, "tx_latency_lost_total", NULL, (double) tracker->lost);
+    metricsGauge(sink, "tx_latency_untracked_total", NULL, (double) tracker->untracked);
+    metricsGauge(sink, "tx_latency_resync_total", NULL, (double) tracker->resynced);
+    for (size_t i = 0; i < TXLATENCY_MAX_PORTS; i++)
+    {
+        const TxLatencyPort* const port = &tracker->ports[i];
+        if (port->key == TXLATENCY_PORT_KEY_NONE)
+        {
+            break;
+        }
+        for (size_t k = 0; k < TXLATENCY_NUM_PHASES; k++)
+        {
+            const int base = snprintf(labels,
+                                      sizeof(labels),
+                                      "kind=\"%s\",port=\"%u\",phase=\"%s\"",
+                                      canidGetPortKeyKindName(port->key),
+                                      (unsigned) (port->key & CANID_PORT_KEY_PORT_MASK),
+                                      PhaseNames[k]);
+            writeHistogram(&port->phases[k], "tx_latency", labels, sizeof(labels), base, sink);
+        }
+    }
+    for (size_t i = 0; i <= CANARD_PRIORITY_MAX; i++)
+    {
+        const int base = snprintf(labels, sizeof(labels), "priority=\"%u\"", (unsigned) i);
+        writeHistogram(&tracker->priorities[i], "tx_latency_priority", labels, sizeof(labels), base, sink);
+    }
+}
@@ -0,0 +1,147 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// TX latency tracker. Follows every transmitted frame from the moment its transfer was pushed into the libcanard
+/// TX queue until the controller reports it sent, and accumulates per-port latency distributions split into phases:
+///
+///     userspace   From the push of the transfer until the frame is written into the socket.
+///     kernel      From the write until the driver takes the frame (the SOF_TIMESTAMPING_TX_SOFTWARE report);
+///                 if the driver does not report it, until the frame enters the packet scheduler instead.
+///     transmit    From the driver hand-off until the frame is looped back by the socket, which the CAN drivers do
+///                 once the controller confirms the transmission, so this includes the time spent in the controller
+///                 waiting for arbitration.
+///     total       From the push of the transfer until the loopback.
+///
+/// The total latency is also accumulated per priority level over all ports, which shows whether the frames of a
+/// higher priority actually overtake the others under load.
+///
+/// The moment of the push is recorded explicitly by every producer of transfers, because the deadlines of the
+/// transfers are not a fixed distance from it; a written frame is matched with its push by the port and the deadline,
+/// which all frames of a transfer share. A frame whose push is not recorded is counted as untracked, and only its
+/// kernel and transmit phases are accumulated.
+/// The frames are matched with the kernel reports by the sequence number assigned by the kernel (see
+/// socketcanEnableTxTimestamping()), and with the looped back frames by the CAN ID in the order of transmission.
+/// The kernel assigns the sequence number before the frame is handed to the driver, so a failed write may use one up.
+/// The scheduler report is taken while the frame is written, so it shall fall between the writes of the frame and the
+/// one before it; if it does not, the sequence numbers have drifted apart, and the frame written first after the
+/// report is taken for the one it belongs to from then on.
+/// A frame whose loopback never arrives is eventually overwritten by a newer frame and counted as lost.
+/// The distributions are kept as base-2 logarithmic histograms; the quantiles are reported as bin upper bounds.
+
+#ifndef TXLATENCY_H_INCLUDED
+#define TXLATENCY_H_INCLUDED
+
+#include "canard.h"
+#include "metrics.h"
+#include "socketcan.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// The maximum number of frames between the write and the loopback. Shall be a power of two.
+#define TXLATENCY_MAX_IN_FLIGHT 64U
+/// The maximum number of transfers pushed before the last frame of the oldest one is written. Shall be a power of two.
+#define TXLATENCY_MAX_QUEUED 64U
+#define TXLATENCY_MAX_PORTS 16U
+/// Bin 0 holds zero; bin k holds [2**(k-1), 2**k) microseconds; the last bin also holds everything above.
+#define TXLATENCY_HISTOGRAM_BINS 24U
+
+typedef enum
+{
+    TxLatencyPhaseUserspace = 0,
+    TxLatencyPhaseKernel,
+    TxLatencyPhaseTransmit,
+    TxLatencyPhaseTotal,
+} TxLatencyPhase;
+#define TXLATENCY_NUM_PHASES 4U
+
+typedef struct TxLatencyHistogram
+{
+    uint32_t bins[TXLATENCY_HISTOGRAM_BINS];
+    uint64_t count;
+    uint64_t sum_usec;
+    uint64_t max_usec;
+} TxLatencyHistogram;
+
+typedef struct TxLatencyPush
+{
+    uint16_t          key;            ///< See canidGetPortKey().
+    CanardMicrosecond deadline_usec;  ///< Zero if the entry is vacant.
+    CanardMicrosecond enqueued_usec;
+} TxLatencyPush;
+
+typedef struct TxLatencyRecord
+{
+    bool              pending;
+    uint32_t          id;
+    uint32_t          can_id;
+    CanardMicrosecond enqueued_usec;   ///< Zero if the push was not recorded.
+    CanardMicrosecond written_usec;
+    CanardMicrosecond scheduled_usec;  ///< Zero until reported.
+    CanardMicrosecond sent_usec;       ///< Zero until reported.
+} TxLatencyRecord;
+
+typedef struct TxLatencyPort
+{
+    uint16_t           key;  ///< See canidGetPortKey(); TXLATENCY_PORT_KEY_NONE if the entry is vacant.
+    TxLatencyHistogram phases[TXLATENCY_NUM_PHASES];
+} TxLatencyPort;
+#define TXLATENCY_PORT_KEY_NONE 0xFFFFU
+
+typedef struct TxLatencyTracker
+{
+    TxLatencyPush      queued[TXLATENCY_MAX_QUEUED];
+    uint32_t           next_push;
+    uint64_t           untracked;  ///< The frames written without a recorded push.
+    TxLatencyRecord    in_flight[TXLATENCY_MAX_IN_FLIGHT];
+    uint32_t           next_id;    ///< The sequence number the kernel will assign to the next written frame.
+    uint32_t           oldest_id;  ///< All records older than this are completed or lost.
+    uint32_t           id_skew;    ///< Added to the sequence numbers reported by the kernel to obtain ours.
+    uint64_t           resynced;   ///< The times the sequence numbers were found to have drifted.
+    uint64_t           lost;
+    TxLatencyPort      ports[TXLATENCY_MAX_PORTS];
+    TxLatencyHistogram priorities[CANARD_PRIORITY_MAX + 1U];  ///< The total latency by priority level.
+} TxLatencyTracker;
+
+/// Shall be invoked at the same time socketcanEnableTxTimestamping() is, so that the sequence numbers match.
+void txlatencyInit(TxLatencyTracker* const tracker);
+
+/// Shall be invoked after every transfer successfully pushed into the TX queue, with the deadline of the transfer.
+void txlatencyOnPush(TxLatencyTracker* const  tracker,
+                     const CanardTransferKind kind,
+                     const CanardPortID       port_id,
+                     const CanardMicrosecond  deadline_usec,
+                     const CanardMicrosecond  enqueued_usec);
+
+/// Shall be invoked after every frame successfully written into the socket, in the order of writing.
+/// The time complexity is linear in TXLATENCY_MAX_QUEUED in the worst case.
+void txlatencyOnWrite(TxLatencyTracker* const  tracker,
+                      const CanardFrame* const frame,
+                      const CanardMicrosecond  written_usec);
+
+/// Shall be invoked after every write into the socket that failed, i.e., when socketcanPush() returned an error;
+/// not when it timed out without writing.
+void txlatencyOnWriteFailed(TxLatencyTracker* const  tracker,
+                            const CanardFrame* const frame,
+                            const CanardMicrosecond  failed_usec);
+
+/// Shall be invoked for every report obtained from socketcanPopTxTimestamp().
+/// The time complexity is linear in TXLATENCY_MAX_IN_FLIGHT if the sequence numbers have to be resynchronized.
+void txlatencyOnTimestamp(TxLatencyTracker* const tracker, const SocketCANTxTimestamp* const timestamp);
+
+/// Shall be invoked for every frame received from socketcanPop() with the loopback flag set.
+/// The time complexity is linear of the number of frames in flight in the worst case.
+void txlatencyOnLoopback(TxLatencyTracker* const tracker, const CanardFrame* const frame);
+
+/// Export the latency distributions via the metrics surface.
+void txlatencyWriteMetrics(const TxLatencyTracker* const tracker, MetricsSink* const sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,190 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+/// Based on code by:
+///     joan2937 <joan@abyz.me.uk>
+
+#include "ultrasound.h"
+#include "trace.h"
+#include "ultrasound_layout.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+static_assert((ULTRASOUND_QUEUE_CAPACITY & (ULTRASOUND_QUEUE_CAPACITY - 1U)) == 0U, "Shall be a power of two");
+
+int ultrasoundInit(UltrasoundPipeline* const pipeline,
+                   PeriodicEngine* const     periodic,
+                   SensorBackend* const      sensor,
+                   const UltrasoundClock     clock,
+                   FlightRecorder* const     recorder,
+                   const CanardPortID        subject_id,
+                   const CanardMicrosecond   tx_deadline_usec)
+{
+    pipeline->periodic   = periodic;
+    pipeline->sensor     = sensor;
+    pipeline->clock      = clock;
+    pipeline->subject_id = subject_id;
+    pipeline->recorder   = recorder;
+    flightrecSampleWriterInit(&pipeline->samples, recorder, 0U);
+    pipeline->print_distance = false;
+    pipeline->burst          = NULL;
+    pipeline->history        = NULL;
+    ultrasoundSetUrgency(pipeline, NULL, 0U);
+    pipeline->start_tick       = 0U;
+    pipeline->num_samples      = 0U;
+    atomic_init(&pipeline->queue_head, 0U);
+    atomic_init(&pipeline->queue_tail, 0U);
+    atomic_init(&pipeline->dropped, 0U);
+    pipeline->last_distance_cm = 0.0F;
+    pipeline->last_at_usec     = 0U;
+    (void) memset(pipeline->published_by_priority, 0, sizeof(pipeline->published_by_priority));
+    pipeline->slot = periodicAdd(periodic,
+                                 subject_id,
+                                 CanardPriorityNominal,
+                                 ULTRASOUND_DISTANCE_SIZE_BYTES,
+                                 0U,  // Published on demand, whenever a measurement completes.
+                                 tx_deadline_usec,
+                                 NULL,
+                                 NULL,
+                                 clock());
+    return (pipeline->slot < 0) ? pipeline->slot : 0;
+}
+
+void ultrasoundSetUrgency(UltrasoundPipeline* const           pipeline,
+                          const UltrasoundUrgencyLevel* const levels,
+                          const size_t                        num_levels)
+{
+    pipeline->urgency            = levels;
+    pipeline->num_urgency_levels = (levels != NULL) ? num_levels : 0U;
+}
+
+/// The first urgency level matching the reading determines the priority; the nominal one otherwise.
+static CanardPriority ultrasoundGetPriority(const UltrasoundPipeline* const pipeline,
+                                            const CanardMicrosecond         now_usec,
+                                            const float                     distance)
+{
+    float closing_speed = 0.0F;
+    if ((pipeline->last_at_usec != 0U) && (now_usec > pipeline->last_at_usec) &&
+        ((now_usec - pipeline->last_at_usec) <= ULTRASOUND_CLOSING_SPEED_MAX_INTERVAL_USEC))
+    {
+        closing_speed = (pipeline->last_distance_cm - distance) * 1e6F / (float) (now_usec - pipeline->last_at_usec);
+    }
+    for (size_t i = 0; i < pipeline->num_urgency_levels; i++)
+    {
+        const UltrasoundUrgencyLevel* const level = &pipeline->urgency[i];
+        if ((distance < level->max_distance_cm) &&
+            ((level->min_closing_speed_cm_per_s <= 0.0F) || (closing_speed >= level->min_closing_speed_cm_per_s)))
+        {
+            return level->priority;
+        }
+    }
+    return CanardPriorityNominal;
+}
+
+/// See ultrasound_layout.h for the layout of the message. Only the distance and the priority are patched into the
+/// prebuilt frame; the periodic messages are published with the Classic CAN MTU, see periodic.h. The main loop only.
+static void ultrasoundPublishDistance(UltrasoundPipeline* const pipeline,
+                                      const CanardMicrosecond   now_usec,
+                                      const float               distance)
+{
+    const CanardPriority priority = ultrasoundGetPriority(pipeline, now_usec, distance);
+    pipeline->last_distance_cm    = distance;
+    pipeline->last_at_usec        = now_usec;
+    periodicSetPriority(pipeline->periodic, pipeline->slot, priority);
+    canardDSDLSetF32(periodicGetPayload(pipeline->periodic, pipeline->slot),
+                     ULTRASOUND_DISTANCE_OFFSET_CENTIMETERS,
+                     distance);
+    const CanardTransferID transfer_id = pipeline->periodic->slots[pipeline->slot].transfer_id;  // Of this one.
+    const FlightRecPublish event       = {
+        .port_id     = pipeline->subject_id,
+        .transfer_id = transfer_id,
+        .priority    = (uint8_t) priority,
+        .result      = periodicPublish(pipeline->periodic, pipeline->slot, now_usec),
+        .value       = distance,
+    };
+    pipeline->published_by_priority[priority] += (event.result > 0) ? 1U : 0U;
+    flightrecWrite(pipeline->recorder, FlightRecRecordPublish, now_usec, &event, sizeof(event));
+}
+
+/// The thread of the sensor backend only. The reading is dropped if the main loop falls behind by the whole queue.
+static void ultrasoundEnqueue(UltrasoundPipeline* const pipeline,
+                              const CanardMicrosecond   now_usec,
+                              const float               distance)
+{
+    const uint32_t head = atomic_load_explicit(&pipeline->queue_head, memory_order_relaxed);
+    if ((head - atomic_load_explicit(&pipeline->queue_tail, memory_order_acquire)) >= ULTRASOUND_QUEUE_CAPACITY)
+    {
+        atomic_fetch_add_explicit(&pipeline->dropped, 1U, memory_order_relaxed);
+        return;
+    }
+    UltrasoundReading* const reading = &pipeline->queue[head % ULTRASOUND_QUEUE_CAPACITY];
+    reading->at_usec                 = now_usec;
+    reading->distance_cm             = distance;
+    atomic_store_explicit(&pipeline->queue_head, head + 1U, memory_order_release);
+}
+
+void ultrasoundOnEcho(void* const context, const int level, const uint32_t tick)
+{
+    UltrasoundPipeline* const pipeline = (UltrasoundPipeline*) context;
+    if (level == SENSOR_LEVEL_HIGH)
+    {
+        pipeline->start_tick = tick;
+    }
+    else if (level == SENSOR_LEVEL_LOW)
+    {
+        const int    diffTick   = (int) (tick - pipeline->start_tick);
+        const double distanceCm = (diffTick / 2) * 0.0343;
+        TRACE(echo, pipeline->start_tick, tick, diffTick, (int32_t)(distanceCm * 10.0));  // The distance in mm.
+
+        // The edge is timestamped in the time base of the transfers by subtracting its age.
+        const CanardMicrosecond now_usec  = pipeline->clock();
+        const uint32_t          age_usec  = pipeline->sensor->tick(pipeline->sensor) - tick;
+        const CanardMicrosecond edge_usec = now_usec - age_usec;
+        flightrecSample(&pipeline->samples, edge_usec, diffTick);
+        pipeline->num_samples++;
+
+        // During a burst, only some of the samples are published, at about the normal rate.
+        if ((pipeline->burst == NULL) ||
+            burstAccept(pipeline->burst, edge_usec, (diffTick > 0) ? (uint32_t) diffTick : 0U))
+        {
+            ultrasoundEnqueue(pipeline, now_usec, (float) distanceCm);
+            if (pipeline->history != NULL)
+            {
+                historyAppend(pipeline->history, edge_usec, (float) distanceCm);
+            }
+            if (pipeline->print_distance)
+            {
+                (void) printf("%f \n", distanceCm);
+            }
+        }
+    }
+}
+
+size_t ultrasoundPoll(UltrasoundPipeline* const pipeline)
+{
+    const uint32_t head  = atomic_load_explicit(&pipeline->queue_head, memory_order_acquire);
+    uint32_t       tail  = atomic_load_explicit(&pipeline->queue_tail, memory_order_relaxed);
+    const size_t   count = (size_t)(head - tail);
+    for (; tail != head; tail++)
+    {
+        const UltrasoundReading reading = pipeline->queue[tail % ULTRASOUND_QUEUE_CAPACITY];
+        ultrasoundPublishDistance(pipeline, reading.at_usec, reading.distance_cm);
+    }
+    atomic_store_explicit(&pipeline->queue_tail, tail, memory_order_release);  // The slots may be reused now.
+    return count;
+}
+
+void ultrasoundWriteMetrics(const UltrasoundPipeline* const pipeline, MetricsSink* const sink)
+{
+    metricsGauge(sink,
+                 "distance_dropped_total",
+                 NULL,
+                 (double) atomic_load_explicit(&pipeline->dropped, memory_order_relaxed));
+    char labels[32];
+    for (size_t i = 0; i <= CANARD_PRIORITY_MAX; i++)
+    {
+        (void) snprintf(labels, sizeof(labels), "priority=\"%u\"", (unsigned) i);
+        metricsGauge(sink, "distance_published_total", labels, (double) pipeline->published_by_priority[i]);
+    }
+}
@@ -0,0 +1,128 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The measurement pipeline of the node: echo edges in, distance messages out. The edges come from a SensorBackend;
+/// the echo pulse width is converted into the distance, recorded into the flight recorder, and published on the
+/// distance subject through an on-demand slot of the periodic publication engine, which patches the distance into
+/// the prebuilt frame. The time base of the transfers is provided by the caller, so that a replayed trace produces
+/// the same transfers every time.
+///
+/// The distance is published with the nominal priority unless an urgency level applies. The levels escalate the
+/// priority of close-range readings, optionally only if the target is closing in fast, so that they win the
+/// arbitration on a loaded bus while the routine readings stay behind the traffic of higher priority.
+///
+/// Optionally, every sample is also passed to a burst capture, which decimates the publications of the distance
+/// while the burst runs.
+///
+/// The edges are handled in the thread of the sensor backend, but libcanard is not thread-safe, so the readings to be
+/// published are passed to the main loop through a single-producer single-consumer queue, and the main loop publishes
+/// them with ultrasoundPoll(). The main loop does not block, so a reading waits for one iteration at most.
+
+#ifndef ULTRASOUND_H_INCLUDED
+#define ULTRASOUND_H_INCLUDED
+
+#include "burst.h"
+#include "flightrec.h"
+#include "history.h"
+#include "metrics.h"
+#include "periodic.h"
+#include "sensor.h"
+#include <canard.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Returns the current time in the time base of the transfers (TAI microseconds in the node).
+typedef CanardMicrosecond (*UltrasoundClock)(void);
+
+/// The closing speed is only estimated from two readings at most this far apart; otherwise it is taken as zero.
+#define ULTRASOUND_CLOSING_SPEED_MAX_INTERVAL_USEC 500000U
+
+/// The capacity of the queue of the readings to be published. Shall be a power of two.
+#define ULTRASOUND_QUEUE_CAPACITY 16U
+
+/// A reading matches the level if it is closer than the distance and the target is closing in at least at the
+/// speed (the decrease of the distance between two consecutive readings). A nonpositive speed matches any reading
+/// closer than the distance, including a receding target.
+typedef struct UltrasoundUrgencyLevel
+{
+    float          max_distance_cm;
+    float          min_closing_speed_cm_per_s;
+    CanardPriority priority;
+} UltrasoundUrgencyLevel;
+
+typedef struct UltrasoundReading
+{
+    CanardMicrosecond at_usec;  ///< When the echo was handled, in the time base of the transfers.
+    float             distance_cm;
+} UltrasoundReading;
+
+typedef struct UltrasoundPipeline
+{
+    PeriodicEngine*       periodic;
+    int                   slot;  ///< The on-demand slot of the distance subject in the engine.
+    SensorBackend*        sensor;
+    UltrasoundClock       clock;
+    CanardPortID          subject_id;
+    FlightRecorder*       recorder;
+    FlightRecSampleWriter samples;
+    bool                  print_distance;  ///< Print every distance to stdout, for debugging.
+    BurstCapture*         burst;           ///< Receives every sample if not NULL, see burst.h.
+    HistoryRing*          history;         ///< Receives every published sample if not NULL, see history.h.
+
+    const UltrasoundUrgencyLevel* urgency;
+    size_t                        num_urgency_levels;
+
+    // The thread of the sensor backend only.
+    uint32_t start_tick;
+    uint64_t num_samples;
+
+    // The queue of the readings to be published: written by the thread of the sensor backend, read by the main loop.
+    UltrasoundReading queue[ULTRASOUND_QUEUE_CAPACITY];
+    _Atomic uint32_t  queue_head;  ///< The number of readings queued so far; written by the producer only.
+    _Atomic uint32_t  queue_tail;  ///< The number of readings taken so far; written by the consumer only.
+    _Atomic uint64_t  dropped;     ///< The readings lost because the queue was full.
+
+    // The main loop only.
+    float             last_distance_cm;
+    CanardMicrosecond last_at_usec;  ///< Of the last reading; zero before the first one.
+    uint64_t          published_by_priority[CANARD_PRIORITY_MAX + 1U];
+} UltrasoundPipeline;
+
+/// Adds the slot of the distance subject to the engine; returns zero on success, or the error of periodicAdd().
+/// The TX deadline is relative to the moment the transfer is pushed.
+int ultrasoundInit(UltrasoundPipeline* const pipeline,
+                   PeriodicEngine* const     periodic,
+                   SensorBackend* const      sensor,
+                   const UltrasoundClock     clock,
+                   FlightRecorder* const     recorder,
+                   const CanardPortID        subject_id,
+                   const CanardMicrosecond   tx_deadline_usec);
+
+/// The levels are checked in the given order and the first matching one determines the priority, so the most urgent
+/// level goes first. The array is not copied and shall outlive the pipeline; zero levels disable the escalation,
+/// which is the initial state.
+void ultrasoundSetUrgency(UltrasoundPipeline* const           pipeline,
+                          const UltrasoundUrgencyLevel* const levels,
+                          const size_t                        num_levels);
+
+/// The SensorEchoHandler of the pipeline; the context is the pipeline. Does not touch the libcanard instance.
+void ultrasoundOnEcho(void* const context, const int level, const uint32_t tick);
+
+/// Shall be invoked from the main loop, the only user of the libcanard instance: publishes the queued readings.
+/// Returns the number of readings published.
+size_t ultrasoundPoll(UltrasoundPipeline* const pipeline);
+
+/// Export the number of distance messages published at each priority, and the number of the readings dropped, via the
+/// metrics surface.
+void ultrasoundWriteMetrics(const UltrasoundPipeline* const pipeline, MetricsSink* const sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
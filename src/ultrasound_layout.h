@@ -0,0 +1,41 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The layout of the distance message published by the node, shared by the publisher (ultrasound.c) and the consumers
+/// of the subject (distance-recorder and the aggregators on the master side). The message is a single float32 with
+/// the distance in centimeters; the timestamp of a sample is that of the transfer.
+///
+/// The consumers read the fields directly from the received payload through the view accessors, without decoding the
+/// message into a struct first:
+///
+///     const CanardDSDLView view = {(const uint8_t*) transfer.payload, transfer.payload_size};
+///     const float distance = ultrasoundDistanceGetCentimeters(view);
+
+#ifndef ULTRASOUND_LAYOUT_H_INCLUDED
+#define ULTRASOUND_LAYOUT_H_INCLUDED
+
+#include <canard_dsdl.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ULTRASOUND_DISTANCE_SUBJECT_ID 1610U
+
+/// The offsets of the fields are in bits.
+#define ULTRASOUND_DISTANCE_OFFSET_CENTIMETERS 0U
+
+/// The serialized size of the message, which is also the extent of the subscriptions.
+#define ULTRASOUND_DISTANCE_SIZE_BYTES 4U
+
+CANARD_DSDL_VIEW_FLOAT(ultrasoundDistanceGetCentimeters,
+                       CanardDSDLFloat32,
+                       canardDSDLGetF32,
+                       ULTRASOUND_DISTANCE_OFFSET_CENTIMETERS)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,38 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The minimal test harness shared by the test programs: every failed check is reported with its location and the
+/// program keeps going, so that one run shows all failures; the exit code is nonzero if any check failed.
+/// Each test program is one translation unit that includes this header once.
+
+#ifndef CHECK_H_INCLUDED
+#define CHECK_H_INCLUDED
+
+#include <stdio.h>
+
+static unsigned CheckFailures = 0U;
+
+#define CHECK(condition)                                                                         \
+    do                                                                                           \
+    {                                                                                            \
+        if (!(condition))                                                                        \
+        {                                                                                        \
+            (void) fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            CheckFailures++;                                                                     \
+        }                                                                                        \
+    } while (0)
+
+/// Returns the exit code of the test program.
+static inline int checkReport(const char* const name)
+{
+    if (CheckFailures > 0U)
+    {
+        (void) fprintf(stderr, "%s: %u checks failed\n", name, CheckFailures);
+        return 1;
+    }
+    (void) printf("%s: all checks passed\n", name);
+    return 0;
+}
+
+#endif
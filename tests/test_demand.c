@@ -0,0 +1,260 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The demand-driven sampling (src/demand.c) on a mock sensor backend: the subscribers learned from the mask, the
+/// sparse list, and the total form of uavcan.node.port.List, the expiry of the silent subscribers, the startup, the
+/// malformed and anonymous lists, and the change of the period deferred while a burst capture runs.
+
+#include "check.h"
+#include "demand.h"
+#include <canard_dsdl.h>
+#include <string.h>
+
+#define SUBJECT_ID 1234U
+#define OTHER_SUBJECT_ID 1235U
+#define ACTIVE_PERIOD_USEC 300000U
+#define IDLE_PERIOD_USEC 1000000U
+#define ROUNDED_IDLE_PERIOD_USEC 1200000U  ///< A whole number of active periods.
+#define TIMEOUT_USEC 30000000U
+
+#define LIST_MASK 0U
+#define LIST_SPARSE 1U
+#define LIST_TOTAL 2U
+
+typedef struct
+{
+    SensorBackend base;
+    uint32_t      period_usec;
+    size_t        calls;
+} MockSensor;
+
+static int16_t mockSetTriggerPeriod(SensorBackend* const self, const uint32_t period_usec)
+{
+    MockSensor* const mock = (MockSensor*) self;
+    mock->period_usec      = period_usec;
+    mock->calls++;
+    return 0;
+}
+
+static void mockInit(MockSensor* const mock)
+{
+    (void) memset(mock, 0, sizeof(*mock));
+    mock->base.name             = "mock";
+    mock->base.setTriggerPeriod = &mockSetTriggerPeriod;
+    mock->period_usec           = ACTIVE_PERIOD_USEC;
+}
+
+static BurstCapture Burst;
+
+typedef struct
+{
+    uint8_t data[DEMAND_PORT_LIST_EXTENT];
+    size_t  size;
+} PortList;
+
+/// Serializes a SubjectIDList.0.1 of the given form at the byte-aligned offset; returns the offset after it.
+static size_t writeSubjects(uint8_t* const            buf,
+                            const size_t              off,
+                            const uint8_t             form,
+                            const CanardPortID* const subjects,
+                            const size_t              count)
+{
+    const size_t body = canardDSDLBeginDelimited(off);
+    canardDSDLSetUxx(buf, body, form, 8U);
+    size_t end = body + 8U;
+    if (form == LIST_MASK)
+    {
+        for (size_t i = 0U; i < count; i++)
+        {
+            canardDSDLSetBit(buf, body + 8U + subjects[i], true);
+        }
+        end += 8192U;
+    }
+    else if (form == LIST_SPARSE)
+    {
+        canardDSDLSetUxx(buf, end, count, 8U);
+        end += 8U;
+        for (size_t i = 0U; i < count; i++)
+        {
+            canardDSDLSetUxx(buf, end, subjects[i], 16U);
+            end += 16U;
+        }
+    }
+    return canardDSDLEndDelimited(buf, off, end);
+}
+
+/// A list with no publishers and the given subscribers; the service lists are beyond the extent.
+static void makeList(PortList* const list, const uint8_t form, const CanardPortID* const subjects, const size_t count)
+{
+    (void) memset(list, 0, sizeof(*list));
+    const size_t off = writeSubjects(list->data, 0U, LIST_SPARSE, NULL, 0U);
+    list->size       = writeSubjects(list->data, off, form, subjects, count) / 8U;
+    CHECK(list->size <= sizeof(list->data));
+}
+
+static void deliver(DemandTracker* const    tracker,
+                    const PortList* const   list,
+                    const CanardNodeID      node_id,
+                    const CanardMicrosecond now_usec)
+{
+    const CanardTransfer transfer = {
+        .timestamp_usec = now_usec,
+        .priority       = CanardPriorityNominal,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = DEMAND_PORT_LIST_SUBJECT_ID,
+        .remote_node_id = node_id,
+        .transfer_id    = 0U,
+        .payload_size   = list->size,
+        .payload        = &list->data[0],
+    };
+    demandOnPortList(tracker, &transfer);
+}
+
+/// The full rate during the startup, then the rounded keep-alive period without subscribers.
+static void testStartup(void)
+{
+    MockSensor mock;
+    mockInit(&mock);
+    DemandTracker tracker;
+    demandInit(&tracker, &mock.base, NULL, SUBJECT_ID, ACTIVE_PERIOD_USEC, IDLE_PERIOD_USEC, TIMEOUT_USEC, 1000U);
+    demandPoll(&tracker, 1000U + TIMEOUT_USEC - 1U);
+    CHECK(mock.calls == 0U);
+    CHECK(tracker.period_usec == ACTIVE_PERIOD_USEC);
+    demandPoll(&tracker, 1000U + TIMEOUT_USEC);
+    CHECK(mock.calls == 1U);
+    CHECK(mock.period_usec == ROUNDED_IDLE_PERIOD_USEC);
+    CHECK(tracker.transitions == 1U);
+
+    // A zero idle period disables the demand-driven sampling.
+    mockInit(&mock);
+    demandInit(&tracker, &mock.base, NULL, SUBJECT_ID, ACTIVE_PERIOD_USEC, 0U, TIMEOUT_USEC, 0U);
+    demandPoll(&tracker, 10U * TIMEOUT_USEC);
+    CHECK(mock.calls == 0U);
+    CHECK(tracker.period_usec == ACTIVE_PERIOD_USEC);
+}
+
+static void testForms(void)
+{
+    const uint8_t forms[] = {LIST_MASK, LIST_SPARSE, LIST_TOTAL};
+    for (size_t f = 0U; f < sizeof(forms); f++)
+    {
+        MockSensor mock;
+        mockInit(&mock);
+        DemandTracker tracker;
+        demandInit(&tracker, &mock.base, NULL, SUBJECT_ID, ACTIVE_PERIOD_USEC, IDLE_PERIOD_USEC, TIMEOUT_USEC, 0U);
+        CanardMicrosecond now = TIMEOUT_USEC;
+        demandPoll(&tracker, now);
+        CHECK(mock.period_usec == ROUNDED_IDLE_PERIOD_USEC);
+
+        const CanardPortID with[]    = {1U, OTHER_SUBJECT_ID, SUBJECT_ID, 8191U};
+        const CanardPortID without[] = {1U, OTHER_SUBJECT_ID, 8191U};
+        PortList           list;
+        makeList(&list, forms[f], with, 4U);
+        deliver(&tracker, &list, 42U, ++now);
+        CHECK(tracker.num_subscribers == 1U);
+        CHECK(mock.period_usec == ACTIVE_PERIOD_USEC);  // At once, not at the next poll.
+        deliver(&tracker, &list, 42U, ++now);           // The same node again is not another subscriber.
+        CHECK(tracker.num_subscribers == 1U);
+        if (forms[f] != LIST_TOTAL)
+        {
+            makeList(&list, forms[f], without, 3U);
+            deliver(&tracker, &list, 42U, ++now);
+            CHECK(tracker.num_subscribers == 0U);
+            CHECK(mock.period_usec == ROUNDED_IDLE_PERIOD_USEC);
+        }
+        CHECK(tracker.malformed == 0U);
+    }
+}
+
+/// A subscriber that goes silent is forgotten after the timeout; the rate drops once the last one is gone.
+static void testExpiry(void)
+{
+    MockSensor mock;
+    mockInit(&mock);
+    DemandTracker tracker;
+    demandInit(&tracker, &mock.base, NULL, SUBJECT_ID, ACTIVE_PERIOD_USEC, IDLE_PERIOD_USEC, TIMEOUT_USEC, 0U);
+    const CanardPortID subjects[] = {SUBJECT_ID};
+    PortList           list;
+    makeList(&list, LIST_SPARSE, subjects, 1U);
+    const CanardMicrosecond first = 2U * TIMEOUT_USEC;
+    deliver(&tracker, &list, 10U, first);
+    deliver(&tracker, &list, 11U, first + 1000000U);
+    CHECK(tracker.num_subscribers == 2U);
+
+    demandPoll(&tracker, first + TIMEOUT_USEC);
+    CHECK(tracker.num_subscribers == 2U);
+    demandPoll(&tracker, first + TIMEOUT_USEC + 1U);
+    CHECK(tracker.num_subscribers == 1U);
+    CHECK(mock.period_usec == ACTIVE_PERIOD_USEC);
+    demandPoll(&tracker, first + 1000000U + TIMEOUT_USEC + 1U);
+    CHECK(tracker.num_subscribers == 0U);
+    CHECK(mock.period_usec == ROUNDED_IDLE_PERIOD_USEC);
+    CHECK(tracker.seen_at_usec[10] == 0U);
+    CHECK(tracker.seen_at_usec[11] == 0U);
+}
+
+/// The lists that cannot be parsed and the anonymous ones change nothing.
+static void testIgnored(void)
+{
+    MockSensor mock;
+    mockInit(&mock);
+    DemandTracker tracker;
+    demandInit(&tracker, &mock.base, NULL, SUBJECT_ID, ACTIVE_PERIOD_USEC, IDLE_PERIOD_USEC, TIMEOUT_USEC, 0U);
+    const CanardPortID subjects[] = {SUBJECT_ID};
+    PortList           list;
+    makeList(&list, LIST_TOTAL, subjects, 0U);
+    deliver(&tracker, &list, CANARD_NODE_ID_UNSET, 2U * TIMEOUT_USEC);
+    CHECK(tracker.num_subscribers == 0U);
+    CHECK(tracker.malformed == 0U);
+
+    makeList(&list, LIST_SPARSE, subjects, 1U);
+    list.size--;  // The subscribers extend beyond the end of the transfer.
+    deliver(&tracker, &list, 10U, 2U * TIMEOUT_USEC);
+    CHECK(tracker.num_subscribers == 0U);
+    CHECK(tracker.malformed == 1U);
+}
+
+/// A burst capture owns the trigger period while it runs: the change of the demand is applied when it is over, and
+/// the burst capture reverts to the period of the demand.
+static void testDeferredByBurst(void)
+{
+    MockSensor mock;
+    mockInit(&mock);
+    burstInit(&Burst, &mock.base, NULL, 0U, CANARD_MTU_CAN_CLASSIC, ACTIVE_PERIOD_USEC, 0U);
+    DemandTracker tracker;
+    demandInit(&tracker, &mock.base, &Burst, SUBJECT_ID, ACTIVE_PERIOD_USEC, IDLE_PERIOD_USEC, TIMEOUT_USEC, 0U);
+    demandPoll(&tracker, TIMEOUT_USEC);
+    CHECK(mock.period_usec == ROUNDED_IDLE_PERIOD_USEC);
+    CHECK(Burst.normal_period_usec == ROUNDED_IDLE_PERIOD_USEC);
+
+    atomic_store(&Burst.active, true);
+    mock.period_usec              = 1000U;  // The burst period.
+    const size_t       calls      = mock.calls;
+    const CanardPortID subjects[] = {SUBJECT_ID};
+    PortList           list;
+    makeList(&list, LIST_MASK, subjects, 1U);
+    deliver(&tracker, &list, 10U, TIMEOUT_USEC + 1U);
+    CHECK(tracker.num_subscribers == 1U);
+    demandPoll(&tracker, TIMEOUT_USEC + 2U);
+    CHECK(mock.calls == calls);
+    CHECK(mock.period_usec == 1000U);
+    CHECK(tracker.period_usec == ROUNDED_IDLE_PERIOD_USEC);
+
+    atomic_store(&Burst.active, false);
+    demandPoll(&tracker, TIMEOUT_USEC + 3U);
+    CHECK(mock.calls == (calls + 1U));
+    CHECK(mock.period_usec == ACTIVE_PERIOD_USEC);
+    CHECK(tracker.period_usec == ACTIVE_PERIOD_USEC);
+    CHECK(Burst.normal_period_usec == ACTIVE_PERIOD_USEC);
+}
+
+int main(void)
+{
+    testStartup();
+    testForms();
+    testExpiry();
+    testIgnored();
+    testDeferredByBurst();
+    return checkReport("test-demand");
+}
@@ -0,0 +1,149 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The delimited (extensible) composites of canard_dsdl.h: the round trip of a message with a nested delimited
+/// composite, the senders of an older and a newer version of the nested type, and the malformed delimiter headers.
+
+#include "check.h"
+#include <canard_dsdl.h>
+#include <string.h>
+
+/// The message used throughout: uint8 before; a delimited composite {float32, uint16}; uint8 after.
+#define BODY_SIZE_BYTES 6U
+#define MESSAGE_SIZE_BYTES (1U + 4U + BODY_SIZE_BYTES + 1U)
+
+static size_t serializeMessage(uint8_t* const buf, const size_t body_size_bytes)
+{
+    (void) memset(buf, 0, 64U);
+    canardDSDLSetUxx(buf, 0U, 0xA5U, 8U);
+    const size_t body_off = canardDSDLBeginDelimited(8U);
+    CHECK(body_off == 40U);
+    if (body_size_bytes >= 4U)
+    {
+        canardDSDLSetF32(buf, body_off, 1.5F);
+    }
+    if (body_size_bytes >= 6U)
+    {
+        canardDSDLSetUxx(buf, body_off + 32U, 0x1234U, 16U);
+    }
+    for (size_t i = 6U; i < body_size_bytes; i++)  // The fields added by a newer version of the type.
+    {
+        canardDSDLSetUxx(buf, body_off + (i * 8U), 0xEEU, 8U);
+    }
+    const size_t off = canardDSDLEndDelimited(buf, 8U, body_off + (body_size_bytes * 8U));
+    CHECK(off == (body_off + (body_size_bytes * 8U)));
+    canardDSDLSetUxx(buf, off, 0x5AU, 8U);
+    return (off / 8U) + 1U;
+}
+
+static void testRoundTrip(void)
+{
+    uint8_t      buf[64];
+    const size_t size = serializeMessage(buf, BODY_SIZE_BYTES);
+    CHECK(size == MESSAGE_SIZE_BYTES);
+    CHECK(canardDSDLGetU32(buf, size, 8U, 32U) == BODY_SIZE_BYTES);
+
+    CHECK(canardDSDLGetU8(buf, size, 0U, 8U) == 0xA5U);
+    CanardDSDLView body = {NULL, 0U};
+    const int64_t  off  = canardDSDLGetDelimited(buf, size, 8U, &body);
+    CHECK(off == (int64_t) ((MESSAGE_SIZE_BYTES - 1U) * 8U));
+    CHECK(body.data == &buf[5]);
+    CHECK(body.size == BODY_SIZE_BYTES);
+    CHECK(canardDSDLGetF32(body.data, body.size, 0U) == 1.5F);
+    CHECK(canardDSDLGetU16(body.data, body.size, 32U, 16U) == 0x1234U);
+    CHECK(canardDSDLGetU8(buf, size, (size_t) off, 8U) == 0x5AU);
+}
+
+/// A newer sender added fields to the nested type: they are skipped and the field after the composite is intact.
+static void testNewerSender(void)
+{
+    uint8_t      buf[64];
+    const size_t size = serializeMessage(buf, BODY_SIZE_BYTES + 5U);
+    CHECK(size == (MESSAGE_SIZE_BYTES + 5U));
+    CanardDSDLView body = {NULL, 0U};
+    const int64_t  off  = canardDSDLGetDelimited(buf, size, 8U, &body);
+    CHECK(off == (int64_t) ((size - 1U) * 8U));
+    CHECK(body.size == (BODY_SIZE_BYTES + 5U));
+    CHECK(canardDSDLGetF32(body.data, body.size, 0U) == 1.5F);
+    CHECK(canardDSDLGetU16(body.data, body.size, 32U, 16U) == 0x1234U);
+    CHECK(canardDSDLGetU8(buf, size, (size_t) off, 8U) == 0x5AU);
+}
+
+/// An older sender did not serialize the uint16: it is read as zero, from the view and from the fixed-size copy.
+static void testOlderSender(void)
+{
+    uint8_t      buf[64];
+    const size_t size = serializeMessage(buf, 4U);
+    CHECK(size == (MESSAGE_SIZE_BYTES - 2U));
+    CanardDSDLView body = {NULL, 0U};
+    const int64_t  off  = canardDSDLGetDelimited(buf, size, 8U, &body);
+    CHECK(off == (int64_t) ((size - 1U) * 8U));
+    CHECK(body.size == 4U);
+    CHECK(canardDSDLGetF32(body.data, body.size, 0U) == 1.5F);
+    CHECK(canardDSDLGetU16(body.data, body.size, 32U, 16U) == 0U);
+    CHECK(canardDSDLGetU8(buf, size, (size_t) off, 8U) == 0x5AU);
+
+    uint8_t scratch[BODY_SIZE_BYTES];
+    (void) memset(scratch, 0xFF, sizeof(scratch));
+    const uint8_t* const fixed = canardDSDLViewFix(&body, BODY_SIZE_BYTES, scratch);
+    CHECK(fixed == scratch);
+    CHECK(canardDSDLGetF32(fixed, BODY_SIZE_BYTES, 0U) == 1.5F);
+    CHECK(canardDSDLGetU16(fixed, BODY_SIZE_BYTES, 32U, 16U) == 0U);
+
+    // A large enough view is not copied.
+    const size_t full_size = serializeMessage(buf, BODY_SIZE_BYTES);
+    CHECK(canardDSDLGetDelimited(buf, full_size, 8U, &body) > 0);
+    CHECK(canardDSDLViewFix(&body, BODY_SIZE_BYTES, scratch) == body.data);
+}
+
+static void testMalformedHeader(void)
+{
+    uint8_t        buf[64];
+    const size_t   size = serializeMessage(buf, BODY_SIZE_BYTES);
+    CanardDSDLView body = {NULL, 0U};
+
+    // Truncated in the middle of the body, e.g., to the extent of the subscription.
+    CHECK(canardDSDLGetDelimited(buf, size - 3U, 8U, &body) == -CANARD_DSDL_ERROR_BAD_DELIMITER_HEADER);
+    // Truncated in the middle of the header: the bytes that are there still announce a body that is not.
+    CHECK(canardDSDLGetDelimited(buf, 3U, 8U, &body) == -CANARD_DSDL_ERROR_BAD_DELIMITER_HEADER);
+    // A header that claims more than the buffer holds.
+    canardDSDLSetUxx(buf, 8U, BODY_SIZE_BYTES + 2U, 32U);
+    CHECK(canardDSDLGetDelimited(buf, size, 8U, &body) == -CANARD_DSDL_ERROR_BAD_DELIMITER_HEADER);
+    canardDSDLSetUxx(buf, 8U, UINT32_MAX, 32U);
+    CHECK(canardDSDLGetDelimited(buf, size, 8U, &body) == -CANARD_DSDL_ERROR_BAD_DELIMITER_HEADER);
+    // The view is not modified on failure.
+    CHECK(body.data == NULL);
+    CHECK(body.size == 0U);
+
+    // The header entirely beyond the end of the buffer is zero per the IZER: an empty composite.
+    CHECK(canardDSDLGetDelimited(buf, 1U, 8U, &body) == 40);
+    CHECK(body.size == 0U);
+
+    CHECK(canardDSDLGetDelimited(buf, size, 9U, &body) == -CANARD_DSDL_ERROR_INVALID_ARGUMENT);
+    CHECK(canardDSDLGetDelimited(NULL, size, 8U, &body) == -CANARD_DSDL_ERROR_INVALID_ARGUMENT);
+    CHECK(canardDSDLGetDelimited(buf, size, 8U, NULL) == -CANARD_DSDL_ERROR_INVALID_ARGUMENT);
+}
+
+/// A body that does not end on a byte boundary is padded to a whole number of bytes.
+static void testPadding(void)
+{
+    uint8_t buf[16];
+    (void) memset(buf, 0, sizeof(buf));
+    const size_t body_off = canardDSDLBeginDelimited(0U);
+    canardDSDLSetUxx(buf, body_off, 0x1FFU, 9U);
+    CHECK(canardDSDLEndDelimited(buf, 0U, body_off + 9U) == (32U + 16U));
+    CHECK(canardDSDLGetU32(buf, sizeof(buf), 0U, 32U) == 2U);
+    CHECK(canardDSDLEndDelimited(buf, 0U, body_off) == 32U);
+    CHECK(canardDSDLGetU32(buf, sizeof(buf), 0U, 32U) == 0U);
+}
+
+int main(void)
+{
+    testRoundTrip();
+    testNewerSender();
+    testOlderSender();
+    testMalformedHeader();
+    testPadding();
+    return checkReport("test-dsdl-delimited");
+}
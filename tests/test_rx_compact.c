@@ -0,0 +1,232 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The compact RX sessions of libcanard (CANARD_CONFIG_COMPACT_RX_SESSION=1, which the build defines for this
+/// program only): the limits of the extent and of the transfer-ID timeout enforced by canardRxSubscribe(), the
+/// repeated transfer-ID accepted after an idle time of 2**31 to 2**32 microseconds, the documented blind spot just
+/// after 2**32 microseconds, the tolerance of the timestamps going backwards, and the full transfer timestamp of a
+/// multi-frame transfer whose frames straddle a multiple of 2**32 microseconds.
+
+#include "check.h"
+#include <canard.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(CANARD_CONFIG_COMPACT_RX_SESSION) || !CANARD_CONFIG_COMPACT_RX_SESSION
+#    error "This test shall be built with CANARD_CONFIG_COMPACT_RX_SESSION=1"
+#endif
+
+#define PORT_ID 1234U
+#define SENDER_NODE_ID 10U
+#define TRANSFER_ID_TIMEOUT_USEC 2000000U
+#define EXTENT 64U
+#define MAX_FRAMES 8U
+
+#define WRAP_USEC (UINT64_C(1) << 32U)
+#define HALF_WRAP_USEC (UINT64_C(1) << 31U)
+#define BACKWARD_TOLERANCE_USEC 1000000U  ///< RX_SESSION_BACKWARD_TOLERANCE_USEC of libcanard.
+
+typedef struct
+{
+    CanardFrame frame;
+    uint8_t     data[CANARD_MTU_CAN_CLASSIC];
+} TestFrame;
+
+static size_t Allocated = 0U;
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    Allocated++;
+    return malloc(amount);
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    if (pointer != NULL)
+    {
+        Allocated--;
+    }
+    free(pointer);
+}
+
+/// Serializes a message transfer into Classic CAN frames; returns the number of frames.
+static size_t makeFrames(const size_t payload_size, const CanardTransferID transfer_id, TestFrame* const out)
+{
+    CanardInstance sender = canardInit(&memAllocate, &memFree);
+    sender.node_id        = SENDER_NODE_ID;
+    sender.mtu_bytes      = CANARD_MTU_CAN_CLASSIC;
+    uint8_t payload[EXTENT];
+    for (size_t i = 0U; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8_t) (transfer_id + (i * 3U));
+    }
+    const CanardTransfer transfer = {
+        .timestamp_usec = 0U,
+        .priority       = CanardPriorityNominal,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = PORT_ID,
+        .remote_node_id = CANARD_NODE_ID_UNSET,
+        .transfer_id    = transfer_id,
+        .payload_size   = payload_size,
+        .payload        = &payload[0],
+    };
+    const int32_t result = canardTxPush(&sender, &transfer);
+    CHECK((result > 0) && ((size_t) result <= MAX_FRAMES));
+    size_t count = 0U;
+    for (const CanardFrame* txf = canardTxPeek(&sender); txf != NULL; txf = canardTxPeek(&sender))
+    {
+        canardTxPop(&sender);
+        if (count < MAX_FRAMES)
+        {
+            out[count].frame = *txf;
+            (void) memcpy(out[count].data, txf->payload, txf->payload_size);
+            out[count].frame.payload = out[count].data;
+            count++;
+        }
+        sender.memory_free(&sender, (void*) txf);
+    }
+    return count;
+}
+
+/// Accepts a single-frame transfer; returns truth if it was received, and its timestamp in the output.
+static bool receive(CanardInstance* const    ins,
+                    const CanardTransferID   transfer_id,
+                    const CanardMicrosecond  timestamp_usec,
+                    CanardMicrosecond* const out_timestamp_usec)
+{
+    TestFrame frames[MAX_FRAMES];
+    CHECK(makeFrames(3U, transfer_id, frames) == 1U);
+    frames[0].frame.timestamp_usec = timestamp_usec;
+    CanardTransfer transfer;
+    const int8_t   result = canardRxAccept(ins, &frames[0].frame, 0U, &transfer);
+    CHECK(result >= 0);
+    if (result > 0)
+    {
+        if (out_timestamp_usec != NULL)
+        {
+            *out_timestamp_usec = transfer.timestamp_usec;
+        }
+        ins->memory_free(ins, (void*) transfer.payload);
+    }
+    return result > 0;
+}
+
+static void subscribe(CanardInstance* const ins, CanardRxSubscription* const subscription)
+{
+    const CanardMicrosecond timeout = TRANSFER_ID_TIMEOUT_USEC;
+    CHECK(canardRxSubscribe(ins, CanardTransferKindMessage, PORT_ID, EXTENT, timeout, subscription) == 1);
+}
+
+static void testLimits(void)
+{
+    CanardInstance          ins = canardInit(&memAllocate, &memFree);
+    CanardRxSubscription    subscription;
+    const CanardMicrosecond timeout = TRANSFER_ID_TIMEOUT_USEC;
+    CHECK(canardRxSubscribe(&ins, CanardTransferKindMessage, PORT_ID, UINT16_MAX, timeout, &subscription) ==
+          -CANARD_ERROR_INVALID_ARGUMENT);
+    CHECK(canardRxSubscribe(&ins, CanardTransferKindMessage, PORT_ID, UINT16_MAX - 1U, timeout, &subscription) ==
+          -CANARD_ERROR_INVALID_ARGUMENT);
+    CHECK(canardRxSubscribe(&ins, CanardTransferKindMessage, PORT_ID, UINT16_MAX - 2U, timeout, &subscription) == 1);
+    CHECK(canardRxSubscribe(&ins, CanardTransferKindMessage, PORT_ID, EXTENT, HALF_WRAP_USEC, &subscription) ==
+          -CANARD_ERROR_INVALID_ARGUMENT);
+    // Replaces the subscription above.
+    CHECK(canardRxSubscribe(&ins, CanardTransferKindMessage, PORT_ID, EXTENT, HALF_WRAP_USEC - 1U, &subscription) == 0);
+    CHECK(canardRxUnsubscribe(&ins, CanardTransferKindMessage, PORT_ID) == 1);
+}
+
+/// The same transfer-ID again after an idle time in the upper half of the 32-bit range is a new transfer, although
+/// the 32-bit difference alone cannot tell it from a short one that went backwards.
+static void testRepeatedTransferIDAfterLongGap(void)
+{
+    const CanardMicrosecond gaps[] = {HALF_WRAP_USEC, UINT64_C(3000000000), WRAP_USEC - BACKWARD_TOLERANCE_USEC - 1U};
+    for (size_t i = 0U; i < (sizeof(gaps) / sizeof(gaps[0])); i++)
+    {
+        CanardInstance       ins = canardInit(&memAllocate, &memFree);
+        CanardRxSubscription subscription;
+        subscribe(&ins, &subscription);
+        const CanardMicrosecond start = 5000000U;
+        CHECK(receive(&ins, 7U, start, NULL));
+        CHECK(!receive(&ins, 7U, start + 1000U, NULL));  // A duplicate within the timeout.
+        CanardMicrosecond timestamp = 0U;
+        CHECK(receive(&ins, 7U, start + gaps[i], &timestamp));
+        CHECK(timestamp == (start + gaps[i]));
+        CHECK(canardRxUnsubscribe(&ins, CanardTransferKindMessage, PORT_ID) == 1);
+    }
+}
+
+/// An idle time just above a multiple of 2**32 microseconds looks like a short one: the repeated transfer-ID is
+/// dropped until the transfer-ID timeout elapses after the wrap, as documented.
+static void testBlindSpotAfterWrap(void)
+{
+    CanardInstance       ins = canardInit(&memAllocate, &memFree);
+    CanardRxSubscription subscription;
+    subscribe(&ins, &subscription);
+    const CanardMicrosecond start = 5000000U;
+    CHECK(receive(&ins, 7U, start, NULL));
+    CHECK(!receive(&ins, 7U, start + WRAP_USEC + 1000U, NULL));
+    CHECK(receive(&ins, 7U, start + WRAP_USEC + TRANSFER_ID_TIMEOUT_USEC + 1U, NULL));
+    CHECK(canardRxUnsubscribe(&ins, CanardTransferKindMessage, PORT_ID) == 1);
+}
+
+/// A timestamp up to one second earlier than that of the session is no time elapsed, so the duplicate is dropped;
+/// farther back, the 32-bit difference is in the upper half of the range, which is a timeout.
+static void testBackwardTolerance(void)
+{
+    const CanardMicrosecond backward[] = {1U, 100U, BACKWARD_TOLERANCE_USEC};
+    for (size_t i = 0U; i < (sizeof(backward) / sizeof(backward[0])); i++)
+    {
+        CanardInstance       ins = canardInit(&memAllocate, &memFree);
+        CanardRxSubscription subscription;
+        subscribe(&ins, &subscription);
+        const CanardMicrosecond start = 10000000U;
+        CHECK(receive(&ins, 9U, start, NULL));
+        CHECK(!receive(&ins, 9U, start - backward[i], NULL));
+        CHECK(receive(&ins, 10U, start - backward[i], NULL));  // The next transfer-ID is accepted as usual.
+        CHECK(canardRxUnsubscribe(&ins, CanardTransferKindMessage, PORT_ID) == 1);
+    }
+    CanardInstance       ins = canardInit(&memAllocate, &memFree);
+    CanardRxSubscription subscription;
+    subscribe(&ins, &subscription);
+    const CanardMicrosecond start = 10000000U;
+    CHECK(receive(&ins, 9U, start, NULL));
+    CHECK(receive(&ins, 9U, start - BACKWARD_TOLERANCE_USEC - 1U, NULL));
+    CHECK(canardRxUnsubscribe(&ins, CanardTransferKindMessage, PORT_ID) == 1);
+}
+
+/// Only the lower 32 bits of the timestamp of the first frame are stored; the transfer timestamp is restored from
+/// the timestamp of the last frame, also across a multiple of 2**32 microseconds.
+static void testTransferTimestampAcrossWrap(void)
+{
+    CanardInstance       ins = canardInit(&memAllocate, &memFree);
+    CanardRxSubscription subscription;
+    subscribe(&ins, &subscription);
+    TestFrame    frames[MAX_FRAMES];
+    const size_t count = makeFrames(20U, 11U, frames);
+    CHECK(count == 4U);
+    const CanardMicrosecond first = (3U * WRAP_USEC) - 20U;
+    CanardTransfer          transfer;
+    for (size_t i = 0U; i < count; i++)
+    {
+        frames[i].frame.timestamp_usec = first + (i * 10U);
+        const int8_t result            = canardRxAccept(&ins, &frames[i].frame, 0U, &transfer);
+        CHECK(result == (((i + 1U) == count) ? 1 : 0));
+    }
+    CHECK(transfer.timestamp_usec == first);
+    CHECK(transfer.payload_size == 20U);
+    ins.memory_free(&ins, (void*) transfer.payload);
+    CHECK(canardRxUnsubscribe(&ins, CanardTransferKindMessage, PORT_ID) == 1);
+}
+
+int main(void)
+{
+    testLimits();
+    testRepeatedTransferIDAfterLongGap();
+    testBlindSpotAfterWrap();
+    testBackwardTolerance();
+    testTransferTimestampAcrossWrap();
+    CHECK(Allocated == 0U);
+    return checkReport("test-rx-compact");
+}
@@ -0,0 +1,314 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The streaming subscriptions of libcanard (canardRxSubscribeStream): the chunks and the commit of a valid transfer,
+/// the holdback that keeps the CRC from being delivered as data, the abort on a CRC error and on a lost frame, and
+/// the truncation by the extent. The frames are produced by canardTxPush() on a Classic CAN sender instance.
+
+#include "check.h"
+#include <canard.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PORT_ID 4321U
+#define SENDER_NODE_ID 42U
+#define TRANSFER_ID_TIMEOUT_USEC 2000000U
+#define MAX_FRAMES 16U
+#define MAX_PAYLOAD 64U
+
+typedef struct
+{
+    CanardFrame frame;
+    uint8_t     data[CANARD_MTU_CAN_CLASSIC];
+} TestFrame;
+
+/// What the handler has received.
+typedef struct
+{
+    uint8_t             data[MAX_PAYLOAD];
+    size_t              delivered;  ///< The end of the last chunk; the chunks shall be contiguous.
+    size_t              chunks;
+    size_t              commits;
+    size_t              aborts;
+    size_t              concluded_offset;  ///< The offset of the last commit or abort.
+    CanardTransferID    concluded_transfer_id;
+    CanardRxStreamEvent last_event;
+} Received;
+
+static size_t Allocated = 0U;
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    Allocated++;
+    return malloc(amount);
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    if (pointer != NULL)
+    {
+        Allocated--;
+    }
+    free(pointer);
+}
+
+static void onStream(CanardInstance* const       ins,
+                     CanardRxSubscription* const subscription,
+                     const CanardRxStreamEvent   event,
+                     const CanardTransfer* const transfer,
+                     const size_t                offset)
+{
+    (void) ins;
+    Received* const received = (Received*) subscription->user_reference;
+    received->last_event     = event;
+    if (event == CanardRxStreamEventData)
+    {
+        CHECK(offset == received->delivered);
+        CHECK(transfer->payload_size > 0U);
+        CHECK((offset + transfer->payload_size) <= MAX_PAYLOAD);
+        (void) memcpy(&received->data[offset], transfer->payload, transfer->payload_size);
+        received->delivered = offset + transfer->payload_size;
+        received->chunks++;
+    }
+    else
+    {
+        CHECK(transfer->payload == NULL);
+        CHECK(offset == received->delivered);
+        received->concluded_offset      = offset;
+        received->concluded_transfer_id = transfer->transfer_id;
+        received->commits += (event == CanardRxStreamEventCommit) ? 1U : 0U;
+        received->aborts += (event == CanardRxStreamEventAbort) ? 1U : 0U;
+        received->delivered = 0U;  // The next transfer starts over.
+    }
+}
+
+/// Serializes a message transfer into frames; returns the number of frames.
+static size_t makeFrames(const uint8_t* const   payload,
+                         const size_t           payload_size,
+                         const CanardTransferID transfer_id,
+                         TestFrame* const       out)
+{
+    CanardInstance sender = canardInit(&memAllocate, &memFree);
+    sender.node_id        = SENDER_NODE_ID;
+    sender.mtu_bytes      = CANARD_MTU_CAN_CLASSIC;
+    const CanardTransfer transfer = {
+        .timestamp_usec = 0U,
+        .priority       = CanardPriorityNominal,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = PORT_ID,
+        .remote_node_id = CANARD_NODE_ID_UNSET,
+        .transfer_id    = transfer_id,
+        .payload_size   = payload_size,
+        .payload        = payload,
+    };
+    const int32_t result = canardTxPush(&sender, &transfer);
+    CHECK((result > 0) && ((size_t) result <= MAX_FRAMES));
+    size_t count = 0U;
+    for (const CanardFrame* txf = canardTxPeek(&sender); txf != NULL; txf = canardTxPeek(&sender))
+    {
+        canardTxPop(&sender);
+        if (count < MAX_FRAMES)
+        {
+            CHECK(txf->payload_size <= CANARD_MTU_CAN_CLASSIC);
+            out[count].frame = *txf;
+            (void) memcpy(out[count].data, txf->payload, txf->payload_size);
+            out[count].frame.payload = out[count].data;
+            count++;
+        }
+        sender.memory_free(&sender, (void*) txf);
+    }
+    return count;
+}
+
+static void accept(CanardInstance* const ins, TestFrame* const frame, const CanardMicrosecond timestamp_usec)
+{
+    frame->frame.timestamp_usec = timestamp_usec;
+    CanardTransfer transfer;
+    CHECK(canardRxAccept(ins, &frame->frame, 0U, &transfer) == 0);  // Never reassembled.
+}
+
+static void makePayload(uint8_t* const payload, const size_t size, const uint8_t seed)
+{
+    for (size_t i = 0U; i < size; i++)
+    {
+        payload[i] = (uint8_t) (seed + (i * 7U));
+    }
+}
+
+static void subscribe(CanardInstance* const       ins,
+                      CanardRxSubscription* const subscription,
+                      Received* const             received,
+                      const size_t                extent)
+{
+    (void) memset(received, 0, sizeof(*received));
+    CHECK(canardRxSubscribeStream(ins,
+                                  CanardTransferKindMessage,
+                                  PORT_ID,
+                                  extent,
+                                  TRANSFER_ID_TIMEOUT_USEC,
+                                  &onStream,
+                                  subscription) == 1);
+    subscription->user_reference = received;
+}
+
+/// 20 bytes of payload and 2 of CRC in 7-byte frames: 7 + 7 + 7 + 1. The last two bytes of the stream received so
+/// far are held back, so the CRC, which is split over the last two frames, is never delivered.
+static void testCommitAndHoldback(void)
+{
+    CanardInstance       ins = canardInit(&memAllocate, &memFree);
+    CanardRxSubscription subscription;
+    Received             received;
+    subscribe(&ins, &subscription, &received, MAX_PAYLOAD);
+
+    uint8_t payload[20];
+    makePayload(payload, sizeof(payload), 1U);
+    TestFrame    frames[MAX_FRAMES];
+    const size_t count = makeFrames(payload, sizeof(payload), 3U, frames);
+    CHECK(count == 4U);
+
+    const size_t delivered_after[] = {5U, 12U, 19U};
+    for (size_t i = 0U; i < 3U; i++)
+    {
+        accept(&ins, &frames[i], 1000U + i);
+        CHECK(received.delivered == delivered_after[i]);
+        CHECK(received.commits == 0U);
+    }
+    accept(&ins, &frames[3], 1003U);
+    CHECK(received.commits == 1U);
+    CHECK(received.aborts == 0U);
+    CHECK(received.concluded_offset == sizeof(payload));
+    CHECK(received.concluded_transfer_id == 3U);
+    CHECK(0 == memcmp(received.data, payload, sizeof(payload)));
+
+    // A single-frame transfer has no CRC: delivered at once and committed.
+    TestFrame single[MAX_FRAMES];
+    CHECK(makeFrames(payload, 5U, 4U, single) == 1U);
+    received.chunks = 0U;
+    accept(&ins, &single[0], 2000U);
+    CHECK(received.chunks == 1U);
+    CHECK(received.commits == 2U);
+    CHECK(received.concluded_offset == 5U);
+    CHECK(0 == memcmp(received.data, payload, 5U));
+
+    CHECK(canardRxUnsubscribe(&ins, CanardTransferKindMessage, PORT_ID) == 1);
+}
+
+static void testAbortOnCRCError(void)
+{
+    CanardInstance       ins = canardInit(&memAllocate, &memFree);
+    CanardRxSubscription subscription;
+    Received             received;
+    subscribe(&ins, &subscription, &received, MAX_PAYLOAD);
+
+    uint8_t payload[20];
+    makePayload(payload, sizeof(payload), 2U);
+    TestFrame    frames[MAX_FRAMES];
+    const size_t count = makeFrames(payload, sizeof(payload), 5U, frames);
+    CHECK(count == 4U);
+    frames[1].data[2] ^= 0x10U;
+    for (size_t i = 0U; i < count; i++)
+    {
+        accept(&ins, &frames[i], 1000U + i);
+    }
+    CHECK(received.commits == 0U);
+    CHECK(received.aborts == 1U);
+    CHECK(received.last_event == CanardRxStreamEventAbort);
+    CHECK(received.concluded_offset == sizeof(payload));
+    CHECK(received.concluded_transfer_id == 5U);
+
+    CHECK(canardRxUnsubscribe(&ins, CanardTransferKindMessage, PORT_ID) == 1);
+}
+
+/// A lost frame in the middle: the next frame has the wrong toggle and is ignored, the one after it is accepted, and
+/// the CRC of the transfer fails. A lost last frame: the transfer is aborted when the next one starts.
+static void testAbortOnLostFrame(void)
+{
+    CanardInstance       ins = canardInit(&memAllocate, &memFree);
+    CanardRxSubscription subscription;
+    Received             received;
+    subscribe(&ins, &subscription, &received, MAX_PAYLOAD);
+
+    uint8_t payload[20];
+    makePayload(payload, sizeof(payload), 3U);
+    TestFrame frames[MAX_FRAMES];
+    CHECK(makeFrames(payload, sizeof(payload), 6U, frames) == 4U);
+    accept(&ins, &frames[0], 1000U);
+    accept(&ins, &frames[2], 1002U);
+    CHECK(received.delivered == 5U);
+    accept(&ins, &frames[3], 1003U);
+    CHECK(received.commits == 0U);
+    CHECK(received.aborts == 1U);
+    CHECK(received.concluded_transfer_id == 6U);
+
+    CHECK(makeFrames(payload, sizeof(payload), 7U, frames) == 4U);
+    for (size_t i = 0U; i < 3U; i++)
+    {
+        accept(&ins, &frames[i], 2000U + i);
+    }
+    CHECK(received.delivered == 19U);
+    CHECK(received.aborts == 1U);
+
+    uint8_t next[12];
+    makePayload(next, sizeof(next), 4U);
+    TestFrame    next_frames[MAX_FRAMES];
+    const size_t next_count = makeFrames(next, sizeof(next), 8U, next_frames);
+    CHECK(next_count == 2U);
+    accept(&ins, &next_frames[0], 3000U);
+    CHECK(received.aborts == 2U);
+    CHECK(received.concluded_offset == 19U);
+    CHECK(received.concluded_transfer_id == 7U);
+    accept(&ins, &next_frames[1], 3001U);
+    CHECK(received.commits == 1U);
+    CHECK(received.concluded_offset == sizeof(next));
+    CHECK(received.concluded_transfer_id == 8U);
+    CHECK(0 == memcmp(received.data, next, sizeof(next)));
+
+    CHECK(canardRxUnsubscribe(&ins, CanardTransferKindMessage, PORT_ID) == 1);
+}
+
+/// The data beyond the extent is not delivered, but the CRC of the whole transfer is still checked.
+static void testExtentTruncation(void)
+{
+    CanardInstance       ins = canardInit(&memAllocate, &memFree);
+    CanardRxSubscription subscription;
+    Received             received;
+    subscribe(&ins, &subscription, &received, 10U);
+
+    uint8_t payload[20];
+    makePayload(payload, sizeof(payload), 5U);
+    TestFrame    frames[MAX_FRAMES];
+    const size_t count = makeFrames(payload, sizeof(payload), 9U, frames);
+    for (size_t i = 0U; i < count; i++)
+    {
+        accept(&ins, &frames[i], 1000U + i);
+    }
+    CHECK(received.commits == 1U);
+    CHECK(received.concluded_offset == 10U);
+    CHECK(0 == memcmp(received.data, payload, 10U));
+
+    // A CRC error beyond the extent still aborts the transfer.
+    CHECK(makeFrames(payload, sizeof(payload), 10U, frames) == count);
+    frames[2].data[3] ^= 0x01U;
+    for (size_t i = 0U; i < count; i++)
+    {
+        accept(&ins, &frames[i], 2000U + i);
+    }
+    CHECK(received.commits == 1U);
+    CHECK(received.aborts == 1U);
+    CHECK(received.concluded_offset == 10U);
+
+    CHECK(canardRxUnsubscribe(&ins, CanardTransferKindMessage, PORT_ID) == 1);
+}
+
+int main(void)
+{
+    testCommitAndHoldback();
+    testAbortOnCRCError();
+    testAbortOnLostFrame();
+    testExtentTruncation();
+    CHECK(Allocated == 0U);  // The session states are freed when unsubscribing; no payload buffer is ever allocated.
+    return checkReport("test-rx-stream");
+}
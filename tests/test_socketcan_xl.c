@@ -0,0 +1,104 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The priority field of the CAN XL frames written by socketcanPush() (socketcanGetXLPriority()): the nodes that
+/// publish the same subject get distinct priority fields, and the priority fields arbitrate in the order of the
+/// transfer priorities, with the messages ahead of the services. The CAN IDs are produced by canardTxPush().
+
+#include "check.h"
+#include <canard.h>
+#include <socketcan.h>
+#include <stdlib.h>
+
+#define SUBJECT_ID 1630U
+#define SERVICE_ID 210U
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    return malloc(amount);
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    free(pointer);
+}
+
+/// Returns the CAN ID of the single frame of a transfer sent by the given node.
+static uint32_t makeCANID(const CanardNodeID       node_id,
+                          const CanardPriority     priority,
+                          const CanardTransferKind kind,
+                          const CanardPortID       port_id)
+{
+    CanardInstance ins = canardInit(&memAllocate, &memFree);
+    ins.node_id        = node_id;
+    const uint8_t        payload[1] = {0};
+    const CanardTransfer transfer   = {
+        .timestamp_usec = 0U,
+        .priority       = priority,
+        .transfer_kind  = kind,
+        .port_id        = port_id,
+        .remote_node_id = (kind == CanardTransferKindMessage) ? CANARD_NODE_ID_UNSET : 1U,
+        .transfer_id    = 0U,
+        .payload_size   = sizeof(payload),
+        .payload        = &payload[0],
+    };
+    CHECK(canardTxPush(&ins, &transfer) == 1);
+    const CanardFrame* const txf = canardTxPeek(&ins);
+    CHECK(txf != NULL);
+    const uint32_t out = (txf != NULL) ? txf->extended_can_id : 0U;
+    canardTxPop(&ins);
+    ins.memory_free(&ins, (void*) txf);
+    return out;
+}
+
+static void testLayout(void)
+{
+    const uint32_t can_id = makeCANID(42U, CanardPriorityLow, CanardTransferKindMessage, SUBJECT_ID);
+    CHECK(socketcanGetXLPriority(can_id) == ((CanardPriorityLow << 8U) | 42U));
+    const uint32_t service_id = makeCANID(42U, CanardPriorityLow, CanardTransferKindResponse, SERVICE_ID);
+    CHECK(socketcanGetXLPriority(service_id) == ((CanardPriorityLow << 8U) | 0x80U | 42U));
+    const uint32_t top = makeCANID(CANARD_NODE_ID_MAX, CanardPriorityOptional, CanardTransferKindRequest, SERVICE_ID);
+    CHECK(socketcanGetXLPriority(top) == 0x7FFU);  // All 11 bits are used, none beyond.
+}
+
+/// The nodes that publish the same subject with the same priority shall not collide in the arbitration.
+static void testDistinctNodes(void)
+{
+    for (CanardNodeID a = 0U; a <= CANARD_NODE_ID_MAX; a++)
+    {
+        const CanardNodeID b    = (CanardNodeID) ((a + 1U) % (CANARD_NODE_ID_MAX + 1U));
+        const uint32_t     id_a = makeCANID(a, CanardPriorityNominal, CanardTransferKindMessage, SUBJECT_ID);
+        const uint32_t     id_b = makeCANID(b, CanardPriorityNominal, CanardTransferKindMessage, SUBJECT_ID);
+        CHECK(socketcanGetXLPriority(id_a) != socketcanGetXLPriority(id_b));
+    }
+}
+
+/// A lower priority field wins the arbitration, as a lower CAN ID does with Classic CAN and CAN FD.
+static void testArbitrationOrder(void)
+{
+    for (unsigned prio = 0U; prio < CANARD_PRIORITY_MAX; prio++)
+    {
+        // Any node of a higher transfer priority wins, whatever the kind of its transfer.
+        const CanardPriority high   = (CanardPriority) prio;
+        const CanardPriority low    = (CanardPriority) (prio + 1U);
+        const uint32_t       higher = makeCANID(CANARD_NODE_ID_MAX, high, CanardTransferKindRequest, SERVICE_ID);
+        const uint32_t       lower  = makeCANID(0U, low, CanardTransferKindMessage, SUBJECT_ID);
+        CHECK(socketcanGetXLPriority(higher) < socketcanGetXLPriority(lower));
+        CHECK((higher < lower) == (socketcanGetXLPriority(higher) < socketcanGetXLPriority(lower)));
+    }
+    const uint32_t message =
+        makeCANID(CANARD_NODE_ID_MAX, CanardPriorityNominal, CanardTransferKindMessage, SUBJECT_ID);
+    const uint32_t service = makeCANID(0U, CanardPriorityNominal, CanardTransferKindResponse, SERVICE_ID);
+    CHECK(socketcanGetXLPriority(message) < socketcanGetXLPriority(service));
+}
+
+int main(void)
+{
+    testLayout();
+    testDistinctNodes();
+    testArbitrationOrder();
+    return checkReport("test-socketcan-xl");
+}
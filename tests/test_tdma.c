@@ -0,0 +1,225 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The time-division trigger schedule (src/tdma.c) on a mock sensor backend: the validation of the requests, the
+/// alignment once the node is synchronized, and the slot phase handed to the backend, also when the tick wraps around
+/// between the alignment and the trigger or the phase lies before the wrap.
+
+#include "check.h"
+#include "tdma.h"
+#include <canard_dsdl.h>
+#include <errno.h>
+
+#define MASTER_NODE_ID 10U
+#define SYNC_PERIOD_USEC 1000000U
+
+typedef struct
+{
+    SensorBackend base;
+    uint32_t      tick;
+    bool          aligned;
+    uint32_t      phase_tick;
+    int16_t       result;  ///< Of setTriggerPhase().
+    size_t        calls;
+} MockSensor;
+
+static uint32_t mockTick(SensorBackend* const self)
+{
+    return ((MockSensor*) self)->tick;
+}
+
+static int16_t mockSetTriggerPhase(SensorBackend* const self, const bool aligned, const uint32_t phase_tick)
+{
+    MockSensor* const mock = (MockSensor*) self;
+    mock->calls++;
+    if (mock->result >= 0)
+    {
+        mock->aligned    = aligned;
+        mock->phase_tick = phase_tick;
+    }
+    return mock->result;
+}
+
+static void mockInit(MockSensor* const mock)
+{
+    *mock = (MockSensor){
+        .base = {.name = "mock", .tick = &mockTick, .setTriggerPhase = &mockSetTriggerPhase},
+    };
+}
+
+/// Synchronizes to a master whose network time is ahead of the local time by the offset; the second message is
+/// received at now_usec.
+static void synchronize(TimeSync* const sync, const CanardMicrosecond now_usec, const uint64_t offset_usec)
+{
+    timesyncInit(sync);
+    for (uint8_t n = 0U; n < 2U; n++)
+    {
+        const CanardMicrosecond received_usec = now_usec - SYNC_PERIOD_USEC + (n * SYNC_PERIOD_USEC);
+        uint8_t                 payload[TIMESYNC_MESSAGE_EXTENT] = {0};
+        canardDSDLSetUxx(payload, 0U, (n > 0U) ? (received_usec - SYNC_PERIOD_USEC + offset_usec) : 0U, 56U);
+        const CanardTransfer transfer = {
+            .timestamp_usec = received_usec,
+            .priority       = CanardPriorityNominal,
+            .transfer_kind  = CanardTransferKindMessage,
+            .port_id        = TIMESYNC_SUBJECT_ID,
+            .remote_node_id = MASTER_NODE_ID,
+            .transfer_id    = n,
+            .payload_size   = sizeof(payload),
+            .payload        = &payload[0],
+        };
+        timesyncOnMessage(sync, &transfer);
+    }
+    CHECK(sync->synchronized);
+}
+
+/// Sends a request; returns the frame length and the status and the alignment from the response.
+static uint32_t request(TdmaSchedule* const     schedule,
+                        const uint8_t           slot_index,
+                        const uint8_t           slot_count,
+                        const uint16_t          slot_usec,
+                        const CanardMicrosecond now_usec,
+                        TdmaStatus* const       out_status,
+                        bool* const             out_synchronized)
+{
+    uint8_t req[TDMA_REQUEST_SIZE] = {0};
+    canardDSDLSetUxx(req, 0U, slot_index, 8U);
+    canardDSDLSetUxx(req, 8U, slot_count, 8U);
+    canardDSDLSetUxx(req, 16U, slot_usec, 16U);
+    uint8_t        response[TDMA_RESPONSE_SIZE] = {0};
+    const uint32_t frame_usec = tdmaHandleRequest(schedule, req, sizeof(req), now_usec, response);
+    *out_status               = (TdmaStatus) canardDSDLGetU8(response, sizeof(response), 0U, 8U);
+    *out_synchronized         = canardDSDLGetBit(response, sizeof(response), 8U);
+    CHECK(canardDSDLGetU32(response, sizeof(response), 16U, 32U) == frame_usec);
+    return frame_usec;
+}
+
+static void testRequests(void)
+{
+    MockSensor mock;
+    mockInit(&mock);
+    TimeSync sync;
+    timesyncInit(&sync);
+    TdmaSchedule schedule;
+    tdmaInit(&schedule, &mock.base, &sync);
+    TdmaStatus status       = TdmaStatusApplied;
+    bool       synchronized = true;
+
+    CHECK(request(&schedule, 4U, 4U, 0U, 0U, &status, &synchronized) == 0U);  // The slot index is out of range.
+    CHECK(status == TdmaStatusInvalid);
+    CHECK(request(&schedule, 0U, 1U, 0U, 0U, &status, &synchronized) == 0U);  // 25 ms is below the minimal frame.
+    CHECK(status == TdmaStatusInvalid);
+
+    // Applied, but not aligned without the network time; the backend is not touched.
+    CHECK(request(&schedule, 1U, 4U, 0U, 0U, &status, &synchronized) == (4U * TDMA_DEFAULT_SLOT_USEC));
+    CHECK(status == TdmaStatusApplied);
+    CHECK(!synchronized);
+    CHECK(mock.calls == 0U);
+    CHECK(request(&schedule, 0U, 2U, 20000U, 0U, &status, &synchronized) == 40000U);
+    CHECK(status == TdmaStatusApplied);
+    // An invalid request keeps the schedule in effect.
+    CHECK(request(&schedule, 2U, 2U, 20000U, 0U, &status, &synchronized) == 40000U);
+    CHECK(status == TdmaStatusInvalid);
+
+    CHECK(request(&schedule, 0U, 0U, 0U, 0U, &status, &synchronized) == 0U);
+    CHECK(status == TdmaStatusDisabled);
+    CHECK(mock.calls == 0U);  // Nothing to undo, the trigger was never aligned.
+}
+
+/// The time from the tick of the alignment to the next trigger equals the time from the network time of the
+/// alignment to the next start of the slot.
+static void checkPhase(const MockSensor* const mock,
+                       const uint64_t          network_usec,
+                       const uint32_t          frame_usec,
+                       const uint32_t          slot_start_usec)
+{
+    const uint32_t expected = (uint32_t) ((slot_start_usec + frame_usec - (network_usec % frame_usec)) % frame_usec);
+    CHECK(mock->aligned);
+    CHECK(sensorGetTimeToPhase(mock->tick, mock->phase_tick, frame_usec) == expected);
+    // Later, after the tick has wrapped around.
+    const uint32_t later = 3U * frame_usec;
+    CHECK(sensorGetTimeToPhase(mock->tick + later + 7U, mock->phase_tick, frame_usec) ==
+          ((expected + frame_usec - 7U) % frame_usec));
+}
+
+static void testAlignment(void)
+{
+    const uint32_t ticks[]   = {123456U, 100U, UINT32_MAX - 1000U};
+    const uint64_t offsets[] = {0U, 12345U, 1000000000123ULL};
+    for (size_t t = 0U; t < (sizeof(ticks) / sizeof(ticks[0])); t++)
+    {
+        for (size_t o = 0U; o < (sizeof(offsets) / sizeof(offsets[0])); o++)
+        {
+            const CanardMicrosecond now_usec = 5000000U + (t * 1234567U);
+            MockSensor              mock;
+            mockInit(&mock);
+            mock.tick = ticks[t];
+            TimeSync sync;
+            synchronize(&sync, now_usec, offsets[o]);
+            TdmaSchedule schedule;
+            tdmaInit(&schedule, &mock.base, &sync);
+            TdmaStatus status       = TdmaStatusInvalid;
+            bool       synchronized = false;
+
+            const uint32_t frame_usec = request(&schedule, 2U, 5U, 10000U, now_usec, &status, &synchronized);
+            CHECK(frame_usec == 50000U);
+            CHECK(status == TdmaStatusApplied);
+            CHECK(synchronized);
+            CHECK(schedule.alignments == 1U);
+            checkPhase(&mock, now_usec + offsets[o], frame_usec, 20000U);
+
+            // The refresh follows the tick and the network time as they advance; the slot phase stays the same.
+            mock.tick += 333333U;
+            tdmaPoll(&schedule, now_usec + 333333U);
+            CHECK(schedule.alignments == 2U);
+            checkPhase(&mock, now_usec + 333333U + offsets[o], frame_usec, 20000U);
+
+            // The last slot of the frame.
+            CHECK(request(&schedule, 4U, 5U, 10000U, now_usec + 333333U, &status, &synchronized) == frame_usec);
+            checkPhase(&mock, now_usec + 333333U + offsets[o], frame_usec, 40000U);
+        }
+    }
+}
+
+/// The alignment is kept when the synchronization is lost and undone when the schedule is disabled; a backend that
+/// cannot align the trigger leaves the schedule unaligned.
+static void testLossAndDisable(void)
+{
+    MockSensor mock;
+    mockInit(&mock);
+    mock.tick = 1000U;
+    TimeSync sync;
+    synchronize(&sync, 10000000U, 777U);
+    TdmaSchedule schedule;
+    tdmaInit(&schedule, &mock.base, &sync);
+    TdmaStatus status       = TdmaStatusInvalid;
+    bool       synchronized = false;
+    CHECK(request(&schedule, 0U, 2U, 0U, 10000000U, &status, &synchronized) == 50000U);
+    CHECK(synchronized);
+    const size_t calls = mock.calls;
+
+    tdmaPoll(&schedule, 10000000U + TIMESYNC_TIMEOUT_USEC + 1U);
+    CHECK(mock.calls == calls);
+    CHECK(schedule.aligned);
+    CHECK(mock.aligned);
+
+    CHECK(request(&schedule, 0U, 0U, 0U, 10000000U, &status, &synchronized) == 0U);
+    CHECK(status == TdmaStatusDisabled);
+    CHECK(!synchronized);
+    CHECK(!mock.aligned);
+    CHECK(!schedule.aligned);
+
+    mock.result = -EINVAL;
+    CHECK(request(&schedule, 1U, 2U, 0U, 10000000U, &status, &synchronized) == 50000U);
+    CHECK(status == TdmaStatusApplied);
+    CHECK(!synchronized);
+    CHECK(schedule.alignments == 1U);
+}
+
+int main(void)
+{
+    testRequests();
+    testAlignment();
+    testLossAndDisable();
+    return checkReport("test-tdma");
+}
@@ -0,0 +1,165 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The time synchronization slave (src/timesync.c): the pairing of the previous transmission timestamp with the
+/// reception of the previous message by consecutive transfer-IDs, the selection of the master with the lowest
+/// node-ID, and the failover to another master once the current one has been silent for the timeout.
+
+#include "check.h"
+#include "timesync.h"
+#include <canard_dsdl.h>
+
+/// The network time is ahead of the local time by this much, with the master of the lower node-ID.
+#define OFFSET_USEC 500000000
+/// Another master, with another time base.
+#define OTHER_OFFSET_USEC 100000
+#define PERIOD_USEC 1000000U
+
+/// Delivers a uavcan.time.Synchronization message received at the local time.
+static void deliver(TimeSync* const         sync,
+                    const CanardNodeID      node_id,
+                    const CanardTransferID  transfer_id,
+                    const CanardMicrosecond received_usec,
+                    const CanardMicrosecond previous_tx_usec)
+{
+    uint8_t payload[TIMESYNC_MESSAGE_EXTENT] = {0};
+    canardDSDLSetUxx(payload, 0U, previous_tx_usec, 56U);
+    const CanardTransfer transfer = {
+        .timestamp_usec = received_usec,
+        .priority       = CanardPriorityNominal,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = TIMESYNC_SUBJECT_ID,
+        .remote_node_id = node_id,
+        .transfer_id    = transfer_id,
+        .payload_size   = sizeof(payload),
+        .payload        = &payload[0],
+    };
+    timesyncOnMessage(sync, &transfer);
+}
+
+/// A master publishing every PERIOD_USEC from the local time start_usec on; the message n carries the transmission
+/// time of the message n - 1 in the network time, which is the reception time in the local time plus the offset.
+static void publish(TimeSync* const         sync,
+                    const CanardNodeID      node_id,
+                    const int64_t           offset_usec,
+                    const CanardMicrosecond start_usec,
+                    const size_t            first,
+                    const size_t            count)
+{
+    for (size_t n = first; n < (first + count); n++)
+    {
+        const CanardMicrosecond previous_tx_usec =
+            (n > 0U) ? (CanardMicrosecond) ((int64_t) (start_usec + ((n - 1U) * PERIOD_USEC)) + offset_usec) : 0U;
+        deliver(sync,
+                node_id,
+                (CanardTransferID) (n & CANARD_TRANSFER_ID_MAX),
+                start_usec + (n * PERIOD_USEC),
+                previous_tx_usec);
+    }
+}
+
+static void testPairing(void)
+{
+    TimeSync sync;
+    timesyncInit(&sync);
+    CanardMicrosecond network = 0U;
+    CHECK(!timesyncGetNetworkTime(&sync, 1000U, &network));
+
+    // The first message has no previous one; the second one is paired with the first.
+    publish(&sync, 10U, OFFSET_USEC, 1000U, 0U, 1U);
+    CHECK(sync.master_node_id == 10U);
+    CHECK(!sync.synchronized);
+    publish(&sync, 10U, OFFSET_USEC, 1000U, 1U, 1U);
+    CHECK(sync.synchronized);
+    CHECK(sync.offset_usec == OFFSET_USEC);
+    CHECK(sync.measurements == 1U);
+    CHECK(timesyncGetNetworkTime(&sync, 1001500U, &network));
+    CHECK(network == (1001500U + OFFSET_USEC));
+
+    // A lost message: the next one refers to the lost one and is not paired, the one after it is.
+    deliver(&sync, 10U, 3U, 1000U + (3U * PERIOD_USEC), 12345U);
+    CHECK(sync.measurements == 1U);
+    CHECK(sync.offset_usec == OFFSET_USEC);
+    publish(&sync, 10U, OFFSET_USEC + 20, 1000U, 4U, 1U);
+    CHECK(sync.measurements == 2U);
+    CHECK(sync.offset_usec == (OFFSET_USEC + 20));
+    CHECK(sync.last_correction_usec == 20);
+
+    // An unknown previous transmission time is not a measurement; the transfer-ID still advances.
+    deliver(&sync, 10U, 5U, 1000U + (5U * PERIOD_USEC), 0U);
+    CHECK(sync.measurements == 2U);
+    publish(&sync, 10U, OFFSET_USEC, 1000U, 6U, 1U);
+    CHECK(sync.measurements == 3U);
+
+    // The transfer-ID wraps around.
+    publish(&sync, 10U, OFFSET_USEC, 1000U, 7U, CANARD_TRANSFER_ID_MAX + 2U);
+    CHECK(sync.measurements == (3U + CANARD_TRANSFER_ID_MAX + 2U));
+    CHECK(sync.offset_usec == OFFSET_USEC);
+
+    // The anonymous messages are ignored.
+    deliver(&sync, CANARD_NODE_ID_UNSET, 0U, 100000000U, 1U);
+    CHECK(sync.master_node_id == 10U);
+}
+
+static void testMasterSelection(void)
+{
+    TimeSync sync;
+    timesyncInit(&sync);
+    publish(&sync, 20U, OTHER_OFFSET_USEC, 0U, 0U, 3U);
+    CHECK(sync.master_node_id == 20U);
+    CHECK(sync.synchronized);
+    CHECK(sync.offset_usec == OTHER_OFFSET_USEC);
+
+    // A master with a lower node-ID takes over at once; the time base changes, so the offset is measured again.
+    publish(&sync, 10U, OFFSET_USEC, 3000000U, 0U, 1U);
+    CHECK(sync.master_node_id == 10U);
+    CHECK(!sync.synchronized);
+    // The higher node-ID is ignored while the master is alive, also with a matching transfer-ID.
+    deliver(&sync, 20U, 3U, 3100000U, 2000000U + OTHER_OFFSET_USEC);
+    CHECK(sync.master_node_id == 10U);
+    CHECK(!sync.synchronized);
+    publish(&sync, 10U, OFFSET_USEC, 3000000U, 1U, 2U);
+    CHECK(sync.synchronized);
+    CHECK(sync.offset_usec == OFFSET_USEC);
+}
+
+static void testFailover(void)
+{
+    TimeSync sync;
+    timesyncInit(&sync);
+    publish(&sync, 10U, OFFSET_USEC, 0U, 0U, 3U);  // The last message at 2 s.
+    CHECK(sync.synchronized);
+    CanardMicrosecond       network   = 0U;
+    const CanardMicrosecond last_usec = 2U * PERIOD_USEC;
+    CHECK(timesyncGetNetworkTime(&sync, last_usec + TIMESYNC_TIMEOUT_USEC, &network));
+    CHECK(!timesyncGetNetworkTime(&sync, last_usec + TIMESYNC_TIMEOUT_USEC + 1U, &network));
+
+    // Within the timeout, the other master is ignored; after it, the other master is followed from scratch.
+    deliver(&sync, 20U, 0U, last_usec + TIMESYNC_TIMEOUT_USEC, 0U);
+    CHECK(sync.master_node_id == 10U);
+    const CanardMicrosecond start = last_usec + TIMESYNC_TIMEOUT_USEC + 1U;
+    publish(&sync, 20U, OTHER_OFFSET_USEC, start, 0U, 1U);
+    CHECK(sync.master_node_id == 20U);
+    CHECK(!sync.synchronized);
+    CHECK(!timesyncGetNetworkTime(&sync, start, &network));
+    publish(&sync, 20U, OTHER_OFFSET_USEC, start, 1U, 1U);
+    CHECK(sync.synchronized);
+    CHECK(sync.offset_usec == OTHER_OFFSET_USEC);
+    CHECK(timesyncGetNetworkTime(&sync, start + PERIOD_USEC, &network));
+    CHECK(network == (start + PERIOD_USEC + OTHER_OFFSET_USEC));
+
+    // The returning master with the lower node-ID takes over again, with its own transfer-ID sequence.
+    publish(&sync, 10U, OFFSET_USEC, start + (2U * PERIOD_USEC), 7U, 2U);
+    CHECK(sync.master_node_id == 10U);
+    CHECK(sync.synchronized);
+    CHECK(sync.offset_usec == OFFSET_USEC);
+}
+
+int main(void)
+{
+    testPairing();
+    testMasterSelection();
+    testFailover();
+    return checkReport("test-timesync");
+}
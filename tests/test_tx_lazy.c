@@ -0,0 +1,242 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The lazy transmission of libcanard (canardTxPushLazy): the frames popped from the queue are the same, in the same
+/// order, as those of canardTxPush() for a mix of transfers, MTU and segmentation policies; and when the allocation of
+/// the next frame fails in canardTxPop(), the rest of the transfer is dropped, the other transfers are not affected,
+/// and nothing leaks.
+
+#include "check.h"
+#include <canard.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NODE_ID 42U
+#define MAX_FRAMES 1024U
+#define PAYLOAD_SIZE 600U
+
+typedef struct
+{
+    CanardMicrosecond timestamp_usec;
+    uint32_t          extended_can_id;
+    size_t            payload_size;
+    uint8_t           payload[CANARD_MTU_CAN_FD];
+} FrameRecord;
+
+static size_t Allocated = 0U;
+/// The number of allocations that succeed before they start failing; negative: unlimited.
+static long AllocationsLeft = -1;
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    void* out = NULL;
+    if (AllocationsLeft != 0)
+    {
+        AllocationsLeft -= (AllocationsLeft > 0) ? 1 : 0;
+        out = malloc(amount);
+        Allocated += (out != NULL) ? 1U : 0U;
+    }
+    return out;
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    if (pointer != NULL)
+    {
+        Allocated--;
+    }
+    free(pointer);
+}
+
+static uint8_t Payload[PAYLOAD_SIZE];
+
+/// The transfers pushed in every case: multi-frame transfers of several sizes and priorities, interleaved with
+/// single-frame ones and with transfers of the same CAN ID, so that the lazy frames have to keep their place.
+typedef struct
+{
+    CanardPriority    priority;
+    CanardPortID      port_id;
+    size_t            payload_size;
+    CanardMicrosecond deadline_usec;
+} TransferSpec;
+
+static const TransferSpec Transfers[] = {
+    {CanardPriorityNominal, 1000U, 300U, 1000U},
+    {CanardPriorityLow, 1001U, 5U, 2000U},
+    {CanardPriorityNominal, 1000U, 61U, 3000U},
+    {CanardPriorityFast, 1002U, PAYLOAD_SIZE, 4000U},
+    {CanardPriorityNominal, 1003U, 0U, 5000U},
+    {CanardPrioritySlow, 1004U, 13U, 6000U},
+    {CanardPriorityFast, 1002U, 14U, 7000U},
+    {CanardPriorityHigh, 1005U, 63U, 8000U},
+};
+#define TRANSFER_COUNT (sizeof(Transfers) / sizeof(Transfers[0]))
+
+static int32_t push(CanardInstance* const ins, const TransferSpec* const spec, const size_t mtu, const bool lazy)
+{
+    const CanardTransfer transfer = {
+        .timestamp_usec = spec->deadline_usec,
+        .priority       = spec->priority,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = spec->port_id,
+        .remote_node_id = CANARD_NODE_ID_UNSET,
+        .transfer_id    = (CanardTransferID) (spec->port_id & CANARD_TRANSFER_ID_MAX),
+        .payload_size   = spec->payload_size,
+        .payload        = &Payload[0],
+    };
+    return lazy ? canardTxPushLazyMTU(ins, &transfer, mtu) : canardTxPushMTU(ins, &transfer, mtu);
+}
+
+/// Pops and frees every frame in the queue; returns the number of frames.
+static size_t drain(CanardInstance* const ins, FrameRecord* const out)
+{
+    size_t count = 0U;
+    for (const CanardFrame* txf = canardTxPeek(ins); txf != NULL; txf = canardTxPeek(ins))
+    {
+        canardTxPop(ins);
+        if (count < MAX_FRAMES)
+        {
+            CHECK(txf->payload_size <= CANARD_MTU_CAN_FD);
+            out[count].timestamp_usec  = txf->timestamp_usec;
+            out[count].extended_can_id = txf->extended_can_id;
+            out[count].payload_size    = txf->payload_size;
+            (void) memcpy(out[count].payload, txf->payload, txf->payload_size);
+            count++;
+        }
+        ins->memory_free(ins, (void*) txf);
+    }
+    return count;
+}
+
+static bool sameFrames(const FrameRecord* const a, const FrameRecord* const b, const size_t count)
+{
+    bool same = true;
+    for (size_t i = 0U; same && (i < count); i++)
+    {
+        same = (a[i].timestamp_usec == b[i].timestamp_usec) && (a[i].extended_can_id == b[i].extended_can_id) &&
+               (a[i].payload_size == b[i].payload_size) &&
+               (0 == memcmp(a[i].payload, b[i].payload, a[i].payload_size));
+    }
+    return same;
+}
+
+static FrameRecord Eager[MAX_FRAMES];
+static FrameRecord Lazy[MAX_FRAMES];
+
+static void testSameFrames(const size_t mtu, const CanardTxSegmentation segmentation)
+{
+    CanardInstance eager    = canardInit(&memAllocate, &memFree);
+    eager.node_id           = NODE_ID;
+    eager.tx_segmentation   = segmentation;
+    CanardInstance lazy     = eager;
+    size_t         expected = 0U;
+    for (size_t i = 0U; i < TRANSFER_COUNT; i++)
+    {
+        const int32_t frames = push(&eager, &Transfers[i], mtu, false);
+        CHECK(frames > 0);
+        CHECK(push(&lazy, &Transfers[i], mtu, true) == frames);
+        expected += (size_t) frames;
+    }
+    CHECK(expected <= MAX_FRAMES);
+    CHECK(canardTxGetQueueSize(&eager) == expected);
+    CHECK(canardTxGetQueueSize(&lazy) == TRANSFER_COUNT);  // One frame of each transfer exists at a time.
+    CHECK(drain(&eager, Eager) == expected);
+    CHECK(drain(&lazy, Lazy) == expected);
+    CHECK(canardTxGetQueueSize(&eager) == 0U);
+    CHECK(canardTxGetQueueSize(&lazy) == 0U);
+    CHECK(sameFrames(Eager, Lazy, expected));
+    CHECK(Allocated == 0U);  // The cursors are freed with the last frame of their transfers.
+}
+
+/// Allows the given number of frames of the lazy transfer to be produced by canardTxPop(), then fails the allocation.
+static void testAllocationFailureInPop(const size_t mtu, const size_t produced)
+{
+    // The reference: the other transfers alone, and the failing transfer alone.
+    CanardInstance eager = canardInit(&memAllocate, &memFree);
+    eager.node_id        = NODE_ID;
+    const TransferSpec failing = {CanardPriorityNominal, 2000U, PAYLOAD_SIZE, 9000U};
+    const TransferSpec others[] = {
+        {CanardPriorityNominal, 2001U, 200U, 9100U},  // Queued behind the failing transfer.
+        {CanardPriorityHigh, 2002U, 3U, 9200U},        // Ahead of it.
+    };
+    const int32_t failing_frames = push(&eager, &failing, mtu, false);
+    CHECK(failing_frames > (int32_t) (produced + 1U));
+    CHECK(drain(&eager, Eager) == (size_t) failing_frames);
+    for (size_t i = 0U; i < (sizeof(others) / sizeof(others[0])); i++)
+    {
+        CHECK(push(&eager, &others[i], mtu, false) > 0);
+    }
+    const size_t others_count = drain(&eager, &Eager[failing_frames]);
+
+    CanardInstance lazy = eager;
+    CHECK(push(&lazy, &failing, mtu, true) == failing_frames);
+    for (size_t i = 0U; i < (sizeof(others) / sizeof(others[0])); i++)
+    {
+        CHECK(push(&lazy, &others[i], mtu, true) > 0);
+    }
+    // The high-priority single frame first, then the first frame of the failing transfer and the produced ones.
+    FrameRecord  popped[MAX_FRAMES];
+    size_t       count = 0U;
+    const size_t keep  = 1U + 1U + produced;
+    for (; count < keep; count++)
+    {
+        const CanardFrame* const txf = canardTxPeek(&lazy);
+        CHECK(txf != NULL);
+        if (txf == NULL)
+        {
+            break;
+        }
+        AllocationsLeft = (count == (keep - 1U)) ? 0 : -1;  // Fail the frame after the last one kept.
+        canardTxPop(&lazy);
+        AllocationsLeft = -1;
+
+        popped[count].timestamp_usec  = txf->timestamp_usec;
+        popped[count].extended_can_id = txf->extended_can_id;
+        popped[count].payload_size    = txf->payload_size;
+        (void) memcpy(popped[count].payload, txf->payload, txf->payload_size);
+        lazy.memory_free(&lazy, (void*) txf);
+    }
+    count += drain(&lazy, &popped[count]);
+    CHECK(canardTxGetQueueSize(&lazy) == 0U);
+
+    CHECK(count == (others_count + 1U + produced));
+    CHECK(sameFrames(&popped[0], &Eager[failing_frames], 1U));
+    CHECK(sameFrames(&popped[1], &Eager[0], 1U + produced));
+    CHECK(sameFrames(&popped[2U + produced], &Eager[failing_frames + 1], others_count - 1U));
+    CHECK(Allocated == 0U);  // The cursor of the dropped transfer is freed.
+}
+
+/// The lazy push itself needs the first frame and the cursor; if either cannot be allocated, nothing is enqueued.
+static void testAllocationFailureInPush(void)
+{
+    CanardInstance ins = canardInit(&memAllocate, &memFree);
+    ins.node_id        = NODE_ID;
+    for (long left = 0; left < 2; left++)
+    {
+        AllocationsLeft = left;
+        CHECK(push(&ins, &Transfers[0], CANARD_MTU_CAN_CLASSIC, true) == -CANARD_ERROR_OUT_OF_MEMORY);
+        AllocationsLeft = -1;
+        CHECK(canardTxPeek(&ins) == NULL);
+        CHECK(Allocated == 0U);
+    }
+}
+
+int main(void)
+{
+    for (size_t i = 0U; i < PAYLOAD_SIZE; i++)
+    {
+        Payload[i] = (uint8_t) ((i * 31U) ^ (i >> 3U));
+    }
+    testSameFrames(CANARD_MTU_CAN_CLASSIC, CanardTxSegmentationMaximizeFrameSize);
+    testSameFrames(CANARD_MTU_CAN_FD, CanardTxSegmentationMaximizeFrameSize);
+    testSameFrames(CANARD_MTU_CAN_FD, CanardTxSegmentationMinimizeBusTime);
+    testSameFrames(32U, CanardTxSegmentationMaximizeFrameSize);
+    testAllocationFailureInPop(CANARD_MTU_CAN_CLASSIC, 0U);
+    testAllocationFailureInPop(CANARD_MTU_CAN_CLASSIC, 5U);
+    testAllocationFailureInPop(CANARD_MTU_CAN_FD, 3U);
+    testAllocationFailureInPush();
+    return checkReport("test-tx-lazy");
+}
@@ -0,0 +1,256 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "aggregator.h"
+#include <assert.h>
+#include <canard_dsdl.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ultrasound_layout.h>
+
+static_assert((AGGREGATOR_HISTORY_CAPACITY & (AGGREGATOR_HISTORY_CAPACITY - 1U)) == 0U, "Shall be a power of two");
+static_assert(AGGREGATOR_READ_MARGIN < AGGREGATOR_HISTORY_CAPACITY, "The margin shall leave something to read");
+static_assert(sizeof(float) == sizeof(uint32_t), "The distance is stored as its bit pattern");
+
+/// The number of the samples of a ring that are safe to read.
+#define AGGREGATOR_READABLE (AGGREGATOR_HISTORY_CAPACITY - AGGREGATOR_READ_MARGIN)
+
+static uint64_t aggregatorGetTimestamp(const AggregatorRing* const ring, const uint64_t index)
+{
+    return atomic_load_explicit(&ring->slots[index % AGGREGATOR_HISTORY_CAPACITY].timestamp_usec, memory_order_relaxed);
+}
+
+static AggregatorSample aggregatorGetSample(const AggregatorRing* const ring, const uint64_t index)
+{
+    const AggregatorSlot* const slot = &ring->slots[index % AGGREGATOR_HISTORY_CAPACITY];
+    const uint32_t              bits = atomic_load_explicit(&slot->distance_bits, memory_order_relaxed);
+    AggregatorSample            out  = {atomic_load_explicit(&slot->timestamp_usec, memory_order_relaxed), 0.0F};
+    (void) memcpy(&out.distance_cm, &bits, sizeof(bits));
+    return out;
+}
+
+/// The oldest index of the ring that is safe to read and in order, given the head read by the reader. A reset after
+/// the head was read leaves nothing to read: the samples before it are discarded and those after it are not visible.
+static uint64_t aggregatorGetOldest(const AggregatorRing* const ring, const uint64_t head)
+{
+    const uint64_t first  = atomic_load_explicit(&ring->first, memory_order_relaxed);
+    const uint64_t oldest = (head > AGGREGATOR_READABLE) ? (head - AGGREGATOR_READABLE) : 0U;
+    return (first > head) ? head : ((first > oldest) ? first : oldest);
+}
+
+void aggregatorInit(Aggregator* const aggregator)
+{
+    (void) memset(aggregator, 0, sizeof(Aggregator));
+    for (size_t i = 0; i <= CANARD_NODE_ID_MAX; i++)
+    {
+        atomic_init(&aggregator->latest[i].sequence, 0U);
+        atomic_init(&aggregator->latest[i].distance_bits, 0U);
+        atomic_init(&aggregator->latest[i].timestamp_usec, 0U);
+        atomic_init(&aggregator->latest[i].count, 0U);
+        atomic_init(&aggregator->rings[i], NULL);
+    }
+    atomic_init(&aggregator->dropped, 0U);
+}
+
+void aggregatorFree(Aggregator* const aggregator)
+{
+    for (size_t i = 0; i <= CANARD_NODE_ID_MAX; i++)
+    {
+        free(atomic_load(&aggregator->rings[i]));
+        atomic_store(&aggregator->rings[i], NULL);
+    }
+}
+
+int aggregatorAccept(Aggregator* const aggregator, const CanardTransfer* const transfer)
+{
+    const CanardDSDLView view = {(const uint8_t*) transfer->payload, transfer->payload_size};
+    return aggregatorUpdate(aggregator,
+                            transfer->remote_node_id,
+                            transfer->timestamp_usec,
+                            ultrasoundDistanceGetCentimeters(view));
+}
+
+int aggregatorUpdate(Aggregator* const  aggregator,
+                     const CanardNodeID node_id,
+                     const uint64_t     timestamp_usec,
+                     const float        distance_cm)
+{
+    if (node_id > CANARD_NODE_ID_MAX)
+    {
+        (void) atomic_fetch_add_explicit(&aggregator->dropped, 1U, memory_order_relaxed);
+        return -EINVAL;
+    }
+    AggregatorRing* ring = atomic_load_explicit(&aggregator->rings[node_id], memory_order_relaxed);
+    if (ring == NULL)
+    {
+        ring = calloc(1U, sizeof(AggregatorRing));
+        if (ring == NULL)
+        {
+            (void) atomic_fetch_add_explicit(&aggregator->dropped, 1U, memory_order_relaxed);
+            return -ENOMEM;
+        }
+        atomic_init(&ring->head, 0U);
+        atomic_init(&ring->first, 0U);
+        for (size_t i = 0; i < AGGREGATOR_HISTORY_CAPACITY; i++)
+        {
+            atomic_init(&ring->slots[i].timestamp_usec, 0U);
+            atomic_init(&ring->slots[i].distance_bits, 0U);
+        }
+        atomic_store_explicit(&aggregator->rings[node_id], ring, memory_order_release);
+    }
+    uint32_t bits = 0U;
+    (void) memcpy(&bits, &distance_cm, sizeof(bits));
+
+    // The reset is published by the release of the head below, before which no reader can see the new sample.
+    const uint64_t head  = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    const uint64_t first = atomic_load_explicit(&ring->first, memory_order_relaxed);
+    if ((head > first) && (timestamp_usec < aggregatorGetTimestamp(ring, head - 1U)))
+    {
+        atomic_store_explicit(&ring->first, head, memory_order_relaxed);
+    }
+    // A reader that sees the slot being overwritten sees the head of this sample at least: it discards its copy.
+    atomic_thread_fence(memory_order_release);
+    AggregatorSlot* const slot = &ring->slots[head % AGGREGATOR_HISTORY_CAPACITY];
+    atomic_store_explicit(&slot->timestamp_usec, timestamp_usec, memory_order_relaxed);
+    atomic_store_explicit(&slot->distance_bits, bits, memory_order_relaxed);
+    atomic_store_explicit(&ring->head, head + 1U, memory_order_release);
+
+    AggregatorLatest* const latest   = &aggregator->latest[node_id];
+    const uint32_t          sequence = atomic_load_explicit(&latest->sequence, memory_order_relaxed);
+    atomic_store_explicit(&latest->sequence, sequence + 1U, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&latest->distance_bits, bits, memory_order_relaxed);
+    atomic_store_explicit(&latest->timestamp_usec, timestamp_usec, memory_order_relaxed);
+    atomic_store_explicit(&latest->count, head + 1U, memory_order_relaxed);
+    atomic_store_explicit(&latest->sequence, sequence + 2U, memory_order_release);
+    return 0;
+}
+
+bool aggregatorGetLatest(const Aggregator* const aggregator,
+                         const CanardNodeID      node_id,
+                         AggregatorSample* const out_sample)
+{
+    if (node_id > CANARD_NODE_ID_MAX)
+    {
+        return false;
+    }
+    const AggregatorLatest* const latest = &aggregator->latest[node_id];
+    uint32_t                      bits   = 0U;
+    uint64_t                      count  = 0U;
+    uint32_t                      before = 0U;
+    uint32_t                      after  = 0U;
+    do
+    {
+        before                     = atomic_load_explicit(&latest->sequence, memory_order_acquire);
+        bits                       = atomic_load_explicit(&latest->distance_bits, memory_order_relaxed);
+        out_sample->timestamp_usec = atomic_load_explicit(&latest->timestamp_usec, memory_order_relaxed);
+        count                      = atomic_load_explicit(&latest->count, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&latest->sequence, memory_order_relaxed);
+    } while (((before % 2U) != 0U) || (before != after));
+    (void) memcpy(&out_sample->distance_cm, &bits, sizeof(bits));
+    return count > 0U;
+}
+
+/// The first index in [lo, hi) of a sample later than the timestamp; hi if none.
+static uint64_t aggregatorSearchAfter(const AggregatorRing* const ring,
+                                      uint64_t                    lo,
+                                      uint64_t                    hi,
+                                      const uint64_t              timestamp_usec)
+{
+    while (lo < hi)
+    {
+        const uint64_t mid = lo + ((hi - lo) / 2U);
+        if (aggregatorGetTimestamp(ring, mid) > timestamp_usec)
+        {
+            hi = mid;
+        }
+        else
+        {
+            lo = mid + 1U;
+        }
+    }
+    return lo;
+}
+
+/// Whether the samples from the oldest index on were not overwritten while the ring was read.
+static bool aggregatorIsIntact(const AggregatorRing* const ring, const uint64_t oldest)
+{
+    atomic_thread_fence(memory_order_acquire);
+    const uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    return (head + 1U) <= (oldest + AGGREGATOR_HISTORY_CAPACITY);
+}
+
+static const AggregatorRing* aggregatorGetRing(const Aggregator* const aggregator, const CanardNodeID node_id)
+{
+    return (node_id <= CANARD_NODE_ID_MAX) ? atomic_load_explicit(&aggregator->rings[node_id], memory_order_acquire)
+                                           : NULL;
+}
+
+int aggregatorGetNearest(const Aggregator* const aggregator,
+                         const CanardNodeID      node_id,
+                         const uint64_t          timestamp_usec,
+                         AggregatorSample* const out_sample)
+{
+    const AggregatorRing* const ring = aggregatorGetRing(aggregator, node_id);
+    if (ring == NULL)
+    {
+        return 0;
+    }
+    for (size_t attempt = 0; attempt < AGGREGATOR_READ_ATTEMPTS; attempt++)
+    {
+        const uint64_t head   = atomic_load_explicit(&ring->head, memory_order_acquire);
+        const uint64_t oldest = aggregatorGetOldest(ring, head);
+        if (head == oldest)
+        {
+            return 0;
+        }
+        // The nearest sample is either the first one later than the timestamp or the one before it.
+        const uint64_t after = aggregatorSearchAfter(ring, oldest, head, timestamp_usec);
+        uint64_t       index = after;
+        if ((after == head) || ((after > oldest) && ((timestamp_usec - aggregatorGetTimestamp(ring, after - 1U)) <=
+                                                     (aggregatorGetTimestamp(ring, after) - timestamp_usec))))
+        {
+            index = after - 1U;
+        }
+        const AggregatorSample sample = aggregatorGetSample(ring, index);
+        if (aggregatorIsIntact(ring, oldest))
+        {
+            *out_sample = sample;
+            return 1;
+        }
+    }
+    return -EAGAIN;
+}
+
+int aggregatorGetNewer(const Aggregator* const aggregator,
+                       const CanardNodeID      node_id,
+                       const uint64_t          since_usec,
+                       AggregatorSample* const out_samples,
+                       const size_t            capacity)
+{
+    const AggregatorRing* const ring = aggregatorGetRing(aggregator, node_id);
+    if (ring == NULL)
+    {
+        return 0;
+    }
+    for (size_t attempt = 0; attempt < AGGREGATOR_READ_ATTEMPTS; attempt++)
+    {
+        const uint64_t head      = atomic_load_explicit(&ring->head, memory_order_acquire);
+        const uint64_t oldest    = aggregatorGetOldest(ring, head);
+        const uint64_t first     = aggregatorSearchAfter(ring, oldest, head, since_usec);
+        const uint64_t available = head - first;
+        const size_t   count     = (available < capacity) ? (size_t) available : capacity;
+        for (size_t i = 0; i < count; i++)
+        {
+            out_samples[i] = aggregatorGetSample(ring, first + i);
+        }
+        if (aggregatorIsIntact(ring, oldest))
+        {
+            return (int) count;
+        }
+    }
+    return -EAGAIN;
+}
@@ -0,0 +1,123 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Master-side aggregation of the distance messages (subject 1610) of all nodes on the bus: a table of the latest
+/// reading of every node and a history ring per node, updated in O(1) per received transfer by the thread that runs
+/// canardRxAccept(), and queried without locks by any number of consumer threads. There shall be a single writer:
+/// aggregatorAccept() and aggregatorUpdate() shall be invoked from one thread only, or serialized by the application.
+///
+/// The latest readings are kept in one table indexed by the node-ID, so that a consumer that scans all nodes touches
+/// a few cache lines per node instead of their rings. Each entry is guarded by a sequence lock: the writer makes the
+/// sequence number odd, updates the entry, and makes it even again; a reader retries if the number was odd or changed
+/// while it read the entry. The writer never waits for the readers.
+///
+/// The rings are allocated on the first transfer of each node and are never freed until aggregatorFree(), so that
+/// the readers can keep the pointers. A ring is read with the same idiom as a sequence lock, the head being the
+/// sequence number: the reader takes the head before and after copying the samples, never reads the oldest
+/// AGGREGATOR_READ_MARGIN slots, which the writer overwrites next, like the sample history of the node (src/history.h),
+/// and discards the copy if the writer lapped it regardless; the query is then retried up to AGGREGATOR_READ_ATTEMPTS
+/// times and fails with -EAGAIN. The slots are accessed with relaxed atomics, so a torn slot is never acted upon, and
+/// the accesses are not data races.
+///
+/// The samples of a node are expected in the order of their timestamps, which is the case for the reception
+/// timestamps of a single socket; the queries by time use a binary search in the ring. A sample older than the newest
+/// one in the ring of its node, e.g., after a step of the clock, discards the samples kept so far, so that the ring is
+/// always in order.
+
+#ifndef AGGREGATOR_H_INCLUDED
+#define AGGREGATOR_H_INCLUDED
+
+#include <canard.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Shall be a power of two. 4096 samples hold 4 s at 1 kHz or 3.4 minutes at 20 Hz; 64 KiB per node.
+#define AGGREGATOR_HISTORY_CAPACITY 4096U
+#define AGGREGATOR_READ_MARGIN 64U
+#define AGGREGATOR_READ_ATTEMPTS 4U
+
+typedef struct AggregatorSample
+{
+    uint64_t timestamp_usec;
+    float    distance_cm;
+} AggregatorSample;
+
+typedef struct AggregatorLatest
+{
+    _Atomic uint32_t sequence;  ///< Odd while the entry is being written.
+    _Atomic uint32_t distance_bits;
+    _Atomic uint64_t timestamp_usec;
+    _Atomic uint64_t count;  ///< The number of samples received from the node; zero if none.
+} AggregatorLatest;
+
+/// A sample as stored in a ring, where it may be read while it is written.
+typedef struct AggregatorSlot
+{
+    _Atomic uint64_t timestamp_usec;
+    _Atomic uint32_t distance_bits;
+} AggregatorSlot;
+
+typedef struct AggregatorRing
+{
+    _Atomic uint64_t head;   ///< The number of samples appended so far; the next one goes to head % capacity.
+    _Atomic uint64_t first;  ///< The index of the oldest sample in order; those before it were discarded.
+    AggregatorSlot   slots[AGGREGATOR_HISTORY_CAPACITY];
+} AggregatorRing;
+
+typedef struct Aggregator
+{
+    AggregatorLatest latest[CANARD_NODE_ID_MAX + 1U];
+    AggregatorRing* _Atomic rings[CANARD_NODE_ID_MAX + 1U];  ///< NULL until the first sample of the node.
+    _Atomic uint64_t        dropped;  ///< The samples that could not be stored, for the lack of memory or a node-ID.
+} Aggregator;
+
+void aggregatorInit(Aggregator* const aggregator);
+
+/// Frees the rings; no reader shall access the aggregator after this.
+void aggregatorFree(Aggregator* const aggregator);
+
+/// Stores a distance transfer received from the subject; the timestamp of the sample is that of the transfer.
+/// Shall be invoked from one thread only. Returns zero on success, negated errno on failure: -EINVAL if the publisher
+/// is anonymous, -ENOMEM if the ring of a new node could not be allocated.
+int aggregatorAccept(Aggregator* const aggregator, const CanardTransfer* const transfer);
+
+/// The same as aggregatorAccept() for a sample that was decoded elsewhere. Shall be invoked from one thread only.
+int aggregatorUpdate(Aggregator* const  aggregator,
+                     const CanardNodeID node_id,
+                     const uint64_t     timestamp_usec,
+                     const float        distance_cm);
+
+/// The latest reading of the node. Returns false if nothing has been received from it. Wait-free for the writer;
+/// the reader retries while the entry is being written, which takes a few nanoseconds.
+bool aggregatorGetLatest(const Aggregator* const  aggregator,
+                         const CanardNodeID       node_id,
+                         AggregatorSample* const  out_sample);
+
+/// The reading of the node closest in time to the timestamp, among those kept in the ring. Returns 1 if found, zero
+/// if the ring is empty, -EAGAIN if the writer kept overwriting the ring. The time complexity is logarithmic.
+int aggregatorGetNearest(const Aggregator* const aggregator,
+                         const CanardNodeID      node_id,
+                         const uint64_t          timestamp_usec,
+                         AggregatorSample* const out_sample);
+
+/// The readings of the node newer than the timestamp, oldest first, at most capacity of them; pass the timestamp of
+/// the last reading returned to get the next ones. Returns the number of readings, or -EAGAIN if the writer kept
+/// overwriting the ring. The time complexity is logarithmic in the size of the ring plus linear in the output.
+int aggregatorGetNewer(const Aggregator* const aggregator,
+                       const CanardNodeID      node_id,
+                       const uint64_t          since_usec,
+                       AggregatorSample* const out_samples,
+                       const size_t            capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
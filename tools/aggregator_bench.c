@@ -0,0 +1,162 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Load test of the aggregator (aggregator.h): one writer feeds all 128 node-IDs with 1 kHz streams of synthetic
+/// samples as fast as it can while the reader threads query random nodes: the latest reading, the nearest reading to
+/// a recent time, and the readings newer than the last one they saw. The distance of every sample is a function of
+/// its node and timestamp, so a reader detects any torn or misplaced sample. Reported: the cost of an update, the
+/// update rate against the 128 kHz of a bus full of 1 kHz nodes, and the queries of the readers with their failures.
+///
+///     aggregator-bench [<seconds> [<readers>]]
+
+#include "aggregator.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NODES (CANARD_NODE_ID_MAX + 1U)
+#define PERIOD_USEC 1000U
+#define NEWER_CAPACITY 256U
+#define READERS_MAX 16U
+
+typedef struct Reader
+{
+    pthread_t         thread;
+    const Aggregator* aggregator;
+    unsigned          seed;
+    uint64_t          queries;
+    uint64_t          torn;  ///< Samples that do not match their timestamp or come out of order.
+    uint64_t          retries_exhausted;
+} Reader;
+
+static atomic_bool Stop;
+
+static uint64_t getMonotonicNanoseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+/// The node-IDs are interleaved within the period, so that the nodes are not all sampled at the same time.
+static uint64_t getTimestamp(const uint64_t step, const size_t node)
+{
+    return (step * PERIOD_USEC) + node;
+}
+
+static float getDistance(const uint64_t timestamp_usec, const size_t node)
+{
+    return (float) ((timestamp_usec * 7U + node) % 40000U) * 0.01F;
+}
+
+static bool isValid(const AggregatorSample* const sample, const size_t node)
+{
+    return ((sample->timestamp_usec % PERIOD_USEC) == node) &&
+           (sample->distance_cm == getDistance(sample->timestamp_usec, node));
+}
+
+static void* readerThread(void* const user)
+{
+    Reader* const    reader = (Reader*) user;
+    uint64_t         since[NODES] = {0};
+    AggregatorSample samples[NEWER_CAPACITY];
+    while (!atomic_load(&Stop))
+    {
+        const size_t     node   = (size_t) rand_r(&reader->seed) % NODES;
+        AggregatorSample latest = {0};
+        if (aggregatorGetLatest(reader->aggregator, (CanardNodeID) node, &latest))
+        {
+            reader->torn += isValid(&latest, node) ? 0U : 1U;
+            // Somewhere in the last second, which is in the ring.
+            const uint64_t   back    = (uint64_t) rand_r(&reader->seed) % 1000000U;
+            const uint64_t   target  = (latest.timestamp_usec > back) ? (latest.timestamp_usec - back) : 0U;
+            AggregatorSample nearest = {0};
+            const int        found   = aggregatorGetNearest(reader->aggregator, (CanardNodeID) node, target, &nearest);
+            reader->torn += ((found == 1) && !isValid(&nearest, node)) ? 1U : 0U;
+            reader->retries_exhausted += (found < 0) ? 1U : 0U;
+        }
+        const int count =
+            aggregatorGetNewer(reader->aggregator, (CanardNodeID) node, since[node], &samples[0], NEWER_CAPACITY);
+        reader->retries_exhausted += (count < 0) ? 1U : 0U;
+        for (int i = 0; i < count; i++)
+        {
+            reader->torn += (isValid(&samples[i], node) && (samples[i].timestamp_usec > since[node])) ? 0U : 1U;
+            since[node] = samples[i].timestamp_usec;
+        }
+        reader->queries += 3U;
+    }
+    return NULL;
+}
+
+int main(const int argc, const char* const argv[])
+{
+    const double seconds     = (argc > 1) ? atof(argv[1]) : 3.0;
+    const size_t num_readers = (argc > 2) ? (size_t) atoi(argv[2]) : 3U;
+    if ((seconds <= 0.0) || (num_readers > READERS_MAX))
+    {
+        (void) fprintf(stderr, "Usage: %s [<seconds> [<readers, at most %u>]]\n", argv[0], READERS_MAX);
+        return 1;
+    }
+    static Aggregator aggregator;
+    aggregatorInit(&aggregator);
+    atomic_init(&Stop, false);
+    static Reader readers[READERS_MAX];
+    for (size_t i = 0; i < num_readers; i++)
+    {
+        readers[i].aggregator = &aggregator;
+        readers[i].seed       = (unsigned) i + 1U;
+        if (pthread_create(&readers[i].thread, NULL, &readerThread, &readers[i]) != 0)
+        {
+            (void) fprintf(stderr, "Could not start the reader threads\n");
+            return 1;
+        }
+    }
+
+    // The clock is read once per step of 128 updates, which costs little in comparison.
+    const uint64_t started  = getMonotonicNanoseconds();
+    const uint64_t deadline = started + (uint64_t) (seconds * 1e9);
+    uint64_t       step     = 0U;
+    uint64_t       finished = started;
+    while (finished < deadline)
+    {
+        for (size_t node = 0; node < NODES; node++)
+        {
+            const uint64_t timestamp_usec = getTimestamp(step, node);
+            (void) aggregatorUpdate(&aggregator, (CanardNodeID) node, timestamp_usec, getDistance(timestamp_usec, node));
+        }
+        step++;
+        finished = getMonotonicNanoseconds();
+    }
+    atomic_store(&Stop, true);
+
+    uint64_t queries = 0U;
+    uint64_t torn    = 0U;
+    uint64_t retries = 0U;
+    for (size_t i = 0; i < num_readers; i++)
+    {
+        (void) pthread_join(readers[i].thread, NULL);
+        queries += readers[i].queries;
+        torn += readers[i].torn;
+        retries += readers[i].retries_exhausted;
+    }
+    const uint64_t updates = step * NODES;
+    const double   elapsed = (double) (finished - started) * 1e-9;
+    (void) printf("%llu updates in %.2f s: %.1f ns per update, %.2f M updates/s, %.0fx the load of %u nodes",
+                  (unsigned long long) updates,
+                  elapsed,
+                  (double) (finished - started) / (double) updates,
+                  (double) updates / elapsed * 1e-6,
+                  (double) updates / elapsed / (double) (NODES * (1000000U / PERIOD_USEC)),
+                  (unsigned) NODES);
+    (void) printf(" at 1 kHz\n");
+    (void) printf("%zu readers: %llu queries, %.2f M queries/s, %llu torn samples, %llu queries out of retries\n",
+                  num_readers,
+                  (unsigned long long) queries,
+                  (double) queries / elapsed * 1e-6,
+                  (unsigned long long) torn,
+                  (unsigned long long) retries);
+    aggregatorFree(&aggregator);
+    return (torn == 0U) ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Measures the hot paths of the node that are affected by the code generation options: the publication of the
+/// distance message (DSDL serialization, canardTxPush(), canardTxPeek(), canardTxPop()) and the reception of the
+/// same message (canardRxAccept() and the DSDL deserialization). The socket I/O is left out because the system call
+/// overhead would hide the difference between the variants. Build variants (see CMakeLists.txt):
+///
+///     codegen-bench           Separate translation units.
+///     codegen-bench-unity     Single translation unit, built like the amalgamated node; see codegen_bench_unity.c.
+///
+/// Either can be combined with the ENABLE_LTO and TARGET_CPU options.
+///
+///     codegen-bench [iterations]
+
+#include <canard.h>
+#include <canard_dsdl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define DISTANCE_SUBJECT_ID 1610U
+#define REMOTE_NODE_ID 43U
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    return malloc(amount);
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    free(pointer);
+}
+
+static uint64_t getMonotonicNanoseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+/// Same as publishUltrasoundDistance() in main.c followed by the transmission loop, minus the socket.
+static double benchPublish(const size_t iterations)
+{
+    CanardInstance ins = canardInit(&memAllocate, &memFree);
+    ins.mtu_bytes      = CANARD_MTU_CAN_CLASSIC;
+    ins.node_id        = 42U;
+    uint32_t checksum  = 0;
+
+    const uint64_t started = getMonotonicNanoseconds();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        uint8_t payload[4] = {0, 0, 0, 0};
+        canardDSDLSetF32(payload, 0, (float) i * 0.01F);
+        const CanardTransfer transfer = {
+            .timestamp_usec = i,
+            .priority       = CanardPriorityNominal,
+            .transfer_kind  = CanardTransferKindMessage,
+            .port_id        = DISTANCE_SUBJECT_ID,
+            .remote_node_id = CANARD_NODE_ID_UNSET,
+            .transfer_id    = (CanardTransferID) i,
+            .payload_size   = sizeof(payload),
+            .payload        = &payload[0],
+        };
+        (void) canardTxPush(&ins, &transfer);
+        for (const CanardFrame* txf = canardTxPeek(&ins); txf != NULL; txf = canardTxPeek(&ins))
+        {
+            checksum += txf->extended_can_id + ((const uint8_t*) txf->payload)[0];
+            canardTxPop(&ins);
+            ins.memory_free(&ins, (void*) txf);
+        }
+    }
+    const uint64_t elapsed = getMonotonicNanoseconds() - started;
+    if (checksum == 0U)
+    {
+        (void) printf("(unexpected checksum)\n");
+    }
+    return (double) elapsed / (double) iterations;
+}
+
+/// The reception of the distance message published by a remote node, including the deserialization.
+static double benchReceive(const size_t iterations)
+{
+    CanardInstance ins = canardInit(&memAllocate, &memFree);
+    ins.node_id        = 42U;
+    CanardRxSubscription subscription;
+    (void) canardRxSubscribe(&ins,
+                             CanardTransferKindMessage,
+                             DISTANCE_SUBJECT_ID,
+                             4U,
+                             CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                             &subscription);
+    // A single-frame transfer: 4 bytes of payload and the tail byte.
+    uint8_t     frame_payload[5] = {0, 0, 0, 0, 0};
+    CanardFrame frame            = {
+        .timestamp_usec  = 0U,
+        .extended_can_id = (UINT32_C(4) << 26U) | (UINT32_C(3) << 21U) | (DISTANCE_SUBJECT_ID << 8U) | REMOTE_NODE_ID,
+        .payload_size    = sizeof(frame_payload),
+        .payload         = frame_payload,
+    };
+    float sum = 0.0F;
+
+    const uint64_t started = getMonotonicNanoseconds();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        canardDSDLSetF32(frame_payload, 0, (float) i * 0.01F);
+        frame_payload[4]     = (uint8_t)(0xE0U | (i & CANARD_TRANSFER_ID_MAX));  // SOT, EOT, toggle.
+        frame.timestamp_usec = i;
+        CanardTransfer transfer;
+        if (canardRxAccept(&ins, &frame, 0, &transfer) > 0)
+        {
+            sum += canardDSDLGetF32((const uint8_t*) transfer.payload, transfer.payload_size, 0);
+            ins.memory_free(&ins, (void*) transfer.payload);
+        }
+    }
+    const uint64_t elapsed = getMonotonicNanoseconds() - started;
+    if (!(sum > 0.0F))
+    {
+        (void) printf("(unexpected sum)\n");
+    }
+    return (double) elapsed / (double) iterations;
+}
+
+/// The hot functions of the paths above timed in isolation, so that their speedups can be reported individually.
+static double benchSetF32(const size_t iterations)
+{
+    uint8_t        buffer[4] = {0, 0, 0, 0};
+    uint32_t       checksum  = 0;
+    const uint64_t started   = getMonotonicNanoseconds();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        canardDSDLSetF32(buffer, (i & 1U) * 3U, (float) i * 0.01F);
+        checksum += buffer[1];
+    }
+    const uint64_t elapsed = getMonotonicNanoseconds() - started;
+    if (checksum == 0U)
+    {
+        (void) printf("(unexpected checksum)\n");
+    }
+    return (double) elapsed / (double) iterations;
+}
+
+static double benchGetF32(const size_t iterations)
+{
+    uint8_t        buffer[5] = {0x12, 0x34, 0x56, 0x78, 0x9A};
+    float          sum       = 0.0F;
+    const uint64_t started   = getMonotonicNanoseconds();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        buffer[0] = (uint8_t) i;
+        sum += canardDSDLGetF32(buffer, sizeof(buffer), (i & 1U) * 3U);
+    }
+    const uint64_t elapsed = getMonotonicNanoseconds() - started;
+    if (sum == 0.0F)
+    {
+        (void) printf("(unexpected sum)\n");
+    }
+    return (double) elapsed / (double) iterations;
+}
+
+int main(const int argc, const char* const argv[])
+{
+    const size_t iterations = (argc > 1) ? (size_t) strtoul(argv[1], NULL, 10) : 10000000U;
+    // The first two lines are the complete paths; the rest are the individual functions.
+    (void) printf("publish           %6.1f ns\n", benchPublish(iterations));
+    (void) printf("receive           %6.1f ns\n", benchReceive(iterations));
+    (void) printf("canardDSDLSetF32  %6.1f ns\n", benchSetF32(iterations));
+    (void) printf("canardDSDLGetF32  %6.1f ns\n", benchGetF32(iterations));
+    return 0;
+}
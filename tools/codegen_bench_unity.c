@@ -0,0 +1,10 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// The single-translation-unit variant of codegen_bench.c, see src/amalgamation.c.
+
+#include "../libcanard/canard.c"
+#include "../libcanard/canard_dsdl.c"
+
+#include "codegen_bench.c"
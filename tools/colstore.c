@@ -0,0 +1,509 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "colstore.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define FILE_MAGIC "DCOL1\0\0"  // Eight bytes with the implicit terminator.
+#define CHUNK_MAGIC 0x4B4E4843UL  // "CHNK"
+#define INDEX_SUFFIX ".idx"
+#define PATH_SIZE_MAX 4096U
+
+/// The worst case of a column: full-width blocks with their width bytes.
+#define COLUMN_SIZE_MAX (((COLSTORE_CHUNK_SAMPLES_MAX / COLSTORE_BLOCK_SIZE) + 1U) + (COLSTORE_CHUNK_SAMPLES_MAX * 8U))
+
+static void putU16(uint8_t* const out, const uint16_t value)
+{
+    out[0] = (uint8_t) value;
+    out[1] = (uint8_t)(value >> 8U);
+}
+
+static void putU32(uint8_t* const out, const uint32_t value)
+{
+    putU16(out, (uint16_t) value);
+    putU16(&out[2], (uint16_t)(value >> 16U));
+}
+
+static void putU64(uint8_t* const out, const uint64_t value)
+{
+    putU32(out, (uint32_t) value);
+    putU32(&out[4], (uint32_t)(value >> 32U));
+}
+
+static uint16_t getU16(const uint8_t* const in)
+{
+    return (uint16_t)(in[0] | (uint16_t)(in[1] << 8U));
+}
+
+static uint32_t getU32(const uint8_t* const in)
+{
+    return getU16(in) | ((uint32_t) getU16(&in[2]) << 16U);
+}
+
+static uint64_t getU64(const uint8_t* const in)
+{
+    return getU32(in) | ((uint64_t) getU32(&in[4]) << 32U);
+}
+
+static uint64_t zigzagEncode(const int64_t value)
+{
+    return ((uint64_t) value << 1U) ^ (uint64_t)(value >> 63U);
+}
+
+static int64_t zigzagDecode(const uint64_t value)
+{
+    return (int64_t)(value >> 1U) ^ -(int64_t)(value & 1U);
+}
+
+static uint32_t floatToBits(const float value)
+{
+    uint32_t bits = 0;
+    (void) memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static float floatFromBits(const uint32_t bits)
+{
+    float value = 0;
+    (void) memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static uint8_t bitWidth(uint64_t value)
+{
+    uint8_t width = 0;
+    while (value != 0U)
+    {
+        width++;
+        value >>= 1U;
+    }
+    return width;
+}
+
+/// The output buffer shall be zeroed.
+static void putBits(uint8_t* const out, size_t bit_offset, uint64_t value, uint8_t width)
+{
+    while (width > 0U)
+    {
+        const uint8_t shift = (uint8_t)(bit_offset % 8U);
+        const uint8_t size  = (uint8_t)(((8U - shift) < width) ? (8U - shift) : width);
+        out[bit_offset / 8U] |= (uint8_t)((value & ((1U << size) - 1U)) << shift);
+        value      = (size < 64U) ? (value >> size) : 0U;
+        width      = (uint8_t)(width - size);
+        bit_offset += size;
+    }
+}
+
+static uint64_t getBits(const uint8_t* const in, size_t bit_offset, const uint8_t width)
+{
+    uint64_t value = 0;
+    uint8_t  done  = 0;
+    while (done < width)
+    {
+        const uint8_t shift = (uint8_t)(bit_offset % 8U);
+        const uint8_t left  = (uint8_t)(width - done);
+        const uint8_t size  = (uint8_t)(((8U - shift) < left) ? (8U - shift) : left);
+        value |= (uint64_t)((in[bit_offset / 8U] >> shift) & ((1U << size) - 1U)) << done;
+        done = (uint8_t)(done + size);
+        bit_offset += size;
+    }
+    return value;
+}
+
+/// Bit-packs the values in blocks; returns the number of bytes written into the zeroed output.
+static size_t packColumn(const uint64_t* const values, const size_t count, uint8_t* const out)
+{
+    size_t size = 0;
+    for (size_t begin = 0; begin < count; begin += COLSTORE_BLOCK_SIZE)
+    {
+        const size_t end     = ((begin + COLSTORE_BLOCK_SIZE) < count) ? (begin + COLSTORE_BLOCK_SIZE) : count;
+        uint64_t     all_ors = 0;
+        for (size_t i = begin; i < end; i++)
+        {
+            all_ors |= values[i];
+        }
+        const uint8_t width = bitWidth(all_ors);
+        out[size++]         = width;
+        for (size_t i = begin; i < end; i++)
+        {
+            putBits(&out[size], (i - begin) * width, values[i], width);
+        }
+        size += (((end - begin) * width) + 7U) / 8U;
+    }
+    return size;
+}
+
+/// Returns the number of bytes consumed, zero if the input is truncated or malformed.
+static size_t unpackColumn(const uint8_t* const in, const size_t in_size, const size_t count, uint64_t* const values)
+{
+    size_t size = 0;
+    for (size_t begin = 0; begin < count; begin += COLSTORE_BLOCK_SIZE)
+    {
+        const size_t end = ((begin + COLSTORE_BLOCK_SIZE) < count) ? (begin + COLSTORE_BLOCK_SIZE) : count;
+        if (size >= in_size)
+        {
+            return 0;
+        }
+        const uint8_t width       = in[size++];
+        const size_t  block_bytes = (((end - begin) * width) + 7U) / 8U;
+        if ((width > 64U) || ((size + block_bytes) > in_size))
+        {
+            return 0;
+        }
+        for (size_t i = begin; i < end; i++)
+        {
+            values[i] = getBits(&in[size], (i - begin) * width, width);
+        }
+        size += block_bytes;
+    }
+    return size;
+}
+
+static void makeIndexPath(char* const out, const char* const path)
+{
+    (void) snprintf(out, PATH_SIZE_MAX, "%s%s", path, INDEX_SUFFIX);
+}
+
+/// Discards the incomplete chunk at the end of the data, if any, and rewrites the index from the valid chunks.
+static int colstoreRecover(const char* const path, const char* const index_path, uint64_t* const out_end)
+{
+    ColStoreReader reader;
+    int            result = colstoreReaderOpen(&reader, path);
+    if (result != 0)
+    {
+        return result;
+    }
+    *out_end = reader.end;
+    result   = (truncate(path, (off_t) reader.end) == 0) ? 0 : -errno;
+    FILE* const index = (result == 0) ? fopen(index_path, "wb") : NULL;
+    result            = ((result == 0) && (index == NULL)) ? -errno : result;
+    for (size_t i = 0; (result == 0) && (i < reader.num_chunks); i++)
+    {
+        uint8_t entry[COLSTORE_INDEX_ENTRY_SIZE];
+        (void) memset(entry, 0, sizeof(entry));
+        putU64(&entry[0], reader.chunks[i].first_timestamp_usec);
+        putU64(&entry[8], reader.chunks[i].last_timestamp_usec);
+        putU64(&entry[16], reader.chunks[i].offset);
+        putU32(&entry[24], reader.chunks[i].count);
+        result = (fwrite(entry, 1, sizeof(entry), index) == sizeof(entry)) ? 0 : -EIO;
+    }
+    if ((index != NULL) && (fclose(index) != 0) && (result == 0))
+    {
+        result = -EIO;
+    }
+    colstoreReaderClose(&reader);
+    return result;
+}
+
+int colstoreWriterOpen(ColStoreWriter* const writer,
+                       const char* const     path,
+                       const CanardPortID    subject_id,
+                       const CanardNodeID    node_id)
+{
+    (void) memset(writer, 0, sizeof(ColStoreWriter));
+    char index_path[PATH_SIZE_MAX];
+    makeIndexPath(index_path, path);
+
+    // A file without a complete header is treated as new.
+    bool        exists   = false;
+    int         result   = 0;
+    FILE* const existing = fopen(path, "rb");
+    if (existing != NULL)
+    {
+        uint8_t header[COLSTORE_FILE_HEADER_SIZE];
+        exists = fread(header, 1, sizeof(header), existing) == sizeof(header);
+        (void) fclose(existing);
+        if (exists)
+        {
+            const bool valid = (0 == memcmp(header, FILE_MAGIC, 8U)) && (getU16(&header[8]) == subject_id) &&
+                               (getU16(&header[10]) == node_id);
+            result           = valid ? colstoreRecover(path, index_path, &writer->offset) : -EINVAL;
+        }
+    }
+    if (result == 0)
+    {
+        writer->data = fopen(path, exists ? "ab" : "wb");
+        result       = (writer->data != NULL) ? 0 : -errno;
+    }
+    if ((result == 0) && !exists)
+    {
+        uint8_t header[COLSTORE_FILE_HEADER_SIZE];
+        (void) memset(header, 0, sizeof(header));
+        (void) memcpy(header, FILE_MAGIC, 8U);
+        putU16(&header[8], subject_id);
+        putU16(&header[10], node_id);
+        putU32(&header[12], COLSTORE_CHUNK_SAMPLES_MAX);
+        result         = (fwrite(header, 1, sizeof(header), writer->data) == sizeof(header)) ? 0 : -EIO;
+        writer->offset = sizeof(header);
+    }
+    if (result == 0)
+    {
+        writer->index = fopen(index_path, exists ? "ab" : "wb");
+        result        = (writer->index != NULL) ? 0 : -errno;
+    }
+    if ((result != 0) && (writer->data != NULL))
+    {
+        (void) fclose(writer->data);
+        writer->data = NULL;
+    }
+    return result;
+}
+
+static int colstoreWriteChunk(ColStoreWriter* const writer)
+{
+    static uint64_t deltas[COLSTORE_CHUNK_SAMPLES_MAX];
+    static uint8_t  buffer[COLSTORE_CHUNK_HEADER_SIZE + (2U * COLUMN_SIZE_MAX)];
+    const size_t    count = writer->count;
+    (void) memset(buffer, 0, sizeof(buffer));
+
+    // Timestamps: delta of deltas. Values: delta of the bit patterns.
+    int64_t previous_delta = 0;
+    for (size_t i = 1; i < count; i++)
+    {
+        const int64_t delta = (int64_t)(writer->timestamps_usec[i] - writer->timestamps_usec[i - 1U]);
+        deltas[i - 1U]      = zigzagEncode(delta - previous_delta);
+        previous_delta      = delta;
+    }
+    const size_t ts_size = packColumn(deltas, count - 1U, &buffer[COLSTORE_CHUNK_HEADER_SIZE]);
+    uint32_t     previous_bits = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const uint32_t bits = floatToBits(writer->values[i]);
+        deltas[i]           = zigzagEncode((int64_t) bits - (int64_t) previous_bits);
+        previous_bits       = bits;
+    }
+    const size_t value_size = packColumn(deltas, count, &buffer[COLSTORE_CHUNK_HEADER_SIZE + ts_size]);
+
+    putU32(&buffer[0], CHUNK_MAGIC);
+    putU32(&buffer[4], (uint32_t) count);
+    putU64(&buffer[8], writer->timestamps_usec[0]);
+    putU64(&buffer[16], writer->timestamps_usec[count - 1U]);
+    putU32(&buffer[24], (uint32_t) ts_size);
+    putU32(&buffer[28], (uint32_t) value_size);
+    const size_t chunk_size = COLSTORE_CHUNK_HEADER_SIZE + ts_size + value_size;
+
+    uint8_t entry[COLSTORE_INDEX_ENTRY_SIZE];
+    (void) memset(entry, 0, sizeof(entry));
+    putU64(&entry[0], writer->timestamps_usec[0]);
+    putU64(&entry[8], writer->timestamps_usec[count - 1U]);
+    putU64(&entry[16], writer->offset);
+    putU32(&entry[24], (uint32_t) count);
+
+    // The chunk goes first: an index entry shall never point past the end of the data.
+    if ((fwrite(buffer, 1, chunk_size, writer->data) != chunk_size) || (fflush(writer->data) != 0) ||
+        (fwrite(entry, 1, sizeof(entry), writer->index) != sizeof(entry)))
+    {
+        return -EIO;
+    }
+    writer->offset += chunk_size;
+    writer->bytes_written += chunk_size + sizeof(entry);
+    writer->samples_written += count;
+    writer->count = 0;
+    return 0;
+}
+
+int colstoreWriterAppend(ColStoreWriter* const writer, const uint64_t timestamp_usec, const float value)
+{
+    writer->timestamps_usec[writer->count] = timestamp_usec;
+    writer->values[writer->count]          = value;
+    writer->count++;
+    return (writer->count >= COLSTORE_CHUNK_SAMPLES_MAX) ? colstoreWriteChunk(writer) : 0;
+}
+
+int colstoreWriterFlush(ColStoreWriter* const writer)
+{
+    const int result = (writer->count > 0U) ? colstoreWriteChunk(writer) : 0;
+    return ((result == 0) && (fflush(writer->index) != 0)) ? -EIO : result;
+}
+
+int colstoreWriterClose(ColStoreWriter* const writer)
+{
+    int result = colstoreWriterFlush(writer);
+    if ((fclose(writer->index) != 0) && (result == 0))
+    {
+        result = -EIO;
+    }
+    if ((fclose(writer->data) != 0) && (result == 0))
+    {
+        result = -EIO;
+    }
+    writer->data  = NULL;
+    writer->index = NULL;
+    return result;
+}
+
+static bool colstoreReaderAppendChunk(ColStoreReader* const reader, size_t* const capacity, const ColStoreChunkInfo info)
+{
+    if (reader->num_chunks >= *capacity)
+    {
+        const size_t             new_capacity = (*capacity > 0U) ? (*capacity * 2U) : 256U;
+        ColStoreChunkInfo* const grown        = realloc(reader->chunks, new_capacity * sizeof(ColStoreChunkInfo));
+        if (grown == NULL)
+        {
+            return false;
+        }
+        reader->chunks = grown;
+        *capacity      = new_capacity;
+    }
+    reader->chunks[reader->num_chunks++] = info;
+    return true;
+}
+
+int colstoreReaderOpen(ColStoreReader* const reader, const char* const path)
+{
+    (void) memset(reader, 0, sizeof(ColStoreReader));
+    reader->data = fopen(path, "rb");
+    if (reader->data == NULL)
+    {
+        return -errno;
+    }
+    uint8_t header[COLSTORE_FILE_HEADER_SIZE];
+    if ((fread(header, 1, sizeof(header), reader->data) != sizeof(header)) || (0 != memcmp(header, FILE_MAGIC, 8U)) ||
+        (getU32(&header[12]) > COLSTORE_CHUNK_SAMPLES_MAX))
+    {
+        colstoreReaderClose(reader);
+        return -EINVAL;
+    }
+    reader->subject_id = getU16(&header[8]);
+    reader->node_id    = (CanardNodeID) getU16(&header[10]);
+
+    // Load the index; it may be missing or lag behind the data after a crash.
+    size_t   capacity = 0;
+    uint64_t next     = COLSTORE_FILE_HEADER_SIZE;
+    char     index_path[PATH_SIZE_MAX];
+    makeIndexPath(index_path, path);
+    FILE* const index = fopen(index_path, "rb");
+    uint8_t     entry[COLSTORE_INDEX_ENTRY_SIZE];
+    while ((index != NULL) && (fread(entry, 1, sizeof(entry), index) == sizeof(entry)))
+    {
+        const ColStoreChunkInfo info = {
+            .first_timestamp_usec = getU64(&entry[0]),
+            .last_timestamp_usec  = getU64(&entry[8]),
+            .offset               = getU64(&entry[16]),
+            .count                = getU32(&entry[24]),
+        };
+        if ((info.offset != next) || !colstoreReaderAppendChunk(reader, &capacity, info))
+        {
+            break;  // Inconsistent; rebuild the rest from the data.
+        }
+        // The size of the chunk is in its header; the next entry shall point right after it.
+        uint8_t chunk_header[COLSTORE_CHUNK_HEADER_SIZE];
+        if ((fseek(reader->data, (long) info.offset, SEEK_SET) != 0) ||
+            (fread(chunk_header, 1, sizeof(chunk_header), reader->data) != sizeof(chunk_header)))
+        {
+            reader->num_chunks--;
+            break;
+        }
+        next = info.offset + COLSTORE_CHUNK_HEADER_SIZE + getU32(&chunk_header[24]) + getU32(&chunk_header[28]);
+    }
+    if (index != NULL)
+    {
+        (void) fclose(index);
+    }
+
+    // Scan the chunk headers that are not indexed.
+    uint8_t chunk_header[COLSTORE_CHUNK_HEADER_SIZE];
+    while ((fseek(reader->data, (long) next, SEEK_SET) == 0) &&
+           (fread(chunk_header, 1, sizeof(chunk_header), reader->data) == sizeof(chunk_header)) &&
+           (getU32(&chunk_header[0]) == CHUNK_MAGIC))
+    {
+        const ColStoreChunkInfo info = {
+            .first_timestamp_usec = getU64(&chunk_header[8]),
+            .last_timestamp_usec  = getU64(&chunk_header[16]),
+            .offset               = next,
+            .count                = getU32(&chunk_header[4]),
+        };
+        if (!colstoreReaderAppendChunk(reader, &capacity, info))
+        {
+            break;
+        }
+        next += COLSTORE_CHUNK_HEADER_SIZE + getU32(&chunk_header[24]) + getU32(&chunk_header[28]);
+    }
+    reader->end = next;
+    return 0;
+}
+
+size_t colstoreReaderSeek(const ColStoreReader* const reader, const uint64_t timestamp_usec)
+{
+    size_t low  = 0;
+    size_t high = reader->num_chunks;
+    while (low < high)
+    {
+        const size_t middle = low + ((high - low) / 2U);
+        if (reader->chunks[middle].last_timestamp_usec < timestamp_usec)
+        {
+            low = middle + 1U;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+int colstoreReaderRead(const ColStoreReader* const reader,
+                       const size_t                chunk,
+                       uint64_t* const             out_timestamps_usec,
+                       float* const                out_values)
+{
+    static uint8_t  buffer[COLSTORE_CHUNK_HEADER_SIZE + (2U * COLUMN_SIZE_MAX)];
+    static uint64_t deltas[COLSTORE_CHUNK_SAMPLES_MAX];
+    const ColStoreChunkInfo* const info = &reader->chunks[chunk];
+    if ((fseek(reader->data, (long) info->offset, SEEK_SET) != 0) ||
+        (fread(buffer, 1, COLSTORE_CHUNK_HEADER_SIZE, reader->data) != COLSTORE_CHUNK_HEADER_SIZE))
+    {
+        return -EIO;
+    }
+    const size_t count      = getU32(&buffer[4]);
+    const size_t ts_size    = getU32(&buffer[24]);
+    const size_t value_size = getU32(&buffer[28]);
+    if ((getU32(&buffer[0]) != CHUNK_MAGIC) || (count == 0U) || (count > COLSTORE_CHUNK_SAMPLES_MAX) ||
+        (ts_size > COLUMN_SIZE_MAX) || (value_size > COLUMN_SIZE_MAX))
+    {
+        return -EILSEQ;
+    }
+    uint8_t* const columns = &buffer[COLSTORE_CHUNK_HEADER_SIZE];
+    if (fread(columns, 1, ts_size + value_size, reader->data) != (ts_size + value_size))
+    {
+        return -EIO;
+    }
+
+    if (unpackColumn(columns, ts_size, count - 1U, deltas) != ts_size)
+    {
+        return -EILSEQ;
+    }
+    out_timestamps_usec[0] = getU64(&buffer[8]);
+    int64_t delta          = 0;
+    for (size_t i = 1; i < count; i++)
+    {
+        delta += zigzagDecode(deltas[i - 1U]);
+        out_timestamps_usec[i] = out_timestamps_usec[i - 1U] + (uint64_t) delta;
+    }
+
+    if (unpackColumn(&columns[ts_size], value_size, count, deltas) != value_size)
+    {
+        return -EILSEQ;
+    }
+    int64_t bits = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        bits += zigzagDecode(deltas[i]);
+        out_values[i] = floatFromBits((uint32_t) bits);
+    }
+    return (int) count;
+}
+
+void colstoreReaderClose(ColStoreReader* const reader)
+{
+    if (reader->data != NULL)
+    {
+        (void) fclose(reader->data);
+    }
+    free(reader->chunks);
+    (void) memset(reader, 0, sizeof(ColStoreReader));
+}
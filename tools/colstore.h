@@ -0,0 +1,108 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Columnar storage of a float32 time series, one file per publisher, used by distance-recorder and distance-query.
+/// The samples are stored in chunks of up to COLSTORE_CHUNK_SAMPLES_MAX. Each chunk holds two columns:
+///
+///     timestamps  The first one in the chunk header; then the delta of consecutive deltas (zero for a periodic
+///                 publisher), zigzag-encoded.
+///     values      The IEEE 754 bit patterns, each as the delta from the previous one, zigzag-encoded. This is
+///                 lossless, and close values have close bit patterns.
+///
+/// Both columns are bit-packed in blocks of COLSTORE_BLOCK_SIZE values, each block with the bit width of its widest
+/// value, so that an outlier only widens its own block.
+///
+/// A sparse time index, one entry per chunk with its time span and offset, is kept in a separate file next to the data
+/// (".idx"), so that a range query only reads and decodes the chunks that overlap the range. A chunk is
+/// written before its index entry, so after a crash the index may miss the last chunks; the reader recovers them by
+/// scanning the chunk headers after the last indexed chunk. All integers are little-endian.
+
+#ifndef COLSTORE_H_INCLUDED
+#define COLSTORE_H_INCLUDED
+
+#include <canard.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define COLSTORE_CHUNK_SAMPLES_MAX 2048U
+#define COLSTORE_BLOCK_SIZE 64U
+#define COLSTORE_FILE_HEADER_SIZE 16U
+#define COLSTORE_CHUNK_HEADER_SIZE 32U
+#define COLSTORE_INDEX_ENTRY_SIZE 32U
+
+typedef struct ColStoreChunkInfo
+{
+    uint64_t first_timestamp_usec;
+    uint64_t last_timestamp_usec;
+    uint64_t offset;  ///< Of the chunk header in the data file.
+    uint32_t count;
+} ColStoreChunkInfo;
+
+typedef struct ColStoreWriter
+{
+    FILE*    data;
+    FILE*    index;
+    uint64_t offset;  ///< The size of the data file.
+    size_t   count;   ///< The number of buffered samples.
+    uint64_t timestamps_usec[COLSTORE_CHUNK_SAMPLES_MAX];
+    float    values[COLSTORE_CHUNK_SAMPLES_MAX];
+    uint64_t bytes_written;  ///< Statistics: the data and index bytes written since the file was opened.
+    uint64_t samples_written;
+} ColStoreWriter;
+
+/// Opens the series for appending, creating the data and index files if they do not exist. If the series was not closed
+/// properly, the incomplete chunk at the end of the data is discarded and the index is rebuilt.
+/// Returns zero on success, negated errno on failure (-EINVAL if the file belongs to another series).
+int colstoreWriterOpen(ColStoreWriter* const writer,
+                       const char* const     path,
+                       const CanardPortID    subject_id,
+                       const CanardNodeID    node_id);
+
+/// Buffers the sample; a chunk is written once COLSTORE_CHUNK_SAMPLES_MAX samples are buffered.
+/// Returns zero on success, negated errno on failure.
+int colstoreWriterAppend(ColStoreWriter* const writer, const uint64_t timestamp_usec, const float value);
+
+/// Writes the buffered samples as a (short) chunk and flushes the files. Invoke periodically to bound the loss in a
+/// crash. Returns zero on success, negated errno on failure.
+int colstoreWriterFlush(ColStoreWriter* const writer);
+
+/// Flushes and closes the files. Returns zero on success, negated errno on failure.
+int colstoreWriterClose(ColStoreWriter* const writer);
+
+typedef struct ColStoreReader
+{
+    FILE*              data;
+    ColStoreChunkInfo* chunks;
+    size_t             num_chunks;
+    uint64_t           end;  ///< The end of the last valid chunk in the data file.
+    CanardPortID       subject_id;
+    CanardNodeID       node_id;
+} ColStoreReader;
+
+/// Opens the series and loads the time index. Returns zero on success, negated errno on failure.
+int colstoreReaderOpen(ColStoreReader* const reader, const char* const path);
+
+/// Returns the index of the first chunk that may contain samples at or after the timestamp, num_chunks if none.
+/// The chunks are assumed to be in chronological order, which is the case for a single publisher.
+size_t colstoreReaderSeek(const ColStoreReader* const reader, const uint64_t timestamp_usec);
+
+/// Decodes the chunk into the arrays of COLSTORE_CHUNK_SAMPLES_MAX elements.
+/// Returns the number of samples, negated errno on failure (-EILSEQ if the chunk is corrupted).
+int colstoreReaderRead(const ColStoreReader* const reader,
+                       const size_t                chunk,
+                       uint64_t* const             out_timestamps_usec,
+                       float* const                out_values);
+
+void colstoreReaderClose(ColStoreReader* const reader);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,82 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Prints the samples of a file written by distance-recorder, one "<timestamp-usec> <distance-cm>" line per sample,
+/// optionally only those in a time range. Thanks to the time index only the chunks that overlap the range are read.
+/// With -q, the samples are only counted; the statistics of the query are reported to stderr.
+///
+///     distance-query [-q] <file> [<from-usec> <to-usec>]
+
+#include "colstore.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static uint64_t getMonotonicNanoseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+int main(const int argc, const char* const argv[])
+{
+    int        arg   = 1;
+    const bool quiet = (argc > 1) && (0 == strcmp(argv[1], "-q"));
+    arg += quiet ? 1 : 0;
+    if (((argc - arg) != 1) && ((argc - arg) != 3))
+    {
+        (void) fprintf(stderr, "Usage: %s [-q] <file> [<from-usec> <to-usec>]\n", argv[0]);
+        return 1;
+    }
+    const uint64_t from = ((argc - arg) == 3) ? strtoull(argv[arg + 1], NULL, 10) : 0U;
+    const uint64_t to   = ((argc - arg) == 3) ? strtoull(argv[arg + 2], NULL, 10) : UINT64_MAX;
+
+    const uint64_t started = getMonotonicNanoseconds();
+    ColStoreReader reader;
+    const int      result = colstoreReaderOpen(&reader, argv[arg]);
+    if (result != 0)
+    {
+        (void) fprintf(stderr, "Could not open %s: errno %d\n", argv[arg], -result);
+        return 1;
+    }
+    static uint64_t timestamps[COLSTORE_CHUNK_SAMPLES_MAX];
+    static float    values[COLSTORE_CHUNK_SAMPLES_MAX];
+    size_t          chunks_read = 0;
+    uint64_t        matched     = 0;
+    for (size_t c = colstoreReaderSeek(&reader, from);
+         (c < reader.num_chunks) && (reader.chunks[c].first_timestamp_usec <= to);
+         c++)
+    {
+        const int count = colstoreReaderRead(&reader, c, timestamps, values);
+        if (count < 0)
+        {
+            (void) fprintf(stderr, "Chunk %zu is unreadable: errno %d\n", c, -count);
+            break;
+        }
+        chunks_read++;
+        for (int i = 0; i < count; i++)
+        {
+            if ((timestamps[i] >= from) && (timestamps[i] <= to))
+            {
+                matched++;
+                if (!quiet)
+                {
+                    (void) printf("%llu %.9g\n", (unsigned long long) timestamps[i], (double) values[i]);
+                }
+            }
+        }
+    }
+    const uint64_t elapsed_ns = getMonotonicNanoseconds() - started;
+    (void) fprintf(stderr,
+                   "subject %u node %u: %llu samples in range, %zu of %zu chunks read, %.3f ms\n",
+                   reader.subject_id,
+                   reader.node_id,
+                   (unsigned long long) matched,
+                   chunks_read,
+                   reader.num_chunks,
+                   (double) elapsed_ns * 1e-6);
+    colstoreReaderClose(&reader);
+    return 0;
+}
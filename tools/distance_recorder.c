@@ -0,0 +1,242 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Records the distance messages (subject 1610) published by all nodes on the bus into one columnar file per node
+/// (see colstore.h), named <subject>-<node>.dcol in the output directory. The capture runs until SIGINT or SIGTERM;
+/// the buffered samples are flushed every few seconds, so a crash loses little. An existing file of the same node is
+/// appended to. Read the files with distance-query.
+///
+///     distance-recorder <iface-name> <output-dir>
+///
+/// The storage efficiency can be evaluated without a bus: the synthetic mode writes the given number of seconds of
+/// 20 Hz publications with a realistic reception jitter from the given number of nodes, then reports the size.
+///
+///     distance-recorder --synthetic <output-dir> <nodes> <seconds>
+
+#include "colstore.h"
+#include <canid.h>
+#include <errno.h>
+#include <signal.h>
+#include <socketcan.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ultrasound_layout.h>
+
+#define FLUSH_PERIOD_USEC 5000000U
+#define POLL_TIMEOUT_USEC 100000U
+#define PATH_SIZE_MAX 4096U
+
+#define SYNTHETIC_PERIOD_USEC 50000U
+#define SYNTHETIC_JITTER_USEC 200U
+#define SYNTHETIC_START_USEC 1600000000000000ULL
+
+static volatile sig_atomic_t Stop;
+
+static ColStoreWriter* Writers[CANARD_NODE_ID_MAX + 1U];
+
+static void onSignal(const int signal)
+{
+    (void) signal;
+    Stop = 1;
+}
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    return malloc(amount);
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    free(pointer);
+}
+
+static uint64_t getMonotonicMicroseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000ULL) + ((uint64_t) ts.tv_nsec / 1000U);
+}
+
+/// Returns the writer of the node, opening its file on first use; NULL on failure, which is reported once.
+static ColStoreWriter* getWriter(const char* const dir, const CanardNodeID node_id)
+{
+    static bool failed[CANARD_NODE_ID_MAX + 1U];
+    if ((Writers[node_id] == NULL) && !failed[node_id])
+    {
+        char path[PATH_SIZE_MAX];
+        (void) snprintf(path, sizeof(path), "%s/%u-%u.dcol", dir, ULTRASOUND_DISTANCE_SUBJECT_ID, node_id);
+        ColStoreWriter* const writer = malloc(sizeof(ColStoreWriter));
+        const int             result =
+            (writer != NULL) ? colstoreWriterOpen(writer, path, ULTRASOUND_DISTANCE_SUBJECT_ID, node_id) : -ENOMEM;
+        if (result == 0)
+        {
+            Writers[node_id] = writer;
+        }
+        else
+        {
+            (void) fprintf(stderr, "Could not open %s: errno %d %s\n", path, -result, strerror(-result));
+            free(writer);
+            failed[node_id] = true;
+        }
+    }
+    return Writers[node_id];
+}
+
+static void flushWriters(void)
+{
+    for (size_t i = 0; i <= CANARD_NODE_ID_MAX; i++)
+    {
+        if ((Writers[i] != NULL) && (colstoreWriterFlush(Writers[i]) != 0))
+        {
+            (void) fprintf(stderr, "Could not write the samples of node %zu\n", i);
+        }
+    }
+}
+
+static int closeWriters(void)
+{
+    uint64_t samples = 0;
+    uint64_t bytes   = 0;
+    size_t   nodes   = 0;
+    int      status  = 0;
+    for (size_t i = 0; i <= CANARD_NODE_ID_MAX; i++)
+    {
+        if (Writers[i] != NULL)
+        {
+            if (colstoreWriterClose(Writers[i]) != 0)
+            {
+                (void) fprintf(stderr, "Could not write the samples of node %zu\n", i);
+                status = 1;
+            }
+            samples += Writers[i]->samples_written;
+            bytes += Writers[i]->bytes_written;
+            nodes++;
+            free(Writers[i]);
+            Writers[i] = NULL;
+        }
+    }
+    (void) fprintf(stderr,
+                   "%zu nodes, %llu samples, %llu bytes, %.2f bytes/sample\n",
+                   nodes,
+                   (unsigned long long) samples,
+                   (unsigned long long) bytes,
+                   (samples > 0U) ? ((double) bytes / (double) samples) : 0.0);
+    return status;
+}
+
+static int capture(const char* const iface, const char* const dir)
+{
+    SocketCANFD sock = socketcanOpen(iface, true);
+    if (sock == -EOPNOTSUPP)
+    {
+        sock = socketcanOpen(iface, false);
+    }
+    if (sock < 0)
+    {
+        (void) fprintf(stderr, "Could not open %s: errno %d %s\n", iface, -sock, strerror(-sock));
+        return 1;
+    }
+    // Only the messages of the subject are of interest; let the kernel drop the rest.
+    const SocketCANFilterConfig filter = {
+        .extended_id = (uint32_t) ULTRASOUND_DISTANCE_SUBJECT_ID << CANID_OFFSET_SUBJECT_ID,
+        .mask        = CANID_FLAG_SERVICE_NOT_MESSAGE | ((uint32_t) CANARD_SUBJECT_ID_MAX << CANID_OFFSET_SUBJECT_ID),
+    };
+    if (socketcanFilter(sock, 1, &filter) < 0)
+    {
+        (void) fprintf(stderr, "Could not configure the acceptance filter, filtering in software\n");
+    }
+
+    CanardInstance       ins = canardInit(&memAllocate, &memFree);
+    CanardRxSubscription subscription;
+    (void) canardRxSubscribe(&ins,
+                             CanardTransferKindMessage,
+                             ULTRASOUND_DISTANCE_SUBJECT_ID,
+                             ULTRASOUND_DISTANCE_SIZE_BYTES,
+                             CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                             &subscription);
+
+    uint64_t next_flush_at = getMonotonicMicroseconds() + FLUSH_PERIOD_USEC;
+    while (!Stop)
+    {
+        uint8_t     payload_buffer[CANARD_MTU_CAN_FD];
+        CanardFrame frame;
+        if (socketcanPop(sock, &frame, NULL, sizeof(payload_buffer), payload_buffer, POLL_TIMEOUT_USEC) > 0)
+        {
+            CanardTransfer transfer;
+            if (canardRxAccept(&ins, &frame, 0, &transfer) > 0)
+            {
+                ColStoreWriter* const writer = (transfer.remote_node_id <= CANARD_NODE_ID_MAX)
+                                                   ? getWriter(dir, transfer.remote_node_id)
+                                                   : NULL;  // Anonymous publishers cannot be told apart.
+                if (writer != NULL)
+                {
+                    const CanardDSDLView view = {(const uint8_t*) transfer.payload, transfer.payload_size};
+                    (void) colstoreWriterAppend(writer,
+                                                transfer.timestamp_usec,
+                                                ultrasoundDistanceGetCentimeters(view));
+                }
+                ins.memory_free(&ins, (void*) transfer.payload);
+            }
+        }
+        if (getMonotonicMicroseconds() >= next_flush_at)
+        {
+            next_flush_at += FLUSH_PERIOD_USEC;
+            flushWriters();
+        }
+    }
+    return closeWriters();
+}
+
+/// The quantization of the distance is the same as in the node: the pulse width is halved in integer arithmetic.
+static int synthesize(const char* const dir, const size_t nodes, const size_t seconds)
+{
+    const size_t samples = seconds * (1000000U / SYNTHETIC_PERIOD_USEC);
+    const clock_t started = clock();
+    for (size_t n = 0; (n < nodes) && (n <= CANARD_NODE_ID_MAX); n++)
+    {
+        ColStoreWriter* const writer = getWriter(dir, (CanardNodeID) n);
+        if (writer == NULL)
+        {
+            return 1;
+        }
+        uint32_t rng = (uint32_t) n + 1U;
+        for (size_t i = 0; i < samples; i++)
+        {
+            rng                          = (rng * 1103515245U) + 12345U;
+            const uint32_t jitter        = (rng >> 8U) % (2U * SYNTHETIC_JITTER_USEC);
+            const uint32_t pulse_usec    = 2900U + (uint32_t)((i / 4U) % 400U) + ((rng >> 20U) % 8U);
+            const uint64_t timestamp     = SYNTHETIC_START_USEC + (i * SYNTHETIC_PERIOD_USEC) + jitter;
+            const float    distance      = (float) ((pulse_usec / 2U) * 0.0343);
+            if (colstoreWriterAppend(writer, timestamp, distance) != 0)
+            {
+                (void) fprintf(stderr, "Could not write the samples of node %zu\n", n);
+                return 1;
+            }
+        }
+    }
+    const int    status     = closeWriters();
+    const double elapsed    = (double) (clock() - started) / CLOCKS_PER_SEC;
+    (void) fprintf(stderr, "%.0f samples/s encoded\n", (double) (samples * nodes) / elapsed);
+    return status;
+}
+
+int main(const int argc, const char* const argv[])
+{
+    if ((argc == 5) && (0 == strcmp(argv[1], "--synthetic")))
+    {
+        return synthesize(argv[2], (size_t) strtoul(argv[3], NULL, 10), (size_t) strtoul(argv[4], NULL, 10));
+    }
+    if (argc != 3)
+    {
+        (void) fprintf(stderr, "Usage: %s <iface-name> <output-dir>\n", argv[0]);
+        (void) fprintf(stderr, "       %s --synthetic <output-dir> <nodes> <seconds>\n", argv[0]);
+        return 1;
+    }
+    (void) signal(SIGINT, &onSignal);
+    (void) signal(SIGTERM, &onSignal);
+    return capture(argv[1], argv[2]);
+}
@@ -0,0 +1,130 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Prints the bus time of CAN FD multi-frame transfers segmented with the default policy and with
+/// CanardTxSegmentationMinimizeBusTime for every payload size from 1 to 1024 bytes. The bus time is computed by the
+/// bus load estimator model (expected stuffing) at the bit rates given on the command line:
+///
+///     fd-segmentation-table [nominal_bitrate [data_bitrate]]
+///
+/// The default is 500 kbit/s without bit rate switching. The policy is configured with the ratio of the bit rates.
+/// The output is tab-separated; a summary is printed to stderr.
+
+#include "busload.h"
+#include <canard.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_PAYLOAD_SIZE 1024U
+
+typedef struct
+{
+    size_t   frames;
+    size_t   padding;
+    uint64_t bus_time_ns;
+} Segmentation;
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    return malloc(amount);
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    free(pointer);
+}
+
+static BusLoadFrameFormat format = BusLoadFrameFormatFD;
+
+static Segmentation segment(const CanardTxSegmentation policy,
+                            const size_t               payload_size,
+                            const uint32_t             nominal_bitrate,
+                            const uint32_t             data_bitrate)
+{
+    static uint8_t payload[MAX_PAYLOAD_SIZE];
+    CanardInstance ins      = canardInit(&memAllocate, &memFree);
+    ins.node_id             = 42U;
+    ins.mtu_bytes           = CANARD_MTU_CAN_FD;
+    ins.tx_segmentation     = policy;
+    ins.tx_fd_bitrate_ratio = (data_bitrate > nominal_bitrate) ? (data_bitrate / nominal_bitrate) : 1U;
+    const CanardTransfer transfer = {
+        .timestamp_usec = 0U,
+        .priority       = CanardPriorityNominal,
+        .transfer_kind  = CanardTransferKindMessage,
+        .port_id        = 1234U,
+        .remote_node_id = CANARD_NODE_ID_UNSET,
+        .transfer_id    = 0U,
+        .payload_size   = payload_size,
+        .payload        = payload,
+    };
+    if (canardTxPush(&ins, &transfer) < 0)
+    {
+        (void) fprintf(stderr, "Could not push a transfer of %zu bytes\n", payload_size);
+        exit(EXIT_FAILURE);
+    }
+    Segmentation out   = {0};
+    size_t       bytes = 0;
+    for (const CanardFrame* frame = canardTxPeek(&ins); frame != NULL; frame = canardTxPeek(&ins))
+    {
+        const BusLoadFrameBits bits =
+            busloadComputeFrameBits(frame->payload_size, format, BusLoadStuffingExpected);
+        out.bus_time_ns += busloadComputeFrameTimeNs(bits, nominal_bitrate, data_bitrate);
+        out.frames++;
+        bytes += frame->payload_size;
+        canardTxPop(&ins);
+        ins.memory_free(&ins, (void*) frame);
+    }
+    // Each frame carries the tail byte; multi-frame transfers also carry the transfer CRC.
+    out.padding = bytes - payload_size - out.frames - ((out.frames > 1U) ? 2U : 0U);
+    return out;
+}
+
+int main(const int argc, const char* const argv[])
+{
+    const uint32_t nominal_bitrate = (argc > 1) ? (uint32_t) strtoul(argv[1], NULL, 10) : 500000U;
+    const uint32_t data_bitrate    = (argc > 2) ? (uint32_t) strtoul(argv[2], NULL, 10) : nominal_bitrate;
+    uint64_t       total_default   = 0;
+    uint64_t       total_optimized = 0;
+    double         best_saving     = 0.0;
+    size_t         best_size       = 0;
+    size_t         improved        = 0;
+    format = (data_bitrate > nominal_bitrate) ? BusLoadFrameFormatFDBRS : BusLoadFrameFormatFD;
+    (void) printf("payload\tframes\tpadding\tbus_ns\tframes_opt\tpadding_opt\tbus_ns_opt\tsaving_pct\n");
+    for (size_t size = 1U; size <= MAX_PAYLOAD_SIZE; size++)
+    {
+        const Segmentation def =
+            segment(CanardTxSegmentationMaximizeFrameSize, size, nominal_bitrate, data_bitrate);
+        const Segmentation opt =
+            segment(CanardTxSegmentationMinimizeBusTime, size, nominal_bitrate, data_bitrate);
+        const double saving =
+            100.0 * ((double) def.bus_time_ns - (double) opt.bus_time_ns) / (double) def.bus_time_ns;
+        (void) printf("%zu\t%zu\t%zu\t%llu\t%zu\t%zu\t%llu\t%.1f\n",
+                      size,
+                      def.frames,
+                      def.padding,
+                      (unsigned long long) def.bus_time_ns,
+                      opt.frames,
+                      opt.padding,
+                      (unsigned long long) opt.bus_time_ns,
+                      saving);
+        total_default += def.bus_time_ns;
+        total_optimized += opt.bus_time_ns;
+        improved += (opt.bus_time_ns < def.bus_time_ns) ? 1U : 0U;
+        if (saving > best_saving)
+        {
+            best_saving = saving;
+            best_size   = size;
+        }
+    }
+    (void) fprintf(stderr,
+                   "%zu of %u sizes improved; mean saving %.2f%%; best %.1f%% at %zu bytes\n",
+                   improved,
+                   MAX_PAYLOAD_SIZE,
+                   100.0 * ((double) total_default - (double) total_optimized) / (double) total_default,
+                   best_saving,
+                   best_size);
+    return 0;
+}
@@ -0,0 +1,316 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Measures the throughput of file read responses (uavcan.file.Read.1.1, service 408) with Classic CAN, CAN FD and
+/// CAN XL frames. A response carries up to 256 bytes of file data plus 4 bytes of the error code and the array length.
+/// Every response is segmented by libcanard, transmitted, received and reassembled by another libcanard instance.
+///
+/// Without an interface, the frames are passed from the TX queue to the receiver in memory, which measures the cost
+/// of the segmentation, the CRC and the reassembly alone. With an interface, they go through two sockets on it, which
+/// adds the cost of the SocketCAN stack; a virtual interface carries CAN XL once its MTU is raised:
+///
+///     ip link add dev vcan0 type vcan && ip link set vcan0 mtu 2060 up
+///     file-read-bench [-s] [-i vcan0] [<response-size> [<responses>]]
+///
+/// The modes that the interface does not support are skipped. With -s, the client uses a streaming subscription
+/// (canardRxSubscribeStream()), which hands the data over as the frames arrive instead of reassembling the responses
+/// in a buffer; the heap column shows the memory the client allocates per response in either case.
+
+#include <canard.h>
+#include <errno.h>
+#include <socketcan.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define FILE_READ_SERVICE_ID 408U
+#define FILE_READ_RESPONSE_SIZE_MAX 260U
+#define SERVER_NODE_ID 42U
+#define CLIENT_NODE_ID 43U
+#define SOCKET_TIMEOUT_USEC 1000000U
+
+typedef struct
+{
+    const char* name;
+    size_t      mtu;
+} Mode;
+
+static const Mode Modes[] = {
+    {"classic", CANARD_MTU_CAN_CLASSIC},
+    {"fd", CANARD_MTU_CAN_FD},
+    {"xl", CANARD_MTU_CAN_XL},
+};
+
+typedef struct
+{
+    size_t   frames;
+    size_t   wire_bytes;  ///< Frame payloads including the tail bytes, the padding and the CRC.
+    size_t   transfers;
+    uint64_t elapsed_ns;
+} Result;
+
+/// The state of a streaming client, linked to its subscription through the user reference.
+typedef struct
+{
+    size_t response_size;
+    size_t committed;
+} StreamState;
+
+static size_t ClientHeapBytes;
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    return malloc(amount);
+}
+
+static void* memAllocateCounted(CanardInstance* const ins, const size_t amount)
+{
+    ClientHeapBytes += amount;
+    return memAllocate(ins, amount);
+}
+
+/// Checks the data the client received, which stands for writing it to its destination in either mode.
+/// The padding of the last frame, if any, follows the response.
+static void consumeData(const uint8_t* const data, const size_t offset, const size_t size, const size_t response_size)
+{
+    for (size_t i = 0; (i < size) && ((offset + i) < response_size); i++)
+    {
+        if (data[i] != (uint8_t) (offset + i))
+        {
+            (void) fprintf(stderr, "Corrupted data at offset %zu\n", offset + i);
+            exit(1);
+        }
+    }
+}
+
+static void onStreamEvent(CanardInstance* const       ins,
+                          CanardRxSubscription* const subscription,
+                          const CanardRxStreamEvent   event,
+                          const CanardTransfer* const transfer,
+                          const size_t                offset)
+{
+    (void) ins;
+    StreamState* const state = (StreamState*) subscription->user_reference;
+    if (event == CanardRxStreamEventData)
+    {
+        consumeData((const uint8_t*) transfer->payload, offset, transfer->payload_size, state->response_size);
+    }
+    else if (event == CanardRxStreamEventCommit)
+    {
+        state->committed++;
+    }
+    else
+    {
+        (void) fprintf(stderr, "Transfer %u aborted\n", transfer->transfer_id);
+    }
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    free(pointer);
+}
+
+static uint64_t getMonotonicNanoseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+/// Opens a socket of the mode; returns -EOPNOTSUPP if the interface does not support it.
+static SocketCANFD openSocket(const char* const iface, const size_t mtu)
+{
+    return (mtu > CANARD_MTU_CAN_FD) ? socketcanOpenXL(iface) : socketcanOpen(iface, mtu > CANARD_MTU_CAN_CLASSIC);
+}
+
+/// Transmits the frames of one response and receives them on the other side. Without sockets, the frames are passed
+/// over directly. Returns 1 once the response is reassembled, negated errno on failure.
+static int transferOne(CanardInstance* const server,
+                       CanardInstance* const client,
+                       const SocketCANFD     tx,
+                       const SocketCANFD     rx,
+                       StreamState* const    stream,
+                       Result* const         result)
+{
+    static uint8_t rx_buffer[CANARD_MTU_CAN_XL];
+    int            out = 0;
+    for (const CanardFrame* txf = canardTxPeek(server); txf != NULL; txf = canardTxPeek(server))
+    {
+        result->frames++;
+        result->wire_bytes += txf->payload_size;
+        CanardFrame frame = *txf;
+        int16_t     io    = 1;
+        if (tx >= 0)
+        {
+            io = socketcanPush(tx, txf, SOCKET_TIMEOUT_USEC);
+            while (io > 0)  // Skip the frames of other nodes on the bus, if any.
+            {
+                io = socketcanPop(rx, &frame, NULL, sizeof(rx_buffer), rx_buffer, SOCKET_TIMEOUT_USEC);
+                if ((io > 0) && (frame.extended_can_id == txf->extended_can_id))
+                {
+                    break;
+                }
+            }
+        }
+        if (io <= 0)
+        {
+            return (io < 0) ? io : -ETIMEDOUT;
+        }
+        CanardTransfer transfer;
+        if (canardRxAccept(client, &frame, 0, &transfer) > 0)
+        {
+            consumeData((const uint8_t*) transfer.payload, 0U, transfer.payload_size, stream->response_size);
+            client->memory_free(client, (void*) transfer.payload);
+            out = 1;
+        }
+        if (stream->committed > 0U)
+        {
+            stream->committed = 0U;
+            out               = 1;
+        }
+        canardTxPop(server);
+        server->memory_free(server, (void*) txf);
+    }
+    return out;
+}
+
+static int runMode(const char* const iface,
+                   const bool        streaming,
+                   const Mode* const mode,
+                   const size_t      response_size,
+                   const size_t      responses,
+                   Result* const     result)
+{
+    SocketCANFD tx = -1;
+    SocketCANFD rx = -1;
+    if (iface != NULL)
+    {
+        tx = openSocket(iface, mode->mtu);
+        rx = (tx >= 0) ? openSocket(iface, mode->mtu) : tx;
+        if (rx < 0)
+        {
+            if (tx >= 0)
+            {
+                (void) close(tx);
+            }
+            return rx;
+        }
+    }
+
+    static uint8_t payload[FILE_READ_RESPONSE_SIZE_MAX];
+    for (size_t i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (uint8_t) i;
+    }
+    CanardInstance server = canardInit(&memAllocate, &memFree);
+    server.node_id        = SERVER_NODE_ID;
+    server.mtu_bytes      = mode->mtu;
+    CanardInstance client = canardInit(&memAllocateCounted, &memFree);
+    client.node_id        = CLIENT_NODE_ID;
+    CanardRxSubscription subscription;
+    if (streaming)
+    {
+        (void) canardRxSubscribeStream(&client,
+                                       CanardTransferKindResponse,
+                                       FILE_READ_SERVICE_ID,
+                                       FILE_READ_RESPONSE_SIZE_MAX,
+                                       CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                                       &onStreamEvent,
+                                       &subscription);
+    }
+    else
+    {
+        (void) canardRxSubscribe(&client,
+                                 CanardTransferKindResponse,
+                                 FILE_READ_SERVICE_ID,
+                                 FILE_READ_RESPONSE_SIZE_MAX,
+                                 CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                                 &subscription);
+    }
+    StreamState stream          = {.response_size = response_size, .committed = 0U};
+    subscription.user_reference = &stream;
+
+    (void) memset(result, 0, sizeof(*result));
+    ClientHeapBytes        = 0U;
+    int            status  = 0;
+    const uint64_t started = getMonotonicNanoseconds();
+    for (size_t i = 0; (i < responses) && (status >= 0); i++)
+    {
+        const CanardTransfer transfer = {
+            .timestamp_usec = 0U,
+            .priority       = CanardPriorityNominal,
+            .transfer_kind  = CanardTransferKindResponse,
+            .port_id        = FILE_READ_SERVICE_ID,
+            .remote_node_id = CLIENT_NODE_ID,
+            .transfer_id    = (CanardTransferID) i,
+            .payload_size   = response_size,
+            .payload        = payload,
+        };
+        status = canardTxPush(&server, &transfer);
+        status = (status > 0) ? transferOne(&server, &client, tx, rx, &stream, result) : -ENOMEM;
+        result->transfers += (status > 0) ? 1U : 0U;
+    }
+    result->elapsed_ns = getMonotonicNanoseconds() - started;
+    (void) canardRxUnsubscribe(&client, CanardTransferKindResponse, FILE_READ_SERVICE_ID);
+
+    if (iface != NULL)
+    {
+        (void) close(tx);
+        (void) close(rx);
+    }
+    return (status < 0) ? status : 0;
+}
+
+int main(const int argc, const char* const argv[])
+{
+    int        arg       = 1;
+    const bool streaming = (argc > 1) && (0 == strcmp(argv[1], "-s"));
+    arg += streaming ? 1 : 0;
+    const char* const iface = ((argc > (arg + 1)) && (0 == strcmp(argv[arg], "-i"))) ? argv[arg + 1] : NULL;
+    arg += (iface != NULL) ? 2 : 0;
+    const size_t response_size = (argc > arg) ? (size_t) strtoul(argv[arg], NULL, 10) : FILE_READ_RESPONSE_SIZE_MAX;
+    const size_t responses     = (argc > (arg + 1)) ? (size_t) strtoul(argv[arg + 1], NULL, 10) : 100000U;
+    if ((response_size <= 4U) || (response_size > FILE_READ_RESPONSE_SIZE_MAX) || (responses == 0U))
+    {
+        (void) fprintf(stderr, "Usage: %s [-s] [-i <iface-name>] [<response-size> [<responses>]]\n", argv[0]);
+        return 1;
+    }
+
+    (void) printf("%s, %zu-byte responses, %s\n",
+                  (iface != NULL) ? iface : "in memory",
+                  response_size,
+                  streaming ? "streaming" : "reassembled");
+    (void) printf("| mode    | frames/response | wire bytes/response | ns/response | file data MB/s "
+                  "| heap bytes/response |\n");
+    (void) printf("|---------|----------------:|--------------------:|------------:|---------------:"
+                  "|--------------------:|\n");
+    for (size_t m = 0; m < (sizeof(Modes) / sizeof(Modes[0])); m++)
+    {
+        Result    result;
+        const int status = runMode(iface, streaming, &Modes[m], response_size, responses, &result);
+        if (status == -EOPNOTSUPP)
+        {
+            (void) printf("| %-7s | not supported by the interface |\n", Modes[m].name);
+            continue;
+        }
+        if ((status < 0) || (result.transfers == 0U))
+        {
+            (void) fprintf(stderr, "%s: errno %d %s\n", Modes[m].name, -status, strerror(-status));
+            return 1;
+        }
+        const double ns_per_response = (double) result.elapsed_ns / (double) result.transfers;
+        (void) printf("| %-7s | %15.1f | %19.1f | %11.1f | %14.1f | %19.1f |\n",
+                      Modes[m].name,
+                      (double) result.frames / (double) result.transfers,
+                      (double) result.wire_bytes / (double) result.transfers,
+                      ns_per_response,
+                      (double) (response_size - 4U) * 1e3 / ns_per_response,
+                      (double) ClientHeapBytes / (double) result.transfers);
+    }
+    return 0;
+}
@@ -0,0 +1,197 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Time to the first publication after a start of the node, with the in-process pigpio backend against the pigpio
+/// daemon backend. Every round sets up the measurement pipeline of the node (src/ultrasound.c) on a fresh backend,
+/// starts it, waits for the first distance message in the TX queue, and stops it again, like a restart of the node
+/// does. Reported per round and as the minimum, median and maximum over the rounds: the time the start of the backend
+/// takes (the hardware initialization or the connection to the daemon) and the time to the first publication, which
+/// adds the first trigger and the echo. The start of the process itself and the CAN interface are not included.
+///
+///     first-publish-bench <pigpio|pigpiod|synthetic> [rounds]
+///
+/// The pigpio backend needs root and cannot initialize while the daemon runs, so stop the daemon for it
+/// (sudo killall pigpiod) and start it again for the pigpiod backend (sudo pigpiod), which is only available in a build
+/// configured with ENABLE_PIGPIOD. The synthetic backend replays an echo that ends 1 ms after the start instead, to
+/// check the harness without the sensor.
+
+#include <sensor_pigpio.h>
+#include <sensor_pigpiod.h>
+#include <sensor_replay.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ultrasound.h>
+
+#define TRIGGER_PIN 18U
+#define ECHO_PIN 24U
+#define TRIGGER_PERIOD_MS 50U
+#define DISTANCE_SUBJECT_ID 1610U
+#define TX_DEADLINE_USEC 100000U
+#define TIMEOUT_NS 2000000000ULL
+#define MAX_ROUNDS 1000U
+
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    return malloc(amount);
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    free(pointer);
+}
+
+static uint64_t getMonotonicNanoseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+static CanardMicrosecond getMonotonicMicroseconds(void)
+{
+    return getMonotonicNanoseconds() / 1000U;
+}
+
+static int compareDoubles(const void* const a, const void* const b)
+{
+    const double x = *(const double*) a;
+    const double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+static void printSummary(const char* const what, double* const values, const size_t count)
+{
+    qsort(values, count, sizeof(double), &compareDoubles);
+    (void) printf("%-20s min %8.2f  median %8.2f  max %8.2f ms\n",
+                  what,
+                  values[0],
+                  values[count / 2U],
+                  values[count - 1U]);
+}
+
+/// Runs one start of the backend. Returns false if the backend could not start or nothing was published in time.
+static bool runRound(SensorBackend* const sensor, double* const start_ms, double* const publish_ms)
+{
+    CanardInstance ins = canardInit(&memAllocate, &memFree);
+    ins.node_id        = 42U;
+    FlightRecorder recorder;
+    (void) memset(&recorder, 0, sizeof(recorder));  // Not open: the recording is disabled.
+    static PeriodicEngine periodic;
+    periodicInit(&periodic, &ins);
+    static UltrasoundPipeline pipeline;
+
+    const uint64_t started_at = getMonotonicNanoseconds();
+
+    int result = ultrasoundInit(&pipeline,
+                                &periodic,
+                                sensor,
+                                &getMonotonicMicroseconds,
+                                &recorder,
+                                DISTANCE_SUBJECT_ID,
+                                TX_DEADLINE_USEC);
+    if (result >= 0)
+    {
+        result = sensor->start(sensor, TRIGGER_PERIOD_MS, &ultrasoundOnEcho, &pipeline);
+    }
+    const uint64_t attached_at = getMonotonicNanoseconds();
+    if (result < 0)
+    {
+        (void) fprintf(stderr, "Could not start the %s backend: errno %d\n", sensor->name, -result);
+        return false;
+    }
+    // Spins like the main loop of the node, which publishes the readings queued by the thread of the backend.
+    uint64_t published_at = 0U;
+    while ((published_at == 0U) && ((getMonotonicNanoseconds() - started_at) < TIMEOUT_NS))
+    {
+        if ((ultrasoundPoll(&pipeline) > 0U) && (canardTxPeek(&ins) != NULL))
+        {
+            published_at = getMonotonicNanoseconds();
+        }
+    }
+    sensor->stop(sensor);
+    const bool ok = published_at != 0U;
+    if (!ok)
+    {
+        (void) fprintf(stderr, "Nothing was published within %llu ms\n", TIMEOUT_NS / 1000000ULL);
+    }
+    *start_ms   = (double) (attached_at - started_at) * 1e-6;
+    *publish_ms = (double) (published_at - started_at) * 1e-6;
+    for (const CanardFrame* txf = canardTxPeek(&ins); txf != NULL; txf = canardTxPeek(&ins))
+    {
+        canardTxPop(&ins);
+        ins.memory_free(&ins, (void*) txf);
+    }
+    return ok;
+}
+
+int main(const int argc, const char* const argv[])
+{
+    if ((argc < 2) || (argc > 3))
+    {
+        (void) fprintf(stderr, "Usage: %s <pigpio|pigpiod|synthetic> [rounds]\n", argv[0]);
+        return 1;
+    }
+    const char* const backend = argv[1];
+    const size_t      rounds  = (argc > 2) ? (size_t) strtoul(argv[2], NULL, 10) : 10U;
+    if ((rounds == 0U) || (rounds > MAX_ROUNDS))
+    {
+        (void) fprintf(stderr, "The number of rounds shall be 1 to %u\n", MAX_ROUNDS);
+        return 1;
+    }
+
+    static SensorPigpio           sensor_pigpio;
+#if PIGPIOD_ENABLED
+    static SensorPigpiod sensor_pigpiod;
+#endif
+    static SensorReplay           sensor_replay;
+    static const SensorReplayEdge synthetic[] = {
+        {.tick = 0U, .level = SENSOR_LEVEL_HIGH},
+        {.tick = 1000U, .level = SENSOR_LEVEL_LOW},
+    };
+    SensorBackend* sensor = NULL;
+    if (0 == strcmp(backend, "pigpio"))
+    {
+        sensor = &sensor_pigpio.base;
+    }
+#if PIGPIOD_ENABLED
+    else if (0 == strcmp(backend, "pigpiod"))
+    {
+        sensor = &sensor_pigpiod.base;
+    }
+#endif
+    else if (0 == strcmp(backend, "synthetic"))
+    {
+        sensor = &sensor_replay.base;
+    }
+    else
+    {
+        (void) fprintf(stderr, "Unknown backend %s\n", backend);
+        return 1;
+    }
+
+    static double start_ms[MAX_ROUNDS];
+    static double publish_ms[MAX_ROUNDS];
+    for (size_t r = 0; r < rounds; r++)
+    {
+        sensorPigpioInit(&sensor_pigpio, TRIGGER_PIN, ECHO_PIN);
+#if PIGPIOD_ENABLED
+        sensorPigpiodInit(&sensor_pigpiod, NULL, NULL, TRIGGER_PIN, ECHO_PIN);
+#endif
+        sensorReplayInit(&sensor_replay, &synthetic[0], sizeof(synthetic) / sizeof(synthetic[0]), 1.0);
+        if (!runRound(sensor, &start_ms[r], &publish_ms[r]))
+        {
+            return 1;
+        }
+        (void) printf("round %3zu: start %8.2f ms, first publication %8.2f ms\n", r, start_ms[r], publish_ms[r]);
+    }
+    (void) printf("%s backend, %zu rounds:\n", sensor->name, rounds);
+    printSummary("start", &start_ms[0], rounds);
+    printSummary("first publication", &publish_ms[0], rounds);
+    return 0;
+}
@@ -0,0 +1,114 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Measures the cost of the flight recorder on the echo path of the node: one sensor sample and one publication
+/// record per measurement, at simulated 1 kHz timestamps with a realistic pulse width jitter. Reports the time per
+/// measurement, the resulting CPU share at 1 kHz, and the storage density; then reads the samples back and checks
+/// that they are recovered exactly.
+///
+///     flightrec-bench [file] [measurements]
+
+#include <flightrec.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CAPACITY 65536U
+#define SAMPLE_PERIOD_USEC 1000U
+#define START_USEC 1600000000000000ULL
+
+static uint64_t getMonotonicNanoseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+/// A target at about 50 cm moving slowly, with a few microseconds of noise; deterministic.
+static int32_t simulatePulseWidth(const size_t i, uint32_t* const rng)
+{
+    *rng = (*rng * 1103515245U) + 12345U;
+    return (int32_t)(2900U + ((i / 16U) % 200U) + ((*rng >> 16U) % 8U));
+}
+
+int main(const int argc, const char* const argv[])
+{
+    const char* const path         = (argc > 1) ? argv[1] : "/tmp/flightrec-bench.rec";
+    const size_t      measurements = (argc > 2) ? (size_t) strtoul(argv[2], NULL, 10) : 1000000U;
+
+    FlightRecorder recorder;
+    const int16_t  result = flightrecOpen(&recorder, path, CAPACITY);
+    if (result < 0)
+    {
+        (void) fprintf(stderr, "Could not open %s: errno %d\n", path, -result);
+        return 1;
+    }
+    FlightRecSampleWriter writer;
+    flightrecSampleWriterInit(&writer, &recorder, 0U);
+    const uint64_t head_before = atomic_load(&recorder.header->head);
+
+    uint32_t       rng     = 1U;
+    const uint64_t started = getMonotonicNanoseconds();
+    for (size_t i = 0; i < measurements; i++)
+    {
+        const CanardMicrosecond ts    = START_USEC + (i * SAMPLE_PERIOD_USEC);
+        const int32_t           pulse = simulatePulseWidth(i, &rng);
+        flightrecSample(&writer, ts, pulse);
+        const FlightRecPublish event = {
+            .port_id     = 1610U,
+            .transfer_id = (CanardTransferID)(i & CANARD_TRANSFER_ID_MAX),
+            .priority    = (uint8_t) CanardPriorityNominal,
+            .result      = 1,
+            .value       = (float) pulse * 0.01715F,
+        };
+        flightrecWrite(&recorder, FlightRecRecordPublish, ts, &event, sizeof(event));
+    }
+    const uint64_t elapsed_ns = getMonotonicNanoseconds() - started;
+    const uint64_t records    = atomic_load(&recorder.header->head) - head_before;
+
+    // Read back the samples that are still in the ring and compare them against the simulation replayed in step.
+    uint64_t       verified = 0;
+    uint64_t       errors   = 0;
+    uint32_t       rng_ref  = 1U;
+    size_t         next     = 0;
+    int32_t        expected = 0;
+    const uint64_t head     = atomic_load(&recorder.header->head);
+    for (uint64_t seq = (head > CAPACITY) ? (head - CAPACITY + 1U) : 1U; seq <= head; seq++)
+    {
+        FlightRecRecordCopy copy;
+        if (flightrecRead(recorder.header, recorder.records, seq, &copy) &&
+            (copy.type == (uint8_t) FlightRecRecordSamples))
+        {
+            CanardMicrosecond timestamps[FLIGHTREC_RECORD_PAYLOAD_SIZE];
+            int32_t           values[FLIGHTREC_RECORD_PAYLOAD_SIZE];
+            const size_t count = flightrecDecodeSamples(&copy, FLIGHTREC_RECORD_PAYLOAD_SIZE, timestamps, values);
+            for (size_t k = 0; k < count; k++)
+            {
+                const size_t i = (size_t)((timestamps[k] - START_USEC) / SAMPLE_PERIOD_USEC);
+                while (next <= i)
+                {
+                    expected = simulatePulseWidth(next++, &rng_ref);
+                }
+                errors += (values[k] != expected) ? 1U : 0U;
+                verified++;
+            }
+        }
+    }
+    flightrecClose(&recorder);
+
+    const double ns_per_measurement = (double) elapsed_ns / (double) measurements;
+    (void) printf("measurements        %zu\n", measurements);
+    (void) printf("time                %.1f ns per measurement (sample + publication record)\n", ns_per_measurement);
+    (void) printf("CPU share at 1 kHz  %.4f %%\n", ns_per_measurement * 1000.0 / 1e9 * 100.0);
+    (void) printf("records             %.3f per measurement, %.1f bytes\n",
+                  (double) records / (double) measurements,
+                  (double) records * FLIGHTREC_RECORD_SIZE / (double) measurements);
+    (void) printf("history at 1 kHz    %.0f s in %u records\n",
+                  (double) CAPACITY * (double) measurements / (double) records / 1000.0,
+                  CAPACITY);
+    (void) printf("verified samples    %llu, mismatches %llu\n",
+                  (unsigned long long) verified,
+                  (unsigned long long) errors);
+    return (errors == 0U) ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Prints the contents of a flight recorder file (see src/flightrec.h) in chronological order, one event per line,
+/// with the TAI timestamps in microseconds. The file can be read while the node is running or after it crashed;
+/// records that are being written or were torn by the crash are skipped.
+///
+///     flightrec-dump <file> [seconds]
+///
+/// If the number of seconds is given, only the events of the last seconds before the newest one are printed.
+
+#include <flightrec.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SAMPLES_PER_RECORD_MAX FLIGHTREC_RECORD_PAYLOAD_SIZE
+
+static void printRecord(const FlightRecRecordCopy* const copy, const CanardMicrosecond since_usec)
+{
+    if (copy->type == (uint8_t) FlightRecRecordSamples)
+    {
+        CanardMicrosecond timestamps[SAMPLES_PER_RECORD_MAX];
+        int32_t           values[SAMPLES_PER_RECORD_MAX];
+        const size_t      count = flightrecDecodeSamples(copy, SAMPLES_PER_RECORD_MAX, timestamps, values);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (timestamps[i] >= since_usec)
+            {
+                (void) printf("%llu sample stream=%u value=%ld\n",
+                              (unsigned long long) timestamps[i],
+                              copy->stream,
+                              (long) values[i]);
+            }
+        }
+    }
+    else if (copy->timestamp_usec < since_usec)
+    {
+        // Too old.
+    }
+    else if ((copy->type == (uint8_t) FlightRecRecordPublish) && (copy->size >= sizeof(FlightRecPublish)))
+    {
+        FlightRecPublish event;
+        (void) memcpy(&event, copy->payload, sizeof(event));
+        (void) printf("%llu publish port=%u tid=%u priority=%u result=%ld value=%g\n",
+                      (unsigned long long) copy->timestamp_usec,
+                      event.port_id,
+                      event.transfer_id,
+                      event.priority,
+                      (long) event.result,
+                      (double) event.value);
+    }
+    else if ((copy->type == (uint8_t) FlightRecRecordBus) && (copy->size >= sizeof(FlightRecBusEvent)))
+    {
+        FlightRecBusEvent event;
+        (void) memcpy(&event, copy->payload, sizeof(event));
+        if (event.kind == (uint8_t) FlightRecBusTxDropped)
+        {
+            (void) printf("%llu bus tx-dropped can_id=%08lx result=%ld\n",
+                          (unsigned long long) copy->timestamp_usec,
+                          (unsigned long) event.can_id,
+                          (long) event.error);
+        }
+        else
+        {
+            (void) printf("%llu bus utilization=%.4f\n", (unsigned long long) copy->timestamp_usec, (double) event.value);
+        }
+    }
+    else
+    {
+        (void) printf("%llu unknown type=%u size=%u\n",
+                      (unsigned long long) copy->timestamp_usec,
+                      copy->type,
+                      copy->size);
+    }
+}
+
+int main(const int argc, const char* const argv[])
+{
+    if ((argc != 2) && (argc != 3))
+    {
+        (void) fprintf(stderr, "Usage: %s <file> [seconds]\n", argv[0]);
+        return 1;
+    }
+    const int   fd = open(argv[1], O_RDONLY);
+    struct stat st;
+    if ((fd < 0) || (fstat(fd, &st) != 0) || ((size_t) st.st_size < FLIGHTREC_HEADER_SIZE))
+    {
+        (void) fprintf(stderr, "Could not open %s\n", argv[1]);
+        return 1;
+    }
+    const uint8_t* const map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    (void) close(fd);
+    if (map == MAP_FAILED)
+    {
+        (void) fprintf(stderr, "Could not map %s\n", argv[1]);
+        return 1;
+    }
+    const FlightRecHeader* const header = (const FlightRecHeader*) (const void*) map;
+    const uint64_t               capacity = header->capacity;
+    if ((0 != memcmp(header->magic, FLIGHTREC_MAGIC, sizeof(FLIGHTREC_MAGIC))) ||
+        (header->version != FLIGHTREC_VERSION) || (header->record_size != FLIGHTREC_RECORD_SIZE) ||
+        (capacity == 0U) || ((capacity & (capacity - 1U)) != 0U) ||
+        ((FLIGHTREC_HEADER_SIZE + (capacity * FLIGHTREC_RECORD_SIZE)) > (uint64_t) st.st_size))
+    {
+        (void) fprintf(stderr, "%s is not a flight recorder file of a supported version\n", argv[1]);
+        return 1;
+    }
+    const FlightRecRecord* const records = (const FlightRecRecord*) (const void*) (map + FLIGHTREC_HEADER_SIZE);
+
+    // The records are visited in the order of reservation, which is also chronological except that a sample block
+    // spans the time from its first to its last sample.
+    const uint64_t head  = atomic_load_explicit(&header->head, memory_order_acquire);
+    const uint64_t first = (head > capacity) ? (head - capacity + 1U) : 1U;
+
+    CanardMicrosecond since_usec = 0;
+    if (argc == 3)
+    {
+        CanardMicrosecond newest = 0;
+        for (uint64_t seq = first; seq <= head; seq++)
+        {
+            FlightRecRecordCopy copy;
+            if (flightrecRead(header, records, seq, &copy) && (copy.timestamp_usec > newest))
+            {
+                newest = copy.timestamp_usec;
+            }
+        }
+        const CanardMicrosecond window_usec = (CanardMicrosecond)(strtod(argv[2], NULL) * 1e6);
+        since_usec                          = (newest > window_usec) ? (newest - window_usec) : 0U;
+    }
+
+    uint64_t skipped = 0;
+    for (uint64_t seq = first; seq <= head; seq++)
+    {
+        FlightRecRecordCopy copy;
+        if (flightrecRead(header, records, seq, &copy))
+        {
+            printRecord(&copy, since_usec);
+        }
+        else
+        {
+            skipped++;
+        }
+    }
+    (void) fprintf(stderr,
+                   "%llu records of %llu, %llu skipped\n",
+                   (unsigned long long) (head - first + 1U),
+                   (unsigned long long) capacity,
+                   (unsigned long long) skipped);
+    return 0;
+}
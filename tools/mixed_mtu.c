@@ -0,0 +1,152 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Compares the bus time and the throughput of large transfers mixed with the periodic traffic of the node when all
+/// transfers use the Classic CAN MTU versus when the large transfers use the CAN FD MTU (with and without the bit rate
+/// switch) while the periodic messages remain Classic CAN. The frames are produced by libcanard exactly as the node
+/// does and timed by the bus load estimator model (expected stuffing):
+///
+///     mixed-mtu-bench [nominal_bitrate [data_bitrate [large_transfers_per_second]]]
+///
+/// The default is 500 kbit/s, 2 Mbit/s, 10 large transfers per second.
+
+#include "busload.h"
+#include <canard.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAX_PAYLOAD_SIZE 1024U
+
+typedef struct
+{
+    const char* name;
+    size_t      size;
+    uint32_t    rate_hz;
+} PeriodicMessage;
+
+/// The periodic traffic of the node, see src/main.c.
+static const PeriodicMessage PeriodicMessages[] = {
+    {"heartbeat", 7U, 1U},
+    {"distance", 4U, 20U},
+};
+
+typedef struct
+{
+    const char* name;
+    size_t      large_mtu;
+    bool        brs;
+} Scenario;
+
+static const Scenario Scenarios[] = {
+    {"classic", CANARD_MTU_CAN_CLASSIC, false},
+    {"mixed-fd", CANARD_MTU_CAN_FD, false},
+    {"mixed-fd-brs", CANARD_MTU_CAN_FD, true},
+};
+
+static const size_t LargeSizes[] = {16U, 64U, 128U, 256U, 512U, 1024U};
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    return malloc(amount);
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    free(pointer);
+}
+
+/// Returns the bus time of one transfer in nanoseconds; the frame count is stored into the output argument.
+static uint64_t transferTimeNs(const size_t   payload_size,
+                               const size_t   mtu,
+                               const bool     brs,
+                               const uint32_t nominal_bitrate,
+                               const uint32_t data_bitrate,
+                               size_t* const  out_frames)
+{
+    static uint8_t payload[MAX_PAYLOAD_SIZE];
+    CanardInstance ins = canardInit(&memAllocate, &memFree);
+    ins.node_id        = 42U;
+    ins.mtu_bytes      = mtu;
+    const CanardTransfer transfer = {
+        .timestamp_usec = 0U,
+        .priority       = CanardPriorityNominal,
+        .transfer_kind  = CanardTransferKindResponse,
+        .port_id        = 408U,
+        .remote_node_id = 43U,
+        .transfer_id    = 0U,
+        .payload_size   = payload_size,
+        .payload        = payload,
+    };
+    if (canardTxPush(&ins, &transfer) < 0)
+    {
+        (void) fprintf(stderr, "Could not push a transfer of %zu bytes\n", payload_size);
+        exit(EXIT_FAILURE);
+    }
+    uint64_t out    = 0;
+    size_t   frames = 0;
+    for (const CanardFrame* frame = canardTxPeek(&ins); frame != NULL; frame = canardTxPeek(&ins))
+    {
+        // Same as socketcanPush(): the frames that fit into 8 bytes are emitted as Classic CAN frames.
+        const BusLoadFrameFormat format = (frame->payload_size <= CANARD_MTU_CAN_CLASSIC)
+                                              ? BusLoadFrameFormatClassic
+                                              : (brs ? BusLoadFrameFormatFDBRS : BusLoadFrameFormatFD);
+        out += busloadComputeFrameTimeNs(busloadComputeFrameBits(frame->payload_size, format, BusLoadStuffingExpected),
+                                         nominal_bitrate,
+                                         brs ? data_bitrate : 0U);
+        frames++;
+        canardTxPop(&ins);
+        ins.memory_free(&ins, (void*) frame);
+    }
+    *out_frames = frames;
+    return out;
+}
+
+int main(const int argc, const char* const argv[])
+{
+    const uint32_t nominal_bitrate = (argc > 1) ? (uint32_t) strtoul(argv[1], NULL, 10) : 500000U;
+    const uint32_t data_bitrate    = (argc > 2) ? (uint32_t) strtoul(argv[2], NULL, 10) : 2000000U;
+    const uint32_t large_rate_hz   = (argc > 3) ? (uint32_t) strtoul(argv[3], NULL, 10) : 10U;
+
+    // The periodic messages are always Classic CAN, so their share of the bus is the same in all scenarios.
+    uint64_t periodic_ns = 0;
+    for (size_t i = 0; i < (sizeof(PeriodicMessages) / sizeof(PeriodicMessages[0])); i++)
+    {
+        size_t frames = 0;
+        periodic_ns += PeriodicMessages[i].rate_hz * transferTimeNs(PeriodicMessages[i].size,
+                                                                    CANARD_MTU_CAN_CLASSIC,
+                                                                    false,
+                                                                    nominal_bitrate,
+                                                                    data_bitrate,
+                                                                    &frames);
+    }
+    const double second_ns = 1e9;
+    (void) printf("Periodic traffic: %.2f%% of the bus\n", 100.0 * (double) periodic_ns / second_ns);
+    (void) printf("Large transfers at %u Hz; throughput is the payload rate with the rest of the bus saturated\n\n",
+                  large_rate_hz);
+    (void) printf("%-8s %-14s %7s %12s %10s %14s\n", "size", "scenario", "frames", "usec/xfer", "load_pct",
+                  "max_kbyte/s");
+    for (size_t i = 0; i < (sizeof(LargeSizes) / sizeof(LargeSizes[0])); i++)
+    {
+        for (size_t k = 0; k < (sizeof(Scenarios) / sizeof(Scenarios[0])); k++)
+        {
+            const Scenario* const sc     = &Scenarios[k];
+            size_t                frames = 0;
+            const uint64_t        xfer_ns =
+                transferTimeNs(LargeSizes[i], sc->large_mtu, sc->brs, nominal_bitrate, data_bitrate, &frames);
+            const double load = ((double) periodic_ns + ((double) large_rate_hz * (double) xfer_ns)) / second_ns;
+            const double throughput =
+                ((second_ns - (double) periodic_ns) / (double) xfer_ns) * (double) LargeSizes[i] / 1e3;
+            (void) printf("%-8zu %-14s %7zu %12.1f %10.2f %14.1f\n",
+                          LargeSizes[i],
+                          sc->name,
+                          frames,
+                          (double) xfer_ns / 1e3,
+                          100.0 * load,
+                          throughput);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,155 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Publication cost of a single-frame periodic message: canardTxPush(), which validates the transfer and serializes
+/// the frame every time, against periodicPublish(), which patches the prebuilt frame of the slot and inserts a copy
+/// with canardTxPushFrameUnchecked(). Each publication is pushed into a TX queue that holds a backlog of
+/// lower-priority frames, then popped again, so that the queue does not grow. Reported per publication: the time of
+/// the push and the pop, measured over the whole run, because reading the clock around every call would cost as much
+/// as the call.
+///
+///     periodic-bench [<backlog-frames> [<publications>]]
+
+#include "periodic.h"
+#include <canard_dsdl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NODE_ID 42U
+#define SUBJECT_ID 7509U
+#define BACKLOG_SUBJECT_ID 4000U
+#define PAYLOAD_SIZE 7U
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    return malloc(amount);
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    free(pointer);
+}
+
+static uint64_t getMonotonicNanoseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+static void updatePayload(void* const context, uint8_t* const payload, const CanardMicrosecond now_usec)
+{
+    (void) context;
+    canardDSDLSetUxx(payload, 0U, now_usec, 32U);
+}
+
+/// Fills the queue with frames of a lower priority, so that the publications are inserted in front of them.
+static int pushBacklog(CanardInstance* const ins, const size_t frames)
+{
+    const uint8_t payload[PAYLOAD_SIZE] = {0};
+    for (size_t i = 0; i < frames; i++)
+    {
+        const CanardTransfer transfer = {
+            .timestamp_usec = 0U,
+            .priority       = CanardPriorityOptional,
+            .transfer_kind  = CanardTransferKindMessage,
+            .port_id        = BACKLOG_SUBJECT_ID,
+            .remote_node_id = CANARD_NODE_ID_UNSET,
+            .transfer_id    = (CanardTransferID)(i & CANARD_TRANSFER_ID_MAX),
+            .payload_size   = sizeof(payload),
+            .payload        = &payload[0],
+        };
+        if (canardTxPush(ins, &transfer) < 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void drain(CanardInstance* const ins)
+{
+    for (const CanardFrame* txf = canardTxPeek(ins); txf != NULL; txf = canardTxPeek(ins))
+    {
+        canardTxPop(ins);
+        ins->memory_free(ins, (void*) txf);
+    }
+}
+
+int main(const int argc, const char* const argv[])
+{
+    const size_t backlog      = (argc > 1) ? (size_t) strtoul(argv[1], NULL, 10) : 16U;
+    const size_t publications = (argc > 2) ? (size_t) strtoul(argv[2], NULL, 10) : 1000000U;
+    if (publications == 0U)
+    {
+        (void) fprintf(stderr, "Usage: %s [<backlog-frames> [<publications>]]\n", argv[0]);
+        return 1;
+    }
+    CanardInstance ins = canardInit(&memAllocate, &memFree);
+    ins.node_id        = NODE_ID;
+    ins.mtu_bytes      = CANARD_MTU_CAN_CLASSIC;
+    PeriodicEngine engine;
+    periodicInit(&engine, &ins);
+    const int slot = periodicAdd(&engine, SUBJECT_ID, CanardPriorityNominal, PAYLOAD_SIZE, 0U, 0U, NULL, NULL, 0U);
+    if ((slot < 0) || (pushBacklog(&ins, backlog) < 0))
+    {
+        (void) fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    (void) printf("%zu publications of %u bytes, %zu frames of lower priority queued\n",
+                  publications,
+                  PAYLOAD_SIZE,
+                  backlog);
+    (void) printf("| method          | ns/publication |\n");
+    (void) printf("|-----------------|---------------:|\n");
+    for (int prebuilt = 0; prebuilt <= 1; prebuilt++)
+    {
+        uint8_t        payload[PAYLOAD_SIZE] = {0};
+        const uint64_t started               = getMonotonicNanoseconds();
+        for (size_t i = 0; i < publications; i++)
+        {
+            int32_t result = 0;
+            if (prebuilt != 0)
+            {
+                updatePayload(NULL, periodicGetPayload(&engine, slot), i);
+                result = periodicPublish(&engine, slot, i);
+            }
+            else
+            {
+                updatePayload(NULL, &payload[0], i);
+                const CanardTransfer transfer = {
+                    .timestamp_usec = i,
+                    .priority       = CanardPriorityNominal,
+                    .transfer_kind  = CanardTransferKindMessage,
+                    .port_id        = SUBJECT_ID,
+                    .remote_node_id = CANARD_NODE_ID_UNSET,
+                    .transfer_id    = (CanardTransferID)(i & CANARD_TRANSFER_ID_MAX),
+                    .payload_size   = sizeof(payload),
+                    .payload        = &payload[0],
+                };
+                result = canardTxPush(&ins, &transfer);
+            }
+            if (result != 1)
+            {
+                (void) fprintf(stderr, "Push failed: %d\n", (int) result);
+                drain(&ins);
+                return 1;
+            }
+            const CanardFrame* const txf = canardTxPeek(&ins);  // The publication is ahead of the backlog.
+            canardTxPop(&ins);
+            ins.memory_free(&ins, (void*) txf);
+        }
+        const uint64_t elapsed = getMonotonicNanoseconds() - started;
+        (void) printf("| %-15s | %14.1f |\n",
+                      (prebuilt != 0) ? "periodicPublish" : "canardTxPush",
+                      (double) elapsed / (double) publications);
+    }
+    drain(&ins);
+    return 0;
+}
@@ -0,0 +1,49 @@
+#!/bin/sh
+# This software is distributed under the terms of the MIT License.
+# Copyright (c) 2020 Hugo A. Garcia
+# Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+#
+# Builds the node and the benchmarks with and without profile-guided optimization, reports which translation units
+# of the node were trained, and the speedups of the hot paths and functions measured by codegen-bench, whose objects
+# are always trained. Usage:
+#
+#     tools/pgo.sh [build-directory] [extra-cmake-arguments...]
+#
+# The PGO build is left in <build-directory>/pgo; the profile is in <build-directory>/pgo/pgo-profile.
+
+set -e
+src=$(cd "$(dirname "$0")/.." && pwd)
+out=${1:-$src/_pgo}
+[ $# -gt 0 ] && shift
+
+cmake -S "$src" -B "$out/base" -DCMAKE_BUILD_TYPE=Release "$@"
+cmake --build "$out/base" -j"$(nproc)"
+
+cmake -S "$src" -B "$out/pgo" -DCMAKE_BUILD_TYPE=Release -DPGO=GENERATE "$@"
+cmake --build "$out/pgo" -j"$(nproc)" --target pgo-train
+
+# The profile only applies to the objects that ran during the training; the main loop of the node and the amalgamated
+# node need the CAN interface of tools/pgo_vcan.sh. GCC writes one file per object, Clang one merged profile.
+profile=$out/pgo/pgo-profile
+for unit in main amalgamation; do
+    if ls "$profile" | grep -q "#src#$unit\.c\.gcda\$" || { [ -f "$profile/default.profdata" ] &&
+        llvm-profdata show --all-functions "$profile/default.profdata" |
+        grep -q "$unit\.c:transmitPendingFrames"; }; then
+        echo "src/$unit.c: trained"
+    else
+        echo "src/$unit.c: not trained, optimized without a profile"
+    fi
+done
+cmake -S "$src" -B "$out/pgo" -DPGO=USE
+cmake --build "$out/pgo" -j"$(nproc)" --clean-first
+
+# Best of five runs of each variant.
+best()
+{
+    for _ in 1 2 3 4 5; do "$1"; done | awk '{ if (!($1 in t) || ($2 < t[$1])) { t[$1] = $2 } ; if (!($1 in o)) { o[$1] = n++ } }
+        END { for (k in t) { print o[k], k, t[k] } }' | sort -n | cut -d' ' -f2-
+}
+best "$out/base/codegen-bench" > "$out/base.txt"
+best "$out/pgo/codegen-bench" > "$out/pgo.txt"
+printf '%-18s %10s %10s %8s\n' function base_ns pgo_ns speedup
+paste -d' ' "$out/base.txt" "$out/pgo.txt" | awk '{ printf "%-18s %10.1f %10.1f %7.2fx\n", $1, $2, $4, $2 / $4 }'
@@ -0,0 +1,40 @@
+#!/bin/sh
+# This software is distributed under the terms of the MIT License.
+# Copyright (c) 2020 Hugo A. Garcia
+# Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+#
+# The part of the PGO training workload that needs a CAN interface (see the pgo-train target): the node and the
+# amalgamated node run side by side on it for a few seconds, each replaying a synthetic trace at 1 kHz, so that both
+# receive the traffic of the other; then file-read-bench moves its responses through the interface. Usage:
+#
+#     tools/pgo_vcan.sh <iface-name> <node> <amalgamated-node> <file-read-bench>
+#
+# The nodes record into their usual flight recorder file. The scenario is skipped if the interface is not up, e.g.:
+#
+#     ip link add dev vcan0 type vcan && ip link set vcan0 mtu 72 up
+
+set -e
+iface=$1
+seconds=5
+
+if ! ip link show "$iface" up 2>/dev/null | grep -q .; then
+    echo "pgo_vcan.sh: $iface is not up, the node is not trained"
+    exit 0
+fi
+
+trace=$(mktemp)
+trap 'rm -f "$trace"' EXIT
+# A target slowly moving between 50 and 150 cm, one reading every 50 ms, replayed 20 times faster.
+awk 'BEGIN { for (i = 0; i < 20000; i++) { printf "%d distance=%.1f\n", i * 50000, 100 + 50 * sin(i / 40) } }' > "$trace"
+
+"$2" "$iface" 42 "$trace" 20 &
+node=$!
+"$3" "$iface" 43 "$trace" 20 &
+amalgamated=$!
+sleep "$seconds"
+# The nodes write their profiles when they exit normally, which they do on SIGTERM.
+kill -TERM "$node" "$amalgamated"
+wait "$node"
+wait "$amalgamated"
+
+"$4" -i "$iface" 260 20000
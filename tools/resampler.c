@@ -0,0 +1,203 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+
+#include "resampler.h"
+#include <assert.h>
+#include <canard_dsdl.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <ultrasound_layout.h>
+
+typedef float ResamplerVector __attribute__((vector_size(RESAMPLER_VECTOR_SIZE)));
+
+#define RESAMPLER_LANES (RESAMPLER_VECTOR_SIZE / sizeof(float))
+
+static_assert((RESAMPLER_BUFFER_CAPACITY & (RESAMPLER_BUFFER_CAPACITY - 1U)) == 0U, "Shall be a power of two");
+static_assert((RESAMPLER_CHANNELS % RESAMPLER_LANES) == 0U, "The channels shall fill whole vectors");
+
+void resamplerInit(Resampler* const    resampler,
+                   const ResamplerMode mode,
+                   const uint64_t      period_usec,
+                   const uint64_t      latency_usec,
+                   const uint64_t      max_hold_usec)
+{
+    (void) memset(resampler, 0, sizeof(Resampler));
+    resampler->mode          = mode;
+    resampler->period_usec   = period_usec;
+    resampler->latency_usec  = latency_usec;
+    resampler->max_hold_usec = max_hold_usec;
+}
+
+int resamplerAccept(Resampler* const resampler, const CanardTransfer* const transfer)
+{
+    const CanardDSDLView view = {(const uint8_t*) transfer->payload, transfer->payload_size};
+    return resamplerUpdate(resampler,
+                           transfer->remote_node_id,
+                           transfer->timestamp_usec,
+                           ultrasoundDistanceGetCentimeters(view));
+}
+
+static uint32_t resamplerIndex(const ResamplerChannel* const channel, const uint32_t offset)
+{
+    return (channel->tail + offset) % RESAMPLER_BUFFER_CAPACITY;
+}
+
+int resamplerUpdate(Resampler* const   resampler,
+                    const CanardNodeID channel_id,
+                    const uint64_t     timestamp_usec,
+                    const float        value)
+{
+    if (channel_id >= RESAMPLER_CHANNELS)
+    {
+        return -EINVAL;
+    }
+    ResamplerChannel* const channel = &resampler->channels[channel_id];
+    if ((channel->count > 0U) &&
+        (timestamp_usec < channel->timestamps_usec[resamplerIndex(channel, channel->count - 1U)]))
+    {
+        channel->late++;  // The buffer is kept in the order of time.
+        return 0;
+    }
+    if (channel->count == RESAMPLER_BUFFER_CAPACITY)
+    {
+        channel->tail = resamplerIndex(channel, 1U);
+        channel->count--;
+        channel->overruns++;
+    }
+    const uint32_t index            = resamplerIndex(channel, channel->count);
+    channel->timestamps_usec[index] = timestamp_usec;
+    channel->values[index]          = value;
+    channel->count++;
+    if (resampler->next_frame_usec == 0U)
+    {
+        resampler->next_frame_usec = ((timestamp_usec / resampler->period_usec) + 1U) * resampler->period_usec;
+    }
+    return 0;
+}
+
+/// Fills the lane of the channel with the operands of the interpolation at the frame time and updates the statistics.
+static void resamplerPrepare(Resampler* const resampler, const size_t channel_id, const uint64_t frame_usec)
+{
+    ResamplerChannel* const channel = &resampler->channels[channel_id];
+    // Only the last sample not later than the frame time and the ones after it can be of use for this frame and on.
+    while ((channel->count >= 2U) && (channel->timestamps_usec[resamplerIndex(channel, 1U)] <= frame_usec))
+    {
+        channel->tail = resamplerIndex(channel, 1U);
+        channel->count--;
+    }
+    float    offset  = 0.0F;
+    float    span    = 1.0F;
+    float    earlier = NAN;
+    float    later   = NAN;
+    uint64_t error   = 0U;
+    if (channel->count > 0U)
+    {
+        const uint64_t t0 = channel->timestamps_usec[channel->tail];
+        if ((t0 > frame_usec) || ((frame_usec - t0) > resampler->max_hold_usec))
+        {
+            channel->missing++;  // Before the first sample of the channel, or the channel went silent.
+        }
+        else if ((resampler->mode == ResamplerModeInterpolate) && (channel->count >= 2U))
+        {
+            const uint32_t next = resamplerIndex(channel, 1U);
+            const uint64_t t1   = channel->timestamps_usec[next];
+            offset              = (float) (frame_usec - t0);
+            span                = (float) (t1 - t0);
+            earlier             = channel->values[channel->tail];
+            later               = channel->values[next];
+            error               = ((frame_usec - t0) < (t1 - frame_usec)) ? (frame_usec - t0) : (t1 - frame_usec);
+            channel->interpolated++;
+        }
+        else
+        {
+            earlier = channel->values[channel->tail];
+            later   = earlier;
+            error   = frame_usec - t0;
+            channel->held++;
+        }
+        channel->error_sum_usec += error;
+        channel->error_max_usec = (error > channel->error_max_usec) ? error : channel->error_max_usec;
+    }
+    resampler->offsets[channel_id] = offset;
+    resampler->spans[channel_id]   = span;
+    resampler->earlier[channel_id] = earlier;
+    resampler->later[channel_id]   = later;
+}
+
+bool resamplerPoll(Resampler* const resampler, const uint64_t now_usec, ResamplerFrame* const out_frame)
+{
+    const uint64_t frame_usec = resampler->next_frame_usec;
+    if ((frame_usec == 0U) || (now_usec < (frame_usec + resampler->latency_usec)))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < RESAMPLER_CHANNELS; i++)
+    {
+        resamplerPrepare(resampler, i, frame_usec);
+    }
+    resamplerInterpolate(&resampler->offsets[0],
+                         &resampler->spans[0],
+                         &resampler->earlier[0],
+                         &resampler->later[0],
+                         &out_frame->values[0],
+                         RESAMPLER_CHANNELS);
+    out_frame->timestamp_usec = frame_usec;
+    resampler->next_frame_usec += resampler->period_usec;
+    resampler->frames++;
+    return true;
+}
+
+void resamplerInterpolate(const float* const offsets,
+                          const float* const spans,
+                          const float* const earlier,
+                          const float* const later,
+                          float* const       out,
+                          const size_t       count)
+{
+    for (size_t i = 0; i < count; i += RESAMPLER_LANES)
+    {
+        ResamplerVector o;
+        ResamplerVector s;
+        ResamplerVector e;
+        ResamplerVector l;
+        (void) memcpy(&o, &offsets[i], sizeof(o));
+        (void) memcpy(&s, &spans[i], sizeof(s));
+        (void) memcpy(&e, &earlier[i], sizeof(e));
+        (void) memcpy(&l, &later[i], sizeof(l));
+        const ResamplerVector v = e + ((l - e) * (o / s));
+        (void) memcpy(&out[i], &v, sizeof(v));
+    }
+}
+
+void resamplerWriteMetrics(const Resampler* const resampler, MetricsSink* const sink)
+{
+    char labels[48];
+    for (size_t i = 0; i < RESAMPLER_CHANNELS; i++)
+    {
+        const ResamplerChannel* const channel = &resampler->channels[i];
+        const uint64_t                aligned = channel->interpolated + channel->held;
+        if (channel->count > 0U)
+        {
+            (void) snprintf(labels, sizeof(labels), "node=\"%zu\"", i);
+            metricsGauge(sink,
+                         "resampler_alignment_error_mean_seconds",
+                         labels,
+                         (aligned > 0U) ? ((double) channel->error_sum_usec * 1e-6 / (double) aligned) : 0.0);
+            metricsGauge(sink,
+                         "resampler_alignment_error_max_seconds",
+                         labels,
+                         (double) channel->error_max_usec * 1e-6);
+            metricsGauge(sink, "resampler_overruns_total", labels, (double) channel->overruns);
+            metricsGauge(sink, "resampler_late_samples_total", labels, (double) channel->late);
+            (void) snprintf(labels, sizeof(labels), "node=\"%zu\",kind=\"interpolated\"", i);
+            metricsGauge(sink, "resampler_values_total", labels, (double) channel->interpolated);
+            (void) snprintf(labels, sizeof(labels), "node=\"%zu\",kind=\"held\"", i);
+            metricsGauge(sink, "resampler_values_total", labels, (double) channel->held);
+            (void) snprintf(labels, sizeof(labels), "node=\"%zu\",kind=\"missing\"", i);
+            metricsGauge(sink, "resampler_values_total", labels, (double) channel->missing);
+        }
+    }
+}
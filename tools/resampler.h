@@ -0,0 +1,126 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Streaming resampler of the distance messages (subject 1610) of many nodes onto a common time grid, for the fusion
+/// code on the master side. Each node is a channel with a small buffer of its latest samples; the frames are produced
+/// at the multiples of the period in the time base of the reception timestamps, so that several resamplers agree on
+/// the grid. A frame is produced once the latency has elapsed after its time, which bounds the added latency and
+/// leaves the time for the samples that follow the frame time to arrive.
+///
+/// The value of a channel at the frame time is interpolated linearly between the samples around it, or the last
+/// value is held, depending on the mode. A channel whose next sample is late is held even in the interpolation mode;
+/// a channel without a sample within max_hold before the frame time is missing (NaN). The samples around the frame
+/// time are found per channel in amortized constant time, because the frame time only moves forward; then all
+/// channels are interpolated at once with the SIMD instructions of the target (the GCC vector extensions; NEON on the
+/// Raspberry Pi, SSE on x86-64), four channels per instruction.
+///
+/// The alignment error of a channel is the distance in time from the frame time to the nearest sample used; it is
+/// zero if a sample falls on the grid, and half of the input period at most when interpolating a regular stream.
+
+#ifndef RESAMPLER_H_INCLUDED
+#define RESAMPLER_H_INCLUDED
+
+#include "metrics.h"
+#include <canard.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RESAMPLER_CHANNELS (CANARD_NODE_ID_MAX + 1U)
+/// Shall be a power of two and hold the samples of a channel that arrive within the latency plus one period.
+#define RESAMPLER_BUFFER_CAPACITY 32U
+/// The width of the SIMD registers in bytes; the number of channels shall be a multiple of the number of lanes.
+#define RESAMPLER_VECTOR_SIZE 16U
+
+typedef enum
+{
+    ResamplerModeInterpolate = 0,
+    ResamplerModeHold,
+} ResamplerMode;
+
+typedef struct ResamplerFrame
+{
+    uint64_t timestamp_usec;
+    float    values[RESAMPLER_CHANNELS];  ///< Indexed by the node-ID; NaN if the channel is missing.
+} ResamplerFrame;
+
+typedef struct ResamplerChannel
+{
+    uint64_t timestamps_usec[RESAMPLER_BUFFER_CAPACITY];
+    float    values[RESAMPLER_BUFFER_CAPACITY];
+    uint32_t tail;  ///< The oldest sample kept.
+    uint32_t count;
+
+    // Statistics.
+    uint64_t interpolated;
+    uint64_t held;
+    uint64_t missing;   ///< Only counted after the first sample of the channel.
+    uint64_t overruns;  ///< The samples lost because the buffer was full.
+    uint64_t late;      ///< The samples dropped because they are older than a frame already produced.
+    uint64_t error_sum_usec;
+    uint64_t error_max_usec;
+} ResamplerChannel;
+
+typedef struct Resampler
+{
+    ResamplerMode mode;
+    uint64_t      period_usec;
+    uint64_t      latency_usec;
+    uint64_t      max_hold_usec;
+    uint64_t      next_frame_usec;  ///< Zero until the first sample.
+    uint64_t      frames;
+
+    ResamplerChannel channels[RESAMPLER_CHANNELS];
+
+    // The operands of the interpolation, one lane per channel, filled for every frame.
+    _Alignas(RESAMPLER_VECTOR_SIZE) float offsets[RESAMPLER_CHANNELS];  ///< From the earlier sample to the frame.
+    _Alignas(RESAMPLER_VECTOR_SIZE) float spans[RESAMPLER_CHANNELS];    ///< Between the samples; never zero.
+    _Alignas(RESAMPLER_VECTOR_SIZE) float earlier[RESAMPLER_CHANNELS];
+    _Alignas(RESAMPLER_VECTOR_SIZE) float later[RESAMPLER_CHANNELS];
+} Resampler;
+
+/// The latency shall be longer than the input period plus the reception jitter for the interpolation to be possible;
+/// a shorter latency holds the last value instead.
+void resamplerInit(Resampler* const    resampler,
+                   const ResamplerMode mode,
+                   const uint64_t      period_usec,
+                   const uint64_t      latency_usec,
+                   const uint64_t      max_hold_usec);
+
+/// Buffers a distance transfer received from the subject; the timestamp of the sample is that of the transfer.
+/// Returns zero on success, -EINVAL if the publisher is anonymous.
+int resamplerAccept(Resampler* const resampler, const CanardTransfer* const transfer);
+
+/// The same as resamplerAccept() for a sample that was decoded elsewhere. The samples of a channel shall come in the
+/// order of their timestamps. Returns zero on success, -EINVAL if the channel is out of range.
+int resamplerUpdate(Resampler* const   resampler,
+                    const CanardNodeID channel_id,
+                    const uint64_t     timestamp_usec,
+                    const float        value);
+
+/// Produces the next frame if its time plus the latency has passed; invoke until it returns false. The time
+/// complexity is linear in the number of channels.
+bool resamplerPoll(Resampler* const resampler, const uint64_t now_usec, ResamplerFrame* const out_frame);
+
+/// The kernel of the interpolation, exposed for the benchmark: out = earlier + (later - earlier) * offsets / spans
+/// for count channels; count shall be a multiple of the number of lanes and the arrays aligned to the vector size.
+void resamplerInterpolate(const float* const offsets,
+                          const float* const spans,
+                          const float* const earlier,
+                          const float* const later,
+                          float* const       out,
+                          const size_t       count);
+
+/// Writes the alignment error and the counters of the channels that have received samples.
+void resamplerWriteMetrics(const Resampler* const resampler, MetricsSink* const sink);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
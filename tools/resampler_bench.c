@@ -0,0 +1,181 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Evaluation of the resampler (resampler.h) on synthetic traffic: the nodes publish a smooth distance signal at
+/// 20 Hz with random phases and 0-400 us of reception jitter, which is resampled onto a 50 Hz grid with 60 ms of
+/// latency, once with interpolation and once holding the last value. Reported per mode: the alignment error, the error
+/// of the values against the signal at the frame time, and the cost of a frame; then the cost of the interpolation
+/// kernel of 128 channels, vectorized and scalar.
+///
+///     resampler-bench [<nodes> [<seconds>]]
+
+#include "resampler.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define INPUT_PERIOD_USEC 50000U
+#define INPUT_JITTER_USEC 400U
+#define OUTPUT_PERIOD_USEC 20000U
+#define LATENCY_USEC 60000U
+#define MAX_HOLD_USEC 200000U
+#define START_USEC 1600000000000000ULL
+#define KERNEL_ITERATIONS 1000000U
+
+static uint64_t getMonotonicNanoseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+/// A target moving back and forth in front of each node, with a period of two seconds.
+static float getSignal(const size_t node, const uint64_t timestamp_usec)
+{
+    const double seconds = (double) (timestamp_usec - START_USEC) * 1e-6;
+    return (float) (100.0 + (50.0 * sin((seconds * M_PI) + (double) node)));
+}
+
+static void evaluate(const ResamplerMode mode, const size_t nodes, const uint64_t seconds)
+{
+    static Resampler      resampler;
+    static ResamplerFrame frame;
+    resamplerInit(&resampler, mode, OUTPUT_PERIOD_USEC, LATENCY_USEC, MAX_HOLD_USEC);
+    uint64_t next_usec[RESAMPLER_CHANNELS];
+    unsigned seed = 1U;
+    for (size_t n = 0; n < nodes; n++)
+    {
+        next_usec[n] = START_USEC + ((uint64_t) rand_r(&seed) % INPUT_PERIOD_USEC);
+    }
+    const uint64_t end_usec    = START_USEC + (seconds * 1000000U);
+    double         value_sum   = 0.0;
+    double         value_max   = 0.0;
+    uint64_t       values      = 0U;
+    uint64_t       poll_ns     = 0U;
+    uint64_t       now_usec    = START_USEC;
+    while (now_usec < end_usec)
+    {
+        size_t node = 0U;
+        for (size_t n = 1; n < nodes; n++)
+        {
+            node = (next_usec[n] < next_usec[node]) ? n : node;
+        }
+        // The jitter delays the reception; the samples of a node stay in order because it is less than the period.
+        now_usec = next_usec[node] + ((uint64_t) rand_r(&seed) % INPUT_JITTER_USEC);
+        (void) resamplerUpdate(&resampler, (CanardNodeID) node, now_usec, getSignal(node, next_usec[node]));
+        next_usec[node] += INPUT_PERIOD_USEC;
+
+        const uint64_t started = getMonotonicNanoseconds();
+        while (resamplerPoll(&resampler, now_usec, &frame))
+        {
+            poll_ns += getMonotonicNanoseconds() - started;
+            for (size_t n = 0; n < nodes; n++)
+            {
+                if (!isnan(frame.values[n]))
+                {
+                    const double error = fabs((double) (frame.values[n] - getSignal(n, frame.timestamp_usec)));
+                    value_sum += error;
+                    value_max = (error > value_max) ? error : value_max;
+                    values++;
+                }
+            }
+        }
+    }
+    uint64_t error_sum = 0U;
+    uint64_t error_max = 0U;
+    uint64_t aligned   = 0U;
+    uint64_t held      = 0U;
+    for (size_t n = 0; n < nodes; n++)
+    {
+        const ResamplerChannel* const channel = &resampler.channels[n];
+        error_sum += channel->error_sum_usec;
+        error_max = (channel->error_max_usec > error_max) ? channel->error_max_usec : error_max;
+        aligned += channel->interpolated + channel->held;
+        held += channel->held;
+    }
+    (void) printf("%-11s %llu frames, %llu values (%llu held): alignment error mean %.0f us max %llu us; "
+                  "value error mean %.3f cm max %.3f cm; %.0f ns per frame\n",
+                  (mode == ResamplerModeInterpolate) ? "interpolate" : "hold",
+                  (unsigned long long) resampler.frames,
+                  (unsigned long long) values,
+                  (unsigned long long) held,
+                  (aligned > 0U) ? ((double) error_sum / (double) aligned) : 0.0,
+                  (unsigned long long) error_max,
+                  (values > 0U) ? (value_sum / (double) values) : 0.0,
+                  value_max,
+                  (resampler.frames > 0U) ? ((double) poll_ns / (double) resampler.frames) : 0.0);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+__attribute__((optimize("no-tree-vectorize")))
+#endif
+static void interpolateScalar(const float* const offsets,
+                              const float* const spans,
+                              const float* const earlier,
+                              const float* const later,
+                              float* const       out,
+                              const size_t       count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        out[i] = earlier[i] + ((later[i] - earlier[i]) * (offsets[i] / spans[i]));
+    }
+}
+
+static void benchmarkKernel(void)
+{
+    static _Alignas(RESAMPLER_VECTOR_SIZE) float offsets[RESAMPLER_CHANNELS];
+    static _Alignas(RESAMPLER_VECTOR_SIZE) float spans[RESAMPLER_CHANNELS];
+    static _Alignas(RESAMPLER_VECTOR_SIZE) float earlier[RESAMPLER_CHANNELS];
+    static _Alignas(RESAMPLER_VECTOR_SIZE) float later[RESAMPLER_CHANNELS];
+    static _Alignas(RESAMPLER_VECTOR_SIZE) float out_vector[RESAMPLER_CHANNELS];
+    static _Alignas(RESAMPLER_VECTOR_SIZE) float out_scalar[RESAMPLER_CHANNELS];
+    for (size_t i = 0; i < RESAMPLER_CHANNELS; i++)
+    {
+        offsets[i] = (float) (i * 97U % 50000U);
+        spans[i]   = 50000.0F;
+        earlier[i] = (float) i;
+        later[i]   = (float) (i + 10U);
+    }
+    uint64_t started = getMonotonicNanoseconds();
+    for (size_t k = 0; k < KERNEL_ITERATIONS; k++)
+    {
+        resamplerInterpolate(offsets, spans, earlier, later, out_vector, RESAMPLER_CHANNELS);
+        __asm__ volatile("" : : "r"(out_vector) : "memory");  // Keeps the iterations from being merged.
+    }
+    const uint64_t vector_ns = getMonotonicNanoseconds() - started;
+    started                  = getMonotonicNanoseconds();
+    for (size_t k = 0; k < KERNEL_ITERATIONS; k++)
+    {
+        interpolateScalar(offsets, spans, earlier, later, out_scalar, RESAMPLER_CHANNELS);
+        __asm__ volatile("" : : "r"(out_scalar) : "memory");
+    }
+    const uint64_t scalar_ns = getMonotonicNanoseconds() - started;
+    size_t         mismatches = 0U;
+    for (size_t i = 0; i < RESAMPLER_CHANNELS; i++)
+    {
+        mismatches += (out_vector[i] != out_scalar[i]) ? 1U : 0U;
+    }
+    (void) printf("kernel of %u channels: vectorized %.1f ns, scalar %.1f ns, %zu mismatches\n",
+                  (unsigned) RESAMPLER_CHANNELS,
+                  (double) vector_ns / KERNEL_ITERATIONS,
+                  (double) scalar_ns / KERNEL_ITERATIONS,
+                  mismatches);
+}
+
+int main(const int argc, const char* const argv[])
+{
+    const size_t   nodes   = (argc > 1) ? (size_t) atoi(argv[1]) : 16U;
+    const uint64_t seconds = (argc > 2) ? (uint64_t) atoi(argv[2]) : 600U;
+    if ((nodes == 0U) || (nodes > RESAMPLER_CHANNELS) || (seconds == 0U))
+    {
+        (void) fprintf(stderr, "Usage: %s [<nodes, at most %u> [<seconds>]]\n", argv[0], (unsigned) RESAMPLER_CHANNELS);
+        return 1;
+    }
+    evaluate(ResamplerModeInterpolate, nodes, seconds);
+    evaluate(ResamplerModeHold, nodes, seconds);
+    benchmarkKernel();
+    return 0;
+}
@@ -0,0 +1,208 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// RX pipeline benchmark: many remote nodes publish multi-frame transfers on many subjects at the same time, so that
+/// the frames of every RX session are interleaved with the frames of all other sessions and the session states are
+/// evicted from the cache between accesses, as it happens on a busy bus. The cache misses are counted with
+/// perf_event_open(); build it twice to compare the session layouts (target rx-bench-compact):
+///
+///     rx-bench [rounds]
+///
+/// The counters are only enabled around canardRxAccept(); the first round, which allocates the sessions, is excluded.
+
+#include <canard.h>
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NUM_SUBJECTS 16U
+#define NUM_NODES (CANARD_NODE_ID_MAX + 1U)
+#define NUM_SESSIONS (NUM_SUBJECTS * NUM_NODES)
+#define PAYLOAD_SIZE 19U  ///< Three Classic CAN frames per transfer, CRC included.
+#define FRAMES_PER_TRANSFER 3U
+#define FRAME_INTERVAL_USEC 10U
+
+typedef struct
+{
+    const char* name;
+    uint32_t    type;
+    uint64_t    config;
+    int         fd;
+} Counter;
+
+static Counter Counters[] = {
+    {"cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, -1},
+    {"L1d-read-misses",
+     PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8U) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U),
+     -1},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1},
+};
+#define NUM_COUNTERS (sizeof(Counters) / sizeof(Counters[0]))
+
+static CanardFrame frames[NUM_SESSIONS * FRAMES_PER_TRANSFER];
+static uint8_t     frame_payloads[NUM_SESSIONS * FRAMES_PER_TRANSFER][CANARD_MTU_CAN_CLASSIC];
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    return malloc(amount);
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    free(pointer);
+}
+
+static void openCounters(void)
+{
+    for (size_t i = 0; i < NUM_COUNTERS; i++)
+    {
+        struct perf_event_attr attr;
+        (void) memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = Counters[i].type;
+        attr.config         = Counters[i].config;
+        attr.disabled       = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        Counters[i].fd      = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+}
+
+static void enableCounters(const bool enable)
+{
+    for (size_t i = 0; i < NUM_COUNTERS; i++)
+    {
+        if (Counters[i].fd >= 0)
+        {
+            (void) ioctl(Counters[i].fd, enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+}
+
+/// The frames of the same transfer from all sessions are interleaved: first frames of all sessions, then the second
+/// frames, and so on. The transfer-ID is patched in the tail bytes every round; it is not covered by the CRC.
+static void generateFrames(void)
+{
+    uint8_t payload[PAYLOAD_SIZE];
+    for (size_t i = 0; i < PAYLOAD_SIZE; i++)
+    {
+        payload[i] = (uint8_t) i;
+    }
+    for (size_t s = 0; s < NUM_SESSIONS; s++)
+    {
+        CanardInstance ins = canardInit(&memAllocate, &memFree);
+        ins.mtu_bytes      = CANARD_MTU_CAN_CLASSIC;
+        ins.node_id        = (CanardNodeID)(s % NUM_NODES);
+        const CanardTransfer transfer = {
+            .timestamp_usec = 0U,
+            .priority       = CanardPriorityNominal,
+            .transfer_kind  = CanardTransferKindMessage,
+            .port_id        = (CanardPortID)(1000U + (s / NUM_NODES)),
+            .remote_node_id = CANARD_NODE_ID_UNSET,
+            .transfer_id    = 0U,
+            .payload_size   = PAYLOAD_SIZE,
+            .payload        = payload,
+        };
+        (void) canardTxPush(&ins, &transfer);
+        for (size_t f = 0; f < FRAMES_PER_TRANSFER; f++)
+        {
+            const CanardFrame* const txf = canardTxPeek(&ins);
+            if (txf == NULL)
+            {
+                (void) fprintf(stderr, "Unexpected number of frames per transfer\n");
+                exit(EXIT_FAILURE);
+            }
+            const size_t index = (f * NUM_SESSIONS) + s;
+            (void) memcpy(frame_payloads[index], txf->payload, txf->payload_size);
+            frames[index]         = *txf;
+            frames[index].payload = frame_payloads[index];
+            canardTxPop(&ins);
+            ins.memory_free(&ins, (void*) txf);
+        }
+    }
+}
+
+int main(const int argc, const char* const argv[])
+{
+    const size_t rounds = (argc > 1) ? (size_t) strtoul(argv[1], NULL, 10) : 200U;
+
+    CanardInstance ins = canardInit(&memAllocate, &memFree);
+    ins.node_id        = 42U;
+    static CanardRxSubscription subscriptions[NUM_SUBJECTS];
+    for (size_t i = 0; i < NUM_SUBJECTS; i++)
+    {
+        (void) canardRxSubscribe(&ins,
+                                 CanardTransferKindMessage,
+                                 (CanardPortID)(1000U + i),
+                                 PAYLOAD_SIZE,
+                                 CANARD_DEFAULT_TRANSFER_ID_TIMEOUT_USEC,
+                                 &subscriptions[i]);
+    }
+    generateFrames();
+    openCounters();
+
+    CanardMicrosecond now_usec  = 1000000U;
+    uint64_t          transfers = 0;
+    struct timespec   started;
+    struct timespec   finished;
+    (void) memset(&started, 0, sizeof(started));
+    for (size_t r = 0; r <= rounds; r++)
+    {
+        const size_t num_frames = sizeof(frames) / sizeof(frames[0]);
+        for (size_t i = 0; i < num_frames; i++)
+        {
+            uint8_t* const tail = &frame_payloads[i][frames[i].payload_size - 1U];
+            *tail               = (uint8_t)((*tail & ~CANARD_TRANSFER_ID_MAX) | (r & CANARD_TRANSFER_ID_MAX));
+        }
+        if (r == 1U)
+        {
+            (void) clock_gettime(CLOCK_MONOTONIC, &started);
+        }
+        enableCounters(r > 0U);
+        for (size_t i = 0; i < num_frames; i++)
+        {
+            frames[i].timestamp_usec = now_usec;
+            now_usec += FRAME_INTERVAL_USEC;
+            CanardTransfer transfer;
+            if (canardRxAccept(&ins, &frames[i], 0, &transfer) > 0)
+            {
+                transfers += (r > 0U) ? 1U : 0U;
+                ins.memory_free(&ins, (void*) transfer.payload);
+            }
+        }
+        enableCounters(false);
+    }
+    (void) clock_gettime(CLOCK_MONOTONIC, &finished);
+
+    const double elapsed_ns = ((double) (finished.tv_sec - started.tv_sec) * 1e9) +
+                              (double) (finished.tv_nsec - started.tv_nsec);
+    const double num_frames = (double) rounds * (double) (sizeof(frames) / sizeof(frames[0]));
+    (void) printf("sessions %u, frames %.0f, transfers %llu (expected %llu)\n",
+                  NUM_SESSIONS,
+                  num_frames,
+                  (unsigned long long) transfers,
+                  (unsigned long long) rounds * NUM_SESSIONS);
+    (void) printf("%-18s %10.1f ns/frame\n", "time", elapsed_ns / num_frames);
+    for (size_t i = 0; i < NUM_COUNTERS; i++)
+    {
+        uint64_t value = 0;
+        if ((Counters[i].fd >= 0) && (read(Counters[i].fd, &value, sizeof(value)) == (ssize_t) sizeof(value)))
+        {
+            (void) printf("%-18s %10.3f per frame\n", Counters[i].name, (double) value / num_frames);
+        }
+        else
+        {
+            (void) printf("%-18s %10s\n", Counters[i].name, "n/a");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,200 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// Drives the measurement pipeline of the node (src/ultrasound.c) from a recorded trace as fast as possible, without
+/// the sensor and the CAN interface. The frames that would be transmitted are printed in the candump format without
+/// timestamps, so that the output of two versions of the pipeline can be compared against a golden file:
+///
+///     sensor-replay trace.txt > out.txt && diff golden.txt out.txt
+///
+/// The time base of the transfers is derived from the trace, so the output is deterministic. The trace is replayed
+/// the specified number of rounds; the frames are printed for the first one only, unless -q is given, and the
+/// throughput of the pipeline in samples per second is measured over the others and reported to stderr.
+/// Instead of a file, "synthetic:<samples>" generates a trace at 20 Hz with a slowly moving target.
+///
+///     sensor-replay [-q] <trace|synthetic:<samples>> [rounds]
+
+#include <sensor_replay.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <ultrasound.h>
+
+#define DISTANCE_SUBJECT_ID 1610U
+#define TX_DEADLINE_USEC 100000U
+#define SYNTHETIC_PERIOD_USEC 50000U
+#define SYNTHETIC_START_USEC 1000000U
+
+typedef struct
+{
+    UltrasoundPipeline pipeline;
+    bool               print;
+    size_t             frames;
+    uint32_t           last_tick;
+    bool               started;
+} Harness;
+
+static CanardMicrosecond ReplayNow;
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    return malloc(amount);
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    free(pointer);
+}
+
+static uint64_t getMonotonicNanoseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+static CanardMicrosecond getReplayMicroseconds(void)
+{
+    return ReplayNow;
+}
+
+static void drainFrames(Harness* const harness)
+{
+    CanardInstance* const ins = harness->pipeline.periodic->canard;
+    for (const CanardFrame* txf = canardTxPeek(ins); txf != NULL; txf = canardTxPeek(ins))
+    {
+        if (harness->print)
+        {
+            (void) printf("%08lX#", (unsigned long) txf->extended_can_id);
+            for (size_t i = 0; i < txf->payload_size; i++)
+            {
+                (void) printf("%02X", ((const uint8_t*) txf->payload)[i]);
+            }
+            (void) printf("\n");
+        }
+        canardTxPop(ins);
+        ins->memory_free(ins, (void*) txf);
+        harness->frames++;
+    }
+}
+
+/// The clock of the pipeline follows the trace; the ticks wrap around after 2^32 us but the clock does not.
+/// The readings are published and the frames are drained after every edge, like the main loop of the node does.
+static void onEcho(void* const context, const int level, const uint32_t tick)
+{
+    Harness* const harness = (Harness*) context;
+    ReplayNow += harness->started ? (uint32_t)(tick - harness->last_tick) : 0U;
+    harness->started   = true;
+    harness->last_tick = tick;
+    ultrasoundOnEcho(&harness->pipeline, level, tick);
+    (void) ultrasoundPoll(&harness->pipeline);
+    drainFrames(harness);
+}
+
+static SensorReplayEdge* generateSynthetic(const size_t samples)
+{
+    SensorReplayEdge* const edges = malloc(samples * 2U * sizeof(SensorReplayEdge));
+    uint32_t                rng   = 1U;
+    for (size_t i = 0; (edges != NULL) && (i < samples); i++)
+    {
+        rng                        = (rng * 1103515245U) + 12345U;
+        const uint32_t pulse_usec  = 2900U + (uint32_t)((i / 4U) % 400U) + ((rng >> 16U) % 8U);
+        const uint32_t falling     = (uint32_t)(SYNTHETIC_START_USEC + (i * SYNTHETIC_PERIOD_USEC));
+        edges[2U * i].tick         = falling - pulse_usec;
+        edges[2U * i].level        = SENSOR_LEVEL_HIGH;
+        edges[(2U * i) + 1U].tick  = falling;
+        edges[(2U * i) + 1U].level = SENSOR_LEVEL_LOW;
+    }
+    return edges;
+}
+
+int main(const int argc, const char* const argv[])
+{
+    int        arg   = 1;
+    const bool quiet = (argc > 1) && (0 == strcmp(argv[1], "-q"));
+    arg += quiet ? 1 : 0;
+    if ((argc - arg) < 1)
+    {
+        (void) fprintf(stderr, "Usage: %s [-q] <trace|synthetic:<samples>> [rounds]\n", argv[0]);
+        return 1;
+    }
+    const char* const trace  = argv[arg];
+    const size_t      rounds = ((argc - arg) > 1) ? (size_t) strtoul(argv[arg + 1], NULL, 10) : 1U;
+
+    SensorReplay      replay;
+    SensorReplayEdge* synthetic = NULL;
+    if (0 == strncmp(trace, "synthetic:", 10U))
+    {
+        const size_t samples = (size_t) strtoul(&trace[10], NULL, 10);
+        synthetic            = generateSynthetic(samples);
+        if ((synthetic == NULL) || (samples == 0U))
+        {
+            (void) fprintf(stderr, "Could not generate the trace\n");
+            return 1;
+        }
+        sensorReplayInit(&replay, synthetic, samples * 2U, 1.0);
+    }
+    else
+    {
+        const int16_t result = sensorReplayLoad(&replay, trace, 1.0);
+        if (result < 0)
+        {
+            (void) fprintf(stderr, "Could not load %s: errno %d\n", trace, -result);
+            return 1;
+        }
+    }
+
+    CanardInstance ins = canardInit(&memAllocate, &memFree);
+    ins.node_id        = 42U;
+    FlightRecorder recorder;
+    (void) memset(&recorder, 0, sizeof(recorder));  // Not open: the recording is disabled.
+    static PeriodicEngine periodic;
+    periodicInit(&periodic, &ins);
+    static Harness harness;
+    if (ultrasoundInit(&harness.pipeline,
+                       &periodic,
+                       &replay.base,
+                       &getReplayMicroseconds,
+                       &recorder,
+                       DISTANCE_SUBJECT_ID,
+                       TX_DEADLINE_USEC) < 0)
+    {
+        (void) fprintf(stderr, "Could not set up the pipeline\n");
+        return 1;
+    }
+
+    uint64_t started_at = 0;
+    uint64_t samples_at = 0;
+    for (size_t r = 0; r < rounds; r++)
+    {
+        if (r == 1U)
+        {
+            started_at = getMonotonicNanoseconds();
+            samples_at = harness.pipeline.num_samples;
+        }
+        harness.print = !quiet && (r == 0U);
+        (void) sensorReplayRun(&replay, &onEcho, &harness);
+    }
+    const uint64_t elapsed_ns = getMonotonicNanoseconds() - started_at;
+
+    (void) fprintf(stderr,
+                   "%zu edges, %llu samples, %zu frames\n",
+                   replay.count,
+                   (unsigned long long) harness.pipeline.num_samples,
+                   harness.frames);
+    if (rounds > 1U)
+    {
+        const double samples = (double) (harness.pipeline.num_samples - samples_at);
+        (void) fprintf(stderr,
+                       "%.0f samples/s, %.1f ns/sample\n",
+                       samples * 1e9 / (double) elapsed_ns,
+                       (double) elapsed_ns / samples);
+    }
+    sensorReplayFree(&replay);
+    free(synthetic);
+    return 0;
+}
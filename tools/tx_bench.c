@@ -0,0 +1,179 @@
+/// This software is distributed under the terms of the MIT License.
+/// Copyright (c) 2020 Hugo A. Garcia
+/// Author: Hugo A. Garcia <hugo.a.garcia@gmail.com>
+///
+/// TX queue benchmark of large transfers: canardTxPush(), which serializes all frames of a transfer when it is pushed,
+/// against canardTxPushLazy(), which enqueues the first frame only and serializes the next one whenever a frame is
+/// popped. A number of transfers is pushed at once, as a file server answering several requests would do, then the
+/// queue is drained. Reported per transfer: the push time, the drain time (peek, pop and free of all frames), and the
+/// peak heap held by the queue, allocator overhead excluded.
+///
+///     tx-bench [<payload-size> [<transfers> [<rounds>]]]
+
+#include <canard.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NODE_ID 42U
+#define SUBJECT_ID 4000U
+
+typedef struct
+{
+    const char* name;
+    size_t      mtu;
+} Mode;
+
+static const Mode Modes[] = {
+    {"classic", CANARD_MTU_CAN_CLASSIC},
+    {"fd", CANARD_MTU_CAN_FD},
+};
+
+/// The size of every allocation is stored in front of it so that the heap in use can be tracked.
+typedef struct
+{
+    size_t size;
+    size_t padding;  ///< Keeps the allocations aligned to 16 bytes.
+} AllocationHeader;
+
+static size_t HeapInUse;
+static size_t HeapPeak;
+
+static void* memAllocate(CanardInstance* const ins, const size_t amount)
+{
+    (void) ins;
+    AllocationHeader* const header = malloc(sizeof(AllocationHeader) + amount);
+    if (header == NULL)
+    {
+        return NULL;
+    }
+    header->size = amount;
+    HeapInUse += amount;
+    HeapPeak = (HeapInUse > HeapPeak) ? HeapInUse : HeapPeak;
+    return header + 1;
+}
+
+static void memFree(CanardInstance* const ins, void* const pointer)
+{
+    (void) ins;
+    if (pointer != NULL)
+    {
+        AllocationHeader* const header = ((AllocationHeader*) pointer) - 1;
+        HeapInUse -= header->size;
+        free(header);
+    }
+}
+
+static uint64_t getMonotonicNanoseconds(void)
+{
+    struct timespec ts;
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec * 1000000000ULL) + (uint64_t) ts.tv_nsec;
+}
+
+typedef struct
+{
+    uint64_t push_ns;
+    uint64_t drain_ns;
+    size_t   frames;
+    size_t   heap_peak;
+} Result;
+
+static int run(const Mode* const    mode,
+               const bool           lazy,
+               const uint8_t* const payload,
+               const size_t         payload_size,
+               const size_t         transfers,
+               const size_t         rounds,
+               Result* const        result)
+{
+    (void) memset(result, 0, sizeof(*result));
+    CanardInstance ins = canardInit(&memAllocate, &memFree);
+    ins.node_id        = NODE_ID;
+    ins.mtu_bytes      = mode->mtu;
+    HeapPeak           = 0U;
+    for (size_t r = 0; r < rounds; r++)
+    {
+        const uint64_t started = getMonotonicNanoseconds();
+        for (size_t i = 0; i < transfers; i++)
+        {
+            const CanardTransfer transfer = {
+                .timestamp_usec = 0U,
+                .priority       = CanardPriorityLow,
+                .transfer_kind  = CanardTransferKindMessage,
+                .port_id        = SUBJECT_ID,
+                .remote_node_id = CANARD_NODE_ID_UNSET,
+                .transfer_id    = (CanardTransferID) i,
+                .payload_size   = payload_size,
+                .payload        = payload,
+            };
+            const int32_t frames = lazy ? canardTxPushLazy(&ins, &transfer) : canardTxPush(&ins, &transfer);
+            if (frames < 0)
+            {
+                return frames;
+            }
+            result->frames += (size_t) frames;
+        }
+        const uint64_t pushed = getMonotonicNanoseconds();
+        for (const CanardFrame* txf = canardTxPeek(&ins); txf != NULL; txf = canardTxPeek(&ins))
+        {
+            canardTxPop(&ins);
+            ins.memory_free(&ins, (void*) txf);
+        }
+        const uint64_t drained = getMonotonicNanoseconds();
+        result->push_ns += pushed - started;
+        result->drain_ns += drained - pushed;
+    }
+    result->heap_peak = HeapPeak;
+    return (HeapInUse == 0U) ? 0 : -1;
+}
+
+int main(const int argc, const char* const argv[])
+{
+    const size_t payload_size = (argc > 1) ? (size_t) strtoul(argv[1], NULL, 10) : 4096U;
+    const size_t transfers    = (argc > 2) ? (size_t) strtoul(argv[2], NULL, 10) : 8U;
+    const size_t rounds       = (argc > 3) ? (size_t) strtoul(argv[3], NULL, 10) : 1000U;
+    if ((payload_size <= CANARD_MTU_CAN_FD) || (transfers == 0U) || (rounds == 0U))
+    {
+        (void) fprintf(stderr, "Usage: %s [<payload-size> [<transfers> [<rounds>]]]\n", argv[0]);
+        (void) fprintf(stderr, "The payload shall take more than one CAN FD frame.\n");
+        return 1;
+    }
+    uint8_t* const payload = malloc(payload_size);
+    if (payload == NULL)
+    {
+        return 1;
+    }
+    for (size_t i = 0; i < payload_size; i++)
+    {
+        payload[i] = (uint8_t) i;
+    }
+
+    (void) printf("%zu transfers of %zu bytes pushed at once, %zu rounds\n", transfers, payload_size, rounds);
+    (void) printf("| mode    | push  | frames/transfer | push ns/transfer | drain ns/transfer | peak queue bytes |\n");
+    (void) printf("|---------|-------|----------------:|-----------------:|------------------:|-----------------:|\n");
+    for (size_t m = 0; m < (sizeof(Modes) / sizeof(Modes[0])); m++)
+    {
+        for (int lazy = 0; lazy <= 1; lazy++)
+        {
+            Result result;
+            if (run(&Modes[m], lazy != 0, payload, payload_size, transfers, rounds, &result) != 0)
+            {
+                (void) fprintf(stderr, "%s: out of memory or leak\n", Modes[m].name);
+                free(payload);
+                return 1;
+            }
+            const double count = (double) (transfers * rounds);
+            (void) printf("| %-7s | %-5s | %15.1f | %16.1f | %17.1f | %16zu |\n",
+                          Modes[m].name,
+                          (lazy != 0) ? "lazy" : "eager",
+                          (double) result.frames / count,
+                          (double) result.push_ns / count,
+                          (double) result.drain_ns / count,
+                          result.heap_peak);
+        }
+    }
+    free(payload);
+    return 0;
+}